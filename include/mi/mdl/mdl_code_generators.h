@@ -972,6 +972,18 @@ class ICode_generator_jit : public
     /// The name of the option to enable/disable the builtin texture runtime of the native backend
     #define MDL_JIT_USE_BUILTIN_RESOURCE_HANDLER_CPU "jit_use_builtin_resource_handler_cpu"
 
+    /// The name of the option to share compiled functions with identical semantic hash and
+    /// code generation options between the modules of the native backend.
+    #define MDL_JIT_OPTION_SHARE_FUNCTIONS "jit_share_functions"
+
+    /// The name of the option to compile the hot functions of native code again with full
+    /// optimizations in the background, if it was compiled with a lower optimization level.
+    #define MDL_JIT_OPTION_TIERED_COMPILATION "jit_tiered_compilation"
+
+    /// The name of the option that steers, how the libbsdf runtime functions shared by all
+    /// materials are emitted for PTX and HLSL (inline, external or runtime).
+    #define MDL_JIT_OPTION_SHARED_RUNTIME_MODE "jit_shared_runtime_mode"
+
     /// The name of the option to enable the HLSL resource data struct argument.
     #define MDL_JIT_OPTION_HLSL_USE_RESOURCE_DATA "jit_hlsl_use_resource_data"
 
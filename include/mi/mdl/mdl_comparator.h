@@ -50,6 +50,8 @@ public:
     enum Event {
         EV_COMPARING_MODULE,   ///< Comparing two modules.
         EV_COMPARING_EXPORT,   ///< Comparing two exports.
+        EV_MODULE_COMPARED,    ///< Finished comparing two modules of an archive, name is
+                               ///  "<module>: <time> ms" or "<module>: identical source".
     };
 
     /// Called when an event is fired.
@@ -66,9 +66,47 @@ public:
         char const* path) = 0;
 };
 
+/// A store of resource content hashes that can be shared between the creation of several MDLEs.
+///
+/// The encapsulator hashes every resource it writes. If many MDLEs share the same resources,
+/// a store remembers the MD5 hashes by the file name, size and modification time of the
+/// resource, so each resource is read for hashing only once, and a file changed on disk is
+/// hashed again. The store is accessed from several threads concurrently.
+class IEncapsulate_tool_resource_store : public
+    mi::base::Interface_declare<0xf9f66146,0x6a40,0x40d3,0x8e,0x65,0x29,0xc1,0x58,0x3a,0x65,0x27,
+    mi::base::IInterface>
+{
+public:
+    /// Look up the content hash of a resource.
+    ///
+    /// \param file_name  the file name of the resource as reported by its reader
+    /// \param file_size  the size of the file in bytes
+    /// \param file_time  the modification time of the file
+    /// \param[out] hash  the MD5 hash of the content if found
+    ///
+    /// \return true if a hash was found for this name, size and modification time
+    virtual bool get_content_hash(
+        char const    *file_name,
+        mi::Uint64    file_size,
+        mi::Uint64    file_time,
+        unsigned char hash[16]) const = 0;
+
+    /// Record the content hash of a resource.
+    ///
+    /// \param file_name  the file name of the resource as reported by its reader
+    /// \param file_size  the size of the file in bytes
+    /// \param file_time  the modification time of the file
+    /// \param hash       the MD5 hash of the content
+    virtual void set_content_hash(
+        char const          *file_name,
+        mi::Uint64          file_size,
+        mi::Uint64          file_time,
+        unsigned char const hash[16]) = 0;
+};
+
 /// This is the interface to the encapsulated MDL tool.
 class IEncapsulate_tool : public
-    mi::base::Interface_declare<0xf5c07301,0x2bca,0x48ad,0xaf,0xa6,0x8a,0xd1,0x8e,0xdb,0x1d,0x2a,
+    mi::base::Interface_declare<0xa89bedb5,0x28e2,0x41a9,0x91,0x5e,0xe1,0x36,0x26,0xce,0x93,0x58,
     mi::base::IInterface>
 {
 public:
@@ -81,6 +119,7 @@ public:
         char const *const                           *additional_file_source_paths;
         char const *const                           *additional_file_target_paths;
         char const                                  *authoring_tool_name_and_version;
+        IEncapsulate_tool_resource_store            *resource_store;  ///< may be NULL
     };
 
     /// The name of the option to overwrite existing MDLE files.
@@ -160,6 +199,28 @@ public:
     /// Get access to the options.
     ///
     virtual Options &access_options() = 0;
+
+    /// Create several encapsulated mdl files in one call.
+    ///
+    /// Descriptions without a resource store share a store created for this call, so resources
+    /// used by several of the MDLEs are hashed only once.
+    ///
+    /// \param count            Number of MDLEs to create.
+    /// \param modules          Modules that should be written to MDLE files.
+    /// \param mdle_names       MDLE file names without path and without extension.
+    /// \param dest_path        The path where the created MDLE files should be stored.
+    /// \param descs            The export descriptions, one per MDLE.
+    ///
+    /// \returns the number of successfully created MDLEs
+    virtual size_t create_encapsulated_modules(
+        size_t                          count,
+        IModule const * const           *modules,
+        char const * const              *mdle_names,
+        char const                      *dest_path,
+        Mdle_export_description const   *descs) = 0;
+
+    /// Create a new resource store that can be shared between MDLE creations.
+    virtual IEncapsulate_tool_resource_store *create_resource_store() = 0;
 };
 
 } // mdl
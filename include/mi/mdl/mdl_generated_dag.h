@@ -476,7 +476,7 @@ public:
     ///  - Call IGenerated_code_dag::IMaterial_instance::initialize().
     class IMaterial_instance : public
         mi::base::Interface_declare
-        <0x29c36255,0x7558,0x4865,0xa7,0x7e,0xaa,0x3a,0x50,0x4f,0x70,0xbc,
+        <0x0207d177,0x7f5b,0x405f,0x82,0x84,0x06,0x52,0x6a,0x95,0x64,0x92,
         IDag_builder>
     {
     public:
@@ -733,6 +733,18 @@ public:
 
         /// Get the resource tagger for this material instance.
         virtual IResource_tagger *get_resource_tagger() const = 0;
+
+        /// Set a previously compiled instance of the same material to speed up the next
+        /// initialize() call.
+        ///
+        /// \param prev  the previous instance or NULL
+        ///
+        /// During instance compilation, every argument sub-DAG that was already instantiated
+        /// by the previous instance is reused instead of being instantiated and folded again,
+        /// so after an argument edit only the sub-DAGs depending on it are processed.
+        /// The previous instance is only used if it was compiled from the same material
+        /// with the same flags and unit/wavelength settings, and it is released by initialize().
+        virtual void set_previous_instance(IMaterial_instance const *prev) = 0;
     };
 
     // -------------------------- methods --------------------------
@@ -149,6 +149,10 @@ public:
     /// The name of the option that controls, if resources are to be resolved by the compiler.
     #define MDL_OPTION_RESOLVE_RESOURCES "resolve_resources"
 
+    /// The name of the option that enables loading of independent imports on worker threads.
+    /// Requires a module cache that supports concurrent lookups from multiple threads.
+    #define MDL_OPTION_PARALLEL_IMPORTS "parallel_imports"
+
     /// The value of \c limits::FLOAT_MIN.
     #define MDL_OPTION_LIMITS_FLOAT_MIN "limits::FLOAT_MIN"
 
@@ -193,6 +193,9 @@ public:
     ///                                    - bool "fold_ternary_on_df": Fold all ternary operators
     ///                                      of *df types, even in class compilation mode.
     ///                                      Default: false.
+    ///                                    - bool "incremental_instantiation": Reuse the unchanged
+    ///                                      argument sub-graphs of the last instance compilation
+    ///                                      of this material instance. Default: false.
     ///                                    .
     ///                                    During material compilation, messages like errors and
     ///                                    warnings will be passed to the context for later
@@ -60,6 +60,7 @@ class IMdl_execution_context;
 class IMdl_entity_resolver;
 class ITarget_code;
 class ITarget_argument_block;
+class ITarget_value_layout;
 class ITransaction;
 
 struct Target_function_description;
@@ -108,7 +109,7 @@ mi_static_assert(sizeof(Df_data_kind) == sizeof(Uint32));
 ///
 /// It also allows to load plugins to add support for loading and exporting images and videos.
 class IMdl_compiler : public
-    mi::base::Interface_declare<0x8fff0a2d,0x7df7,0x4552,0x92,0xf7,0x36,0x1d,0x31,0xc6,0x30,0x08>
+    mi::base::Interface_declare<0xa96f17fd,0xafa1,0x4f6b,0x9c,0x5f,0x0b,0x04,0x28,0x3c,0xff,0x73>
 {
 public:
     /// \name General configuration
@@ -565,6 +566,32 @@ public:
         Size &rx,
         Size &ry,
         Size &rz) const = 0;
+
+    /// Converts an image file to another image format, including all miplevels.
+    ///
+    /// Miplevels stored in the input file are reused, missing miplevels are computed. Writing
+    /// files with the extension \c ".mitx" requires the \c "mitx" image plugin. These files
+    /// store all miplevels as tiles of fixed size, such that textures using them load only the
+    /// header up front and individual tiles on demand.
+    ///
+    /// \param input_filename    The file name of the image to convert.
+    /// \param output_filename   The file name of the converted image. The ending of the file
+    ///                          name determines the image format.
+    /// \param quality           The compression quality is an integer in the range from 0 to 100,
+    ///                          where 0 is the lowest quality, and 100 is the highest quality.
+    ///                          For \c ".mitx" files, the storage is lossless and the quality
+    ///                          selects the compression level, where values below 10 disable
+    ///                          compression.
+    /// \return
+    ///                          -  0: Success.
+    ///                          - -1: Invalid file name.
+    ///                          - -2: Failure to load the input file.
+    ///                          - -3: Invalid quality.
+    ///                          - -4: Unspecified failure.
+    virtual Sint32 convert_image(
+        const char* input_filename,
+        const char* output_filename,
+        Uint32 quality = 100) const = 0;
 };
 
 mi_static_assert( sizeof( IMdl_compiler::Mdl_backend_kind)== sizeof( Uint32));
@@ -586,6 +613,7 @@ public:
     ///   * \c "0": no optimization
     ///   * \c "1": no inlining, no expensive optimizations
     ///   * \c "2": full optimizations, including inlining (default)
+    ///   The level applies to the machine code generation as well.
     /// - \c "num_texture_spaces": Set the number of supported texture spaces.
     ///   Default: \c "32".
     /// - \c "enable_auxiliary": Enable code generation for auxiliary methods on distribution
@@ -604,6 +632,33 @@ public:
     /// The following options are supported by the NATIVE backend only:
     /// - \c "use_builtin_resource_handler": Enables/disables the built-in texture runtime.
     ///   Possible values: \c "on", \c "off". Default: \c "on".
+    /// - \c "linearize_textures": If enabled, the built-in texture runtime converts
+    ///   gamma-encoded 2D textures to linear float canvases when the target code is initialized,
+    ///   trading memory for lookup speed. Otherwise, 8-bit textures are linearized per texel via
+    ///   lookup tables. Possible values: \c "on", \c "off". Default: \c "off".
+    /// - \c "share_functions": If enabled, MDL functions with identical semantic hash and code
+    ///   generation options are compiled only once and shared between the target codes of all
+    ///   native backends. Functions depending on resources or strings of a target code are not
+    ///   shared. Possible values: \c "on", \c "off". Default: \c "off".
+    /// - \c "tiered_compilation": If enabled and \c "opt_level" is below \c "2", the target code
+    ///   is usable as soon as it has been compiled at the requested level. Once one of its
+    ///   execution functions has been called often, the functions called so far are compiled
+    ///   again with full optimizations on a background thread, and they switch to the
+    ///   optimized code once that is ready. If this fails, the code of the requested level
+    ///   stays in use. Possible values: \c "on", \c "off". Default: \c "off".
+    /// - \c "texture_lookup_footprints": If enabled, the built-in texture runtime creates mipmaps
+    ///   for 2D textures and interprets the texture handler passed to the execution functions as
+    ///   #mi::neuraylib::Texture_handler_footprint, selecting mipmap levels for 2D texture
+    ///   lookups without derivatives according to its footprint. The texture handler may be
+    ///   \c NULL. Possible values: \c "on", \c "off". Default: \c "off".
+    /// - \c "texture_lookup_ptex": If enabled, the built-in texture runtime interprets the texture
+    ///   handler passed to the execution functions as #mi::neuraylib::Texture_handler_ptex for
+    ///   lookups of ptex textures. The faces of a ptex texture are the uv-tiles of its image, or
+    ///   the layers of its canvas for images without uv-tiles. Otherwise, ptex lookups return
+    ///   zero. Possible values: \c "on", \c "off". Default: \c "off".
+    /// - \c "ptex_cache_size": The maximum number of bytes of decoded face data the built-in
+    ///   texture runtime keeps per target code for ptex lookups. The least recently used faces
+    ///   are evicted first. Default: \c "67108864".
     ///
     /// The following options are supported by the PTX, LLVM-IR and native backend:
     ///
@@ -657,6 +712,18 @@ public:
     ///   * \c "direct_call": generate direct function calls
     ///   * \c "optix_cp": generate calls through OptiX bindless callable programs
     ///
+    /// The following options are supported by the PTX and HLSL backends only:
+    /// - \c "shared_runtime": Selects how the libbsdf runtime functions, which are identical for
+    ///   all materials translated with the same options, are emitted.
+    ///   Possible values:
+    ///   * \c "inline": emit the runtime functions into the code of every target code (default)
+    ///   * \c "external": only reference the runtime functions via external declarations with
+    ///     stable names, so the material specific code can be compiled separately
+    ///   * \c "runtime": additionally emit the runtime functions as externally visible
+    ///     definitions. Translating an empty link unit with this mode creates the shared runtime
+    ///     part to be linked with material code created in the \c "external" mode.
+    ///   The option is ignored, if \c "texture_runtime_with_derivs" is enabled.
+    ///
     /// The following options are supported by the HLSL backend only:
     /// - \c "hlsl_use_resource_data": If enabled, an extra user define resource data struct is
     ///   passed to all resource callbacks.
@@ -942,9 +1009,15 @@ public:
 /// The layout of the data is given by the corresponding #mi::neuraylib::ITarget_value_layout
 /// object.
 ///
+/// The argument block keeps track of the byte ranges modified since the last call of
+/// #clear_dirty_ranges(), so renderers can upload only the changed parts. A newly created or
+/// cloned block is dirty as a whole. Modifications done by #set_values() and
+/// #set_values_by_name() are recorded automatically, writes through the non-const #get_data()
+/// must be reported via #mark_dirty().
+///
 /// See \ref mi_neuray_compilation_modes for more details.
 class ITarget_argument_block : public
-    mi::base::Interface_declare<0xf2a5db20,0x85ab,0x4c41,0x8c,0x5f,0x49,0xc8,0x29,0x4a,0x73,0x65>
+    mi::base::Interface_declare<0x1bd8db96,0xbdb3,0x42d2,0x81,0x9c,0xc0,0xb5,0x7a,0x88,0x97,0xb2>
 {
 public:
     /// Returns the target argument block data.
@@ -958,6 +1031,71 @@ public:
 
     /// Clones the argument block (to make it writeable).
     virtual ITarget_argument_block *clone() const = 0;
+
+    /// Returns the number of byte ranges modified since the last call of #clear_dirty_ranges().
+    virtual Size get_dirty_range_count() const = 0;
+
+    /// Returns a modified byte range.
+    ///
+    /// The ranges are sorted by offset, they neither overlap nor touch each other.
+    ///
+    /// \param index        The index of the range.
+    /// \param[out] offset  Receives the offset of the range inside the block.
+    /// \param[out] size    Receives the size of the range in bytes.
+    ///
+    /// \return \c false if \p index is out of range, \c true otherwise.
+    virtual bool get_dirty_range(Size index, Size &offset, Size &size) const = 0;
+
+    /// Marks a byte range as modified.
+    ///
+    /// \param offset  The offset of the range inside the block.
+    /// \param size    The size of the range in bytes, it is clipped to the block size.
+    virtual void mark_dirty(Size offset, Size size) = 0;
+
+    /// Acknowledges all modifications, i.e., clears the set of modified byte ranges.
+    virtual void clear_dirty_ranges() = 0;
+
+    /// Sets several arguments of the class-compiled material in one call.
+    ///
+    /// \param layout             The layout of this argument block.
+    /// \param count              The number of arguments to set.
+    /// \param indices            The layout indices of the arguments, which are the indices of
+    ///                           the corresponding compiled material arguments.
+    /// \param values             The new values of the arguments.
+    /// \param resource_callback  Callback for retrieving resource indices for resource values.
+    ///
+    /// \return
+    ///                      -  0: Success.
+    ///                      - -1: Invalid parameters (\c NULL pointer).
+    ///                      - -2: Invalid index.
+    ///                      - -3: Value kind does not match expected kind.
+    ///                      - -4: Size of compound value does not match expected size.
+    ///                      - -5: Unsupported value type.
+    ///                      On failure, the arguments before the failing one are already set.
+    virtual Sint32 set_values(
+        const ITarget_value_layout *layout,
+        Size count,
+        const Size *indices,
+        const IValue* const *values,
+        ITarget_resource_callback *resource_callback) = 0;
+
+    /// Sets several arguments of the class-compiled material in one call.
+    ///
+    /// \param material           The class-compiled material this argument block belongs to.
+    /// \param layout             The layout of this argument block.
+    /// \param count              The number of arguments to set.
+    /// \param names              The parameter names of the compiled material arguments.
+    /// \param values             The new values of the arguments.
+    /// \param resource_callback  Callback for retrieving resource indices for resource values.
+    ///
+    /// \return                   See #set_values(), -2 is returned for an unknown name.
+    virtual Sint32 set_values_by_name(
+        const ICompiled_material *material,
+        const ITarget_value_layout *layout,
+        Size count,
+        const char* const *names,
+        const IValue* const *values,
+        ITarget_resource_callback *resource_callback) = 0;
 };
 
 /// Structure representing the state during traversal of the nested layout.
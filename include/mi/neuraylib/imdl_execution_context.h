@@ -69,6 +69,8 @@ public:
         MSG_INTEGRATION,
         /// Uncategorized messages do not have a code.
         MSG_UNCATEGORIZED,
+        /// Profiling message, see option "profiling". The code is the wall time in microseconds.
+        MSG_PROFILING,
         //  Undocumented, for alignment only.
         MSG_FORCE_32_BIT = 0xffffffffU
     };
@@ -103,6 +105,13 @@ public:
 /// - "internal_space": Set the internal space of the backend. Possible values: "coordinate_world",
 ///   "coordinate_object". Default: "coordinate_world".
 /// - "experimental": If \c true, enables undocumented experimental MDL features. Default: false.
+/// - "parallel_imports": If \c true, independent imports of a module are loaded concurrently on
+///   worker threads. Default: false.
+/// - "parallel_resource_loading": If \c true, the resources of a module are resolved first. The
+///   uv-tiles of textures are then decoded, and the files of light profiles and BSDF measurements
+///   are hashed and read into memory, concurrently on worker threads. The DB elements are still
+///   created in a deterministic order and the module is only available after all resources have
+///   been loaded. Default: false.
 ///
 /// Options for MDL export
 /// - "bundle_resources": If \c true, referenced resources are exported into the same directory as
@@ -115,6 +124,10 @@ public:
 /// - "wavelength_max": The largest supported wavelength. Default: 780.0f.
 /// - "fold_ternary_on_df": Fold all ternary operators of *df types, even in class compilation
 ///   mode. Default: false.
+/// - "incremental_instantiation": If \c true, a material instance keeps the result of its last
+///   instance compilation and the next instance compilation of it or of an edited copy reuses
+///   all argument sub-graphs that did not change. Speeds up recompilation after argument edits
+///   at the cost of the memory of the kept result. Default: false.
 ///
 /// Options for code generation
 /// - "meters_per_scene_unit": The conversion ratio between meters and scene units for this
@@ -123,6 +136,15 @@ public:
 /// - "wavelength_max": The largest supported wavelength. Default: 780.0f.
 /// - "include_geometry_normal": If true, the \c "geometry.normal" field will be applied to the
 ///   MDL state prior to evaluation of the given DF. Default: true.
+///
+/// Options for profiling
+/// - "profiling": If \c true, the wall time of the phases of module loading, material
+///   compilation and code generation is recorded. When an operation finishes, its phases are
+///   added as info messages of kind #IMessage::MSG_PROFILING, nested phases as notes.
+///   Default: false.
+/// - "profiling_trace_file": If not empty and profiling is enabled, all phases recorded so far
+///   with this context are written to this file in the Chrome trace event format when an
+///   operation finishes. Default: "".
 
 class IMdl_execution_context: public
     base::Interface_declare<0x28eb1f99,0x138f,0x4fa2,0xb5,0x39,0x17,0xb4,0xae,0xfb,0x1b,0xca>
@@ -97,7 +97,7 @@ class IScope;
 /// \note The MDL SDK currently supports only one transaction at a time.
 /// \endif
 class ITransaction : public
-    mi::base::Interface_declare<0x6ca1f0c2,0xb262,0x4f09,0xa6,0xa5,0x05,0xae,0x14,0x45,0xed,0xfa>
+    mi::base::Interface_declare<0x87e29aa8,0x43d0,0x45b2,0x8d,0x9d,0xa3,0x39,0x86,0x7f,0xac,0x9c>
 {
 public:
     /// Commits the transaction.
@@ -583,6 +583,21 @@ public:
     ///                      -   -4: There is no DB element named \p name visible in this
     ///                              transaction.
     virtual Sint32 get_privacy_level( const char* name) const = 0;
+
+    /// Retrieves several elements from the database.
+    ///
+    /// This is equivalent to calling #access(const char*) for each name, but all names are
+    /// resolved in one batch, which is considerably faster for large numbers of elements.
+    ///
+    /// \param count          The number of names.
+    /// \param names          The names of the elements to retrieve.
+    /// \param[out] elements  Receives the requested elements, or \c NULL for names that are
+    ///                       \c NULL or for which no DB element exists. The caller is responsible
+    ///                       for releasing the returned elements.
+    /// \return               The number of retrieved elements, 0 if \p names or \p elements is
+    ///                       \c NULL or the transaction is already closed.
+    virtual Size access(
+        Size count, const char* const* names, const base::IInterface** elements) = 0;
 };
 
 /*@}*/ // end group mi_neuray_database_access
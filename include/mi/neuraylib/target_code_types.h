@@ -543,6 +543,28 @@ struct Texture_handler_deriv_base {
     Texture_handler_deriv_vtable const  *vtable;
 };
 
+/// The texture handler structure that can be passed to native code using the built-in resource
+/// handler, if the backend option \c "texture_lookup_footprints" is enabled.
+/// It provides the filter footprint for 2D texture lookups without derivatives, for example
+/// derived from a ray cone.
+struct Texture_handler_footprint : public Texture_handler_base {
+    /// The width of the lookup footprint in texture space, where 1 covers a whole texture
+    /// (or uv-tile). Values <= 0 select unfiltered lookups in the top mipmap level.
+    tct_float footprint;
+};
+
+/// The texture handler structure that can be passed to native code using the built-in resource
+/// handler, if the backend option \c "texture_lookup_ptex" is enabled.
+/// It provides the face and the face-local coordinates for lookups of ptex textures. For these
+/// lookups, the footprint of the base structure is interpreted in face space.
+struct Texture_handler_ptex : public Texture_handler_footprint {
+    /// The ID of the face to look up. Invalid IDs result in zero lookups.
+    tct_int face_id;
+
+    /// The face-local coordinates in [0, 1]^2.
+    tct_float face_uv[2];
+};
+
 
 /// The data structure providing access to resources for generated code.
 struct Resource_data {
@@ -62,6 +62,7 @@
 #include <base/lib/plug/i_plug.h>
 #include <mdl/integration/mdlnr/i_mdlnr.h>
 #include <io/image/image/i_image.h>
+#include <io/image/image/i_image_mipmap.h>
 #include <io/scene/bsdf_measurement/i_bsdf_measurement.h>
 #include <io/scene/lightprofile/i_lightprofile.h>
 #include <io/scene/mdl_elements/i_mdl_elements_module.h>
@@ -302,6 +303,26 @@ mi::Sint32 Mdl_compiler_impl::export_canvas(
     return result ? 0 : -4;
 }
 
+mi::Sint32 Mdl_compiler_impl::convert_image(
+    const char* input_filename, const char* output_filename, mi::Uint32 quality) const
+{
+    if( !input_filename || !output_filename)
+        return -1;
+
+    if( quality > 100)
+       return -3;
+
+    SYSTEM::Access_module<IMAGE::Image_module> image_module( false);
+    mi::Sint32 errors = 0;
+    mi::base::Handle<IMAGE::IMipmap> mipmap( image_module->create_mipmap(
+        input_filename, /*tile_width*/ 0, /*tile_height*/ 0, /*only_first_level*/ false, &errors));
+    if( errors != 0)
+        return -2;
+
+    bool result = image_module->export_mipmap( mipmap.get(), output_filename, quality);
+    return result ? 0 : -4;
+}
+
 mi::Sint32 Mdl_compiler_impl::export_lightprofile(
     const char* filename, const mi::neuraylib::ILightprofile* lightprofile) const
 {
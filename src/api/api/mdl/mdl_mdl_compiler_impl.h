@@ -139,6 +139,11 @@ public:
         const mi::neuraylib::ICanvas* canvas,
         mi::Uint32 quality) const override;
 
+    mi::Sint32 convert_image(
+        const char* input_filename,
+        const char* output_filename,
+        mi::Uint32 quality) const override;
+
     mi::Sint32 export_lightprofile(
         const char* filename,
         const mi::neuraylib::ILightprofile* lightprofile) const override;
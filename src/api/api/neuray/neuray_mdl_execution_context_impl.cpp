@@ -70,6 +70,8 @@ public:
             return MSG_INTEGRATION;
         case MDL::Message::MSG_IMP_EXP:
             return MSG_IMP_EXP;
+        case MDL::Message::MSG_PROFILING:
+            return MSG_PROFILING;
         default:
             break;
         }
@@ -898,6 +898,7 @@ mi::Sint32 Mdle_api_impl::export_mdle(
     desc.additional_file_source_paths = additional_file_source_paths.data();
     desc.additional_file_target_paths = additional_file_target_paths.data();
     desc.additional_file_count = additional_file_source_paths.size();
+    desc.resource_store = nullptr;
     MDL_ASSERT(additional_file_source_paths.size() == additional_file_target_paths.size());
 
     // add authoring tool
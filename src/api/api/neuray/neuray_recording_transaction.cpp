@@ -102,6 +102,19 @@ void Recording_transaction::store_for_reference_counting(
     m_tags.push_back( tag);
 }
 
+void Recording_transaction::store_lazily_for_reference_counting(
+    DB::Tag tag,
+    DB::Element_factory* factory,
+    const char* name,
+    DB::Privacy_level privacy_level,
+    DB::Journal_type journal_type,
+    DB::Privacy_level store_level)
+{
+    m_transaction->store_lazily_for_reference_counting(
+        tag, factory, name, privacy_level, journal_type, store_level);
+    m_tags.push_back( tag);
+}
+
 bool Recording_transaction::remove(
     DB::Tag tag,
     bool remove_local_copy)
@@ -95,6 +95,14 @@ public:
         DB::Journal_type journal_type,
         DB::Privacy_level store_level);
 
+    void store_lazily_for_reference_counting(
+        DB::Tag tag,
+        DB::Element_factory* factory,
+        const char* name,
+        DB::Privacy_level privacy_level,
+        DB::Journal_type journal_type,
+        DB::Privacy_level store_level);
+
     bool remove(
         DB::Tag tag,
         bool remove_local_copy = false);
@@ -48,6 +48,7 @@
 #include <mi/neuraylib/iuser_class.h>
 
 #include <sstream>
+#include <vector>
 
 #include <base/data/db/i_db_access.h>
 #include <base/data/db/i_db_tag.h>
@@ -209,6 +210,32 @@ const mi::base::IInterface* Transaction_impl::access(
     return access( tag);
 }
 
+mi::Size Transaction_impl::access(
+    mi::Size count, const char* const* names, const mi::base::IInterface** elements)
+{
+    if( !names || !elements)
+        return 0;
+
+    if( !is_open()) {
+        for( mi::Size i = 0; i < count; ++i)
+            elements[i] = 0;
+        return 0;
+    }
+
+    // resolve all names at once, this acquires the DB lock only once
+    std::vector<DB::Tag> tags( count);
+    if( count > 0)
+        m_db_transaction->name_to_tags( count, names, &tags[0]);
+
+    mi::Size result = 0;
+    for( mi::Size i = 0; i < count; ++i) {
+        elements[i] = tags[i].is_valid() ? access( tags[i]) : 0;
+        if( elements[i])
+            ++result;
+    }
+    return result;
+}
+
 mi::base::IInterface* Transaction_impl::edit(
     const char* name)
 {
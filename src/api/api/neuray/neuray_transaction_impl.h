@@ -103,6 +103,9 @@ public:
 
     const mi::base::IInterface* access( const char* name);
 
+    mi::Size access(
+        mi::Size count, const char* const* names, const mi::base::IInterface** elements);
+
     using mi::neuraylib::ITransaction::access;
 
     mi::base::IInterface* edit( const char* name);
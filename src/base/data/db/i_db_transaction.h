@@ -60,6 +60,26 @@ class Info;
 class Scope;
 class IExecution_listener;
 
+/// Creates a database element on demand.
+///
+/// Used with Transaction::store_lazily_for_reference_counting() to defer the (possibly expensive)
+/// construction of an element until it is accessed for the first time.
+class Element_factory
+{
+public:
+    virtual ~Element_factory() { }
+
+    /// Returns the class ID of the element created by #create_element().
+    virtual SERIAL::Class_id get_class_id() const = 0;
+
+    /// Creates the element for the given tag. Called at most once.
+    ///
+    /// \param transaction		The transaction that accesses the element first
+    /// \param tag			The tag of the element
+    /// \return				The new element
+    virtual Element_base* create_element(Transaction* transaction, Tag tag) = 0;
+};
+
 /// A transaction lives within a scope and provides a consistent view on the database for the
 /// lifetime of the transaction.
 ///
@@ -231,6 +251,33 @@ class Transaction : private STLEXT::Non_copyable
 	Journal_type journal_type = JOURNAL_ALL,
 	Privacy_level store_level = 255) = 0;
 
+    /// Insert a new element into the database reusing a tag, but defer the creation of the element.
+    /// The tag and its name are registered immediately. The element itself is created by the
+    /// factory when it is accessed for the first time. The class ID is available without creating
+    /// the element. Otherwise, this method behaves like the corresponding
+    /// #store_for_reference_counting() method.
+    ///
+    /// The default implementation creates the element right away.
+    ///
+    /// \param tag 			The tag to recreate
+    /// \param factory			The factory for the element, the database takes ownership
+    /// \param name			Optional name for tag
+    /// \param privacy_level		Privacy level of element
+    /// \param journal_type 		Type for journal entries
+    /// \param store_level		Level of the scope the tag is stored in
+    virtual void store_lazily_for_reference_counting(
+	Tag tag,
+	Element_factory* factory,
+	const char* name = NULL,
+	Privacy_level privacy_level = 0,
+	Journal_type journal_type = JOURNAL_ALL,
+	Privacy_level store_level = 255)
+    {
+	Element_base* element = factory->create_element(this, tag);
+	delete factory;
+	store_for_reference_counting(tag, element, name, privacy_level, journal_type, store_level);
+    }
+
     /// Insert a new job into the database. The return value is the tag which will now identify the
     /// job.
     /// The tag will be removed immediately, automatically. So to prevent it from being deleted
@@ -340,6 +387,19 @@ class Transaction : private STLEXT::Non_copyable
     virtual Tag name_to_tag(
 	const char* name) = 0;
 
+    /// Lookup the tags for several names within the context of this transaction.
+    ///
+    /// This is equivalent to calling name_to_tag() for each name, but implementations may
+    /// resolve all names at once, e.g., under a single lock acquisition.
+    ///
+    /// \param count		The number of names.
+    /// \param names		The names to lookup, NULL entries are allowed.
+    /// \param tags			Receives the found tags or the 0 tag if a name was not found.
+    virtual void name_to_tags(
+	size_t count,
+	const char* const* names,
+	Tag* tags) = 0;
+
     /// Get the class id of a tag. If the returned class id is class_id_unknown, then it means that
     /// the value could not be determined and must be ignored! This will happen when the element is
     /// not in the cache or if it is a job. In such cases the database will not fetch the element or
@@ -111,6 +111,13 @@ class Transaction_wrapper : public Transaction
         store_for_reference_counting(tag, job, name, privacy_level, journal_type, store_level);
     }
 
+    void store_lazily_for_reference_counting(Tag tag, Element_factory* factory, const char* name,
+        Privacy_level privacy_level, Journal_type journal_type, Privacy_level store_level = 255)
+    {
+        m_transaction->store_lazily_for_reference_counting(
+            tag, factory, name, privacy_level, journal_type, store_level);
+    }
+
     Tag store_deferred(const char* name, Privacy_level privacy_level, Tag_set* references)
     {
         return m_transaction->store_deferred(name, privacy_level, references);
@@ -127,6 +134,9 @@ class Transaction_wrapper : public Transaction
 
     Tag name_to_tag(const char* name) { return m_transaction->name_to_tag(name); }
 
+    void name_to_tags(size_t count, const char* const* names, Tag* tags)
+    { m_transaction->name_to_tags(count, names, tags); }
+
     SERIAL::Class_id get_class_id(Tag tag) { return m_transaction->get_class_id(tag); }
 
     Tag_version get_tag_version(Tag tag) { return m_transaction->get_tag_version(tag); }
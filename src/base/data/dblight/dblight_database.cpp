@@ -61,6 +61,11 @@ Database_impl::~Database_impl()
         info->unpin();
     }
 
+    Deferred_element_map::iterator it     = m_deferred_elements.begin();
+    Deferred_element_map::iterator it_end = m_deferred_elements.end();
+    for ( ; it != it_end; ++it)
+        delete it->second.m_factory;
+
     m_global_scope->unpin();
 }
 
@@ -221,6 +226,19 @@ Uint32 Database_impl::get_tag_reference_count(DB::Tag tag)
     return m_reference_counts[tag];
 }
 
+bool Database_impl::wait_for_deferred_creation(DB::Tag tag, mi::base::Lock::Block& block)
+{
+    Deferred_element_map::const_iterator it = m_deferred_elements.find(tag);
+    if (it == m_deferred_elements.end() || !it->second.m_creation)
+        return false;
+
+    std::shared_ptr<Deferred_creation> creation = it->second.m_creation;
+    block.release();
+    creation->wait();
+    block.set(&m_lock);
+    return true;
+}
+
 void Database_impl::garbage_collection_internal()
 {
     mi::base::Lock::Block block(&m_lock);
@@ -237,9 +255,21 @@ void Database_impl::garbage_collection_internal()
 
             DB::Tag tag = *it;
 
+            // the factory might be dropped below, the maps might have changed while waiting
+            if (wait_for_deferred_creation(tag, block))
+                break;
+
             Tag_map::iterator it_info = m_tags.find(tag);
-            it_info->second->unpin();
-            m_tags.erase(it_info);
+            if (it_info != m_tags.end()) {
+                it_info->second->unpin();
+                m_tags.erase(it_info);
+            } else {
+                // the element was never accessed, drop its factory
+                Deferred_element_map::iterator it_deferred = m_deferred_elements.find(tag);
+                MI_ASSERT(it_deferred != m_deferred_elements.end());
+                delete it_deferred->second.m_factory;
+                m_deferred_elements.erase(it_deferred);
+            }
 
             Reverse_named_tag_map::iterator it_name = m_reverse_named_tags.find(tag);
             if( it_name != m_reverse_named_tags.end()) {
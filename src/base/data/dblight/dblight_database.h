@@ -37,14 +37,18 @@
 
 #include <base/data/db/i_db_database.h>
 
+#include <condition_variable>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <map>
+#include <unordered_map>
 #include <mi/base/atom.h>
 #include <mi/base/lock.h>
 
 namespace MI {
 
-namespace DB { class Info; }
+namespace DB { class Element_factory; class Info; }
 
 
 namespace DBLIGHT {
@@ -54,8 +58,52 @@ class Scope_impl;
 /// Map of tags to infos
 typedef std::map<DB::Tag, DB::Info*> Tag_map;
 
-/// Map of names (strings) to tags
-typedef std::map<std::string, DB::Tag> Named_tag_map;
+/// Guards the creation of a deferred element. Threads that need the factory of the element wait
+/// until the creation is done.
+class Deferred_creation
+{
+public:
+    Deferred_creation() : m_done(false) { }
+
+    /// Waits until the creation is done.
+    void wait()
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_condition.wait(lock, [this]() { return m_done; });
+    }
+
+    /// Marks the creation as done and wakes up all waiting threads.
+    void signal()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_done = true;
+        }
+        m_condition.notify_all();
+    }
+
+private:
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    bool m_done;
+};
+
+/// An element that has not been created yet
+struct Deferred_element
+{
+    Deferred_element() : m_factory(0) { }
+
+    /// The factory of the element
+    DB::Element_factory* m_factory;
+    /// Set while the factory creates the element
+    std::shared_ptr<Deferred_creation> m_creation;
+};
+
+/// Map of tags to the elements that have not been created yet
+typedef std::map<DB::Tag, Deferred_element> Deferred_element_map;
+
+/// Hash index of names (strings) to tags
+typedef std::unordered_map<std::string, DB::Tag> Named_tag_map;
 
 /// Map of tags to names (strings)
 typedef std::map<DB::Tag, std::string> Reverse_named_tag_map;
@@ -156,6 +204,14 @@ public:
     Reverse_named_tag_map& get_reverse_named_tag_map() { return m_reverse_named_tags; }
     /// Used by the transaction to track removal requests. Needs #m_lock.
     Flagged_for_removal_set& get_flagged_for_removal_set() { return m_tags_flagged_for_removal; }
+    /// Used by the transaction to access the deferred elements. Needs #m_lock. Removing or
+    /// replacing the factory of an entry needs a preceding wait_for_deferred_creation().
+    Deferred_element_map& get_deferred_element_map() { return m_deferred_elements; }
+
+    /// Waits until the deferred element with the given tag is no longer being created. The block
+    /// must hold #m_lock, which is released while waiting. Returns \c true if it waited; the
+    /// caller must look up the tag again then, and call this method again.
+    bool wait_for_deferred_creation(DB::Tag tag, mi::base::Lock::Block& block);
 
 
 private:
@@ -165,7 +221,7 @@ private:
     mi::base::Atom32 m_next_transaction_id;
 
 public:
-    /// The lock for the six containers below.
+    /// The lock for the seven containers below.
     mi::base::Lock m_lock;
 
 private:
@@ -181,6 +237,8 @@ private:
     Reference_count_map m_reference_counts;
     /// Holds the tags with reference count zero. Needs #m_lock.
     Reference_count_zero_set m_reference_count_zero;
+    /// Holds the factories of elements that have not been created yet. Needs #m_lock.
+    Deferred_element_map m_deferred_elements;
 
     /// The global scope is currently the only scope
     Scope_impl* m_global_scope;
@@ -145,13 +145,22 @@ void Transaction_impl::store(
 
     mi::base::Lock::Block block(&m_database->m_lock);
 
+    // a deferred element replaced below might be under construction
+    while (m_database->wait_for_deferred_creation(tag, block)) { }
+
     info->store_references();
 
     Tag_map::iterator it = m_database->get_tag_map().find(tag);
+    Deferred_element_map::iterator it_deferred = m_database->get_deferred_element_map().find(tag);
     if (it != m_database->get_tag_map().end()) {
          it->second->unpin();
          it->second = info;
          // leave self-reference as is
+    } else if (it_deferred != m_database->get_deferred_element_map().end()) {
+         // replaces an element that has not been created yet, leave self-reference as is
+         delete it_deferred->second.m_factory;
+         m_database->get_deferred_element_map().erase(it_deferred);
+         m_database->get_tag_map()[tag] = info;
     } else {
         m_database->get_tag_map()[tag] = info;
         m_database->increment_reference_count(tag);
@@ -208,6 +217,46 @@ void Transaction_impl::store_for_reference_counting(
     remove(tag,false);
 }
 
+void Transaction_impl::store_lazily_for_reference_counting(
+    DB::Tag tag,
+    DB::Element_factory* factory,
+    const char* name,
+    DB::Privacy_level privacy_level,
+    DB::Journal_type journal_type,
+    DB::Privacy_level store_level)
+{
+    if (!m_is_open) {
+        delete factory;
+        return;
+    }
+
+    mi::base::Lock::Block block(&m_database->m_lock);
+
+    // a factory replaced below might be creating its element
+    while (m_database->wait_for_deferred_creation(tag, block)) { }
+
+    MI_ASSERT(m_database->get_tag_map().find(tag) == m_database->get_tag_map().end());
+    Deferred_element_map::iterator it = m_database->get_deferred_element_map().find(tag);
+    if (it != m_database->get_deferred_element_map().end()) {
+        delete it->second.m_factory;
+        it->second.m_factory = factory;
+    } else {
+        m_database->get_deferred_element_map()[tag].m_factory = factory;
+        m_database->increment_reference_count(tag);
+    }
+
+    if (name) {
+         m_database->get_named_tag_map()[name] = tag;
+         m_database->get_reverse_named_tag_map()[tag] = name;
+    }
+
+    // same as remove(tag, false)
+    std::pair<Flagged_for_removal_set::iterator,bool> result
+        = m_database->get_flagged_for_removal_set().insert(tag);
+    if (result.second)
+        m_database->decrement_reference_count(tag);
+}
+
 DB::Tag Transaction_impl::store_for_reference_counting(
     SCHED::Job* job,
     const char* name,
@@ -282,11 +331,43 @@ DB::Tag Transaction_impl::name_to_tag(const char* name)
     return it->second;
 }
 
+void Transaction_impl::name_to_tags(size_t count, const char* const* names, DB::Tag* tags)
+{
+    if (!m_is_open) {
+        for (size_t i = 0; i < count; ++i)
+            tags[i] = DB::Tag();
+        return;
+    }
+
+    // resolve all names under a single lock acquisition
+    mi::base::Lock::Block block(&m_database->m_lock);
+    const Named_tag_map& named_tags = m_database->get_named_tag_map();
+    std::string name;
+    for (size_t i = 0; i < count; ++i) {
+        if (!names[i]) {
+            tags[i] = DB::Tag();
+            continue;
+        }
+        // reuse the buffer of the lookup key instead of constructing a string per name
+        name.assign(names[i]);
+        Named_tag_map::const_iterator it = named_tags.find(name);
+        tags[i] = it != named_tags.end() ? it->second : DB::Tag();
+    }
+}
+
 SERIAL::Class_id Transaction_impl::get_class_id(DB::Tag tag)
 {
     if (!m_is_open)
         return SERIAL::Class_id();
 
+    {
+        // avoid creating deferred elements just to query their class ID
+        mi::base::Lock::Block block(&m_database->m_lock);
+        Deferred_element_map::const_iterator it = m_database->get_deferred_element_map().find(tag);
+        if (it != m_database->get_deferred_element_map().end())
+            return it->second.m_factory->get_class_id();
+    }
+
     DB::Info* info = Transaction_impl::get_element(tag, true);
     SERIAL::Class_id class_id = info->get_element()->get_class_id();
     info->unpin();
@@ -394,8 +475,20 @@ DB::Info* Transaction_impl::edit_element(DB::Tag tag)
     mi::base::Lock::Block block(&m_database->m_lock);
 
     Tag_map::const_iterator it = m_database->get_tag_map().find(tag);
-    if (it == m_database->get_tag_map().end())
-         return 0;
+    if (it == m_database->get_tag_map().end()) {
+        const Deferred_element_map& deferred = m_database->get_deferred_element_map();
+        if (deferred.find(tag) == deferred.end())
+            return 0;
+        block.release();
+        DB::Info* info = create_deferred_element(tag);
+        if (!info)
+            return 0;
+        info->unpin();
+        block.set(&m_database->m_lock);
+        it = m_database->get_tag_map().find(tag);
+        if (it == m_database->get_tag_map().end())
+            return 0;
+    }
 
     DB::Info* old_info = it->second;
     DB::Element_base* new_element = old_info->get_element()->copy();
@@ -427,8 +520,13 @@ DB::Info* Transaction_impl::get_element(DB::Tag tag, bool do_wait)
     mi::base::Lock::Block block(&m_database->m_lock);
 
     Tag_map::const_iterator it = m_database->get_tag_map().find(tag);
-    if (it == m_database->get_tag_map().end())
-        return 0;
+    if (it == m_database->get_tag_map().end()) {
+        const Deferred_element_map& deferred = m_database->get_deferred_element_map();
+        if (deferred.find(tag) == deferred.end())
+            return 0;
+        block.release();
+        return create_deferred_element(tag);
+    }
 
     DB::Info* info = it->second;
     info->pin();
@@ -443,6 +541,64 @@ DB::Element_base* Transaction_impl::construct_empty_element(SERIAL::Class_id cla
 
 DB::Transaction* Transaction_impl::get_real_transaction() { return this; }
 
+DB::Info* Transaction_impl::create_deferred_element(DB::Tag tag)
+{
+    DB::Element_factory* factory = 0;
+    std::shared_ptr<Deferred_creation> creation;
+    {
+        mi::base::Lock::Block block(&m_database->m_lock);
+
+        // another thread might be creating the element, wait for it (a factory must not access
+        // its own element)
+        while (m_database->wait_for_deferred_creation(tag, block)) { }
+
+        // another thread might have created the element in the meantime
+        Tag_map::const_iterator it = m_database->get_tag_map().find(tag);
+        if (it != m_database->get_tag_map().end()) {
+            it->second->pin();
+            return it->second;
+        }
+
+        Deferred_element_map::iterator it_deferred
+            = m_database->get_deferred_element_map().find(tag);
+        if (it_deferred == m_database->get_deferred_element_map().end())
+            return 0;
+        factory = it_deferred->second.m_factory;
+        creation = std::make_shared<Deferred_creation>();
+        it_deferred->second.m_creation = creation;
+    }
+
+    // create the element without holding m_lock, the factory might access the database
+    DB::Element_base* element = factory->create_element(this, tag);
+    element->prepare_store(this, tag);
+
+    Uint32 version = m_next_sequence_number++;
+    DB::Info* info = new DB::Info(m_database, tag, this, DB::Scope_id(0), version, element);
+
+    {
+        mi::base::Lock::Block block(&m_database->m_lock);
+
+        // the factory can not have been removed in the meantime since removing it waits for
+        // the creation
+        Deferred_element_map::iterator it_deferred
+            = m_database->get_deferred_element_map().find(tag);
+        MI_ASSERT(it_deferred != m_database->get_deferred_element_map().end());
+        MI_ASSERT(it_deferred->second.m_factory == factory);
+        MI_ASSERT(m_database->get_tag_map().find(tag) == m_database->get_tag_map().end());
+
+        // the name and the reference count of the tag have already been set up when the factory
+        // was registered
+        info->store_references();
+        m_database->get_tag_map()[tag] = info;
+        m_database->get_deferred_element_map().erase(it_deferred);
+        info->pin();
+    }
+
+    delete factory;
+    creation->signal();
+    return info;
+}
+
 } // namespace DBLIGHT
 
 } // namespace MI
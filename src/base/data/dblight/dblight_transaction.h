@@ -110,6 +110,14 @@ public:
         DB::Journal_type journal_type,
         DB::Privacy_level store_level);
 
+    void store_lazily_for_reference_counting(
+        DB::Tag tag,
+        DB::Element_factory* factory,
+        const char* name,
+        DB::Privacy_level privacy_level,
+        DB::Journal_type journal_type,
+        DB::Privacy_level store_level);
+
     DB::Tag store_for_reference_counting(
         SCHED::Job* job,
         const char* name,
@@ -137,6 +145,8 @@ public:
 
     DB::Tag name_to_tag(const char* name);
 
+    void name_to_tags(size_t count, const char* const* names, DB::Tag* tags);
+
     SERIAL::Class_id get_class_id(DB::Tag tag);
 
     DB::Tag_version get_tag_version(DB::Tag tag);
@@ -200,6 +210,10 @@ public:
     Transaction* get_real_transaction();
 
 private:
+    /// Creates a deferred element and stores it under its tag. Returns \c NULL if the tag is not
+    /// known. Pins the return value.
+    DB::Info* create_deferred_element(DB::Tag tag);
+
     Database_impl* m_database;
     Scope_impl* m_scope;
     DB::Transaction_id m_id;
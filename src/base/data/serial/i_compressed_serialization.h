@@ -38,9 +38,69 @@
 namespace MI {
 namespace SERIAL {
 
+// The size in bytes of the independently compressed blocks of the block format.
+static const size_t COMPRESSION_BLOCK_SIZE = 1024 * 1024;
+
+// The largest block size of the block format. Larger block sizes are reduced to it when writing
+// and rejected when reading.
+static const size_t COMPRESSION_MAX_BLOCK_SIZE = 64 * 1024 * 1024;
+
+// Written instead of the element count to mark the block format. The former format started with
+// the element count and a single zlib stream, it can still be read.
+static const size_t COMPRESSION_BLOCK_MARKER = ~size_t(0);
+
+// Compress and serialize \p size bytes as a sequence of independently compressed blocks. The
+// blocks are compressed in parallel, a batch at a time, so the temporary buffer holds only a few
+// blocks per thread. Blocks that do not shrink are stored uncompressed.
+void compress_and_serialize_blocks(
+    SERIAL::Serializer* const serial,
+    const unsigned char* data,
+    size_t size,
+    std::vector<unsigned char>& temp_buffer,
+    int compression_level,
+    size_t block_size);
+
+// Deserialize the block size and block count written by compress_and_serialize_blocks() for
+// \p size bytes. Returns false if they do not match \p size or if the remaining input is too
+// short for \p size bytes, so no memory needs to be allocated for corrupted data.
+bool deserialize_blocks_header(
+    SERIAL::Deserializer* const deser,
+    size_t size,
+    size_t* block_size,
+    size_t* block_count);
+
+// Deserialize and decompress the blocks of \p size bytes written by
+// compress_and_serialize_blocks(), after deserialize_blocks_header() accepted their header. The
+// blocks are decompressed in parallel, a batch at a time. Returns false on corrupted data.
+bool deserialize_and_decompress_blocks(
+    SERIAL::Deserializer* const deser,
+    unsigned char* data,
+    size_t size,
+    size_t block_size,
+    size_t block_count,
+    std::vector<unsigned char>& temp_buffer);
+
+// Deserialize the size of the single zlib stream of the former format for \p size bytes. Returns
+// false if it does not fit the remaining input, cannot hold \p size bytes, or exceeds the sizes
+// zlib can handle in one call.
+bool deserialize_stream_header(
+    SERIAL::Deserializer* const deser,
+    size_t size,
+    size_t* compressed_size);
+
+// Deserialize and decompress \p size bytes from the single zlib stream of the former format,
+// after deserialize_stream_header() accepted its size. Returns false on corrupted data.
+bool deserialize_and_decompress_stream(
+    SERIAL::Deserializer* const deser,
+    unsigned char* data,
+    size_t size,
+    size_t compressed_size,
+    std::vector<unsigned char>& temp_buffer);
+
 // Compress and serialize a vector, overwriting (and possibly resizing)
-// the given temporary buffer. Returns false if the compression
-// failed (in which case nothing is serialized) and true otherwise.
+// the given temporary buffer. The data is written in blocks of \p block_size
+// bytes that are compressed in parallel. Blocks that fail to compress are
+// stored, so this always returns true.
 // Note that the \p data vector is treated as a chunk of memory,
 // i.e. no conversion is taking place.
 // See the zlib header regarding the compression level settings,
@@ -50,32 +110,23 @@ bool compress_and_serialize(
     SERIAL::Serializer* const serial,
     const std::vector<T>& data,
     std::vector<unsigned char>& temp_buffer,
-    const int compression_level = Z_BEST_SPEED)
+    const int compression_level = Z_BEST_SPEED,
+    const size_t block_size = COMPRESSION_BLOCK_SIZE)
 {
-    // make sure the result buffer is large enough
     const size_t data_size = data.size();
-    const uLong data_bytes = static_cast<uLong>(data_size * sizeof(T));
-    const uLong compress_bound = compressBound(data_bytes);
-    temp_buffer.resize(compress_bound);
-
-    // compress the data
-    uLong compressed_size = compress_bound;
-    if (compress2(reinterpret_cast<Byte*>(&temp_buffer[0]),
-                  &compressed_size, 
-                  reinterpret_cast<const Byte*>(&data[0]),
-                  data_bytes,
-                  compression_level) != Z_OK)
-    {
-        // compression failed
-        return false;
-    }
 
-    // serialize uncompressed data size
+    // serialize marker and uncompressed data size
+    serial->write_size_t(COMPRESSION_BLOCK_MARKER);
     serial->write_size_t(data_size);
 
-    // serialize compressed data
-    temp_buffer.resize(static_cast<size_t>(compressed_size));
-    SERIAL::write(serial, temp_buffer);
+    // serialize compressed blocks, blocks that fail to compress are stored
+    compress_and_serialize_blocks(
+        serial,
+        data_size > 0 ? reinterpret_cast<const unsigned char*>(&data[0]) : NULL,
+        data_size * sizeof(T),
+        temp_buffer,
+        compression_level,
+        block_size);
 
     return true;
 }
@@ -86,6 +137,7 @@ bool compress_and_serialize(
 // and true otherwise.
 // Note that the \p data vector is treated as a chunk of memory,
 // i.e. no conversion is taking place.
+// Reads both the block format and the former single-stream format.
 template <typename T>
 bool deserialize_and_decompress(
     SERIAL::Deserializer* const deser,
@@ -95,17 +147,43 @@ bool deserialize_and_decompress(
     // deserialize uncompressed data size
     size_t data_size = 0;
     deser->read_size_t(&data_size);
-    data.resize(data_size);
 
-    // deserialize compressed data
-    SERIAL::read(deser, &temp_buffer);
+    const bool is_block_format = data_size == COMPRESSION_BLOCK_MARKER;
+    if (is_block_format)
+        deser->read_size_t(&data_size);
+
+    // the sizes are validated before the data is allocated
+    if (!deser->is_valid() || data_size > ~size_t(0) / sizeof(T))
+        return false;
+    const size_t size = data_size * sizeof(T);
+
+    if (is_block_format) {
+        size_t block_size = 0;
+        size_t block_count = 0;
+        if (!deserialize_blocks_header(deser, size, &block_size, &block_count))
+            return false;
+
+        data.resize(data_size);
+        return deserialize_and_decompress_blocks(
+            deser,
+            data_size > 0 ? reinterpret_cast<unsigned char*>(&data[0]) : NULL,
+            size,
+            block_size,
+            block_count,
+            temp_buffer);
+    }
+
+    size_t compressed_size = 0;
+    if (!deserialize_stream_header(deser, size, &compressed_size))
+        return false;
 
-    // decompress the data
-    uLong dest_len(data_size * sizeof(T));
-    return uncompress(reinterpret_cast<Byte*>(&data[0]),
-                      &dest_len,
-                      reinterpret_cast<const Byte*>(&temp_buffer[0]),
-                      static_cast<uLong>(temp_buffer.size())) == Z_OK;
+    data.resize(data_size);
+    return deserialize_and_decompress_stream(
+        deser,
+        data_size > 0 ? reinterpret_cast<unsigned char*>(&data[0]) : NULL,
+        size,
+        compressed_size,
+        temp_buffer);
 }
 
 } // namespace SERIAL
@@ -44,9 +44,13 @@
 
 #include "serial.h"
 
+#include <vector>
+
 namespace MI
 {
 
+namespace DISK { class IFile; }
+
 namespace SERIAL
 {
 
@@ -136,6 +140,8 @@ public:
 
     bool is_valid() const;
 
+    size_t get_remaining_size();
+
 protected:
 
     // Read back various value types
@@ -151,6 +157,124 @@ private:
     bool m_valid;
 };
 
+// A contiguous piece of serialized data. The layout matches struct iovec on POSIX systems (checked
+// in serial_buffer_serializer.cpp), so an array of chunks can be handed to writev() as is.
+struct Buffer_chunk
+{
+    Uint8* data;					// the data of the chunk
+    size_t size;					// the number of used bytes
+};
+
+// A serializer writing to a list of chunks. Written data is never moved: when the current chunk
+// is full, a new one is appended. Serializing large elements therefore neither copies data
+// written so far nor needs twice the serialized size while growing.
+class Chunked_buffer_serializer : public Serializer_impl
+{
+public:
+    // Constructor
+    explicit Chunked_buffer_serializer(
+	size_t min_chunk_size = 64 * 1024);		// size of the first chunk
+
+    // Destructor
+    ~Chunked_buffer_serializer();
+
+    // Reset it so that it can be reused
+    void reset();
+
+    // Get the number of serialized bytes
+    size_t get_buffer_size() const;
+
+    // Get the number of chunks holding the serialized data
+    size_t get_chunk_count() const;
+
+    // Get the chunks holding the serialized data, in order
+    const Buffer_chunk* get_chunks() const;
+
+    // Copy the serialized data into a contiguous buffer of get_buffer_size() bytes
+    void copy_to(
+	Uint8* buffer) const;				// the destination
+
+    // Write the serialized data to a file, returns false on error
+    bool write_to(
+	DISK::IFile* file) const;			// the destination, opened for writing
+
+    using Serializer_impl::write;
+
+    // Give a hint to the serializer that the given number of bytes
+    // are written to the serializer soon. They will be stored in one chunk.
+    void reserve(
+	size_t size);
+
+protected:
+    // Write out various value types
+    void write_impl(
+	const char* buffer,				// read data from here
+	size_t size);					// write this amount of data
+
+private:
+    std::vector<Buffer_chunk> m_chunks;			// the chunks, with their used sizes
+    std::vector<size_t> m_capacities;			// the allocated sizes of the chunks
+    size_t m_min_chunk_size;				// the size of the first chunk
+    size_t m_written_size;				// the number of serialized bytes
+
+    // append a chunk with at least the given number of bytes
+    void add_chunk(
+	size_t needed_size);				// the needed size
+};
+
+// The Deserializer reading from a list of chunks as produced by Chunked_buffer_serializer.
+// Values may span chunk boundaries.
+class Chunked_buffer_deserializer : public Deserializer_impl
+{
+public:
+    using Deserializer_impl::deserialize;
+
+    // See Buffer_deserializer for the need of a Deserialization_manager.
+    explicit Chunked_buffer_deserializer(
+	Deserialization_manager* manager = NULL);	// the set of registered classes
+
+    // Destructor
+    ~Chunked_buffer_deserializer();
+
+    // Set the deserializer to use the given chunks for input
+    void reset(
+	const Buffer_chunk* chunks,			// the chunks, not copied
+	size_t chunk_count);				// the number of chunks
+
+    // Deserialize from a list of chunks
+    Serializable* deserialize(
+	const Buffer_chunk* chunks,			// chunks storing the serialized data
+	size_t chunk_count);				// the number of chunks
+
+    // Deserialize a given object from a list of chunks
+    void deserialize(
+	Serializable* serializable,			// deserialize to here
+	const Buffer_chunk* chunks,			// chunks storing the serialized data
+	size_t chunk_count);				// the number of chunks
+
+    using Deserializer_impl::read;
+
+    bool is_valid() const;
+
+    size_t get_remaining_size();
+
+protected:
+    // Read back various value types
+    void read_impl(
+	char* buffer,					// destination for writing data
+	size_t size);					// number of bytes to read
+
+private:
+    const Buffer_chunk* m_chunks;			// read the data from here
+    size_t m_chunk_count;				// the number of chunks
+    size_t m_chunk;					// the chunk to be read next
+    size_t m_offset;					// the next byte within that chunk
+    bool m_valid;
+
+    // check that all data was consumed
+    bool at_end() const;
+};
+
 } // namespace SERIAL
 
 } // namespace MI
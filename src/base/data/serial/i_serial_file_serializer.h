@@ -207,6 +207,10 @@ public:
     /// no error.
     bool is_valid() const;
 
+    /// Get the number of bytes up to the end of the file.
+    /// \return the remaining size, or ~size_t(0) if it is unknown.
+    size_t get_remaining_size();
+
     /// Deserialize from a file
     /// \return newed deserialized object.
     ///
@@ -390,6 +390,11 @@ public:
     /// Check if we can keep on reading from this deserializer.
     virtual bool is_valid() const = 0;
 
+    /// Returns the number of bytes that can still be read, or ~size_t(0) if it is unknown.
+    ///
+    /// Used to reject corrupted sizes before allocating memory for them.
+    virtual size_t get_remaining_size() = 0;
+
     /// Install handler for deserialization error.
     virtual void set_error_handler(IDeserializer_error_handler<>* handler) = 0;
 };
@@ -199,6 +199,9 @@ public:
 
     void set_error_handler(IDeserializer_error_handler<>* handler);
 
+    /// The remaining size is unknown unless overridden by the derived classes.
+    virtual size_t get_remaining_size() { return ~size_t(0); }
+
 protected:
     // This is meant to be called from the database or similar modules only! It will clear the map
     // of shared objects.
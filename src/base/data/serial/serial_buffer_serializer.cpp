@@ -43,9 +43,16 @@
 
 #include <base/lib/mem/i_mem_allocatable.h>
 #include <base/lib/log/log.h>
+#include <base/hal/disk/disk.h>
 
 #include "i_serial_buffer_serializer.h"
 
+#include <algorithm>
+#include <cstddef>
+
+#ifndef MI_PLATFORM_WINDOWS
+#include <sys/uio.h>
+#endif
 
 namespace MI
 {
@@ -53,6 +60,16 @@ namespace MI
 namespace SERIAL
 {
 
+#ifndef MI_PLATFORM_WINDOWS
+// Arrays of chunks may be handed to writev() as arrays of struct iovec.
+static_assert(sizeof(Buffer_chunk) == sizeof(struct iovec),
+    "Buffer_chunk and struct iovec differ in size");
+static_assert(offsetof(Buffer_chunk, data) == offsetof(struct iovec, iov_base),
+    "Buffer_chunk::data and iovec::iov_base differ in offset");
+static_assert(offsetof(Buffer_chunk, size) == offsetof(struct iovec, iov_len),
+    "Buffer_chunk::size and iovec::iov_len differ in offset");
+#endif
+
 // Constructor
 Buffer_serializer::Buffer_serializer()
 {
@@ -237,6 +254,253 @@ bool Buffer_deserializer::is_valid() const
     return m_valid;
 }
 
+size_t Buffer_deserializer::get_remaining_size()
+{
+    return m_buffer_size - (m_read_pointer - m_buffer);
+}
+
+// Chunks grow with the serialized size up to this limit, so the unused tail of the last chunk
+// stays small compared to the data.
+static const size_t max_chunk_growth = 64 * 1024 * 1024;
+
+// Constructor
+Chunked_buffer_serializer::Chunked_buffer_serializer(
+    size_t min_chunk_size)				// size of the first chunk
+    : m_min_chunk_size(min_chunk_size > 0 ? min_chunk_size : 1),
+      m_written_size(0)
+{
+}
+
+// Destructor
+Chunked_buffer_serializer::~Chunked_buffer_serializer()
+{
+    for (size_t i = 0; i < m_chunks.size(); ++i)
+    MEM::delete_array<Uint8>(m_chunks[i].data);
+}
+
+// Reset it so that it can be reused
+void Chunked_buffer_serializer::reset()
+{
+    for (size_t i = 0; i < m_chunks.size(); ++i)
+    MEM::delete_array<Uint8>(m_chunks[i].data);
+    m_chunks.clear();
+    m_capacities.clear();
+    m_written_size = 0;
+    clear_shared_objects();
+}
+
+// Get the number of serialized bytes
+size_t Chunked_buffer_serializer::get_buffer_size() const
+{
+    return m_written_size;
+}
+
+// Get the number of chunks holding the serialized data
+size_t Chunked_buffer_serializer::get_chunk_count() const
+{
+    return m_chunks.size();
+}
+
+// Get the chunks holding the serialized data
+const Buffer_chunk* Chunked_buffer_serializer::get_chunks() const
+{
+    return m_chunks.empty() ? NULL : &m_chunks[0];
+}
+
+// Copy the serialized data into a contiguous buffer
+void Chunked_buffer_serializer::copy_to(
+    Uint8* buffer) const				// the destination
+{
+    for (size_t i = 0; i < m_chunks.size(); ++i)
+    {
+    memcpy(buffer, m_chunks[i].data, m_chunks[i].size);
+    buffer += m_chunks[i].size;
+    }
+}
+
+// Write the serialized data to a file
+bool Chunked_buffer_serializer::write_to(
+    DISK::IFile* file) const				// the destination
+{
+    for (size_t i = 0; i < m_chunks.size(); ++i)
+    {
+    const Buffer_chunk& chunk = m_chunks[i];
+    if (chunk.size > 0 &&
+        file->write(reinterpret_cast<const char*>(chunk.data), chunk.size) != Sint64(chunk.size))
+        return false;
+    }
+    return true;
+}
+
+// append a chunk with at least the given number of bytes
+void Chunked_buffer_serializer::add_chunk(
+    size_t needed_size)					// the needed size
+{
+    size_t capacity = std::max(m_min_chunk_size, std::min(m_written_size, max_chunk_growth));
+    capacity = std::max(capacity, needed_size);
+
+    Buffer_chunk chunk;
+    chunk.data = MEM::new_array<Uint8>(capacity);
+    chunk.size = 0;
+    m_chunks.push_back(chunk);
+    m_capacities.push_back(capacity);
+}
+
+// Write out various value types
+void Chunked_buffer_serializer::write_impl(
+    const char* buffer,					// read data from here
+    size_t size)					// write this amount of data
+{
+    while (size > 0)
+    {
+    if (m_chunks.empty() || m_chunks.back().size == m_capacities.back())
+        add_chunk(size);
+
+    Buffer_chunk& chunk = m_chunks.back();
+    size_t count = std::min(size, m_capacities.back() - chunk.size);
+    memcpy(chunk.data + chunk.size, buffer, count);
+    chunk.size += count;
+    m_written_size += count;
+    buffer += count;
+    size -= count;
+    }
+}
+
+void Chunked_buffer_serializer::reserve(
+    size_t needed_size)
+{
+    if (m_chunks.empty() || m_capacities.back() - m_chunks.back().size < needed_size)
+    add_chunk(needed_size);
+}
+
+// Constructor
+Chunked_buffer_deserializer::Chunked_buffer_deserializer(
+    Deserialization_manager*	manager) 		// the deserialization manager
+    : Deserializer_impl(manager),
+      m_chunks(NULL),
+      m_chunk_count(0),
+      m_chunk(0),
+      m_offset(0),
+      m_valid(true)
+{
+}
+
+// Destructor
+Chunked_buffer_deserializer::~Chunked_buffer_deserializer()
+{
+}
+
+// Set the deserializer to use the given chunks for input
+void Chunked_buffer_deserializer::reset(
+    const Buffer_chunk* chunks,				// the chunks
+    size_t chunk_count)					// the number of chunks
+{
+    m_chunks = chunks;
+    m_chunk_count = chunk_count;
+    m_chunk = 0;
+    m_offset = 0;
+    m_valid = true;
+    clear_shared_objects();
+}
+
+// check that all data was consumed
+bool Chunked_buffer_deserializer::at_end() const
+{
+    if (m_chunk < m_chunk_count && m_offset < m_chunks[m_chunk].size)
+    return false;
+    for (size_t i = m_chunk + 1; i < m_chunk_count; ++i)
+    if (m_chunks[i].size > 0)
+        return false;
+    return true;
+}
+
+// Deserialize from a list of chunks
+Serializable* Chunked_buffer_deserializer::deserialize(
+    const Buffer_chunk* chunks,				// chunks storing the serialized data
+    size_t chunk_count)					// the number of chunks
+{
+    m_chunks = chunks;
+    m_chunk_count = chunk_count;
+    m_chunk = 0;
+    m_offset = 0;
+
+    Serializable* serializable = Deserializer_impl::deserialize();
+
+    if (at_end())
+    {
+    clear_shared_objects();
+    return serializable;
+    }
+
+    abort();
+    return NULL;
+}
+
+// Deserialize a given object from a list of chunks
+void Chunked_buffer_deserializer::deserialize(
+    Serializable* serializable,				// deserialize to here
+    const Buffer_chunk* chunks,				// chunks storing the serialized data
+    size_t chunk_count)					// the number of chunks
+{
+    m_chunks = chunks;
+    m_chunk_count = chunk_count;
+    m_chunk = 0;
+    m_offset = 0;
+
+    serializable->deserialize(this);
+
+    if (at_end())
+    {
+    clear_shared_objects();
+    return;
+    }
+
+    abort();
+}
+
+// Read back various value types, possibly spanning several chunks
+void Chunked_buffer_deserializer::read_impl(
+    char* buffer,					// destination for writing data
+    size_t size)					// number of bytes to read
+{
+    while (size > 0)
+    {
+    if (m_chunk >= m_chunk_count)
+    {
+        m_valid = false;
+        LOG::mod_log->warning(M_SERIAL, LOG::Mod_log::C_MISC, 1, "Chunked buffer deserializer: "
+                            "reading beyond end of buffer");
+        return;
+    }
+
+    const Buffer_chunk& chunk = m_chunks[m_chunk];
+    size_t count = std::min(size, chunk.size - m_offset);
+    memcpy(buffer, chunk.data + m_offset, count);
+    buffer += count;
+    size -= count;
+    m_offset += count;
+
+    if (m_offset == chunk.size)
+    {
+        ++m_chunk;
+        m_offset = 0;
+    }
+    }
+}
+
+bool Chunked_buffer_deserializer::is_valid() const
+{
+    return m_valid;
+}
+
+size_t Chunked_buffer_deserializer::get_remaining_size()
+{
+    size_t size = 0;
+    for (size_t i = m_chunk; i < m_chunk_count; ++i)
+    size += m_chunks[i].size;
+    return m_chunk < m_chunk_count ? size - m_offset : 0;
+}
+
 } // namespace DB
 
 } // namespace MI
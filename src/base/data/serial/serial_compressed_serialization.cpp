@@ -0,0 +1,278 @@
+/***************************************************************************************************
+ * Copyright (c) 2007-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************************************/
+
+/// \file
+/// \brief Block-parallel (de)compression for compressed serialization.
+
+#include "pch.h"
+
+#include "i_compressed_serialization.h"
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+#include <base/system/stlext/i_stlext_thread_budget.h>
+
+namespace MI {
+namespace SERIAL {
+
+namespace {
+
+// Block compression methods.
+const Uint8 BLOCK_STORED = 0;
+const Uint8 BLOCK_DEFLATED = 1;
+
+// The number of blocks processed per thread and batch.
+const size_t BLOCKS_PER_THREAD = 2;
+
+// The serialized size of the method and size preceding each block.
+const size_t BLOCK_HEADER_SIZE = sizeof(Uint8) + sizeof(Uint64);
+
+// The maximum compression ratio of deflate. Corrupted sizes that cannot be decompressed from the
+// remaining input are rejected based on it.
+const size_t MAX_DEFLATE_RATIO = 1032;
+
+// Returns true if \p size can be passed to zlib, which uses uLong sizes. uLong has only 32 bits
+// on LLP64 platforms.
+bool fits_ulong(size_t size)
+{
+    return static_cast<size_t>(static_cast<uLong>(size)) == size;
+}
+
+// Returns the maximum number of threads to use for the given number of blocks. The batches are
+// sized for it, although STLEXT::parallel_for() may get fewer workers from the thread budget.
+size_t get_thread_count(size_t block_count)
+{
+    size_t n_threads = std::thread::hardware_concurrency();
+    if (n_threads == 0)
+        n_threads = 1;
+    return std::max<size_t>(1, std::min(n_threads, block_count));
+}
+
+} // namespace
+
+void compress_and_serialize_blocks(
+    SERIAL::Serializer* const serial,
+    const unsigned char* data,
+    size_t size,
+    std::vector<unsigned char>& temp_buffer,
+    int compression_level,
+    size_t block_size)
+{
+    if (block_size == 0)
+        block_size = COMPRESSION_BLOCK_SIZE;
+    block_size = std::min(block_size, COMPRESSION_MAX_BLOCK_SIZE);
+    const size_t block_count = (size + block_size - 1) / block_size;
+
+    serial->write_size_t(block_size);
+    serial->write_size_t(block_count);
+
+    // every block of a batch is compressed into its own slot of the temporary buffer
+    const size_t n_threads = get_thread_count(block_count);
+    const size_t batch_size = n_threads * BLOCKS_PER_THREAD;
+    const size_t slot_size = compressBound(static_cast<uLong>(block_size));
+    temp_buffer.resize(std::min(batch_size, block_count) * slot_size);
+    std::vector<size_t> compressed_sizes(batch_size);
+
+    for (size_t first = 0; first < block_count; first += batch_size) {
+        const size_t n = std::min(batch_size, block_count - first);
+
+        STLEXT::parallel_for(n, [&](size_t i) {
+            const size_t offset = (first + i) * block_size;
+            const size_t length = std::min(block_size, size - offset);
+
+            uLong compressed_size = static_cast<uLong>(slot_size);
+            if (compress2(reinterpret_cast<Byte*>(&temp_buffer[i * slot_size]),
+                          &compressed_size,
+                          reinterpret_cast<const Byte*>(data + offset),
+                          static_cast<uLong>(length),
+                          compression_level) != Z_OK ||
+                compressed_size >= length)
+            {
+                // store blocks that do not shrink
+                compressed_sizes[i] = 0;
+            }
+            else
+                compressed_sizes[i] = compressed_size;
+        }, n_threads);
+
+        for (size_t i = 0; i < n; ++i) {
+            const size_t offset = (first + i) * block_size;
+            const size_t length = std::min(block_size, size - offset);
+
+            if (compressed_sizes[i] == 0) {
+                serial->write(BLOCK_STORED);
+                serial->write_size_t(length);
+                serial->write(reinterpret_cast<const Uint8*>(data + offset), length);
+            } else {
+                serial->write(BLOCK_DEFLATED);
+                serial->write_size_t(compressed_sizes[i]);
+                serial->write(
+                    reinterpret_cast<const Uint8*>(&temp_buffer[i * slot_size]),
+                    compressed_sizes[i]);
+            }
+        }
+    }
+}
+
+bool deserialize_blocks_header(
+    SERIAL::Deserializer* const deser,
+    size_t size,
+    size_t* block_size,
+    size_t* block_count)
+{
+    deser->read_size_t(block_size);
+    deser->read_size_t(block_count);
+    if (!deser->is_valid())
+        return false;
+
+    if (*block_size == 0 || *block_size > COMPRESSION_MAX_BLOCK_SIZE)
+        return false;
+    if (*block_count != size / *block_size + (size % *block_size != 0 ? 1 : 0))
+        return false;
+
+    // every block needs its header, and deflate cannot shrink the data arbitrarily
+    const size_t remaining = deser->get_remaining_size();
+    if (*block_count > remaining / BLOCK_HEADER_SIZE)
+        return false;
+    if (size / MAX_DEFLATE_RATIO > remaining - *block_count * BLOCK_HEADER_SIZE)
+        return false;
+    return true;
+}
+
+bool deserialize_and_decompress_blocks(
+    SERIAL::Deserializer* const deser,
+    unsigned char* data,
+    size_t size,
+    size_t block_size,
+    size_t block_count,
+    std::vector<unsigned char>& temp_buffer)
+{
+    // deflated blocks of a batch are read into slots of the temporary buffer, stored blocks
+    // directly into the destination
+    const size_t n_threads = get_thread_count(block_count);
+    const size_t batch_size = n_threads * BLOCKS_PER_THREAD;
+    const size_t slot_size = compressBound(static_cast<uLong>(block_size));
+    temp_buffer.resize(std::min(batch_size, block_count) * slot_size);
+    std::vector<size_t> compressed_sizes(batch_size);
+
+    std::atomic<bool> success(true);
+    for (size_t first = 0; first < block_count; first += batch_size) {
+        const size_t n = std::min(batch_size, block_count - first);
+
+        for (size_t i = 0; i < n; ++i) {
+            const size_t offset = (first + i) * block_size;
+            const size_t length = std::min(block_size, size - offset);
+
+            Uint8 method = BLOCK_STORED;
+            size_t stored_size = 0;
+            deser->read(&method);
+            deser->read_size_t(&stored_size);
+            if (!deser->is_valid() || stored_size > deser->get_remaining_size())
+                return false;
+
+            if (method == BLOCK_STORED) {
+                if (stored_size != length)
+                    return false;
+                deser->read(reinterpret_cast<Uint8*>(data + offset), length);
+                compressed_sizes[i] = 0;
+            } else {
+                if (method != BLOCK_DEFLATED || stored_size == 0 || stored_size > slot_size)
+                    return false;
+                deser->read(reinterpret_cast<Uint8*>(&temp_buffer[i * slot_size]), stored_size);
+                compressed_sizes[i] = stored_size;
+            }
+            if (!deser->is_valid())
+                return false;
+        }
+
+        STLEXT::parallel_for(n, [&](size_t i) {
+            if (compressed_sizes[i] == 0)
+                return;
+
+            const size_t offset = (first + i) * block_size;
+            const size_t length = std::min(block_size, size - offset);
+
+            uLong dest_len = static_cast<uLong>(length);
+            if (uncompress(reinterpret_cast<Byte*>(data + offset),
+                           &dest_len,
+                           reinterpret_cast<const Byte*>(&temp_buffer[i * slot_size]),
+                           static_cast<uLong>(compressed_sizes[i])) != Z_OK ||
+                dest_len != length)
+            {
+                success = false;
+            }
+        }, n_threads);
+
+        if (!success)
+            return false;
+    }
+    return true;
+}
+
+bool deserialize_stream_header(
+    SERIAL::Deserializer* const deser,
+    size_t size,
+    size_t* compressed_size)
+{
+    deser->read_size_t(compressed_size);
+    if (!deser->is_valid())
+        return false;
+
+    if (*compressed_size == 0 || *compressed_size > deser->get_remaining_size())
+        return false;
+    if (size / MAX_DEFLATE_RATIO > *compressed_size)
+        return false;
+    return fits_ulong(size) && fits_ulong(*compressed_size);
+}
+
+bool deserialize_and_decompress_stream(
+    SERIAL::Deserializer* const deser,
+    unsigned char* data,
+    size_t size,
+    size_t compressed_size,
+    std::vector<unsigned char>& temp_buffer)
+{
+    temp_buffer.resize(compressed_size);
+    deser->read(reinterpret_cast<Uint8*>(&temp_buffer[0]), compressed_size);
+    if (!deser->is_valid())
+        return false;
+
+    // zlib needs a destination even for empty data
+    Byte empty = 0;
+    uLong dest_len = static_cast<uLong>(size);
+    return uncompress(data != NULL ? reinterpret_cast<Byte*>(data) : &empty,
+                      &dest_len,
+                      reinterpret_cast<const Byte*>(&temp_buffer[0]),
+                      static_cast<uLong>(compressed_size)) == Z_OK &&
+        dest_len == size;
+}
+
+} // namespace SERIAL
+} // namespace MI
@@ -184,6 +184,22 @@ bool File_deserializer::is_valid() const
     return m_is_valid;
 }
 
+//----------------------------------------------------------------------
+// get the number of bytes up to the end of the file
+size_t File_deserializer::get_remaining_size()
+{
+    if(!this->is_file_valid(m_p_file)){
+        return 0;
+    }
+
+    const Sint64 size     = m_p_file->filesize();
+    const Sint64 position = m_p_file->tell();
+    if(size < 0 || position < 0 || position > size){
+        return ~size_t(0);
+    }
+    return static_cast<size_t>(size - position);
+}
+
 //----------------------------------------------------------------------
 // Deserialize from a buffer of known size
 // Note: The reason why this method name is not deserialize, see
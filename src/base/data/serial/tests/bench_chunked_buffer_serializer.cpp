@@ -0,0 +1,138 @@
+/***************************************************************************************************
+ * Copyright (c) 2007-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************************************/
+/// \file
+/// \brief Benchmark of the chunked buffer serializer against the contiguous one.
+///
+/// Usage: base-data-serial-chunked-benchmark [<payload size in MiB>]
+///
+/// Serializes the payload once in large array writes and once in small values, and reports the
+/// time spent writing with both serializers and reading back with the matching deserializer.
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include <base/data/serial/i_serial_buffer_serializer.h>
+#include <base/lib/log/i_log_logger.h>
+
+// The benchmark never reads beyond the end of a buffer, so nothing is logged.
+namespace MI { namespace LOG { ILogger* mod_log = 0; } }
+
+using namespace MI;
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+double seconds_since( Clock::time_point start)
+{
+    return std::chrono::duration<double>( Clock::now() - start).count();
+}
+
+// Writes \p size bytes, either as arrays of 64 KiB or as single 64-bit values.
+void write_payload( SERIAL::Serializer* serializer, size_t size, bool arrays)
+{
+    if( arrays) {
+        std::vector<Uint8> block( 64 * 1024, Uint8( 0x5a));
+        for( size_t written = 0; written < size; written += block.size())
+            serializer->write( block.data(), block.size());
+    } else {
+        for( size_t written = 0; written < size; written += sizeof( Uint64))
+            serializer->write( Uint64( written));
+    }
+}
+
+// Reads back the payload written by write_payload().
+bool read_payload( SERIAL::Deserializer* deserializer, size_t size, bool arrays)
+{
+    if( arrays) {
+        std::vector<Uint8> block( 64 * 1024);
+        for( size_t read = 0; read < size; read += block.size())
+            deserializer->read( block.data(), block.size());
+    } else {
+        Uint64 value = 0;
+        for( size_t read = 0; read < size; read += sizeof( Uint64))
+            deserializer->read( &value);
+    }
+    return deserializer->is_valid();
+}
+
+void run( size_t size, bool arrays)
+{
+    printf( "%s, %lu MiB:\n", arrays ? "64 KiB arrays" : "64-bit values",
+        static_cast<unsigned long>( size >> 20));
+
+    {
+        Clock::time_point start = Clock::now();
+        SERIAL::Buffer_serializer serializer;
+        write_payload( &serializer, size, arrays);
+        double write_time = seconds_since( start);
+
+        start = Clock::now();
+        SERIAL::Buffer_deserializer deserializer;
+        deserializer.reset( serializer.get_buffer(), serializer.get_buffer_size());
+        bool valid = read_payload( &deserializer, size, arrays);
+        double read_time = seconds_since( start);
+
+        printf( "  contiguous: write %8.1f ms, read %8.1f ms%s\n",
+            write_time * 1e3, read_time * 1e3, valid ? "" : " (read failed)");
+    }
+    {
+        Clock::time_point start = Clock::now();
+        SERIAL::Chunked_buffer_serializer serializer;
+        write_payload( &serializer, size, arrays);
+        double write_time = seconds_since( start);
+
+        start = Clock::now();
+        SERIAL::Chunked_buffer_deserializer deserializer;
+        deserializer.reset( serializer.get_chunks(), serializer.get_chunk_count());
+        bool valid = read_payload( &deserializer, size, arrays);
+        double read_time = seconds_since( start);
+
+        printf( "  chunked:    write %8.1f ms, read %8.1f ms, %lu chunks%s\n",
+            write_time * 1e3, read_time * 1e3,
+            static_cast<unsigned long>( serializer.get_chunk_count()),
+            valid ? "" : " (read failed)");
+    }
+}
+
+}
+
+int main( int argc, char* argv[])
+{
+    size_t size_mib = argc > 1 ? strtoul( argv[1], 0, 10) : 512;
+    if( size_mib == 0) {
+        fprintf( stderr, "Usage: %s [<payload size in MiB>]\n", argv[0]);
+        return 1;
+    }
+
+    run( size_mib << 20, true);
+    run( size_mib << 20, false);
+    return 0;
+}
@@ -0,0 +1,117 @@
+/***************************************************************************************************
+ * Copyright (c) 2007-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************************************/
+/// \file
+/// \brief Benchmark of the compressed serialization of vectors for different block sizes.
+///
+/// Usage: base-data-serial-compressed-benchmark [<payload size in MiB>]
+///
+/// Serializes a partially compressible payload with the default block size, which compresses
+/// the blocks in parallel, and with a single block of the maximum size, which compresses the
+/// payload on one thread. Reports the write and read times and the compressed size.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include <base/data/serial/i_compressed_serialization.h>
+#include <base/data/serial/i_serial_buffer_serializer.h>
+#include <base/lib/log/i_log_logger.h>
+
+// The benchmark never reads beyond the end of a buffer, so nothing is logged.
+namespace MI { namespace LOG { ILogger* mod_log = 0; } }
+
+using namespace MI;
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+double seconds_since( Clock::time_point start)
+{
+    return std::chrono::duration<double>( Clock::now() - start).count();
+}
+
+// Returns \p count values in runs of random length, similar to the index and attribute
+// arrays of meshes.
+std::vector<Uint32> payload( size_t count)
+{
+    std::vector<Uint32> data( count);
+    Uint32 state = 12345u;
+    for( size_t i = 0; i < count; ) {
+        state = state * 1664525u + 1013904223u;
+        const size_t run = std::min<size_t>( 1 + (state >> 28), count - i);
+        for( size_t j = 0; j < run; ++j)
+            data[i++] = state >> 8;
+    }
+    return data;
+}
+
+void run( const std::vector<Uint32>& data, size_t block_size, const char* name)
+{
+    std::vector<unsigned char> temp_buffer;
+
+    Clock::time_point start = Clock::now();
+    SERIAL::Buffer_serializer serializer;
+    SERIAL::compress_and_serialize( &serializer, data, temp_buffer, Z_BEST_SPEED, block_size);
+    double write_time = seconds_since( start);
+
+    start = Clock::now();
+    SERIAL::Buffer_deserializer deserializer;
+    deserializer.reset( serializer.get_buffer(), serializer.get_buffer_size());
+    std::vector<Uint32> result;
+    bool valid = SERIAL::deserialize_and_decompress( &deserializer, result, temp_buffer)
+        && result == data;
+    double read_time = seconds_since( start);
+
+    printf( "  %-14s write %8.1f ms, read %8.1f ms, %lu KiB%s\n", name,
+        write_time * 1e3, read_time * 1e3,
+        static_cast<unsigned long>( serializer.get_buffer_size() >> 10),
+        valid ? "" : " (read failed)");
+}
+
+}
+
+int main( int argc, char* argv[])
+{
+    size_t size_mib = argc > 1 ? strtoul( argv[1], 0, 10) : 64;
+    if( size_mib == 0) {
+        fprintf( stderr, "Usage: %s [<payload size in MiB>]\n", argv[0]);
+        return 1;
+    }
+
+    // a single block holds at most COMPRESSION_MAX_BLOCK_SIZE bytes
+    size_mib = std::min( size_mib, SERIAL::COMPRESSION_MAX_BLOCK_SIZE >> 20);
+    const std::vector<Uint32> data = payload( (size_mib << 20) / sizeof( Uint32));
+
+    printf( "%lu MiB:\n", static_cast<unsigned long>( size_mib));
+    run( data, SERIAL::COMPRESSION_BLOCK_SIZE, "1 MiB blocks:");
+    run( data, SERIAL::COMPRESSION_MAX_BLOCK_SIZE, "single block:");
+    return 0;
+}
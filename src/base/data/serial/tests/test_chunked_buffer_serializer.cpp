@@ -0,0 +1,162 @@
+/***************************************************************************************************
+ * Copyright (c) 2007-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************************************/
+
+/// \file
+/// \brief Round-trip tests for the chunked buffer serializer and deserializer.
+
+#include <base/system/test/i_test_auto_driver.h>
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <base/data/serial/i_compressed_serialization.h>
+#include <base/data/serial/i_serial_buffer_serializer.h>
+#include <base/lib/log/i_log_logger.h>
+
+// The tests never read beyond the end of a buffer, so nothing is logged.
+namespace MI { namespace LOG { ILogger* mod_log = 0; } }
+
+using namespace MI;
+
+namespace {
+
+// Writes values of different sizes, such that many of them span chunk boundaries.
+void write_values( SERIAL::Serializer* serializer, size_t count)
+{
+    for( size_t i = 0; i < count; ++i) {
+        serializer->write( Uint8( i));
+        serializer->write( Uint32( i * 3));
+        serializer->write( Uint64( i) << 40);
+        serializer->write( double( i) / 7.0);
+        serializer->write( std::string( i % 13, char( 'a' + i % 26)));
+    }
+}
+
+// Reads the values written by write_values() and checks them.
+bool read_values( SERIAL::Deserializer* deserializer, size_t count)
+{
+    for( size_t i = 0; i < count; ++i) {
+        Uint8 u8 = 0;
+        Uint32 u32 = 0;
+        Uint64 u64 = 0;
+        double d = 0.0;
+        std::string s;
+        deserializer->read( &u8);
+        deserializer->read( &u32);
+        deserializer->read( &u64);
+        deserializer->read( &d);
+        deserializer->read( &s);
+        if( u8 != Uint8( i) || u32 != Uint32( i * 3) || u64 != Uint64( i) << 40
+            || d != double( i) / 7.0 || s != std::string( i % 13, char( 'a' + i % 26)))
+            return false;
+    }
+    return deserializer->is_valid();
+}
+
+// Returns the total size of the given chunks.
+size_t get_chunks_size( const SERIAL::Chunked_buffer_serializer& serializer)
+{
+    size_t size = 0;
+    for( size_t i = 0; i < serializer.get_chunk_count(); ++i)
+        size += serializer.get_chunks()[i].size;
+    return size;
+}
+
+} // namespace
+
+MI_TEST_AUTO_FUNCTION( test_values_across_chunks)
+{
+    // a first chunk smaller than most values
+    SERIAL::Chunked_buffer_serializer serializer( 3);
+    write_values( &serializer, 1000);
+    MI_CHECK( serializer.get_chunk_count() > 1);
+    MI_CHECK_EQUAL( get_chunks_size( serializer), serializer.get_buffer_size());
+
+    SERIAL::Chunked_buffer_deserializer deserializer;
+    deserializer.reset( serializer.get_chunks(), serializer.get_chunk_count());
+    MI_CHECK_EQUAL( deserializer.get_remaining_size(), serializer.get_buffer_size());
+    MI_CHECK( read_values( &deserializer, 1000));
+    MI_CHECK_EQUAL( deserializer.get_remaining_size(), size_t( 0));
+}
+
+MI_TEST_AUTO_FUNCTION( test_same_bytes_as_buffer_serializer)
+{
+    SERIAL::Buffer_serializer buffer_serializer;
+    write_values( &buffer_serializer, 500);
+
+    SERIAL::Chunked_buffer_serializer serializer( 5);
+    write_values( &serializer, 500);
+    MI_REQUIRE( serializer.get_buffer_size() == buffer_serializer.get_buffer_size());
+
+    std::vector<Uint8> buffer( serializer.get_buffer_size());
+    serializer.copy_to( &buffer[0]);
+    MI_CHECK( memcmp( &buffer[0], buffer_serializer.get_buffer(), buffer.size()) == 0);
+
+    // the contiguous copy reads back like the chunks
+    SERIAL::Buffer_deserializer deserializer;
+    deserializer.reset( &buffer[0], buffer.size());
+    MI_CHECK( read_values( &deserializer, 500));
+}
+
+MI_TEST_AUTO_FUNCTION( test_reserve)
+{
+    SERIAL::Chunked_buffer_serializer serializer( 4);
+    serializer.write( Uint32( 1));
+    serializer.write( Uint8( 2));
+
+    // the reserved bytes end up in one chunk
+    std::vector<Uint8> data( 1000, 42);
+    serializer.reserve( data.size());
+    serializer.write( &data[0], data.size());
+    const SERIAL::Buffer_chunk& last = serializer.get_chunks()[serializer.get_chunk_count() - 1];
+    MI_REQUIRE( last.size == data.size());
+    MI_CHECK( memcmp( last.data, &data[0], data.size()) == 0);
+
+    serializer.reset();
+    MI_CHECK_EQUAL( serializer.get_chunk_count(), size_t( 0));
+    MI_CHECK_EQUAL( serializer.get_buffer_size(), size_t( 0));
+}
+
+MI_TEST_AUTO_FUNCTION( test_compressed_vector_across_chunks)
+{
+    std::vector<Uint32> data( 100000);
+    for( size_t i = 0; i < data.size(); ++i)
+        data[i] = Uint32( i % 1000);
+
+    SERIAL::Chunked_buffer_serializer serializer( 16);
+    std::vector<unsigned char> temp_buffer;
+    SERIAL::compress_and_serialize( &serializer, data, temp_buffer, Z_BEST_SPEED, 4096);
+    MI_CHECK( serializer.get_chunk_count() > 1);
+
+    SERIAL::Chunked_buffer_deserializer deserializer;
+    deserializer.reset( serializer.get_chunks(), serializer.get_chunk_count());
+    std::vector<Uint32> result;
+    MI_REQUIRE( SERIAL::deserialize_and_decompress( &deserializer, result, temp_buffer));
+    MI_CHECK( result == data);
+}
@@ -0,0 +1,237 @@
+/***************************************************************************************************
+ * Copyright (c) 2007-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************************************/
+
+/// \file
+/// \brief Round-trip tests for the compressed serialization of vectors.
+
+#include <base/system/test/i_test_auto_driver.h>
+
+#include <cstring>
+#include <vector>
+
+#include <base/data/serial/i_compressed_serialization.h>
+#include <base/data/serial/i_serial_buffer_serializer.h>
+#include <base/lib/log/i_log_logger.h>
+
+// The tests never read beyond the end of a buffer, so nothing is logged.
+namespace MI { namespace LOG { ILogger* mod_log = 0; } }
+
+using namespace MI;
+
+namespace {
+
+const size_t BLOCK_SIZE = 4096;
+
+// Returns \p count values that do not compress.
+std::vector<Uint32> incompressible_data( size_t count)
+{
+    std::vector<Uint32> data( count);
+    Uint32 state = 12345u;
+    for( size_t i = 0; i < count; ++i) {
+        state = state * 1664525u + 1013904223u;
+        data[i] = state;
+    }
+    return data;
+}
+
+// Returns \p count values that compress well.
+std::vector<Uint32> compressible_data( size_t count)
+{
+    std::vector<Uint32> data( count);
+    for( size_t i = 0; i < count; ++i)
+        data[i] = Uint32( i % 7);
+    return data;
+}
+
+// Serializes \p data in the block format.
+std::vector<Uint8> write_blocks( const std::vector<Uint32>& data)
+{
+    SERIAL::Buffer_serializer serializer;
+    std::vector<unsigned char> temp_buffer;
+    SERIAL::compress_and_serialize( &serializer, data, temp_buffer, Z_BEST_SPEED, BLOCK_SIZE);
+    return std::vector<Uint8>(
+        serializer.get_buffer(), serializer.get_buffer() + serializer.get_buffer_size());
+}
+
+// Serializes \p data in the former single-stream format.
+std::vector<Uint8> write_stream( const std::vector<Uint32>& data)
+{
+    const size_t size = data.size() * sizeof( Uint32);
+    std::vector<Uint8> compressed( compressBound( static_cast<uLong>( size)));
+    uLong compressed_size = static_cast<uLong>( compressed.size());
+    compress2( &compressed[0], &compressed_size,
+        data.empty() ? NULL : reinterpret_cast<const Byte*>( &data[0]),
+        static_cast<uLong>( size), Z_BEST_SPEED);
+    compressed.resize( compressed_size);
+
+    SERIAL::Buffer_serializer serializer;
+    serializer.write_size_t( data.size());
+    SERIAL::write( &serializer, compressed);
+    return std::vector<Uint8>(
+        serializer.get_buffer(), serializer.get_buffer() + serializer.get_buffer_size());
+}
+
+// Deserializes a vector from \p buffer.
+bool read( std::vector<Uint8> buffer, std::vector<Uint32>& data)
+{
+    SERIAL::Buffer_deserializer deserializer;
+    deserializer.reset( buffer.empty() ? NULL : &buffer[0], buffer.size());
+    std::vector<unsigned char> temp_buffer;
+    return SERIAL::deserialize_and_decompress( &deserializer, data, temp_buffer);
+}
+
+// Overwrites the size_t at \p offset of a serialized buffer.
+void patch_size( std::vector<Uint8>& buffer, size_t offset, size_t value)
+{
+    const Uint64 value64 = value;
+    memcpy( &buffer[offset], &value64, sizeof( value64));
+}
+
+// Offsets of the size_t values at the start of the block format.
+const size_t OFFSET_ELEMENT_COUNT = 8;
+const size_t OFFSET_BLOCK_SIZE = 16;
+const size_t OFFSET_BLOCK_COUNT = 24;
+
+} // namespace
+
+MI_TEST_AUTO_FUNCTION( test_deflated_blocks)
+{
+    // three and a half blocks, the last one is partial
+    const std::vector<Uint32> data = compressible_data( 7 * BLOCK_SIZE / ( 2 * sizeof( Uint32)));
+    const std::vector<Uint8> buffer = write_blocks( data);
+    MI_CHECK( buffer.size() < data.size() * sizeof( Uint32) / 4);
+
+    std::vector<Uint32> result;
+    MI_REQUIRE( read( buffer, result));
+    MI_CHECK( result == data);
+}
+
+MI_TEST_AUTO_FUNCTION( test_stored_blocks)
+{
+    const std::vector<Uint32> data = incompressible_data( 3 * BLOCK_SIZE / sizeof( Uint32) + 5);
+    const std::vector<Uint8> buffer = write_blocks( data);
+    MI_CHECK( buffer.size() > data.size() * sizeof( Uint32));
+
+    std::vector<Uint32> result;
+    MI_REQUIRE( read( buffer, result));
+    MI_CHECK( result == data);
+}
+
+MI_TEST_AUTO_FUNCTION( test_mixed_blocks)
+{
+    std::vector<Uint32> data = incompressible_data( 2 * BLOCK_SIZE / sizeof( Uint32));
+    const std::vector<Uint32> regular = compressible_data( 2 * BLOCK_SIZE / sizeof( Uint32));
+    data.insert( data.end(), regular.begin(), regular.end());
+
+    std::vector<Uint32> result;
+    MI_REQUIRE( read( write_blocks( data), result));
+    MI_CHECK( result == data);
+}
+
+MI_TEST_AUTO_FUNCTION( test_empty)
+{
+    std::vector<Uint32> result( 3);
+    MI_REQUIRE( read( write_blocks( std::vector<Uint32>()), result));
+    MI_CHECK( result.empty());
+
+    result.resize( 3);
+    MI_REQUIRE( read( write_stream( std::vector<Uint32>()), result));
+    MI_CHECK( result.empty());
+}
+
+MI_TEST_AUTO_FUNCTION( test_legacy_format)
+{
+    const std::vector<Uint32> data = compressible_data( 10000);
+
+    std::vector<Uint32> result;
+    MI_REQUIRE( read( write_stream( data), result));
+    MI_CHECK( result == data);
+}
+
+MI_TEST_AUTO_FUNCTION( test_corrupted_block_header)
+{
+    const std::vector<Uint32> data = compressible_data( 3 * BLOCK_SIZE / sizeof( Uint32));
+    const std::vector<Uint8> buffer = write_blocks( data);
+    std::vector<Uint32> result;
+
+    // element counts that overflow or do not fit the input are rejected before allocating
+    std::vector<Uint8> corrupted = buffer;
+    patch_size( corrupted, OFFSET_ELEMENT_COUNT, ~size_t( 0) / 2);
+    MI_CHECK( !read( corrupted, result));
+    MI_CHECK( result.empty());
+
+    corrupted = buffer;
+    patch_size( corrupted, OFFSET_ELEMENT_COUNT, size_t( 1) << 40);
+    patch_size( corrupted, OFFSET_BLOCK_COUNT, ( size_t( 1) << 42) / BLOCK_SIZE);
+    MI_CHECK( !read( corrupted, result));
+    MI_CHECK( result.empty());
+
+    // block sizes that are zero, too large or do not match the block count are rejected
+    corrupted = buffer;
+    patch_size( corrupted, OFFSET_BLOCK_SIZE, 0);
+    MI_CHECK( !read( corrupted, result));
+
+    corrupted = buffer;
+    patch_size( corrupted, OFFSET_BLOCK_SIZE, ~size_t( 0));
+    patch_size( corrupted, OFFSET_BLOCK_COUNT, 1);
+    MI_CHECK( !read( corrupted, result));
+
+    corrupted = buffer;
+    patch_size( corrupted, OFFSET_BLOCK_COUNT, 4);
+    MI_CHECK( !read( corrupted, result));
+}
+
+MI_TEST_AUTO_FUNCTION( test_truncated_blocks)
+{
+    const std::vector<Uint32> data = incompressible_data( 3 * BLOCK_SIZE / sizeof( Uint32));
+    std::vector<Uint8> buffer = write_blocks( data);
+
+    // cut the last stored block in half
+    buffer.resize( buffer.size() - BLOCK_SIZE / 2);
+    std::vector<Uint32> result;
+    MI_CHECK( !read( buffer, result));
+}
+
+MI_TEST_AUTO_FUNCTION( test_corrupted_legacy_format)
+{
+    const std::vector<Uint32> data = compressible_data( 10000);
+    const std::vector<Uint8> buffer = write_stream( data);
+    std::vector<Uint32> result;
+
+    // more elements than the compressed data can hold
+    std::vector<Uint8> corrupted = buffer;
+    patch_size( corrupted, 0, size_t( 1) << 40);
+    MI_CHECK( !read( corrupted, result));
+    MI_CHECK( result.empty());
+
+    // a compressed size beyond the end of the input
+    corrupted = buffer;
+    patch_size( corrupted, 8, buffer.size());
+    MI_CHECK( !read( corrupted, result));
+    MI_CHECK( result.empty());
+}
@@ -0,0 +1,116 @@
+/***************************************************************************************************
+ * Copyright (c) 2007-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************************************/
+/// \file
+/// \brief A process-wide budget of worker threads for nested parallel loops.
+
+#ifndef BASE_SYSTEM_STLEXT_THREAD_BUDGET_H
+#define BASE_SYSTEM_STLEXT_THREAD_BUDGET_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+namespace MI { namespace STLEXT {
+
+/**
+ * \brief A process-wide budget of worker threads.
+ *
+ * Parallel loops are nested in several places, e.g., the workers that load the imports of a
+ * module decode the textures of these modules in parallel again. Instead of starting
+ * \c std::thread::hardware_concurrency() threads per loop, each loop borrows its workers from
+ * this budget. The budget holds one worker less than there are hardware threads, since the
+ * calling thread of a loop always works, too. Once the budget is exhausted, nested loops run on
+ * their calling thread alone. Borrowing never blocks, hence nested loops cannot deadlock.
+ */
+class Thread_budget
+{
+public:
+    /// Borrows up to \p wanted workers and returns how many were granted.
+    static size_t acquire(size_t wanted)
+    {
+        std::atomic<size_t>& available = get_available();
+        size_t n = available.load();
+        size_t granted = std::min(n, wanted);
+        while (granted > 0 && !available.compare_exchange_weak(n, n - granted))
+            granted = std::min(n, wanted);
+        return granted;
+    }
+
+    /// Returns \p count workers borrowed by #acquire().
+    static void release(size_t count)
+    {
+        get_available() += count;
+    }
+
+private:
+    static std::atomic<size_t>& get_available()
+    {
+        static std::atomic<size_t> available(get_hardware_workers());
+        return available;
+    }
+
+    static size_t get_hardware_workers()
+    {
+        size_t n = std::thread::hardware_concurrency();
+        return n > 1 ? n - 1 : 0;
+    }
+};
+
+/// Calls \p func(i) for all \p i in [0, \p count) on the calling thread and on up to
+/// \p max_threads - 1 workers borrowed from #Thread_budget.
+///
+/// The indices are handed out in increasing order, but the calls may finish in any order.
+/// Returns when all calls have returned.
+template <typename F>
+void parallel_for(size_t count, F func, size_t max_threads = ~size_t(0))
+{
+    size_t wanted = std::min(count, max_threads);
+    size_t n_workers = Thread_budget::acquire(wanted > 1 ? wanted - 1 : 0);
+
+    std::atomic<size_t> next(0);
+    auto work = [&next, &func, count]() {
+        for (size_t i = next++; i < count; i = next++)
+            func(i);
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(n_workers);
+    for (size_t t = 0; t < n_workers; ++t)
+        threads.push_back(std::thread(work));
+    work();
+    for (size_t t = 0; t < n_workers; ++t)
+        threads[t].join();
+
+    Thread_budget::release(n_workers);
+}
+
+}} // MI::STLEXT
+
+#endif // BASE_SYSTEM_STLEXT_THREAD_BUDGET_H
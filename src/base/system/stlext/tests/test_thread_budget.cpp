@@ -0,0 +1,131 @@
+/***************************************************************************************************
+ * Copyright (c) 2007-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************************************/
+/// \file
+/// \brief Tests for the process-wide thread budget of nested parallel loops.
+
+#include <base/system/test/i_test_auto_driver.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include <base/system/stlext/i_stlext_thread_budget.h>
+
+using namespace MI;
+
+namespace {
+
+// Tracks the number of concurrently running calls and its maximum.
+struct Concurrency
+{
+    std::atomic<size_t> m_running{ 0};
+    std::atomic<size_t> m_max{ 0};
+
+    void enter()
+    {
+        size_t running = ++m_running;
+        size_t max = m_max.load();
+        while( running > max && !m_max.compare_exchange_weak( max, running)) {}
+    }
+
+    void leave() { --m_running; }
+};
+
+size_t get_hardware_threads()
+{
+    return std::max<size_t>( 1, std::thread::hardware_concurrency());
+}
+
+}
+
+MI_TEST_AUTO_FUNCTION( test_parallel_for_visits_each_index_once)
+{
+    const size_t count = 1000;
+    std::vector<std::atomic<int> > visits( count);
+    for( auto& v: visits)
+        v = 0;
+
+    STLEXT::parallel_for( count, [&visits]( size_t i) { ++visits[i]; });
+
+    for( size_t i = 0; i < count; ++i)
+        MI_CHECK_EQUAL( visits[i].load(), 1);
+}
+
+MI_TEST_AUTO_FUNCTION( test_parallel_for_respects_max_threads)
+{
+    Concurrency concurrency;
+    STLEXT::parallel_for( 64, [&concurrency]( size_t) {
+        concurrency.enter();
+        std::this_thread::sleep_for( std::chrono::milliseconds( 1));
+        concurrency.leave();
+    }, 2);
+
+    MI_CHECK( concurrency.m_max.load() <= 2);
+}
+
+MI_TEST_AUTO_FUNCTION( test_nested_parallel_for_stays_within_budget)
+{
+    const size_t outer = 16;
+    const size_t inner = 16;
+    std::atomic<size_t> calls( 0);
+    Concurrency concurrency;
+
+    STLEXT::parallel_for( outer, [&]( size_t) {
+        STLEXT::parallel_for( inner, [&]( size_t) {
+            concurrency.enter();
+            std::this_thread::sleep_for( std::chrono::milliseconds( 1));
+            ++calls;
+            concurrency.leave();
+        });
+    });
+
+    MI_CHECK_EQUAL( calls.load(), outer * inner);
+    MI_CHECK( concurrency.m_max.load() <= get_hardware_threads());
+}
+
+MI_TEST_AUTO_FUNCTION( test_budget_is_returned)
+{
+    size_t workers = STLEXT::Thread_budget::acquire( ~size_t( 0));
+    MI_CHECK_EQUAL( workers, get_hardware_threads() - 1);
+    MI_CHECK_EQUAL( STLEXT::Thread_budget::acquire( 1), 0u);
+
+    // an exhausted budget runs the loop on the calling thread
+    std::thread::id caller = std::this_thread::get_id();
+    bool only_caller = true;
+    STLEXT::parallel_for( 8, [&]( size_t) {
+        if( std::this_thread::get_id() != caller)
+            only_caller = false;
+    });
+    MI_CHECK( only_caller);
+
+    STLEXT::Thread_budget::release( workers);
+    MI_CHECK_EQUAL( STLEXT::Thread_budget::acquire( ~size_t( 0)), workers);
+    STLEXT::Thread_budget::release( workers);
+}
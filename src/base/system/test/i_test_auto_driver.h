@@ -0,0 +1,133 @@
+/***************************************************************************************************
+ * Copyright (c) 2007-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************************************/
+/// \file
+/// \brief Minimal driver for unit tests.
+///
+/// A test executable consists of a single translation unit that includes this header and
+/// defines its test cases with #MI_TEST_AUTO_FUNCTION. The driver runs all of them in the order
+/// of their definition and fails if any check failed.
+///
+/// Usage
+/// \code
+///  MI_TEST_AUTO_FUNCTION( test_addition)
+///  {
+///      MI_CHECK_EQUAL( 1 + 1, 2);
+///  }
+/// \endcode
+
+#ifndef BASE_SYSTEM_TEST_I_TEST_AUTO_DRIVER_H
+#define BASE_SYSTEM_TEST_I_TEST_AUTO_DRIVER_H
+
+#include <cstdio>
+#include <vector>
+
+namespace MI {
+
+namespace TEST {
+
+/// A registered test case.
+struct Test_case
+{
+    const char* m_name;
+    void (*m_func)();
+};
+
+/// Returns the list of registered test cases.
+inline std::vector<Test_case>& get_test_cases()
+{
+    static std::vector<Test_case> test_cases;
+    return test_cases;
+}
+
+/// Returns the number of failed checks.
+inline int& get_failure_count()
+{
+    static int failure_count = 0;
+    return failure_count;
+}
+
+/// Registers a test case during static initialization.
+struct Test_registrar
+{
+    Test_registrar( const char* name, void (*func)())
+    {
+        Test_case test_case = { name, func };
+        get_test_cases().push_back( test_case);
+    }
+};
+
+/// Records a failed check.
+inline void report_failure( const char* file, int line, const char* expr)
+{
+    fprintf( stderr, "%s(%d): check failed: %s\n", file, line, expr);
+    ++get_failure_count();
+}
+
+} // namespace TEST
+
+} // namespace MI
+
+/// Defines a test case that is run by the driver.
+#define MI_TEST_AUTO_FUNCTION( name) \
+    static void name(); \
+    static MI::TEST::Test_registrar name##_registrar( #name, &name); \
+    static void name()
+
+/// Checks that \p expr is true, and continues the test case otherwise.
+#define MI_CHECK( expr) \
+    do { \
+        if( !(expr)) \
+            MI::TEST::report_failure( __FILE__, __LINE__, #expr); \
+    } while( false)
+
+/// Checks that \p a and \p b compare equal, and continues the test case otherwise.
+#define MI_CHECK_EQUAL( a, b) \
+    MI_CHECK( (a) == (b))
+
+/// Checks that \p expr is true, and aborts the test case otherwise.
+#define MI_REQUIRE( expr) \
+    do { \
+        if( !(expr)) { \
+            MI::TEST::report_failure( __FILE__, __LINE__, #expr); \
+            return; \
+        } \
+    } while( false)
+
+int main()
+{
+    const std::vector<MI::TEST::Test_case>& test_cases = MI::TEST::get_test_cases();
+    for( size_t i = 0; i < test_cases.size(); ++i) {
+        int failures = MI::TEST::get_failure_count();
+        test_cases[i].m_func();
+        printf( "%s: %s\n", test_cases[i].m_name,
+            MI::TEST::get_failure_count() == failures ? "passed" : "FAILED");
+    }
+    return MI::TEST::get_failure_count() == 0 ? 0 : 1;
+}
+
+#endif // BASE_SYSTEM_TEST_I_TEST_AUTO_DRIVER_H
@@ -49,6 +49,7 @@
 #include <base/data/db/i_db_transaction.h>
 #include <base/util/registry/i_config_registry.h>
 #include <io/scene/scene/i_scene_journal_types.h>
+#include <io/scene/mdl_elements/i_mdl_elements_utilities.h>
 #include <io/scene/mdl_elements/mdl_elements_detail.h>
 
 namespace MI {
@@ -84,6 +85,16 @@ std::string dump_data( const mi::neuraylib::IBsdf_isotropic_data* data)
     return s.str();
 }
 
+// Indicates whether the filename has the only supported extension ".mbsdf".
+bool has_mbsdf_extension( const std::string& filename)
+{
+    std::string root, extension;
+    HAL::Ospath::splitext( filename, root, extension);
+    if( !extension.empty() && extension[0] == '.' )
+        extension = extension.substr( 1);
+    return extension == "mbsdf";
+}
+
 }
 
 Bsdf_measurement::Bsdf_measurement()
@@ -170,15 +181,24 @@ mi::Sint32 Bsdf_measurement::reset_file_mdl(
     DB::Transaction* transaction,
     const std::string& resolved_filename,
     const std::string& mdl_file_path,
-    const mi::base::Uuid& impl_hash)
+    const mi::base::Uuid& impl_hash,
+    mi::neuraylib::IReader* reader)
 {
+    // Parsing is not needed if the implementation class can be shared.
+    bool reused = reuse_impl( transaction, impl_hash);
+
     mi::base::Handle<mi::neuraylib::IBsdf_isotropic_data> reflection;
     mi::base::Handle<mi::neuraylib::IBsdf_isotropic_data> transmission;
-    bool success = import_from_file( resolved_filename, reflection, transmission);
-    if( !success)
-        return -3;
-
-    reset_shared( transaction, reflection.get(), transmission.get(), impl_hash);
+    if( !reused) {
+        bool success = reader
+            ? has_mbsdf_extension( resolved_filename)
+                && import_from_reader( reader, reflection, transmission)
+            : import_from_file( resolved_filename, reflection, transmission);
+        if( !success)
+            return -3;
+
+        reset_shared( transaction, reflection.get(), transmission.get(), impl_hash);
+    }
 
     m_original_filename.clear();
     m_resolved_filename = resolved_filename;
@@ -186,6 +206,9 @@ mi::Sint32 Bsdf_measurement::reset_file_mdl(
     m_resolved_container_membername.clear();
     m_mdl_file_path = mdl_file_path;
 
+    if( reused)
+        return 0;
+
     std::ostringstream s;
     s << "Loading BSDF measurement \"" << m_resolved_filename.c_str()
       << "\", reflection: " << dump_data( reflection.get())
@@ -203,14 +226,19 @@ mi::Sint32 Bsdf_measurement::reset_container_mdl(
     const std::string& mdl_file_path,
     const mi::base::Uuid& impl_hash)
 {
+    // Parsing is not needed if the implementation class can be shared.
+    bool reused = reuse_impl( transaction, impl_hash);
+
     mi::base::Handle<mi::neuraylib::IBsdf_isotropic_data> reflection;
     mi::base::Handle<mi::neuraylib::IBsdf_isotropic_data> transmission;
-    bool success = import_from_reader(
-        reader, container_filename, container_membername, reflection, transmission);
-    if( !success)
-        return -3;
+    if( !reused) {
+        bool success = import_from_reader(
+            reader, container_filename, container_membername, reflection, transmission);
+        if( !success)
+            return -3;
 
-    reset_shared( transaction, reflection.get(), transmission.get(), impl_hash);
+        reset_shared( transaction, reflection.get(), transmission.get(), impl_hash);
+    }
 
     m_original_filename.clear();
     m_resolved_filename.clear();
@@ -218,6 +246,9 @@ mi::Sint32 Bsdf_measurement::reset_container_mdl(
     m_resolved_container_membername = container_membername;
     m_mdl_file_path = mdl_file_path;
 
+    if( reused)
+        return 0;
+
     std::ostringstream s;
     s << "Loading BSDF measurement \"" << container_membername
       << "\" in \"" << container_filename
@@ -393,6 +424,25 @@ void Bsdf_measurement::get_scene_element_references( DB::Tag_set* result) const
         result->insert( m_impl_tag);
 }
 
+bool Bsdf_measurement::reuse_impl(
+    DB::Transaction* transaction, const mi::base::Uuid& impl_hash)
+{
+    if( impl_hash == mi::base::Uuid{0,0,0,0})
+        return false;
+
+    std::string impl_name = "MI_default_bsdf_measurement_impl_" + hash_to_string( impl_hash);
+    DB::Tag impl_tag = transaction->name_to_tag( impl_name.c_str());
+    if( !impl_tag)
+        return false;
+
+    m_impl_tag = impl_tag;
+    m_impl_hash = impl_hash;
+    DB::Access<Bsdf_measurement_impl> impl( m_impl_tag, transaction);
+    setup_cached_values( impl.get_ptr());
+    MDL::record_shared_resource_impl( impl->get_size());
+    return true;
+}
+
 void Bsdf_measurement::reset_shared(
     DB::Transaction* transaction,
     const mi::neuraylib::IBsdf_isotropic_data* reflection,
@@ -400,17 +450,12 @@ void Bsdf_measurement::reset_shared(
     const mi::base::Uuid& impl_hash)
 {
     // if impl_hash is valid, check whether implementation class exists already
+    if( reuse_impl( transaction, impl_hash))
+        return;
+
     std::string impl_name;
-    if( impl_hash != mi::base::Uuid{0,0,0,0}) {
+    if( impl_hash != mi::base::Uuid{0,0,0,0})
         impl_name = "MI_default_bsdf_measurement_impl_" + hash_to_string( impl_hash);
-        m_impl_tag = transaction->name_to_tag( impl_name.c_str());
-        if( m_impl_tag) {
-            m_impl_hash = impl_hash;
-            DB::Access<Bsdf_measurement_impl> impl( m_impl_tag, transaction);
-            setup_cached_values( impl.get_ptr());
-            return;
-        }
-    }
 
     Bsdf_measurement_impl* impl = new Bsdf_measurement_impl( reflection, transmission);
 
@@ -713,11 +758,7 @@ bool import_from_file(
     if( !reader.open( filename.c_str()))
         return false;
 
-    std::string root, extension;
-    HAL::Ospath::splitext( filename, root, extension);
-    if( !extension.empty() && extension[0] == '.' )
-        extension = extension.substr( 1);
-    if( extension != "mbsdf")
+    if( !has_mbsdf_extension( filename))
         return false;
 
     return import_measurement_from_reader( &reader, reflection, transmission);
@@ -738,11 +779,7 @@ bool import_from_reader(
     mi::base::Handle<mi::neuraylib::IBsdf_isotropic_data>& reflection,
     mi::base::Handle<mi::neuraylib::IBsdf_isotropic_data>& transmission)
 {
-    std::string root, extension;
-    HAL::Ospath::splitext( container_membername, root, extension);
-    if( !extension.empty() && extension[0] == '.' )
-        extension = extension.substr( 1);
-    if( extension != "mbsdf")
+    if( !has_mbsdf_extension( container_membername))
         return false;
 
     return import_measurement_from_reader( reader, reflection, transmission);
@@ -831,7 +868,8 @@ DB::Tag load_mdl_bsdf_measurement(
     const std::string& resolved_filename,
     const std::string& mdl_file_path,
     const mi::base::Uuid& impl_hash,
-    bool shared_proxy)
+    bool shared_proxy,
+    mi::neuraylib::IReader* reader)
 {
     std::string db_name = shared_proxy ? "MI_default_" : "";
     db_name += "bsdf_measurement_" + resolved_filename;
@@ -844,7 +882,7 @@ DB::Tag load_mdl_bsdf_measurement(
 
     Bsdf_measurement* bsdfm = new Bsdf_measurement();
     mi::Sint32 result = bsdfm->reset_file_mdl(
-        transaction, resolved_filename, mdl_file_path, impl_hash);
+        transaction, resolved_filename, mdl_file_path, impl_hash, reader);
     ASSERT( M_BSDF_MEASUREMENT, result == 0 || result == -3);
     if( result == -3)
         LOG::mod_log->error( M_SCENE, LOG::Mod_log::C_IO,
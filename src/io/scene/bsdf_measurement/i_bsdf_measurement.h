@@ -101,6 +101,8 @@ public:
     /// \param mdl_file_path         The MDL file path.
     /// \param impl_hash             Hash of the data in the implementation class. Use {0,0,0,0} if
     ///                              hash is not known.
+    /// \param reader                The contents of \p resolved_filename if they have already been
+    ///                              read, or \c NULL to open the file.
     /// \return
     ///                              -  0: Success.
     ///                              - -2: Failure to resolve the given filename, e.g., the file
@@ -111,7 +113,8 @@ public:
         DB::Transaction* transaction,
         const std::string& resolved_filename,
         const std::string& mdl_file_path,
-        const mi::base::Uuid& impl_hash);
+        const mi::base::Uuid& impl_hash,
+        mi::neuraylib::IReader* reader);
 
     /// Imports a BSDF measurement from a container (used by MDL integration).
     ///
@@ -227,6 +230,12 @@ public:
     const mi::base::Uuid& get_impl_hash() const { return m_impl_hash; }
 
 private:
+    /// Reuses the existing implementation class with hash \p impl_hash, if there is one.
+    ///
+    /// \return   \c true if the implementation class was reused, \c false otherwise (including
+    ///           invalid hashes).
+    bool reuse_impl( DB::Transaction* transaction, const mi::base::Uuid& impl_hash);
+
     /// Set a BSDF measurement from two isotropic data sets.
     ///
     /// Implements the common functionality for all \c reset_*() and \c set_*() methods above.
@@ -486,13 +495,16 @@ mi::neuraylib::IBuffer* create_buffer_from_bsdf_measurement(
 ///                              \c resolved_filename, not on \c impl_hash). Otherwise, an
 ///                              independent proxy DB element is created, even if the resource has
 ///                              already been loaded.
+/// \param reader                The contents of \p resolved_filename if they have already been
+///                              read, e.g., on a worker thread, or \c NULL to open the file.
 /// \return                      The tag of that BSDF measurement (invalid in case of failures).
 DB::Tag load_mdl_bsdf_measurement(
     DB::Transaction* transaction,
     const std::string& resolved_filename,
     const std::string& mdl_file_path,
     const mi::base::Uuid& impl_hash,
-    bool shared_proxy);
+    bool shared_proxy,
+    mi::neuraylib::IReader* reader = nullptr);
 
 /// Loads a default BSDF measurement and stores it in the DB.
 ///
@@ -44,6 +44,7 @@
 #include <base/data/db/i_db_access.h>
 #include <base/data/db/i_db_transaction.h>
 #include <base/util/string_utils/i_string_utils.h>
+#include <base/system/stlext/i_stlext_thread_budget.h>
 #include <io/image/image/i_image.h>
 #include <io/image/image/i_image_mipmap.h>
 #include <io/image/image/i_image_utilities.h>
@@ -68,6 +69,17 @@ std::string hash_to_string( const mi::base::Uuid& hash)
     return buffer;
 }
 
+// Creates the mipmaps for the first \p count uv-tiles of \p image_set.
+//
+// The uv-tiles are distributed among the workers of the thread budget. Each mipmap is stored in
+// the slot of its uv-tile ID, so the result does not depend on the thread scheduling.
+void create_mipmaps( const Image_set* image_set, std::vector<Uvtile>& uvtiles, mi::Size count)
+{
+    STLEXT::parallel_for( count, [image_set, &uvtiles]( size_t i) {
+        uvtiles[i].m_mipmap = image_set->create_mipmap( i);
+    });
+}
+
 }
 
 IMAGE::IMipmap* Image_set::create_mipmap( mi::Size i) const
@@ -91,7 +103,7 @@ IMAGE::IMipmap* Image_set::create_mipmap( mi::Size i) const
             reader.get(),
             container_filename,
             container_membername,
-            /*tile_width*/ 0, /*tile_height*/ 0, /*only_first_level*/ true);
+            /*tile_width*/ 0, /*tile_height*/ 0, /*only_first_level*/ false);
     }
 
     // file based
@@ -100,7 +112,7 @@ IMAGE::IMipmap* Image_set::create_mipmap( mi::Size i) const
     {
         return image_module->create_mipmap(
             resolved_filename,
-            /*tile_width*/ 0, /*tile_height*/ 0, /*only_first_level*/ true);
+            /*tile_width*/ 0, /*tile_height*/ 0, /*only_first_level*/ false);
     }
 
     // canvas based
@@ -426,6 +438,9 @@ mi::Sint32 Image::reset_image_set(
     std::string tmp_original_filename           = image_set->get_original_filename();
     std::string tmp_mdl_file_path               = image_set->get_mdl_file_path();
 
+    // Set up the uv-to-id mapping and the filenames first. Stop at the first uv-tile with an
+    // invalid mapping, its mipmap and the ones of later uv-tiles are not needed.
+    mi::Size number_of_valid_tiles = number_of_tiles;
     for( mi::Uint32 i = 0; i < number_of_tiles; ++i) {
 
         mi::Sint32 u = 0;
@@ -434,17 +449,13 @@ mi::Sint32 Image::reset_image_set(
 
         if( !tmp_uv_to_id.set( u, v, i)) {
             result = -2;
+            number_of_valid_tiles = i;
             break;
         }
 
         Uvtile& tile = tmp_uvtiles[i];
         tile.m_u = u;
         tile.m_v = v;
-        tile.m_mipmap = image_set->create_mipmap( i);
-        if( !tile.m_mipmap) {
-            result = -3;
-            break;
-        }
 
         Uvfilenames& filename = tmp_uvfilenames[i];
         filename.m_resolved_filename    = image_set->get_resolved_filename( i);
@@ -454,10 +465,24 @@ mi::Sint32 Image::reset_image_set(
                 = tmp_resolved_container_filename + ":" + filename.m_container_membername;
     }
 
-    if( result != 0)
-        return result;
+    // Decoding is not needed if the implementation class can be shared.
+    bool reused = result == 0 && reuse_impl( transaction, impl_hash);
 
-    reset_shared( transaction, tmp_is_uvtile, tmp_uvtiles, tmp_uv_to_id, impl_hash);
+    if( !reused) {
+
+        // Decoding the uv-tiles is the expensive part, do it concurrently.
+        create_mipmaps( image_set, tmp_uvtiles, number_of_valid_tiles);
+
+        // Report errors in uv-tile order, as if the uv-tiles had been processed sequentially.
+        for( mi::Size i = 0; i < number_of_valid_tiles; ++i)
+            if( !tmp_uvtiles[i].m_mipmap)
+                return -3;
+
+        if( result != 0)
+            return result;
+
+        reset_shared( transaction, tmp_is_uvtile, tmp_uvtiles, tmp_uv_to_id, impl_hash);
+    }
 
     m_uvfilenames                 = tmp_uvfilenames;
     m_resolved_container_filename = tmp_resolved_container_filename;
@@ -811,6 +836,24 @@ const unsigned int* Image::get_tile_mapping(
     return &m_cached_uv_to_id.m_ids[0];
 }
 
+bool Image::reuse_impl( DB::Transaction* transaction, const mi::base::Uuid& impl_hash)
+{
+    if( impl_hash == mi::base::Uuid{0,0,0,0})
+        return false;
+
+    std::string impl_name = "MI_default_image_impl_" + hash_to_string( impl_hash);
+    DB::Tag impl_tag = transaction->name_to_tag( impl_name.c_str());
+    if( !impl_tag)
+        return false;
+
+    m_impl_tag = impl_tag;
+    m_impl_hash = impl_hash;
+    DB::Access<Image_impl> impl( m_impl_tag, transaction);
+    setup_cached_values( impl.get_ptr());
+    MDL::record_shared_resource_impl( impl->get_size());
+    return true;
+}
+
 void Image::reset_shared(
     DB::Transaction* transaction,
     bool is_uvtile,
@@ -819,17 +862,12 @@ void Image::reset_shared(
     const mi::base::Uuid& impl_hash)
 {
     // If impl_hash is valid, check whether implementation class exists already.
+    if( reuse_impl( transaction, impl_hash))
+        return;
+
     std::string impl_name;
-    if( impl_hash != mi::base::Uuid{0,0,0,0}) {
+    if( impl_hash != mi::base::Uuid{0,0,0,0})
         impl_name = "MI_default_image_impl_" + hash_to_string( impl_hash);
-        m_impl_tag = transaction->name_to_tag( impl_name.c_str());
-        if( m_impl_tag) {
-            m_impl_hash = impl_hash;
-            DB::Access<Image_impl> impl( m_impl_tag, transaction);
-            setup_cached_values( impl.get_ptr());
-            return;
-        }
-    }
 
     Image_impl* impl = new Image_impl( is_uvtile, uvtiles, uv_to_id);
 
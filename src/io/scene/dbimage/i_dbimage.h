@@ -113,8 +113,11 @@ public:
 
     /// Creates a mipmap for the i'th uv-tile.
     ///
+    /// Derived classes may override this method to hand out mipmaps that have been created in
+    /// advance.
+    ///
     /// Never returns \c NULL.
-    IMAGE::IMipmap* create_mipmap( mi::Size i) const;
+    virtual IMAGE::IMipmap* create_mipmap( mi::Size i) const;
 };
 
 /// Represents the pixel data of an uv-tile plus the corresponding coordinates.
@@ -423,6 +426,12 @@ private:
     /// \return Image_set containing the resolved filenames for or \c NULL in case of error
     static Image_set* resolve_filename( const std::string& path);
 
+    /// Reuses the existing implementation class with hash \p impl_hash, if there is one.
+    ///
+    /// \return   \c true if the implementation class was reused, \c false otherwise (including
+    ///           invalid hashes).
+    bool reuse_impl( DB::Transaction* transaction, const mi::base::Uuid& impl_hash);
+
     /// Set an image from uv-tiles.
     ///
     /// Implements the common functionality for all \c reset_*() and \c set_*() methods above.
@@ -125,16 +125,19 @@ public:
     /// \param mdl_file_path         The MDL file path.
     /// \param impl_hash             Hash of the data in the implementation class. Use {0,0,0,0} if
     ///                              hash is not known.
+    /// \param reader                The contents of \p resolved_filename if they have already been
+    ///                              read, or \c NULL to open the file.
     /// \param resolution_phi        See #reset_file().
     /// \param resolution_theta      See #reset_file().
     /// \param degree                See #reset_file().
     /// \param flags                 See #reset_file().
-    /// \return                      See #reset_file() (-2 not possible here).
+    /// \return                      See #reset_file().
     mi::Sint32 reset_file_mdl(
         DB::Transaction* transaction,
         const std::string& resolved_filename,
         const std::string& mdl_file_path,
         const mi::base::Uuid& impl_hash,
+        mi::neuraylib::IReader* reader,
         mi::Uint32 resolution_phi = 0,
         mi::Uint32 resolution_theta = 0,
         mi::neuraylib::Lightprofile_degree degree = mi::neuraylib::LIGHTPROFILE_HERMITE_BASE_1,
@@ -487,13 +490,16 @@ mi::neuraylib::IBuffer* create_buffer_from_lightprofile(
 ///                              \c resolved_filename, not on \c impl_hash). Otherwise, an
 ///                              independent proxy DB element is created, even if the resource has
 ///                              already been loaded.
+/// \param reader                The contents of \p resolved_filename if they have already been
+///                              read, e.g., on a worker thread, or \c NULL to open the file.
 /// \return                      The tag of that light profile (invalid in case of failures).
 DB::Tag load_mdl_lightprofile(
     DB::Transaction* transaction,
     const std::string& resolved_filename,
     const std::string& mdl_file_path,
     const mi::base::Uuid& impl_hash,
-    bool shared_proxy);
+    bool shared_proxy,
+    mi::neuraylib::IReader* reader = nullptr);
 
 /// Loads a default light profile and stores it in the DB.
 ///
@@ -44,6 +44,7 @@
 #include <base/data/serial/i_serializer.h>
 #include <base/util/string_utils/i_string_utils.h>
 #include <io/scene/scene/i_scene_journal_types.h>
+#include <io/scene/mdl_elements/i_mdl_elements_utilities.h>
 #include <io/scene/mdl_elements/mdl_elements_detail.h>
 
 #include <sstream>
@@ -172,18 +173,22 @@ mi::Sint32 Lightprofile::reset_file_mdl(
     const std::string& resolved_filename,
     const std::string& mdl_file_path,
     const mi::base::Uuid& impl_hash,
+    mi::neuraylib::IReader* reader,
     mi::Uint32 resolution_phi,
     mi::Uint32 resolution_theta,
     mi::neuraylib::Lightprofile_degree degree,
     mi::Uint32 flags)
 {
-    // create reader for resolved_filename
-    DISK::File_reader_impl reader;
-    if( !reader.open( resolved_filename.c_str()))
-        return -2;
+    // create reader for resolved_filename unless its contents have already been read
+    DISK::File_reader_impl file_reader;
+    if( !reader) {
+        if( !file_reader.open( resolved_filename.c_str()))
+            return -2;
+        reader = &file_reader;
+    }
 
     mi::Sint32 result = reset_shared( transaction,
-        &reader, resolved_filename, impl_hash, resolution_phi, resolution_theta, degree, flags);
+        reader, resolved_filename, impl_hash, resolution_phi, resolution_theta, degree, flags);
     if( result != 0)
         return result;
 
@@ -261,6 +266,7 @@ mi::Sint32 Lightprofile::reset_shared(
             m_impl_hash = impl_hash;
             DB::Access<Lightprofile_impl> impl( m_impl_tag, transaction);
             setup_cached_values( impl.get_ptr());
+            MDL::record_shared_resource_impl( impl->get_size());
             return 0;
         }
     }
@@ -867,7 +873,8 @@ DB::Tag load_mdl_lightprofile(
     const std::string& resolved_filename,
     const std::string& mdl_file_path,
     const mi::base::Uuid& impl_hash,
-    bool shared_proxy)
+    bool shared_proxy,
+    mi::neuraylib::IReader* reader)
 {
     std::string db_name = shared_proxy ? "MI_default_" : "";
     db_name += "lightprofile_" + resolved_filename;
@@ -880,7 +887,7 @@ DB::Tag load_mdl_lightprofile(
 
     Lightprofile* lp = new Lightprofile();
     mi::Sint32 result = lp->reset_file_mdl(
-        transaction, resolved_filename, mdl_file_path, impl_hash);
+        transaction, resolved_filename, mdl_file_path, impl_hash, reader);
     ASSERT( M_LIGHTPROFILE, result == 0 || result == -4);
     if( result == -4)
         LOG::mod_log->error( M_SCENE, LOG::Mod_log::C_IO,
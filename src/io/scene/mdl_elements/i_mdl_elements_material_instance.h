@@ -29,6 +29,7 @@
 #ifndef IO_SCENE_MDL_ELEMENTS_I_MDL_ELEMENTS_MATERIAL_INSTANCE_H
 #define IO_SCENE_MDL_ELEMENTS_I_MDL_ELEMENTS_MATERIAL_INSTANCE_H
 
+#include <mutex>
 #include <mi/base/handle.h>
 #include <mi/mdl/mdl_generated_dag.h>
 #include <mi/neuraylib/imaterial_instance.h>
@@ -243,6 +244,14 @@ private:
     mi::base::Handle<IExpression_list> m_arguments;
 
     mi::base::Handle<const IExpression_list> m_enable_if_conditions; // (*)
+
+    // The DAG instance of the last instance compilation and the code DAG it was created from.
+    // Used as starting point for the next instance compilation if the "incremental_instantiation"
+    // option is set. Not serialized.
+
+    mutable std::mutex m_last_instance_mutex;
+    mutable mi::base::Handle<const mi::mdl::IGenerated_code_dag::IMaterial_instance> m_last_instance;
+    mutable mi::base::Handle<const mi::mdl::IGenerated_code_dag> m_last_code_dag;
 };
 
 } // namespace MDL
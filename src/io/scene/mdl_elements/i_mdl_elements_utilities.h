@@ -235,6 +235,7 @@ public:
         MSG_IMP_EXP,
         MSG_INTEGRATION,
         MSG_UNCATEGORIZED,
+        MSG_PROFILING,
         MSG_FORCE_32_BIT = 0xffffffffU
     };
 
@@ -328,9 +329,14 @@ public:
 #define MDL_CTX_OPTION_BUNDLE_RESOURCES                 "bundle_resources"
 #define MDL_CTX_OPTION_EXPERIMENTAL                     "experimental"
 #define MDL_CTX_OPTION_RESOLVE_RESOURCES                "resolve_resources"
+#define MDL_CTX_OPTION_PARALLEL_IMPORTS                 "parallel_imports"
+#define MDL_CTX_OPTION_PARALLEL_RESOURCE_LOADING        "parallel_resource_loading"
 #define MDL_CTX_OPTION_FOLD_TERNARY_ON_DF               "fold_ternary_on_df"
+#define MDL_CTX_OPTION_INCREMENTAL_INSTANTIATION        "incremental_instantiation"
 #define MDL_CTX_OPTION_LOADING_WAIT_HANDLE_FACTORY      "loading_wait_handle_factory"
 #define MDL_CTX_OPTION_REPLACE_EXISTING                 "replace_existing"
+#define MDL_CTX_OPTION_PROFILING                        "profiling"
+#define MDL_CTX_OPTION_PROFILING_TRACE_FILE             "profiling_trace_file"
 
     Execution_context();
 
@@ -397,10 +403,32 @@ public:
 
     mi::Sint32 get_result() const;
 
+    /// Starts a profiling phase nested into the currently open phase, see #Profiling_scope.
+    ///
+    /// Returns \c false if profiling is disabled or the phase has been ignored because it was
+    /// started from a different thread than the currently open phase.
+    bool begin_profiling_phase(const char* name);
+
+    /// Ends the innermost open profiling phase.
+    ///
+    /// When the outermost phase ends, all phases recorded by it are added as messages of kind
+    /// MSG_PROFILING, appended to the trace file if MDL_CTX_OPTION_PROFILING_TRACE_FILE is set,
+    /// and discarded.
+    void end_profiling_phase();
+
 private:
 
     void add_option(const Option& option);
 
+    /// Converts the recorded phase \p index and all its nested phases into a message.
+    Message get_profiling_message(mi::Size index) const;
+
+    /// Writes all recorded phases in the Chrome trace event format.
+    ///
+    /// Appends to the file if it has been started by this context before, otherwise the file is
+    /// created.
+    void write_profiling_trace(const std::string& filename);
+
     std::vector<Message> m_messages;
     std::vector<Message> m_error_messages;
 
@@ -409,6 +437,47 @@ private:
 
     mi::Sint32 m_result;
 
+    /// A recorded profiling phase.
+    struct Profiling_phase {
+        std::string m_name;     ///< The name of the phase.
+        mi::Size    m_parent;   ///< The index of the enclosing phase, or ~0 for outermost phases.
+        mi::Float64 m_start;    ///< The start time in seconds.
+        mi::Float64 m_duration; ///< The wall time in seconds (negative while open).
+        mi::Uint64  m_thread;   ///< The ID of the thread that ran the phase.
+    };
+
+    std::vector<Profiling_phase> m_profiling_phases;
+
+    /// The index of the innermost open phase, or ~0 if no phase is open.
+    mi::Size m_profiling_current;
+
+    /// The thread that started the outermost open phase.
+    std::thread::id m_profiling_thread;
+
+    /// The start time of the first phase recorded by this context, or negative if none.
+    mi::Float64 m_profiling_origin;
+
+    /// The trace file started by this context, if any.
+    std::string m_profiling_trace_file;
+};
+
+/// Records the wall time of a compilation phase in an execution context.
+///
+/// Does nothing if \p context is \c NULL or MDL_CTX_OPTION_PROFILING is not set. Phases nest
+/// according to the lifetime of the scopes.
+class Profiling_scope
+{
+public:
+    Profiling_scope(Execution_context* context, const char* phase)
+      : m_context(context && context->begin_profiling_phase(phase) ? context : nullptr) { }
+
+    ~Profiling_scope() { if (m_context) m_context->end_profiling_phase(); }
+
+private:
+    Profiling_scope(const Profiling_scope&) = delete;
+    Profiling_scope& operator=(const Profiling_scope&) = delete;
+
+    Execution_context* m_context;
 };
 
 /// Outputs MDL messages to the logger.
@@ -760,6 +829,9 @@ public:
         /// Increments the usage counter of the entry.
         void increment_usage_count();
 
+        /// Get the id of the loading context that created this entry.
+        size_t get_context_id() const { return m_cache_context_id; }
+
     private:
         /// Erases this entry from the parent table and self-destructs.
         void cleanup();
@@ -827,6 +899,11 @@ public:
         /// If the module is not in the cache, \c wait has to be called on this queue entry
         /// If this pointer is NULL, too, the current thread is responsible for loading the module.
         Entry* queue_entry;
+
+        /// True, if waiting for the loading context of the module would never return, because
+        /// that context is (transitively) waiting for the current context. This can only happen
+        /// for cyclic imports loaded on different threads. The module must not be loaded then.
+        bool would_deadlock;
     };
 
     //---------------------------------------------------------------------------------------------
@@ -868,12 +945,21 @@ public:
         const std::string& module_name,
         int result_code);
 
+    /// Called by a waiting context after \c wait on the entry returned by \c lookup returned.
+    ///
+    /// \param cache            The current module cache.
+    void finished_waiting(const Module_cache* cache);
+
     /// Try free this table when the transaction is not used anymore.
     /// \param transaction      The current transaction that specifies the table to cleanup.
     void cleanup_table(size_t transaction);
 
 private:
     std::unordered_map<size_t, Table*> m_tables;
+
+    /// Maps the ids of waiting loading contexts to the ids of the contexts they are waiting for.
+    std::unordered_map<size_t, size_t> m_waiting_for;
+
     std::mutex m_mutex;
 };
 
@@ -886,6 +972,23 @@ mi::Sint32 add_context_error(
     const std::string& message,
     mi::Sint32 result);
 
+// **********  Resource sharing ********************************************************************
+
+/// Statistics about resource implementation classes shared by content hash.
+struct Resource_sharing_statistics
+{
+    /// Number of resources that reused an existing implementation class instead of loading it.
+    mi::Size m_shared_impls;
+    /// Memory of the reused implementation classes, i.e., the memory not spent on duplicates.
+    mi::Size m_bytes_saved;
+};
+
+/// Records that a resource reused an existing implementation class of size \p bytes.
+void record_shared_resource_impl( mi::Size bytes);
+
+/// Returns the statistics about shared resource implementation classes.
+Resource_sharing_statistics get_resource_sharing_statistics();
+
 // **********  Resource names **********************************************************************
 
 namespace DETAIL {
@@ -46,10 +46,12 @@
 #include <boost/core/ignore_unused.hpp>
 #include <base/system/main/access_module.h>
 #include <base/hal/disk/disk.h>
+#include <base/hal/disk/disk_memory_reader_writer_impl.h>
 #include <base/hal/hal/i_hal_ospath.h>
 #include <base/lib/log/i_log_logger.h>
 #include <base/lib/path/i_path.h>
 #include <base/data/db/i_db_transaction.h>
+#include <base/system/stlext/i_stlext_thread_budget.h>
 #include <mdl/integration/mdlnr/i_mdlnr.h>
 #include <mdl/codegenerators/generator_dag/generator_dag_tools.h>
 #include <io/scene/bsdf_measurement/i_bsdf_measurement.h>
@@ -128,6 +130,17 @@ std::string convert_os_separators_to_slashes( const std::string& s)
 #endif
 }
 
+/// Converts an MDL gamma mode into the gamma value used by TEXTURE::Texture.
+mi::Float32 convert_gamma_mode( mi::mdl::IValue_texture::gamma_mode gamma_mode)
+{
+    switch( gamma_mode) {
+        case mi::mdl::IValue_texture::gamma_default: return 0.0f; // encode as 0.0
+        case mi::mdl::IValue_texture::gamma_linear:  return 1.0f;
+        case mi::mdl::IValue_texture::gamma_srgb:    return 2.2f;
+    }
+    return 0.0f;
+}
+
 /// Calls the MDL entity resolver with the given arguments and returns the file name set, or
 /// \c NULL in case of failure. The flag \c log_messages indicates whether error messages should be
 /// logged.
@@ -343,12 +356,7 @@ DB::Tag mdl_texture_to_tag(
     if( !file_path || !file_path[0])
         return DB::Tag( 0);
 
-    mi::Float32 gamma = 0.0f;
-    switch( value->get_gamma_mode()) {
-        case mi::mdl::IValue_texture::gamma_default: gamma = 0.0f; break; // encode as 0.0
-        case mi::mdl::IValue_texture::gamma_linear:  gamma = 1.0f; break;
-        case mi::mdl::IValue_texture::gamma_srgb:    gamma = 2.2f; break;
-    }
+    mi::Float32 gamma = convert_gamma_mode( value->get_gamma_mode());
 
     // Convert string value into tag value.
     return mdl_texture_to_tag(
@@ -394,53 +402,139 @@ DB::Tag mdl_texture_to_tag(
     return tag;
 }
 
-DB::Tag mdl_light_profile_to_tag(
+Mdl_image_set* resolve_mdl_texture(
     DB::Transaction* transaction,
-    const mi::mdl::IValue_light_profile* value,
+    const mi::mdl::IValue_texture* value,
     const char* module_filename,
     const char* module_name)
 {
-    mi::Uint32 tag_uint32 = value->get_tag_value();
-
-    // Check whether the tag value is set before checking whether the string value is not set.
-    // Resources in compiled materials typically do not have the string value set.
-    if( tag_uint32)
-        return DB::Tag( tag_uint32);
+    if( value->get_tag_value())
+        return nullptr;
 
     const char* file_path = value->get_string_value();
-
-    // Fail if neither tag nor string value is set.
     if( !file_path || !file_path[0])
-        return DB::Tag( 0);
+        return nullptr;
 
-    // Convert string value into tag value.
-    return mdl_light_profile_to_tag(
-        transaction, file_path, module_filename, module_name, /*shared*/ true);
+    mi::base::Handle<mi::mdl::IMDL_resource_set> res_set( get_resource_set(
+        file_path, module_filename, module_name, /*log_messages*/ false));
+    if( !res_set)
+        return nullptr;
+
+    mi::base::Handle<Mdl_image_set> image_set( new Mdl_image_set(
+        res_set.get(), file_path, get_container_filename( res_set->get_filename( 0))));
+    if( TEXTURE::get_mdl_shared_image( transaction, image_set.get()))
+        return nullptr;
+
+    image_set->retain();
+    return image_set.get();
 }
 
-DB::Tag mdl_light_profile_to_tag(
-    DB::Transaction* transaction,
-    const char* file_path,
+namespace {
+
+// Computes the hash of the file and reads its contents into memory.
+void prefetch_resource_file( Mdl_resource_file* file)
+{
+    file->m_hash = get_hash( file->m_reader.get());
+    if( !file->m_reader->seek( 0, mi::mdl::IMDL_resource_reader::MDL_SEEK_SET))
+        return; // the file is read again when the DB element is created
+
+    DISK::Memory_writer_impl writer;
+    std::vector<char> buffer( 64 * 1024);
+    while( mi::Uint64 count = file->m_reader->read( buffer.data(), buffer.size())) {
+        if( writer.write( buffer.data(), count) != static_cast<mi::Sint64>( count))
+            return;
+    }
+
+    if( !file->m_reader->seek( 0, mi::mdl::IMDL_resource_reader::MDL_SEEK_SET))
+        return;
+
+    file->m_contents = writer.get_buffer();
+}
+
+} // namespace
+
+bool resolve_mdl_resource_file(
+    const mi::mdl::IValue_resource* value,
     const char* module_filename,
     const char* module_name,
-    bool shared)
+    Mdl_resource_file& file)
 {
-    mi::base::Handle<mi::mdl::IMDL_resource_reader> reader(
-        get_reader( file_path, module_filename, module_name, /*log_messages*/ true));
-    if( !reader) {
-        LOG::mod_log->warning( M_SCENE, LOG::Mod_log::C_IO,
-            "Failed to resolve \"%s\" in \"%s\".", file_path, module_name);
-        return DB::Tag( 0);
-    }
+    ASSERT( M_SCENE, value->get_kind() == mi::mdl::IValue::VK_LIGHT_PROFILE
+        || value->get_kind() == mi::mdl::IValue::VK_BSDF_MEASUREMENT);
+
+    if( value->get_tag_value())
+        return false;
+
+    const char* file_path = value->get_string_value();
+    if( !file_path || !file_path[0])
+        return false;
+
+    file.m_reader = get_reader( file_path, module_filename, module_name, /*log_messages*/ false);
+    if( !file.m_reader || !file.m_reader->get_filename())
+        return false;
+
+    file.m_hash = mi::base::Uuid{0,0,0,0};
+    return true;
+}
+
+void prefetch_mdl_resources(
+    const std::vector<mi::base::Handle<Mdl_image_set> >& image_sets,
+    const std::vector<Mdl_resource_file*>& files)
+{
+    // one work item per uv-tile, such that large udim sets are split among the threads as well,
+    // followed by one work item per file
+    std::vector<std::pair<Mdl_image_set*, mi::Size> > work;
+    for( const auto& image_set: image_sets)
+        for( mi::Size i = 0, n = image_set->get_length(); i < n; ++i)
+            work.push_back( std::make_pair( image_set.get(), i));
+    size_t n_work = work.size() + files.size();
+
+    // hashing right before decoding reads each file while it is still in the OS cache
+    STLEXT::parallel_for( n_work, [&work, &files]( size_t i) {
+        if( i < work.size()) {
+            work[i].first->prefetch_hash( work[i].second);
+            work[i].first->prefetch_mipmap( work[i].second);
+        } else
+            prefetch_resource_file( files[i - work.size()]);
+    });
+}
+
+DB::Tag mdl_texture_to_tag(
+    DB::Transaction* transaction,
+    const mi::mdl::IValue_texture* value,
+    Mdl_image_set* image_set,
+    const char* module_name)
+{
+    mi::Float32 gamma = convert_gamma_mode( value->get_gamma_mode());
+
+    DB::Tag tag = TEXTURE::load_mdl_texture(
+        transaction, image_set, image_set->get_hash(), /*shared*/ true, gamma);
 
-    const char* resolved_filename = reader->get_filename();
     LOG::mod_log->debug( M_SCENE, LOG::Mod_log::C_IO,
-        "Resolved \"%s\" in \"%s\" to \"%s\".", file_path, module_name, resolved_filename);
+        "Mapped \"%s\" in \"%s\" to texture \"%s\" (tag %u).",
+        value->get_string_value(),
+        module_name,
+        transaction->tag_to_name( tag), tag.get_uint());
+
+    return tag;
+}
+
+namespace {
+
+// Loads the light profile resolved to \p reader. \p contents are the contents of \p reader if
+// they have already been read, or \c NULL.
+DB::Tag load_light_profile(
+    DB::Transaction* transaction,
+    mi::mdl::IMDL_resource_reader* reader,
+    const mi::base::Uuid& hash,
+    mi::neuraylib::IReader* contents,
+    bool shared)
+{
+    const char* resolved_filename = reader->get_filename();
     ASSERT( M_SCENE, resolved_filename);
 
     DB::Tag tag;
     const std::string& absolute_mdl_file_path = reader->get_mdl_url();
-    mi::base::Uuid hash = get_hash( reader.get());
 
     if( is_container_member( resolved_filename)) {
 
@@ -448,15 +542,15 @@ DB::Tag mdl_light_profile_to_tag(
         const std::string& container_filename = get_container_filename( resolved_filename);
         const std::string& member_filename  = get_container_membername( resolved_filename);
 
-        File_reader_impl wrapped_reader( reader.get());
+        File_reader_impl wrapped_reader( reader);
         tag = LIGHTPROFILE::load_mdl_lightprofile(
-            transaction, &wrapped_reader,
+            transaction, contents ? contents : &wrapped_reader,
             container_filename, member_filename, absolute_mdl_file_path, hash, shared);
 
     } else {
 
         tag = LIGHTPROFILE::load_mdl_lightprofile(
-            transaction, resolved_filename, absolute_mdl_file_path, hash, shared);
+            transaction, resolved_filename, absolute_mdl_file_path, hash, shared, contents);
 
     }
 
@@ -466,9 +560,50 @@ DB::Tag mdl_light_profile_to_tag(
     return tag;
 }
 
-DB::Tag mdl_bsdf_measurement_to_tag(
+// Loads the BSDF measurement resolved to \p reader. \p contents are the contents of \p reader if
+// they have already been read, or \c NULL.
+DB::Tag load_bsdf_measurement(
     DB::Transaction* transaction,
-    const mi::mdl::IValue_bsdf_measurement* value,
+    mi::mdl::IMDL_resource_reader* reader,
+    const mi::base::Uuid& hash,
+    mi::neuraylib::IReader* contents,
+    bool shared)
+{
+    const char* resolved_filename = reader->get_filename();
+    ASSERT( M_SCENE, resolved_filename);
+
+    DB::Tag tag;
+    const std::string& absolute_mdl_file_path = reader->get_mdl_url();
+
+    if( is_container_member( resolved_filename)) {
+
+        // Imported resource is in an container
+        const std::string& container_filename = get_container_filename( resolved_filename);
+        const std::string& member_filename  = get_container_membername( resolved_filename);
+
+        File_reader_impl wrapped_reader( reader);
+        tag = BSDFM::load_mdl_bsdf_measurement(
+            transaction, contents ? contents : &wrapped_reader,
+            container_filename, member_filename, absolute_mdl_file_path, hash, shared);
+
+    } else {
+
+        tag = BSDFM::load_mdl_bsdf_measurement(
+            transaction, resolved_filename, absolute_mdl_file_path, hash, shared, contents);
+
+    }
+
+    LOG::mod_log->debug( M_SCENE, LOG::Mod_log::C_IO,
+        "... and mapped to scene element \"%s\" (tag %u).",
+        transaction->tag_to_name( tag), tag.get_uint());
+    return tag;
+}
+
+} // namespace
+
+DB::Tag mdl_light_profile_to_tag(
+    DB::Transaction* transaction,
+    const mi::mdl::IValue_light_profile* value,
     const char* module_filename,
     const char* module_name)
 {
@@ -486,11 +621,11 @@ DB::Tag mdl_bsdf_measurement_to_tag(
         return DB::Tag( 0);
 
     // Convert string value into tag value.
-    return mdl_bsdf_measurement_to_tag(
+    return mdl_light_profile_to_tag(
         transaction, file_path, module_filename, module_name, /*shared*/ true);
 }
 
-DB::Tag mdl_bsdf_measurement_to_tag(
+DB::Tag mdl_light_profile_to_tag(
     DB::Transaction* transaction,
     const char* file_path,
     const char* module_filename,
@@ -505,37 +640,79 @@ DB::Tag mdl_bsdf_measurement_to_tag(
         return DB::Tag( 0);
     }
 
-    const char* resolved_filename = reader->get_filename();
     LOG::mod_log->debug( M_SCENE, LOG::Mod_log::C_IO,
-        "Resolved \"%s\" in \"%s\" to \"%s\".", file_path, module_name, resolved_filename);
-    ASSERT( M_SCENE, resolved_filename);
+        "Resolved \"%s\" in \"%s\" to \"%s\".", file_path, module_name, reader->get_filename());
 
-    DB::Tag tag;
-    const std::string& absolute_mdl_file_path = reader->get_mdl_url();
-    mi::base::Uuid hash = get_hash( reader.get());
+    return load_light_profile(
+        transaction, reader.get(), get_hash( reader.get()), /*contents*/ nullptr, shared);
+}
 
-    if( is_container_member( resolved_filename)) {
+DB::Tag mdl_bsdf_measurement_to_tag(
+    DB::Transaction* transaction,
+    const mi::mdl::IValue_bsdf_measurement* value,
+    const char* module_filename,
+    const char* module_name)
+{
+    mi::Uint32 tag_uint32 = value->get_tag_value();
 
-        // Imported resource is in an container
-        const std::string& container_filename = get_container_filename( resolved_filename);
-        const std::string& member_filename  = get_container_membername( resolved_filename);
+    // Check whether the tag value is set before checking whether the string value is not set.
+    // Resources in compiled materials typically do not have the string value set.
+    if( tag_uint32)
+        return DB::Tag( tag_uint32);
 
-        File_reader_impl wrapped_reader( reader.get());
-        tag = BSDFM::load_mdl_bsdf_measurement(
-            transaction, &wrapped_reader,
-            container_filename, member_filename, absolute_mdl_file_path, hash, shared);
+    const char* file_path = value->get_string_value();
 
-    } else {
+    // Fail if neither tag nor string value is set.
+    if( !file_path || !file_path[0])
+        return DB::Tag( 0);
 
-        tag = BSDFM::load_mdl_bsdf_measurement(
-            transaction, resolved_filename, absolute_mdl_file_path, hash, shared);
+    // Convert string value into tag value.
+    return mdl_bsdf_measurement_to_tag(
+        transaction, file_path, module_filename, module_name, /*shared*/ true);
+}
 
+DB::Tag mdl_bsdf_measurement_to_tag(
+    DB::Transaction* transaction,
+    const char* file_path,
+    const char* module_filename,
+    const char* module_name,
+    bool shared)
+{
+    mi::base::Handle<mi::mdl::IMDL_resource_reader> reader(
+        get_reader( file_path, module_filename, module_name, /*log_messages*/ true));
+    if( !reader) {
+        LOG::mod_log->warning( M_SCENE, LOG::Mod_log::C_IO,
+            "Failed to resolve \"%s\" in \"%s\".", file_path, module_name);
+        return DB::Tag( 0);
     }
 
     LOG::mod_log->debug( M_SCENE, LOG::Mod_log::C_IO,
-        "... and mapped to scene element \"%s\" (tag %u).",
-        transaction->tag_to_name( tag), tag.get_uint());
-    return tag;
+        "Resolved \"%s\" in \"%s\" to \"%s\".", file_path, module_name, reader->get_filename());
+
+    return load_bsdf_measurement(
+        transaction, reader.get(), get_hash( reader.get()), /*contents*/ nullptr, shared);
+}
+
+DB::Tag mdl_resource_file_to_tag(
+    DB::Transaction* transaction,
+    const mi::mdl::IValue_resource* value,
+    const Mdl_resource_file& file,
+    const char* module_name)
+{
+    LOG::mod_log->debug( M_SCENE, LOG::Mod_log::C_IO,
+        "Resolved \"%s\" in \"%s\" to \"%s\".",
+        value->get_string_value(), module_name, file.m_reader->get_filename());
+
+    // the contents have not been read if the prefetching failed or was not worth the threads
+    mi::base::Handle<mi::neuraylib::IReader> contents(
+        file.m_contents ? new DISK::Memory_reader_impl( file.m_contents.get()) : nullptr);
+
+    if( value->get_kind() == mi::mdl::IValue::VK_LIGHT_PROFILE)
+        return load_light_profile(
+            transaction, file.m_reader.get(), file.m_hash, contents.get(), /*shared*/ true);
+    else
+        return load_bsdf_measurement(
+            transaction, file.m_reader.get(), file.m_hash, contents.get(), /*shared*/ true);
 }
 
 static mi::base::Atom32 uniq_id_for_generate_suffix;
@@ -748,7 +925,8 @@ Mdl_image_set::Mdl_image_set(
     mi::mdl::IMDL_resource_set* set, const std::string& filename, const std::string& container_filename)
   : m_resource_set( set, mi::base::DUP_INTERFACE),
     m_container_filename( container_filename),
-    m_is_container( !container_filename.empty())
+    m_is_container( !container_filename.empty()),
+    m_prefetched_mipmaps( set->get_count())
 {
     ASSERT( M_SCENE, set->get_mdl_url(0));
 
@@ -855,6 +1033,37 @@ const char* Mdl_image_set::get_image_format() const
     return "";
 }
 
+IMAGE::IMipmap* Mdl_image_set::create_mipmap( mi::Size i) const
+{
+    ASSERT( M_SCENE, i < m_prefetched_mipmaps.size());
+
+    const mi::base::Handle<IMAGE::IMipmap>& mipmap = m_prefetched_mipmaps[i];
+    if( !mipmap)
+        return DBIMAGE::Image_set::create_mipmap( i);
+
+    mipmap->retain();
+    return mipmap.get();
+}
+
+void Mdl_image_set::prefetch_mipmap( mi::Size i)
+{
+    ASSERT( M_SCENE, i < m_prefetched_mipmaps.size());
+
+    m_prefetched_mipmaps[i] = DBIMAGE::Image_set::create_mipmap( i);
+}
+
+mi::base::Uuid Mdl_image_set::get_hash() const
+{
+    return MDL::get_hash( m_resource_set.get());
+}
+
+void Mdl_image_set::prefetch_hash( mi::Size i)
+{
+    mi::base::Handle<mi::mdl::IMDL_resource_reader> reader( m_resource_set->open_reader( i));
+    if( reader)
+        MDL::get_hash( reader.get());
+}
+
 std::string lookup_thumbnail(
     const std::string& module_filename,
     const std::string& mdl_name,
@@ -38,11 +38,14 @@
 #include <mi/mdl/mdl_values.h>
 #include <mi/mdl/mdl_generated_dag.h>
 #include <mi/mdl/mdl_entity_resolver.h>
+#include <mi/neuraylib/ibuffer.h>
 #include <mi/neuraylib/ireader.h>
 #include <string>
+#include <vector>
 #include <boost/unordered_map.hpp>
 #include <base/data/db/i_db_tag.h>
 #include <io/image/image/i_image.h>
+#include <io/image/image/i_image_mipmap.h>
 #include <io/scene/dbimage/i_dbimage.h>
 
 namespace mi { namespace mdl {
@@ -482,14 +485,103 @@ public:
 
     const char* get_image_format() const;
 
+    /// Returns the mipmap created by #prefetch_mipmap() if available, or creates it otherwise.
+    IMAGE::IMipmap* create_mipmap( mi::Size i) const;
+
+    /// Creates the mipmap for the i'th uv-tile in advance.
+    ///
+    /// Calls for different uv-tiles may run concurrently.
+    void prefetch_mipmap( mi::Size i);
+
+    /// Returns the hash of the resource set, see #MDL::get_hash().
+    mi::base::Uuid get_hash() const;
+
+    /// Computes the content hash of the i'th uv-tile in advance, such that #get_hash() finds it
+    /// in the content hash index.
+    ///
+    /// Calls for different uv-tiles may run concurrently.
+    void prefetch_hash( mi::Size i);
+
 private:
 
     mi::base::Handle<mi::mdl::IMDL_resource_set> m_resource_set;
     std::string m_mdl_file_path;
     std::string m_container_filename;
     bool m_is_container;
+    std::vector<mi::base::Handle<IMAGE::IMipmap> > m_prefetched_mipmaps;
 };
 
+/// Resolves an MDL texture and creates its image set, without creating any mipmaps.
+///
+/// \param transaction          The DB transaction to use.
+/// \param value                The MDL texture to resolve.
+/// \param module_filename      Absolute filename of the MDL module (using OS-specific separators),
+///                             or \c NULL for string-based modules.
+/// \param module_name          The fully-qualified MDL module name.
+/// \return                     The image set, or \c NULL if the texture has already a tag value,
+///                             can not be resolved, or if its image exists already in the DB.
+///                             Failures are not reported, #mdl_texture_to_tag() will do that.
+Mdl_image_set* resolve_mdl_texture(
+    DB::Transaction* transaction,
+    const mi::mdl::IValue_texture* value,
+    const char* module_filename,
+    const char* module_name);
+
+/// A light profile or BSDF measurement resolved in advance by #resolve_mdl_resource_file().
+///
+/// #prefetch_mdl_resources() fills in the hash and the contents of the file, such that only
+/// parsing the contents is left for #mdl_resource_file_to_tag().
+struct Mdl_resource_file
+{
+    mi::base::Handle<mi::mdl::IMDL_resource_reader> m_reader;
+    mi::base::Uuid m_hash;
+    mi::base::Handle<mi::neuraylib::IBuffer> m_contents;
+};
+
+/// Resolves an MDL light profile or BSDF measurement, without reading the file.
+///
+/// \param value                The MDL light profile or BSDF measurement to resolve.
+/// \param module_filename      Absolute filename of the MDL module (using OS-specific separators),
+///                             or \c NULL for string-based modules.
+/// \param module_name          The fully-qualified MDL module name.
+/// \param[out] file            The resolved file.
+/// \return                     \c false if the resource has already a tag value or can not be
+///                             resolved. Failures are not reported, #mdl_resource_to_tag() will
+///                             do that.
+bool resolve_mdl_resource_file(
+    const mi::mdl::IValue_resource* value,
+    const char* module_filename,
+    const char* module_name,
+    Mdl_resource_file& file);
+
+/// Hashes the content and creates the mipmaps of all uv-tiles of the given image sets, and hashes
+/// and reads the given light profile and BSDF measurement files, on worker threads.
+///
+/// Returns when all work items are done. Storing the resources in the DB is left to the caller,
+/// such that the assignment of tags does not depend on the thread scheduling.
+void prefetch_mdl_resources(
+    const std::vector<mi::base::Handle<Mdl_image_set> >& image_sets,
+    const std::vector<Mdl_resource_file*>& files);
+
+/// Returns the DB tag corresponding to an MDL texture resolved by #resolve_mdl_texture().
+///
+/// \see #mdl_resource_to_tag(). The found resources are always shared.
+DB::Tag mdl_texture_to_tag(
+    DB::Transaction* transaction,
+    const mi::mdl::IValue_texture* value,
+    Mdl_image_set* image_set,
+    const char* module_name);
+
+/// Returns the DB tag corresponding to an MDL light profile or BSDF measurement resolved by
+/// #resolve_mdl_resource_file().
+///
+/// \see #mdl_resource_to_tag(). The found resources are always shared.
+DB::Tag mdl_resource_file_to_tag(
+    DB::Transaction* transaction,
+    const mi::mdl::IValue_resource* value,
+    const Mdl_resource_file& file,
+    const char* module_name);
+
 } // namespace DETAIL
 
 } // namespace MDL
@@ -116,6 +116,10 @@ Mdl_material_instance::Mdl_material_instance( const Mdl_material_instance& other
     other.m_arguments.get(), /*transaction*/ nullptr, /*copy_immutable_calls*/ false))
 , m_enable_if_conditions( other.m_enable_if_conditions)  // shared, no clone necessary
 {
+    // edited copies start from the last compilation of the original
+    std::lock_guard<std::mutex> lock( other.m_last_instance_mutex);
+    m_last_instance = other.m_last_instance;
+    m_last_code_dag = other.m_last_code_dag;
 }
 
 DB::Tag Mdl_material_instance::get_material_definition(DB::Transaction* transaction) const
@@ -280,6 +284,8 @@ Mdl_compiled_material* Mdl_material_instance::create_compiled_material(
 {
     context->clear_messages();
 
+    Profiling_scope profiling_scope(context, "compile_material");
+
     if (!is_valid(transaction, context)) {
         add_and_log_message(context, Message(mi::base::MESSAGE_SEVERITY_ERROR,
             "The material instance is invalid."), -1);
@@ -307,6 +313,7 @@ Mdl_compiled_material* Mdl_material_instance::create_compiled_material(
     mi::Float32 mdl_wavelength_max = context->get_option<mi::Float32>(MDL_CTX_OPTION_WAVELENGTH_MAX);
     bool load_resources = context->get_option<bool>(MDL_CTX_OPTION_RESOLVE_RESOURCES);
 
+    Profiling_scope convert_scope(context, "create_compiled_material");
     return new Mdl_compiled_material(
         transaction, instance.get(), module_filename, module_name,
         mdl_meters_per_scene_unit, mdl_wavelength_min, mdl_wavelength_max, load_resources);
@@ -344,6 +351,16 @@ Mdl_material_instance::create_dag_material_instance(
         MDL_CTX_OPTION_WAVELENGTH_MAX);
     bool fold_tn = context->get_option<bool>(
         MDL_CTX_OPTION_FOLD_TERNARY_ON_DF);
+    bool incremental = !class_compilation && context->get_option<bool>(
+        MDL_CTX_OPTION_INCREMENTAL_INSTANTIATION);
+
+    // reuse the argument sub-DAGs instantiated by the last compilation, if it is based on the
+    // same code DAG
+    if( incremental) {
+        std::lock_guard<std::mutex> lock( m_last_instance_mutex);
+        if( m_last_code_dag.get() == code_dag.get())
+            instance->set_previous_instance( m_last_instance.get());
+    }
 
     // convert m_arguments to DAG nodes
     mi::Uint32 n = code_dag->get_material_parameter_count(material_index);
@@ -382,6 +399,7 @@ Mdl_material_instance::create_dag_material_instance(
         :
               mi::mdl::IGenerated_code_dag::IMaterial_instance::INSTANCE_COMPILATION;
 
+    Profiling_scope profiling_scope(context, "instantiate_dag");
     error_code = instance->initialize(
         &resolver,
         /*resource_modifier=*/NULL,
@@ -434,6 +452,12 @@ Mdl_material_instance::create_dag_material_instance(
         return 0;
     }
 
+    if( incremental) {
+        std::lock_guard<std::mutex> lock( m_last_instance_mutex);
+        m_last_instance = instance;
+        m_last_code_dag = code_dag;
+    }
+
     instance->retain();
     return instance.get();
 }
@@ -628,6 +652,18 @@ void Mdl_material_instance::swap( Mdl_material_instance& other)
     std::swap( m_parameter_types, other.m_parameter_types);
     std::swap( m_arguments, other.m_arguments);
     std::swap( m_enable_if_conditions, other.m_enable_if_conditions);
+
+    // locking the same mutex twice would deadlock
+    if( this == &other)
+        return;
+
+    // lock both caches in a deadlock-free order, concurrent swaps may pass them the other way
+    std::lock( m_last_instance_mutex, other.m_last_instance_mutex);
+    std::lock_guard<std::mutex> lock( m_last_instance_mutex, std::adopt_lock);
+    std::lock_guard<std::mutex> other_lock( other.m_last_instance_mutex, std::adopt_lock);
+
+    std::swap( m_last_instance, other.m_last_instance);
+    std::swap( m_last_code_dag, other.m_last_code_dag);
 }
 
 const SERIAL::Serializable* Mdl_material_instance::serialize( SERIAL::Serializer* serializer) const
@@ -105,6 +105,48 @@ private:
     mi::base::Handle<const mi::mdl::IModule> m_module;
 };
 
+/// Creates the DB element of a function or material definition when it is accessed for the first
+/// time. Keeps the code DAG of the module alive until then.
+template <class T>
+class Definition_factory : public DB::Element_factory
+{
+public:
+    Definition_factory(
+        Mdl_ident module_ident,
+        const mi::mdl::IGenerated_code_dag* code_dag,
+        mi::Uint32 index,
+        const char* module_filename,
+        const char* module_name,
+        bool load_resources)
+      : m_module_ident( module_ident)
+      , m_code_dag( code_dag, mi::base::DUP_INTERFACE)
+      , m_index( index)
+      , m_has_module_filename( module_filename != 0)
+      , m_module_filename( module_filename ? module_filename : "")
+      , m_module_name( module_name)
+      , m_load_resources( load_resources)
+    {
+    }
+
+    SERIAL::Class_id get_class_id() const { return T::id; }
+
+    DB::Element_base* create_element( DB::Transaction* transaction, DB::Tag tag)
+    {
+        return new T( transaction, tag, m_module_ident, m_code_dag.get(), m_index,
+            m_has_module_filename ? m_module_filename.c_str() : 0, m_module_name.c_str(),
+            m_load_resources);
+    }
+
+private:
+    Mdl_ident m_module_ident;
+    mi::base::Handle<const mi::mdl::IGenerated_code_dag> m_code_dag;
+    mi::Uint32 m_index;
+    bool m_has_module_filename;
+    std::string m_module_filename;
+    std::string m_module_name;
+    bool m_load_resources;
+};
+
 // Implements the ICall interface for a function call.
 class Function_call : public ICall
 {
@@ -279,6 +321,11 @@ void set_context_options(
     bool experimental_features = src_context->get_option<bool>(MDL_CTX_OPTION_EXPERIMENTAL);
     options.set_option(MDL_OPTION_EXPERIMENTAL_FEATURES,
         experimental_features ? "true" : "false");
+
+    // the DB module cache supports concurrent lookups from the compiler's worker threads
+    bool parallel_imports = src_context->get_option<bool>(MDL_CTX_OPTION_PARALLEL_IMPORTS);
+    options.set_option(MDL_OPTION_PARALLEL_IMPORTS,
+        parallel_imports ? "true" : "false");
 }
 
 class Module_loaded_callback : public mi::mdl::IModule_loaded_callback
@@ -439,6 +486,8 @@ mi::Sint32 Mdl_module::create_module(
     context->clear_messages();
     context->set_result(0);
 
+    Profiling_scope profiling_scope(context, "load_module");
+
     SYSTEM::Access_module<MDLC::Mdlc_module> mdlc_module( false);
     mi::base::Handle<mi::mdl::IMDL> mdl( mdlc_module->get_mdl());
 
@@ -539,6 +588,8 @@ mi::Sint32 Mdl_module::create_module(
     context->clear_messages();
     context->set_result(0);
 
+    Profiling_scope profiling_scope(context, "load_module_from_string");
+
     SYSTEM::Access_module<MDLC::Mdlc_module> mdlc_module( false);
     mi::base::Handle<mi::mdl::IMDL> mdl( mdlc_module->get_mdl());
 
@@ -896,6 +947,8 @@ static mi::mdl::IGenerated_code_dag* compile_module(
     const mi::mdl::IModule* module,
     Execution_context *context)
 {
+    Profiling_scope profiling_scope(context, "compile_module_dag");
+
     // Compile the module.
     mi::base::Handle<mi::mdl::ICode_generator_dag> generator_dag
         = mi::base::make_handle(mdl->load_code_generator("dag"))
@@ -948,12 +1001,15 @@ static mi::mdl::IGenerated_code_dag* compile_module(
         code->get_interface<mi::mdl::IGenerated_code_dag>());
 
     if (context->get_option<bool>(MDL_CTX_OPTION_RESOLVE_RESOURCES)) {
+        Profiling_scope resources_scope(context, "resolve_resources");
+
         const char* module_filename = module->get_filename();
         if (module_filename[0] == '\0')
             module_filename = nullptr;
         Mdl_call_resolver_ext resolver(transaction, module);
         Resource_updater updater(
-            transaction, resolver, code_dag.get(), module_filename, module->get_name());
+            transaction, resolver, code_dag.get(), module_filename, module->get_name(),
+            context->get_option<bool>(MDL_CTX_OPTION_PARALLEL_RESOURCE_LOADING));
 
         updater.update_resource_literals();
     }
@@ -978,6 +1034,11 @@ mi::Sint32 Mdl_module::create_module_internal(
         module_filename = 0;
     ASSERT( M_SCENE, !mdl->is_builtin_module( module_name) || !module_filename);
 
+    std::string profiling_phase;
+    if( context->get_option<bool>( MDL_CTX_OPTION_PROFILING))
+        profiling_phase = std::string( "register_module ") + module_name;
+    Profiling_scope profiling_scope( context, profiling_phase.c_str());
+
     report_messages( module->access_messages(), context);
     if( !module->is_valid())
         return -2;
@@ -1096,22 +1157,21 @@ mi::Sint32 Mdl_module::create_module_internal(
         mdl, module, code_dag.get(), imports, function_tags, material_tags, load_resources);
 
     DB::Privacy_level privacy_level = transaction->get_scope()->get_level();
-    // Create DB elements for the function definitions in this module.
+    // Register DB elements for the function definitions in this module. They are created when
+    // accessed for the first time.
     for( mi::Uint32 i = 0; i < function_count; ++i) {
-        Mdl_function_definition* db_function = new Mdl_function_definition(transaction,
-            function_tags[i].first, module_id, code_dag.get(), i, module_filename, module_name,
-            load_resources);
-        transaction->store_for_reference_counting(
-            function_tags[i].first, db_function, function_names[i].c_str(), privacy_level);
+        DB::Element_factory* factory = new Definition_factory<Mdl_function_definition>(
+            module_id, code_dag.get(), i, module_filename, module_name, load_resources);
+        transaction->store_lazily_for_reference_counting(
+            function_tags[i].first, factory, function_names[i].c_str(), privacy_level);
     }
 
-    // Create DB elements for the material definitions in this module.
+    // Register DB elements for the material definitions in this module.
     for( mi::Uint32 i = 0; i < material_count; ++i) {
-        Mdl_material_definition* db_material = new Mdl_material_definition(transaction,
-            material_tags[i].first, module_id, code_dag.get(), i, module_filename, module_name,
-            load_resources);
-        transaction->store_for_reference_counting(
-            material_tags[i].first, db_material, material_names[i].c_str(), privacy_level);
+        DB::Element_factory* factory = new Definition_factory<Mdl_material_definition>(
+            module_id, code_dag.get(), i, module_filename, module_name, load_resources);
+        transaction->store_lazily_for_reference_counting(
+            material_tags[i].first, factory, material_names[i].c_str(), privacy_level);
     }
 
     // Store the module in the DB.
@@ -2017,13 +2077,13 @@ mi::Sint32 Mdl_module::reload_module_internal(
         if (it == m_function_name_to_index.end()) {
             // does not exist or signature changed, recreate
             DB::Tag new_tag = transaction->reserve_tag();
-            Mdl_function_definition* db_function = new Mdl_function_definition(transaction,
-                new_tag, m_ident, m_code_dag.get(), i, m_file_name.c_str(), m_name.c_str(),
+            DB::Element_factory* factory = new Definition_factory<Mdl_function_definition>(
+                m_ident, m_code_dag.get(), i, m_file_name.c_str(), m_name.c_str(),
                 load_resources);
 
             new_functions[i] = Mdl_tag_ident(new_tag, m_ident);
-            transaction->store_for_reference_counting(
-                new_tag, db_function, function_names[i].c_str(), privacy_level);
+            transaction->store_lazily_for_reference_counting(
+                new_tag, factory, function_names[i].c_str(), privacy_level);
         }
         else {
             DB::Tag reused_tag = m_functions[it->second].first;
@@ -2054,13 +2114,13 @@ mi::Sint32 Mdl_module::reload_module_internal(
         if (it == m_material_name_to_index.end()) {
             // does not exist or signature changed, recreate
             DB::Tag new_tag = transaction->reserve_tag();
-            Mdl_material_definition* db_material = new Mdl_material_definition(transaction,
-                new_tag, m_ident, m_code_dag.get(), i, m_file_name.c_str(), m_name.c_str(),
+            DB::Element_factory* factory = new Definition_factory<Mdl_material_definition>(
+                m_ident, m_code_dag.get(), i, m_file_name.c_str(), m_name.c_str(),
                 load_resources);
 
             new_materials[i] = Mdl_tag_ident(new_tag, m_ident);
-            transaction->store_for_reference_counting(
-                new_tag, db_material, material_names[i].c_str(), privacy_level);
+            transaction->store_lazily_for_reference_counting(
+                new_tag, factory, material_names[i].c_str(), privacy_level);
         }
         else {
             DB::Tag reused_tag = m_materials[it->second].first;
@@ -55,13 +55,16 @@
 #include <boost/functional/hash.hpp>
 #include <base/util/string_utils/i_string_lexicographic_cast.h>
 #include <base/util/string_utils/i_string_utils.h>
+#include <base/hal/disk/disk.h>
 #include <base/hal/disk/disk_memory_reader_writer_impl.h>
 #include <base/hal/hal/i_hal_ospath.h>
+#include <base/hal/time/i_time.h>
 #include <base/lib/log/i_log_logger.h>
 #include <base/data/db/i_db_access.h>
 #include <base/data/db/i_db_tag.h>
 #include <base/data/db/i_db_transaction.h>
 #include <base/data/serial/i_serializer.h>
+#include <mdl/compiler/compilercore/compilercore_hash.h>
 #include <mdl/compiler/compilercore/compilercore_visitor.h>
 #include <mdl/codegenerators/generator_code/generator_code.h>
 #include <mdl/codegenerators/generator_dag/generator_dag_tools.h>
@@ -78,6 +81,12 @@
 #include <boost/uuid/uuid_generators.hpp>
 #include <boost/uuid/uuid_io.hpp>
 
+#include <atomic>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <vector>
+
 namespace MI {
 
 namespace MDL {
@@ -4914,24 +4923,61 @@ Resource_updater::Resource_updater(
     mi::mdl::ICall_name_resolver &resolver,
     mi::mdl::IGenerated_code_dag* code_dag,
     const char* module_filename,
-    const char* module_name)
+    const char* module_name,
+    bool parallel)
 : m_transaction(transaction)
 , m_resolver(resolver)
 , m_code_dag(code_dag)
 , m_module_filename(module_filename)
 , m_module_name(module_name)
+, m_parallel(parallel)
+, m_collect_resources(false)
 , m_resorce_tag_cache()
+, m_prefetched_textures()
+, m_prefetched_paths()
+, m_prefetched_files()
+, m_prefetched_file_paths()
+{
+}
+
+// Destructor.
+Resource_updater::~Resource_updater()
 {
 }
 
 // Update one resource in the current context.
 void Resource_updater::update_resource(mi::mdl::IValue_resource const *resource)
 {
+    if (m_collect_resources) {
+        if (mi::mdl::IValue_texture const *texture = as<mi::mdl::IValue_texture>(resource))
+            collect_texture(texture);
+        else
+            collect_resource_file(resource);
+        return;
+    }
+
     Resource_tag_cache::const_iterator it = m_resorce_tag_cache.find(resource);
     if (it == m_resorce_tag_cache.end()) {
         // loads the resource
-        DB::Tag tag = DETAIL::mdl_resource_to_tag(
-            m_transaction, resource, m_module_filename, m_module_name);
+        DB::Tag tag;
+        Prefetched_textures::const_iterator pit = m_prefetched_textures.find(resource);
+        Prefetched_files::const_iterator fit = m_prefetched_files.find(resource);
+        if (pit != m_prefetched_textures.end()) {
+            tag = DETAIL::mdl_texture_to_tag(
+                m_transaction,
+                cast<mi::mdl::IValue_texture>(resource),
+                pit->second.m_image_set.get(),
+                m_module_name);
+        } else if (fit != m_prefetched_files.end()) {
+            tag = DETAIL::mdl_resource_file_to_tag(
+                m_transaction,
+                resource,
+                *fit->second,
+                m_module_name);
+        } else {
+            tag = DETAIL::mdl_resource_to_tag(
+                m_transaction, resource, m_module_filename, m_module_name);
+        }
         it = m_resorce_tag_cache.insert(Resource_tag_cache::value_type(resource, tag)).first;
     }
 
@@ -4988,7 +5034,98 @@ void Resource_updater::update_resource_literals(
     }
 }
 
+// Resolves a texture and records it for prefetch_textures().
+void Resource_updater::collect_texture(mi::mdl::IValue_texture const *texture)
+{
+    if (m_prefetched_textures.find(texture) != m_prefetched_textures.end())
+        return;
+
+    // literals with the same file path (but possibly different gamma) share the image set
+    char const *file_path = texture->get_string_value();
+    if (file_path != NULL) {
+        Prefetched_paths::const_iterator it = m_prefetched_paths.find(file_path);
+        if (it != m_prefetched_paths.end()) {
+            m_prefetched_textures.insert(Prefetched_textures::value_type(texture, it->second));
+            return;
+        }
+    }
+
+    Prefetched_texture prefetched;
+    prefetched.m_image_set = DETAIL::resolve_mdl_texture(
+        m_transaction, texture, m_module_filename, m_module_name);
+    if (!prefetched.m_image_set)
+        return;
+
+    m_prefetched_textures.insert(Prefetched_textures::value_type(texture, prefetched));
+    m_prefetched_paths.insert(Prefetched_paths::value_type(file_path, prefetched));
+}
+
+// Resolves a light profile or BSDF measurement and records it for prefetch_resources().
+void Resource_updater::collect_resource_file(mi::mdl::IValue_resource const *resource)
+{
+    if (m_prefetched_files.find(resource) != m_prefetched_files.end())
+        return;
+
+    char const *file_path = resource->get_string_value();
+    if (file_path == NULL)
+        return;
+
+    // literals with the same file path share the file
+    Prefetched_file_paths::const_iterator it = m_prefetched_file_paths.find(file_path);
+    if (it == m_prefetched_file_paths.end()) {
+        DETAIL::Mdl_resource_file file;
+        if (!DETAIL::resolve_mdl_resource_file(
+                resource, m_module_filename, m_module_name, file))
+            return;
+        it = m_prefetched_file_paths.insert(
+            Prefetched_file_paths::value_type(file_path, file)).first;
+    }
+
+    m_prefetched_files.insert(Prefetched_files::value_type(resource, &it->second));
+}
+
+// Creates the mipmaps of all collected textures and reads all collected light profiles and BSDF
+// measurements on worker threads.
+void Resource_updater::prefetch_resources()
+{
+    std::vector<mi::base::Handle<DETAIL::Mdl_image_set> > image_sets;
+    image_sets.reserve(m_prefetched_paths.size());
+    for (Prefetched_paths::const_iterator it(m_prefetched_paths.begin()),
+            end(m_prefetched_paths.end()); it != end; ++it) {
+        image_sets.push_back(it->second.m_image_set);
+    }
+
+    std::vector<DETAIL::Mdl_resource_file *> files;
+    files.reserve(m_prefetched_file_paths.size());
+    for (Prefetched_file_paths::iterator it(m_prefetched_file_paths.begin()),
+            end(m_prefetched_file_paths.end()); it != end; ++it) {
+        files.push_back(&it->second);
+    }
+
+    DETAIL::prefetch_mdl_resources(image_sets, files);
+}
+
 void Resource_updater::update_resource_literals()
+{
+    if (m_parallel) {
+        // resolve all resources first, so their files can be loaded in parallel; the DB
+        // elements are created afterwards in traversal order
+        m_collect_resources = true;
+        update_code_dag();
+        m_collect_resources = false;
+
+        prefetch_resources();
+    }
+
+    update_code_dag();
+
+    m_prefetched_textures.clear();
+    m_prefetched_paths.clear();
+    m_prefetched_files.clear();
+    m_prefetched_file_paths.clear();
+}
+
+void Resource_updater::update_code_dag()
 {
     mi::Uint32 material_count = m_code_dag->get_material_count();
     for (mi::Uint32 i = 0; i < material_count; ++i) {
@@ -5664,7 +5801,7 @@ Mdl_module_wait_queue::Queue_lockup Mdl_module_wait_queue::lookup(
     const std::string& name)
 {
     std::unique_lock<std::mutex> lock(m_mutex);
-    Queue_lockup result{nullptr, nullptr};
+    Queue_lockup result{nullptr, nullptr, false};
 
     // check if the module is already in the cache
     result.cached_module = cache->lookup_db(name.c_str());
@@ -5694,11 +5831,39 @@ Mdl_module_wait_queue::Queue_lockup Mdl_module_wait_queue::lookup(
         result.queue_entry = nullptr;
 
     if (result.queue_entry != nullptr)
+    {
+        // the loading context might wait (transitively) for the current one, which happens
+        // for import cycles between modules loaded on different threads
+        size_t current = cache->get_loading_context_id();
+        size_t owner = result.queue_entry->get_context_id();
+        for (;;)
+        {
+            if (owner == current)
+            {
+                result.queue_entry = nullptr;
+                result.would_deadlock = true;
+                return result;
+            }
+            auto found_waiting = m_waiting_for.find(owner);
+            if (found_waiting == m_waiting_for.end())
+                break;
+            owner = found_waiting->second;
+        }
+
+        m_waiting_for[current] = result.queue_entry->get_context_id();
         result.queue_entry->increment_usage_count();
+    }
 
     return result;
 }
 
+// Called by a waiting context after waiting for a loading context finished.
+void Mdl_module_wait_queue::finished_waiting(const Module_cache* cache)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_waiting_for.erase(cache->get_loading_context_id());
+}
+
 // Check if this module is loaded by the current thread.
 bool Mdl_module_wait_queue::processed_in_current_context(
     const Module_cache* cache, 
@@ -5826,6 +5991,9 @@ Module_cache::Module_cache(
     Mdl_module_wait_queue* queue,
     const DB::Tag_set& module_ignore_list)
     : m_context_id(s_context_counter++)
+    , m_creator_thread(std::this_thread::get_id())
+    , m_worker_contexts_mutex()
+    , m_worker_contexts()
     , m_transaction(transaction)
     , m_queue(queue)
     , m_module_load_callback(nullptr)
@@ -5889,6 +6057,10 @@ const mi::mdl::IModule* Module_cache::lookup(
         return lookup.cached_module;
     }
 
+    // waiting would never return, handle it like a failure on a different thread
+    if (lookup.would_deadlock)
+        return nullptr;
+
     // this thread is supposed to load the module, do not wait, start loading instead
     if (!lookup.queue_entry)
     {
@@ -5901,6 +6073,7 @@ const mi::mdl::IModule* Module_cache::lookup(
     // wait until the module is loaded
     // printf_s("[info] waiting for thread loading '%s'\n", module_name);
     mi::Sint32 result_code = lookup.queue_entry->wait(this);
+    m_queue->finished_waiting(this);
 
     // loading thread reported success
     if (result_code >= 0)
@@ -5937,6 +6110,23 @@ const mi::mdl::IModule* Module_cache::lookup_db(DB::Tag &tag) const
     return module->get_mdl_module();
 }
 
+size_t Module_cache::get_loading_context_id() const
+{
+    std::thread::id thread = std::this_thread::get_id();
+    if (thread == m_creator_thread)
+        return m_context_id;
+
+    // worker threads of the compiler get a context of their own
+    std::unique_lock<std::mutex> lock(m_worker_contexts_mutex);
+    auto found = m_worker_contexts.find(thread);
+    if (found != m_worker_contexts.end())
+        return found->second;
+
+    size_t context_id = s_context_counter++;
+    m_worker_contexts[thread] = context_id;
+    return context_id;
+}
+
 /// Check if this module is loaded by the current thread.
 bool Module_cache::loading_process_started_in_current_context(const char* module_name) const
 {
@@ -6344,7 +6534,10 @@ bool validate_space(const STLEXT::Any& value)
 }
 }
 
-Execution_context::Execution_context() : m_result(0)
+Execution_context::Execution_context()
+  : m_result(0)
+  , m_profiling_current(~mi::Size(0))
+  , m_profiling_origin(-1.0)
 {
     mi::base::Handle<mi::base::IInterface> null_interface(nullptr);
 
@@ -6357,9 +6550,14 @@ Execution_context::Execution_context() : m_result(0)
     add_option(Option(MDL_CTX_OPTION_BUNDLE_RESOURCES, false));
     add_option(Option(MDL_CTX_OPTION_EXPERIMENTAL, false));
     add_option(Option(MDL_CTX_OPTION_RESOLVE_RESOURCES, true));
+    add_option(Option(MDL_CTX_OPTION_PARALLEL_IMPORTS, false));
+    add_option(Option(MDL_CTX_OPTION_PARALLEL_RESOURCE_LOADING, false));
     add_option(Option(MDL_CTX_OPTION_FOLD_TERNARY_ON_DF, false));
+    add_option(Option(MDL_CTX_OPTION_INCREMENTAL_INSTANTIATION, false));
     add_option(Option(MDL_CTX_OPTION_LOADING_WAIT_HANDLE_FACTORY, null_interface));
     add_option(Option(MDL_CTX_OPTION_REPLACE_EXISTING, false));
+    add_option(Option(MDL_CTX_OPTION_PROFILING, false));
+    add_option(Option(MDL_CTX_OPTION_PROFILING_TRACE_FILE, std::string("")));
 }
 
 mi::Size Execution_context::get_messages_count() const
@@ -6487,6 +6685,141 @@ void Execution_context::add_option(const Option& option)
     m_options_2_index[option.get_name()] = m_options.size() - 1;
 }
 
+bool Execution_context::begin_profiling_phase(const char* name)
+{
+    if (!get_option<bool>(MDL_CTX_OPTION_PROFILING))
+        return false;
+
+    // phases started on worker threads (e.g. for parallel imports) are not recorded, the
+    // context is not thread-safe
+    std::thread::id this_thread = std::this_thread::get_id();
+    if (m_profiling_current == ~mi::Size(0))
+        m_profiling_thread = this_thread;
+    else if (m_profiling_thread != this_thread)
+        return false;
+
+    Profiling_phase phase;
+    phase.m_name     = name;
+    phase.m_parent   = m_profiling_current;
+    phase.m_start    = TIME::get_time().get_seconds();
+    phase.m_duration = -1.0;
+    phase.m_thread   = std::hash<std::thread::id>()(this_thread);
+
+    if (m_profiling_origin < 0.0)
+        m_profiling_origin = phase.m_start;
+
+    m_profiling_current = m_profiling_phases.size();
+    m_profiling_phases.push_back(phase);
+    return true;
+}
+
+void Execution_context::end_profiling_phase()
+{
+    ASSERT(M_SCENE, m_profiling_current < m_profiling_phases.size());
+
+    Profiling_phase& phase = m_profiling_phases[m_profiling_current];
+    phase.m_duration = TIME::get_time().get_seconds() - phase.m_start;
+
+    mi::Size index = m_profiling_current;
+    m_profiling_current = phase.m_parent;
+    if (m_profiling_current != ~mi::Size(0))
+        return;
+
+    add_message(get_profiling_message(index));
+
+    const std::string& filename = get_option<std::string>(MDL_CTX_OPTION_PROFILING_TRACE_FILE);
+    if (!filename.empty())
+        write_profiling_trace(filename);
+
+    // all phases have been reported, do not keep them for the next outermost phase
+    m_profiling_phases.clear();
+}
+
+Message Execution_context::get_profiling_message(mi::Size index) const
+{
+    const Profiling_phase& phase = m_profiling_phases[index];
+
+    // the code holds the wall time in microseconds
+    mi::Float64 us = std::min(phase.m_duration * 1e6, mi::Float64(0x7fffffff));
+    Message message(
+        mi::base::MESSAGE_SEVERITY_INFO,
+        STRING::formatted_string("%s: %.3f ms", phase.m_name.c_str(), phase.m_duration * 1e3),
+        static_cast<mi::Sint32>(us),
+        Message::MSG_PROFILING);
+
+    // phases are recorded in start order, hence nested phases follow their parent
+    for (mi::Size i = index + 1, n = m_profiling_phases.size(); i < n; ++i) {
+        if (m_profiling_phases[i].m_parent == index)
+            message.m_notes.push_back(get_profiling_message(i));
+    }
+    return message;
+}
+
+namespace {
+
+/// Escapes quotes and backslashes for use in a JSON string.
+std::string escape_json(const std::string& s)
+{
+    std::string result;
+    result.reserve(s.size());
+    for (char c : s) {
+        if (c == '"' || c == '\\')
+            result += '\\';
+        result += c;
+    }
+    return result;
+}
+
+} // anonymous
+
+void Execution_context::write_profiling_trace(const std::string& filename)
+{
+    static const char trailer[] = "\n]}\n";
+
+    // append the new events by overwriting the trailer of a file started before, such that the
+    // cost does not depend on the number of phases written earlier
+    bool append = false;
+    FILE* file = nullptr;
+    if (filename == m_profiling_trace_file) {
+        file = DISK::fopen(filename.c_str(), "r+b");
+        if (file && fseek(file, -long(sizeof(trailer) - 1), SEEK_END) == 0)
+            append = true;
+        else if (file) {
+            fclose(file);
+            file = nullptr;
+        }
+    }
+    if (!append)
+        file = DISK::fopen(filename.c_str(), "wb");
+    if (!file) {
+        LOG::mod_log->warning(M_SCENE, LOG::Mod_log::C_IO,
+            "Failed to write profiling trace \"%s\".", filename.c_str());
+        m_profiling_trace_file.clear();
+        return;
+    }
+
+    if (!append)
+        fputs("{\"traceEvents\":[\n", file);
+    for (mi::Size i = 0, n = m_profiling_phases.size(); i < n; ++i) {
+        const Profiling_phase& phase = m_profiling_phases[i];
+        if (phase.m_duration < 0.0)
+            continue;
+        fprintf(file,
+            "%s{\"name\":\"%s\",\"cat\":\"mdl\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,"
+            "\"pid\":0,\"tid\":%llu}",
+            append ? ",\n" : "",
+            escape_json(phase.m_name).c_str(),
+            (phase.m_start - m_profiling_origin) * 1e6,
+            phase.m_duration * 1e6,
+            static_cast<unsigned long long>(phase.m_thread));
+        append = true;
+    }
+    fputs(trailer, file);
+    fclose(file);
+
+    m_profiling_trace_file = filename;
+}
+
 namespace {
 struct Entry {
     Entry(
@@ -6871,10 +7204,84 @@ mi::base::Uuid convert_hash( const unsigned char h[16])
     return result;
 }
 
+namespace {
+
+/// An entry of the content hash index.
+struct Content_hash_entry
+{
+    Sint64 m_size;               ///< size of the file (or container) when hashed
+    TIME::Time m_modification_time; ///< modification time of the file (or container) when hashed
+    unsigned char m_hash[16];    ///< the MD5 hash of the resource content
+};
+
+/// Content hashes of resources by resolved filename, such that resources referenced repeatedly
+/// are read only once for hashing.
+std::map<std::string, Content_hash_entry> g_content_hash_index;
+
+/// Protects g_content_hash_index.
+std::mutex g_content_hash_index_mutex;
+
+/// Computes the MD5 hash of the content of \p reader and rewinds it.
+///
+/// The hash is looked up in the content hash index first. Entries are invalidated if size or
+/// modification time of the file (or of the container for container members) changed.
+bool get_content_hash( mi::mdl::IMDL_resource_reader* reader, unsigned char hash[16])
+{
+    const char* filename = reader->get_filename();
+    if( !filename || !filename[0])
+        return false;
+
+    std::string stat_filename = DETAIL::is_container_member( filename)
+        ? DETAIL::get_container_filename( filename) : std::string( filename);
+    DISK::Stat file_stat;
+    bool stat_valid = DISK::stat( stat_filename.c_str(), &file_stat);
+
+    if( stat_valid) {
+        std::lock_guard<std::mutex> lock( g_content_hash_index_mutex);
+        auto it = g_content_hash_index.find( filename);
+        if(    it != g_content_hash_index.end()
+            && it->second.m_size == file_stat.m_size
+            && it->second.m_modification_time == file_stat.m_modification_time) {
+            memcpy( hash, it->second.m_hash, 16);
+            return true;
+        }
+    }
+
+    mi::mdl::MD5_hasher hasher;
+    std::vector<unsigned char> buffer( 64 * 1024);
+    while( mi::Uint64 count = reader->read( buffer.data(), buffer.size()))
+        hasher.update( buffer.data(), count);
+    hasher.final( hash);
+
+    if( !reader->seek( 0, mi::mdl::IMDL_resource_reader::MDL_SEEK_SET))
+        return false;
+
+    if( stat_valid) {
+        Content_hash_entry entry;
+        entry.m_size = file_stat.m_size;
+        entry.m_modification_time = file_stat.m_modification_time;
+        memcpy( entry.m_hash, hash, 16);
+
+        std::lock_guard<std::mutex> lock( g_content_hash_index_mutex);
+        g_content_hash_index[filename] = entry;
+    }
+    return true;
+}
+
+/// Number of resources that reused an existing implementation class.
+std::atomic<mi::Size> g_shared_resource_impls( 0);
+
+/// Memory of the implementation classes that was not duplicated.
+std::atomic<mi::Size> g_shared_resource_impl_bytes( 0);
+
+} // namespace
+
 mi::base::Uuid get_hash( mi::mdl::IMDL_resource_reader* reader)
 {
     unsigned char h[16];
     bool valid_hash = reader->get_resource_hash( h);
+    if( !valid_hash)
+        valid_hash = get_content_hash( reader, h);
     if( !valid_hash)
         return mi::base::Uuid{0,0,0,0};
 
@@ -6886,9 +7293,22 @@ mi::base::Uuid get_hash(mi::mdl::IMDL_resource_set const *set)
     size_t count = set->get_count();
     size_t overall_hash = 0;
 
+    // the same files mapped to other tiles, or not as uv-tiles at all, form a different set
+    boost::hash_combine(overall_hash, static_cast<int>(set->get_udim_mode()));
+
     for (size_t i = 0; i < count; ++i) {
+        int u = 0, v = 0;
+        bool is_tile = set->get_udim_mapping(i, u, v);
+        boost::hash_combine(overall_hash, is_tile);
+        boost::hash_combine(overall_hash, u);
+        boost::hash_combine(overall_hash, v);
+
         unsigned char mdl_hash[16];
         bool valid_hash = set->get_resource_hash(i, mdl_hash);
+        if (!valid_hash) {
+            mi::base::Handle<mi::mdl::IMDL_resource_reader> reader(set->open_reader(i));
+            valid_hash = reader && get_content_hash(reader.get(), mdl_hash);
+        }
         if (!valid_hash)
             return mi::base::Uuid{ 0,0,0,0 };
         size_t hash = boost::hash_range(mdl_hash, mdl_hash + 16);
@@ -7037,6 +7457,20 @@ mi::Sint32 add_context_error(
     return -1;
 }
 
+void record_shared_resource_impl( mi::Size bytes)
+{
+    ++g_shared_resource_impls;
+    g_shared_resource_impl_bytes += bytes;
+}
+
+Resource_sharing_statistics get_resource_sharing_statistics()
+{
+    Resource_sharing_statistics result;
+    result.m_shared_impls = g_shared_resource_impls;
+    result.m_bytes_saved  = g_shared_resource_impl_bytes;
+    return result;
+}
+
 } // namespace MDL
 
 } // namespace MI
@@ -38,6 +38,7 @@
 #include <atomic>
 #include <map>
 #include <condition_variable>
+#include <thread>
 #include <base/data/db/i_db_tag.h>
 #include <mi/base/interface_implement.h>
 #include <mi/mdl/mdl_code_generators.h>
@@ -68,6 +69,8 @@ class Mdl_call_resolver;
 class Mdl_module_wait_queue;
 class Name_mangler;
 
+namespace DETAIL { class Mdl_image_set; struct Mdl_resource_file; }
+
 // ********** Conversion from mi::mdl to mi::neuraylib *********************************************
 
 /// Converts mi::mdl::IDefinition::Semantics to mi::neuraylib::IFunction_definition::Semantics.
@@ -535,12 +538,19 @@ public:
     /// \param code_dag               The code DAG to update.
     /// \param module_filename        The file name of the module.
     /// \param module_name            The fully-qualified MDL module name.
+    /// \param parallel               If \c true, the uv-tiles of all textures and the files of
+    ///                               all light profiles and BSDF measurements are loaded on
+    ///                               worker threads before the DB elements are created.
     Resource_updater(
         DB::Transaction* transaction,
         mi::mdl::ICall_name_resolver &resolver,
         mi::mdl::IGenerated_code_dag* code_dag,
         const char* module_filename,
-        const char* module_name);
+        const char* module_name,
+        bool parallel = false);
+
+    /// Destructor.
+    ~Resource_updater();
 
     /// Associates all resource literals inside a code DAG with their DB tags.
     void update_resource_literals();
@@ -555,16 +565,55 @@ private:
     void update_resource_literals(
         const mi::mdl::DAG_node* node);
 
+    /// Traverses all materials and functions of the code DAG.
+    void update_code_dag();
+
+    /// Resolves a texture and records it for #prefetch_resources().
+    void collect_texture(mi::mdl::IValue_texture const *texture);
+
+    /// Resolves a light profile or BSDF measurement and records it for #prefetch_resources().
+    void collect_resource_file(mi::mdl::IValue_resource const *resource);
+
+    /// Creates the mipmaps of all collected textures and reads all collected light profiles and
+    /// BSDF measurements on worker threads.
+    void prefetch_resources();
+
 private:
     DB::Transaction              *m_transaction;
     mi::mdl::ICall_name_resolver &m_resolver;
     mi::mdl::IGenerated_code_dag *m_code_dag;
     char const                   *m_module_filename;
     char const                   *m_module_name;
+    bool                         m_parallel;
+    bool                         m_collect_resources;
 
     typedef std::map<mi::mdl::IValue_resource const *, DB::Tag> Resource_tag_cache;
 
     Resource_tag_cache m_resorce_tag_cache;
+
+    /// A texture resolved in advance.
+    struct Prefetched_texture {
+        mi::base::Handle<DETAIL::Mdl_image_set> m_image_set;
+    };
+
+    typedef std::map<mi::mdl::IValue_resource const *, Prefetched_texture> Prefetched_textures;
+
+    Prefetched_textures m_prefetched_textures;
+
+    typedef std::map<std::string, Prefetched_texture> Prefetched_paths;
+
+    Prefetched_paths m_prefetched_paths;
+
+    /// Light profiles and BSDF measurements resolved in advance. Literals with the same file path
+    /// share the file.
+    typedef std::map<mi::mdl::IValue_resource const *, DETAIL::Mdl_resource_file const *>
+        Prefetched_files;
+
+    Prefetched_files m_prefetched_files;
+
+    typedef std::map<std::string, DETAIL::Mdl_resource_file> Prefetched_file_paths;
+
+    Prefetched_file_paths m_prefetched_file_paths;
 };
 
 /// Helper class to associate all resource literals inside a material instance with their DB tags.
@@ -784,12 +833,19 @@ public:
 
     /// Get an unique identifier for the context in which the current module is loaded.
     ///
+    /// The compiler may load imports of a module on worker threads using this cache. Each of
+    /// these threads is a loading context on its own, so modules imported by several of them
+    /// are loaded only once while the others wait.
+    ///
     /// \return                 The identifier.
-    size_t get_loading_context_id() const { return m_context_id; }
+    size_t get_loading_context_id() const;
 
 private:
 
     size_t m_context_id;
+    std::thread::id m_creator_thread;
+    mutable std::mutex m_worker_contexts_mutex;
+    mutable std::map<std::thread::id, size_t> m_worker_contexts;
     DB::Transaction* m_transaction;
     Mdl_module_wait_queue* m_queue;
     mi::mdl::IModule_loaded_callback* m_module_load_callback;
@@ -969,10 +1025,13 @@ mi::base::Uuid convert_hash( const mi::mdl::DAG_hash& hash);
 mi::base::Uuid convert_hash( const unsigned char hash[16]);
 
 /// Returns the hash value of the resource reader (or {0,0,0,0} if not available).
+///
+/// Readers without an embedded hash are hashed by content, such that byte-identical resources
+/// share their implementation class.
 mi::base::Uuid get_hash( mi::mdl::IMDL_resource_reader* reader);
 
 /// Returns the combined hash value of all resource readers in the set (or {0,0,0,0} if not
-/// available).
+/// available). Like for single readers, the content is hashed if there is no embedded hash.
 mi::base::Uuid get_hash(mi::mdl::IMDL_resource_set const *set);
 
 /// Generates a unique ID.
@@ -166,6 +166,16 @@ DB::Tag load_mdl_texture(
     bool shared_proxy,
     mi::Float32 gamma);
 
+/// Returns the tag of the shared image DB element that #load_mdl_texture() uses for an image set.
+///
+/// Allows to skip expensive preparations for images that have already been loaded.
+///
+/// \param transaction           The DB transaction to be used.
+/// \param image_set             Description of the resolved image set.
+/// \return                      The tag of the shared image, or the invalid tag if that image
+///                              has not been loaded yet.
+DB::Tag get_mdl_shared_image( DB::Transaction* transaction, const DBIMAGE::Image_set* image_set);
+
 } // namespace TEXTURE
 
 } // namespace MI
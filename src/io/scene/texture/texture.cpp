@@ -176,6 +176,28 @@ void Texture::get_scene_element_references( DB::Tag_set* result) const
         result->insert( m_image);
 }
 
+namespace {
+
+/// Returns the filename used to derive the DB element names of an MDL texture and its image.
+std::string get_mdl_resolved_filename( const DBIMAGE::Image_set* image_set)
+{
+    return image_set->is_mdl_container()
+        ? image_set->get_container_filename() + std::string( "_")
+          + image_set->get_container_membername( 0)
+        : image_set->get_resolved_filename( 0);
+}
+
+} // namespace
+
+DB::Tag get_mdl_shared_image( DB::Transaction* transaction, const DBIMAGE::Image_set* image_set)
+{
+    if( image_set->get_length() == 0)
+        return DB::Tag( 0);
+
+    std::string db_image_name = "MI_default_image_" + get_mdl_resolved_filename( image_set);
+    return transaction->name_to_tag( db_image_name.c_str());
+}
+
 DB::Tag load_mdl_texture(
     DB::Transaction* transaction,
     DBIMAGE::Image_set* image_set,
@@ -186,10 +208,7 @@ DB::Tag load_mdl_texture(
     if( image_set->get_length() == 0)
         return DB::Tag( 0);
 
-    std::string resolved_filename = image_set->is_mdl_container()
-        ? image_set->get_container_filename() + std::string( "_")
-          + image_set->get_container_membername( 0)
-        : image_set->get_resolved_filename( 0);
+    std::string resolved_filename = get_mdl_resolved_filename( image_set);
 
     std::string db_texture_name = shared_proxy ? "MI_default_" : "";
     db_texture_name += "texture_" + resolved_filename + "_" +
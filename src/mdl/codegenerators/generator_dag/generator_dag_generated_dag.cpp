@@ -3184,6 +3184,12 @@ Generated_code_dag::Material_instance::Material_instance(
 , m_referenced_scene_data(alloc)
 , m_resource_tag_map(alloc)
 , m_resource_tagger(m_resource_tag_map)
+, m_prev_instance()
+, m_inst_map(0, Instantiation_map::hasher(), Instantiation_map::key_equal(), alloc)
+, m_inst_flags(0)
+, m_mdl_meters_per_scene_unit(1.0f)
+, m_wavelength_min(0.0f)
+, m_wavelength_max(0.0f)
 {
     m_node_factory.enable_unsafe_math_opt(unsafe_math_optimizations);
 
@@ -3326,6 +3332,10 @@ Generated_code_dag::Error_code Generated_code_dag::Material_instance::initialize
     float                     wavelength_min,
     float                     wavelength_max)
 {
+    // the previous instance is only used by this call
+    mi::base::Handle<Material_instance const> prev_instance(m_prev_instance);
+    m_prev_instance.reset();
+
 #if 0
     {
         char buffer[64];
@@ -3470,6 +3480,30 @@ Generated_code_dag::Error_code Generated_code_dag::Material_instance::initialize
     // set the resource modifier here, so inlining will modify resources
     dag_builder.set_resource_modifier(resource_modifier);
 
+    // Instantiated arguments are only recorded for instance compilation, class compilation
+    // creates parameters for them. They can be reused if the previous instance was created
+    // with the same settings, as these influence the folding.
+    bool record_args = (flags & CLASS_COMPILATION) == 0;
+    Instantiation_map const *prev_map = NULL;
+    if (record_args && prev_instance.is_valid_interface()) {
+        Material_instance const *prev = prev_instance.get();
+
+        if (prev->m_material_index == m_material_index &&
+            prev->m_inst_flags == flags &&
+            prev->m_mdl_meters_per_scene_unit == mdl_meters_per_scene_unit &&
+            prev->m_wavelength_min == wavelength_min &&
+            prev->m_wavelength_max == wavelength_max &&
+            strcmp(prev->get_internal_space(), get_internal_space()) == 0)
+        {
+            prev_map = &prev->m_inst_map;
+        }
+    }
+    m_inst_map.clear();
+    m_inst_flags                = flags;
+    m_mdl_meters_per_scene_unit = mdl_meters_per_scene_unit;
+    m_wavelength_min            = wavelength_min;
+    m_wavelength_max            = wavelength_max;
+
     Instantiate_helper creator(
         *resolver,
         *resource_modifier,
@@ -3482,7 +3516,9 @@ Generated_code_dag::Error_code Generated_code_dag::Material_instance::initialize
         argv,
         mdl_meters_per_scene_unit,
         wavelength_min,
-        wavelength_max);
+        wavelength_max,
+        record_args ? &m_inst_map : NULL,
+        prev_map);
 
     DAG_call const *constructor = creator.compile();
     set_constructor(constructor);
@@ -3550,6 +3586,14 @@ Generated_code_dag::Error_code Generated_code_dag::Material_instance::initialize
     return res;
 }
 
+// Set a previously compiled instance of the same material to speed up the next
+// initialize() call.
+void Generated_code_dag::Material_instance::set_previous_instance(
+    IMaterial_instance const *prev)
+{
+    m_prev_instance = mi::base::make_handle_dup(impl_cast<Material_instance>(prev));
+}
+
 // Return the material constructor.
 DAG_call const *Generated_code_dag::Material_instance::get_constructor() const
 {
@@ -4469,7 +4513,9 @@ Generated_code_dag::Material_instance::Instantiate_helper::Instantiate_helper(
     DAG_node const           *argv[],
     float                    mdl_meters_per_scene_unit,
     float                    wavelength_min,
-    float                    wavelength_max)
+    float                    wavelength_max,
+    Instantiation_map        *inst_map,
+    Instantiation_map const  *prev_map)
 : m_resolver(resolver)
 , m_resource_modifier(resource_modifier)
 , m_code_dag(*code_dag)
@@ -4494,7 +4540,13 @@ Generated_code_dag::Material_instance::Instantiate_helper::Instantiate_helper(
     0, Dep_analysis_cache::hasher(), Dep_analysis_cache::key_equal(), get_allocator())
 , m_properties(0)
 , m_referenced_scene_data(dag_builder.get_allocator())
+, m_hash_map(0, Hash_map::hasher(), Hash_map::key_equal(), &m_arena)
+, m_import_map(0, Visit_map::hasher(), Visit_map::key_equal(), &m_arena)
+, m_inst_map(inst_map)
+, m_prev_map(prev_map)
+, m_inlined(get_allocator())
 , m_instantiate_args(flags & CLASS_COMPILATION)
+, m_inside_argument(false)
 {
     // reset the CSE table, we will build new expressions
     m_node_factory.identify_clear();
@@ -4534,6 +4586,8 @@ Generated_code_dag::Material_instance::Instantiate_helper::compile()
 
     m_visit_map.clear();
     m_resource_param_map.clear();
+    m_hash_map.clear();
+    m_import_map.clear();
 
     if (m_params > 0) {
         // ensure that every parameter is used AFTER the optimization, if not, renumber
@@ -5106,6 +5160,52 @@ Generated_code_dag::Material_instance::Instantiate_helper::instantiate_dag(
         {
             DAG_call const *call = cast<DAG_call>(node);
 
+            // inside arguments, reuse the sub-DAGs of the previous instance
+            bool       record_arg = m_inst_map != NULL && m_inside_argument;
+            DAG_hash   arg_hash;
+            Properties outer_props = m_properties;
+            size_t     inlined_start = m_inlined.size();
+            if (record_arg) {
+                arg_hash = get_argument_hash(node);
+
+                if (m_prev_map != NULL) {
+                    Instantiation_map::const_iterator it = m_prev_map->find(arg_hash);
+                    if (it != m_prev_map->end()) {
+                        Instantiated_argument const &prev = it->second;
+
+                        {
+                            No_OPT_scope no_opt(m_node_factory);
+                            res = import_dag(prev.m_node);
+                        }
+                        m_properties |= prev.m_props;
+
+                        // the inlined functions are gone from the sub-DAG, analyze their
+                        // bodies again to collect the scene data they reference
+                        for (size_t i = 0, n = prev.m_inlined.size(); i < n; ++i) {
+                            char const *signature = prev.m_inlined[i].c_str();
+                            mi::base::Handle<IModule const> mod(
+                                m_resolver.get_owner_module(signature));
+                            if (mod.is_valid_interface()) {
+                                Module const *owner = impl_cast<Module>(mod.get());
+                                if (IDefinition const *def =
+                                        owner->find_signature(signature, /*only_exported=*/false))
+                                    analyze_function_ast(owner, def);
+                            }
+                            m_inlined.push_back(prev.m_inlined[i]);
+                        }
+
+                        m_inst_map->insert(
+                            Instantiation_map::value_type(
+                                arg_hash,
+                                Instantiated_argument(res, prev.m_props, prev.m_inlined)));
+                        break;
+                    }
+                }
+
+                // collect the properties of this sub-DAG alone
+                m_properties = 0;
+            }
+
             int n_args = call->get_argument_count();
             VLA<DAG_call::Call_argument> args(get_allocator(), n_args);
 
@@ -5200,6 +5300,9 @@ Generated_code_dag::Material_instance::Instantiate_helper::instantiate_dag(
                                 // inlined function
                                 if (res != NULL) {
                                     analyze_function_ast(module, def);
+                                    if (m_inst_map != NULL)
+                                        m_inlined.push_back(
+                                            string(call->get_name(), get_allocator()));
                                 }
                             }
                         }
@@ -5229,6 +5332,15 @@ Generated_code_dag::Material_instance::Instantiate_helper::instantiate_dag(
                     }
                 }
             }
+
+            if (record_arg) {
+                Signature_list inlined(
+                    m_inlined.begin() + inlined_start, m_inlined.end(), get_allocator());
+                m_inst_map->insert(
+                    Instantiation_map::value_type(
+                        arg_hash, Instantiated_argument(res, m_properties, inlined)));
+                m_properties |= outer_props;
+            }
         }
         break;
     case DAG_node::EK_PARAMETER:
@@ -5247,6 +5359,7 @@ Generated_code_dag::Material_instance::Instantiate_helper::instantiate_dag(
                 res = instantiate_dag_arguments(m_argv[parameter_index]);
             } else {
                 // instance compilation, fold arguments completely
+                Flag_store store(m_inside_argument, true);
                 res = instantiate_dag(m_argv[parameter_index]);
             }
         }
@@ -5319,6 +5432,106 @@ restart:
     return true;
 }
 
+// Compute the structural hash of an (uninstantiated) argument sub-DAG.
+DAG_hash Generated_code_dag::Material_instance::Instantiate_helper::get_argument_hash(
+    DAG_node const *node)
+{
+    Hash_map::const_iterator it = m_hash_map.find(node);
+    if (it != m_hash_map.end())
+        return it->second;
+
+    MD5_hasher md5_hasher;
+
+    switch (node->get_kind()) {
+    case DAG_node::EK_CONSTANT:
+        {
+            Dag_hasher dag_hasher(md5_hasher);
+            dag_hasher.visit(const_cast<DAG_constant *>(cast<DAG_constant>(node)));
+        }
+        break;
+    case DAG_node::EK_TEMPORARY:
+        md5_hasher.update('T');
+        md5_hasher.update(cast<DAG_temporary>(node)->get_index());
+        break;
+    case DAG_node::EK_CALL:
+        {
+            DAG_call const *call = cast<DAG_call>(node);
+
+            // the signature identifies the called definition
+            md5_hasher.update('F');
+            md5_hasher.update(call->get_name());
+
+            int n_args = call->get_argument_count();
+            md5_hasher.update(n_args);
+            for (int i = 0; i < n_args; ++i) {
+                DAG_hash arg_hash = get_argument_hash(call->get_argument(i));
+                md5_hasher.update(arg_hash.data(), arg_hash.size());
+            }
+        }
+        break;
+    case DAG_node::EK_PARAMETER:
+        md5_hasher.update('P');
+        md5_hasher.update(cast<DAG_parameter>(node)->get_index());
+        break;
+    }
+
+    DAG_hash res;
+    md5_hasher.final(res.data());
+    m_hash_map[node] = res;
+    return res;
+}
+
+// Import an instantiated node of the previous instance.
+DAG_node const *Generated_code_dag::Material_instance::Instantiate_helper::import_dag(
+    DAG_node const *node)
+{
+    Visit_map::const_iterator it = m_import_map.find(node);
+    if (it != m_import_map.end())
+        return it->second;
+
+    DAG_node const *res = NULL;
+
+    switch (node->get_kind()) {
+    case DAG_node::EK_CONSTANT:
+        {
+            DAG_constant const *c = cast<DAG_constant>(node);
+            IValue const *v = m_value_factory.import(c->get_value());
+            res = m_node_factory.create_constant(v);
+        }
+        break;
+    case DAG_node::EK_CALL:
+        {
+            DAG_call const *call = cast<DAG_call>(node);
+
+            int n_args = call->get_argument_count();
+            VLA<DAG_call::Call_argument> args(get_allocator(), n_args);
+
+            for (int i = 0; i < n_args; ++i) {
+                args[i].arg        = import_dag(call->get_argument(i));
+                args[i].param_name = call->get_parameter_name(i);
+            }
+
+            IType const *ret_type = m_type_factory.import(call->get_type());
+            res = m_node_factory.create_call(
+                call->get_name(), call->get_semantic(),
+                args.data(), args.size(), ret_type);
+
+            // the properties are recorded with the sub-DAG, but the referenced scene data
+            // must be collected again
+            if (DAG_call const *n_call = as<DAG_call>(res))
+                analyze_call(n_call);
+        }
+        break;
+    case DAG_node::EK_TEMPORARY:
+    case DAG_node::EK_PARAMETER:
+        MDL_ASSERT(!"unexpected node inside an instantiated argument");
+        break;
+    }
+
+    m_import_map[node] = res;
+    return res;
+}
+
 // Instantiate a DAG expression from an argument.
 DAG_node const *
 Generated_code_dag::Material_instance::Instantiate_helper::instantiate_dag_arguments(
@@ -763,6 +763,44 @@ public:
 
         typedef ptr_hash_map<IDefinition const, Dependence_result>::Type Dep_analysis_cache;
 
+        typedef vector<string>::Type Signature_list;
+
+        /// An argument sub-DAG instantiated during instance compilation.
+        struct Instantiated_argument {
+            /// Constructor.
+            Instantiated_argument(
+                DAG_node const       *node,
+                Properties           props,
+                Signature_list const &inlined)
+            : m_node(node)
+            , m_props(props)
+            , m_inlined(inlined)
+            {
+            }
+
+            /// The instantiated node, owned by the instance.
+            DAG_node const *m_node;
+
+            /// The properties collected while instantiating the sub-DAG.
+            Properties m_props;
+
+            /// The signatures of the functions inlined into the sub-DAG. Their bodies must be
+            /// analyzed again when the sub-DAG is reused.
+            Signature_list m_inlined;
+        };
+
+        /// Hash functor for DAG hashes.
+        struct Dag_hash_hash {
+            size_t operator()(DAG_hash const &h) const {
+                size_t res;
+                memcpy(&res, h.data(), sizeof(res));
+                return res;
+            }
+        };
+
+        /// Maps the structural hashes of argument sub-DAGs to their instantiation.
+        typedef hash_map<DAG_hash, Instantiated_argument, Dag_hash_hash>::Type Instantiation_map;
+
     public:
         // Acquires a const interface.
         mi::base::IInterface const *get_interface(
@@ -833,6 +871,12 @@ public:
             float                     wavelength_min,
             float                     wavelength_max) MDL_FINAL;
 
+        /// Set a previously compiled instance of the same material to speed up the next
+        /// initialize() call.
+        ///
+        /// \param prev  the previous instance or NULL
+        void set_previous_instance(IMaterial_instance const *prev) MDL_FINAL;
+
         /// Return the material constructor.
         DAG_call const *get_constructor() const MDL_FINAL;
 
@@ -1084,6 +1128,10 @@ public:
                 IValue_resource const,
                 DAG_node const *>::Type Resource_param_map;
 
+            typedef Arena_ptr_hash_map<
+                DAG_node const,
+                DAG_hash>::Type Hash_map;
+
             /// RAII-like parameter scope.
             class Param_scope {
             public:
@@ -1130,6 +1178,10 @@ public:
             /// \param mdl_meters_per_scene_unit  The value for the meter/scene unit conversion.
             /// \param wavelength_min             The value for state::wavelength_min().
             /// \param wavelength_max             The value for state::wavelength_max().
+            /// \param inst_map                   If non-NULL, record the instantiated argument
+            ///                                   sub-DAGs here.
+            /// \param prev_map                   If non-NULL, the instantiated argument sub-DAGs
+            ///                                   of a previous instance to reuse.
             Instantiate_helper(
                 ICall_name_resolver      &resolver,
                 IResource_modifier       &resource_modifier,
@@ -1142,7 +1194,9 @@ public:
                 DAG_node const           *argv[],
                 float                    mdl_meters_per_scene_unit,
                 float                    wavelength_min,
-                float                    wavelength_max);
+                float                    wavelength_max,
+                Instantiation_map        *inst_map,
+                Instantiation_map const  *prev_map);
 
             /// Destructor.
             ~Instantiate_helper();
@@ -1204,6 +1258,19 @@ public:
             DAG_node const *instantiate_dag_arguments(
                 DAG_node const *node);
 
+            /// Compute the structural hash of an (uninstantiated) argument sub-DAG.
+            ///
+            /// \param node  the root node of the argument sub-DAG
+            DAG_hash get_argument_hash(DAG_node const *node);
+
+            /// Import an instantiated node of the previous instance.
+            ///
+            /// \param node  the node owned by the previous instance
+            /// \returns      the same node, owned by this instance
+            ///
+            /// The node is already folded, so it is copied without optimizations.
+            DAG_node const *import_dag(DAG_node const *node);
+
             /// Inline parameters into a DAG IR node.
             ///
             /// \param node           The (material DAG) root node to instantiate.
@@ -1307,8 +1374,26 @@ public:
             /// Set of scene data names referenced by this instance.
             String_set m_referenced_scene_data;
 
+            /// The structural hashes of the argument sub-DAGs.
+            Hash_map m_hash_map;
+
+            /// Map for importing nodes of the previous instance.
+            Visit_map m_import_map;
+
+            /// If non-NULL, the instantiated argument sub-DAGs are recorded here.
+            Instantiation_map *m_inst_map;
+
+            /// If non-NULL, the instantiated argument sub-DAGs of the previous instance.
+            Instantiation_map const *m_prev_map;
+
+            /// The signatures of all functions inlined while recording argument sub-DAGs.
+            Signature_list m_inlined;
+
             /// If true, instantiate arguments.
             bool m_instantiate_args;
+
+            /// If true, we are inside an argument of an instance compilation.
+            bool m_inside_argument;
         };
 
         /// A builder, used for generating printer.
@@ -1367,6 +1452,24 @@ public:
 
         /// The resource tagger, using the resource to tag map;
         mutable Resource_tagger m_resource_tagger;
+
+        /// The previous instance whose arguments might be reused by initialize().
+        mi::base::Handle<Material_instance const> m_prev_instance;
+
+        /// The argument sub-DAGs instantiated by an instance compilation.
+        Instantiation_map m_inst_map;
+
+        /// The instantiation flags used by initialize().
+        unsigned m_inst_flags;
+
+        /// The meter/scene unit conversion value used by initialize().
+        float m_mdl_meters_per_scene_unit;
+
+        /// The state::wavelength_min() value used by initialize().
+        float m_wavelength_min;
+
+        /// The state::wavelength_max() value used by initialize().
+        float m_wavelength_max;
     };
 
 private:
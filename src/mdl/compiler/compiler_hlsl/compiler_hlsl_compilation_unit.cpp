@@ -56,6 +56,8 @@ Compilation_unit::Compilation_unit(
 , m_msgs(alloc, m_filename)
 , m_decls()
 , m_ref_files(alloc)
+, m_n_nodes_before_opt(0)
+, m_n_nodes_after_opt(0)
 {
 }
 
@@ -204,6 +204,21 @@ public:
     /// Get the allocator.
     IAllocator *get_allocator() const { return m_arena.get_allocator(); }
 
+    /// Get the number of AST nodes before and after the optimizer was run.
+    ///
+    /// \param[out] n_before  number of AST nodes before optimization
+    /// \param[out] n_after   number of AST nodes after optimization
+    void get_optimizer_statistics(size_t &n_before, size_t &n_after) const {
+        n_before = m_n_nodes_before_opt;
+        n_after  = m_n_nodes_after_opt;
+    }
+
+    /// Set the number of AST nodes before and after the optimizer was run.
+    void set_optimizer_statistics(size_t n_before, size_t n_after) {
+        m_n_nodes_before_opt = n_before;
+        m_n_nodes_after_opt  = n_after;
+    }
+
 private:
     /// Constructor.
     ///
@@ -252,6 +267,12 @@ private:
 
     /// Referenced files.
     vector<char const *>::Type m_ref_files;
+
+    /// Number of AST nodes before the optimizer was run.
+    size_t m_n_nodes_before_opt;
+
+    /// Number of AST nodes after the optimizer was run.
+    size_t m_n_nodes_after_opt;
 };
 
 }  // hlsl
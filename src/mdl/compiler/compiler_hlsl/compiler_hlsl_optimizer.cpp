@@ -30,11 +30,273 @@
 
 #include "compiler_hlsl_compilation_unit.h"
 #include "compiler_hlsl_optimizer.h"
+#include "compiler_hlsl_visitor.h"
 
 namespace mi {
 namespace mdl {
 namespace hlsl {
 
+/// Checks if the given operator is an assignment operator.
+static bool is_assign_operator(Expr_binary::Operator op)
+{
+    return Expr_binary::OK_ASSIGN <= op && op <= Expr_binary::OK_BITWISE_XOR_ASSIGN;
+}
+
+/// Checks if the given operator is an increment or decrement operator.
+static bool is_inc_dec_operator(Expr_unary::Operator op)
+{
+    return Expr_unary::OK_PRE_INCREMENT <= op && op <= Expr_unary::OK_POST_DECREMENT;
+}
+
+/// Checks if the given call calls an elemental constructor.
+static bool is_elem_constructor_call(Expr_call *call)
+{
+    Expr_ref *callee = as<Expr_ref>(call->get_callee());
+    if (callee == NULL)
+        return false;
+
+    Definition *def = callee->get_definition();
+    if (def == NULL || !is<Def_function>(def))
+        return false;
+    return cast<Def_function>(def)->get_semantics() == Def_function::DS_ELEM_CONSTRUCTOR;
+}
+
+/// Checks if a statement contains a break or continue that leaves the loop around it.
+///
+/// \param stmt       the statement to check
+/// \param in_switch  true, if a break would leave an enclosing switch instead of the loop
+static bool has_loop_jump(Stmt *stmt, bool in_switch)
+{
+    switch (stmt->get_kind()) {
+    case Stmt::SK_BREAK:
+        return !in_switch;
+    case Stmt::SK_CONTINUE:
+        return true;
+    case Stmt::SK_COMPOUND:
+    case Stmt::SK_SWITCH:
+        {
+            Stmt_list *list = static_cast<Stmt_list *>(stmt);
+            bool is_switch  = in_switch || stmt->get_kind() == Stmt::SK_SWITCH;
+            for (Stmt_list::iterator it(list->begin()), end(list->end()); it != end; ++it) {
+                if (has_loop_jump(it, is_switch))
+                    return true;
+            }
+        }
+        return false;
+    case Stmt::SK_IF:
+        {
+            Stmt_if *if_stmt = cast<Stmt_if>(stmt);
+            if (has_loop_jump(if_stmt->get_then_statement(), in_switch))
+                return true;
+            Stmt *else_stmt = if_stmt->get_else_statement();
+            return else_stmt != NULL && has_loop_jump(else_stmt, in_switch);
+        }
+    default:
+        // jumps inside of nested loops are bound to those
+        return false;
+    }
+}
+
+/// Helper visitor to count the AST nodes of a compilation unit.
+class Node_counter : public CUnit_visitor
+{
+public:
+    using CUnit_visitor::pre_visit;
+
+    bool pre_visit(Declaration *decl) HLSL_FINAL { ++m_count; return true; }
+    bool pre_visit(Stmt *stmt) HLSL_FINAL { ++m_count; return true; }
+    bool pre_visit(Expr *expr) HLSL_FINAL { ++m_count; return true; }
+
+    /// Get the number of visited nodes.
+    size_t get_count() const { return m_count; }
+
+    /// Constructor.
+    Node_counter() : m_count(0) {}
+
+private:
+    /// The number of visited nodes.
+    size_t m_count;
+};
+
+/// Helper visitor to collect the usage information of the local variables of a function.
+class Local_var_collector : public CUnit_visitor
+{
+public:
+    using CUnit_visitor::pre_visit;
+    using CUnit_visitor::post_visit;
+
+    /// Constructor.
+    ///
+    /// \param opt  the optimizer, receives the collected information
+    explicit Local_var_collector(Optimizer &opt)
+    : m_opt(opt)
+    , m_decl_stmt(NULL)
+    , m_top_expr(NULL)
+    , m_in_array_spec(false)
+    {
+    }
+
+    bool pre_visit(Stmt_decl *stmt) HLSL_FINAL
+    {
+        m_decl_stmt = stmt;
+        return true;
+    }
+
+    void post_visit(Stmt_decl *stmt) HLSL_FINAL
+    {
+        m_decl_stmt = NULL;
+    }
+
+    bool pre_visit(Stmt_expr *stmt) HLSL_FINAL
+    {
+        m_top_expr = stmt->get_expression();
+        return true;
+    }
+
+    bool pre_visit(Declaration_variable *decl) HLSL_FINAL
+    {
+        Declaration_variable::iterator it(decl->begin()), end(decl->end());
+        bool is_single = it != end && ++it == end;
+
+        for (it = decl->begin(); it != end; ++it) {
+            Init_declarator *init = it;
+
+            Definition *def = init->get_name()->get_definition();
+            if (def == NULL || !is<Def_variable>(def))
+                continue;
+
+            Optimizer::Local_var_info &info = m_opt.m_local_vars[def];
+            info = Optimizer::Local_var_info(init, is_single ? m_decl_stmt : NULL);
+
+            // references without a definition are bound by symbol, so variables
+            // sharing a symbol cannot be told apart and are never optimized
+            std::pair<Optimizer::Local_sym_map::iterator, bool> res =
+                m_opt.m_local_syms.insert(
+                    Optimizer::Local_sym_map::value_type(def->get_symbol(), def));
+            if (!res.second) {
+                pin(info);
+                pin(m_opt.m_local_vars[res.first->second]);
+            }
+        }
+        return true;
+    }
+
+    bool pre_visit(Expr_ref *expr) HLSL_FINAL
+    {
+        if (Optimizer::Local_var_info *info = m_opt.get_local_var_info(expr)) {
+            ++info->m_n_refs;
+            ++info->m_n_reads;
+            if (m_in_array_spec) {
+                // never replace variables used in array sizes
+                ++info->m_n_writes;
+            }
+        }
+        return true;
+    }
+
+    bool pre_visit(Array_specifier *spec) HLSL_FINAL
+    {
+        m_in_array_spec = true;
+        return true;
+    }
+
+    void post_visit(Array_specifier *spec) HLSL_FINAL
+    {
+        m_in_array_spec = false;
+    }
+
+    bool pre_visit(Expr_unary *expr) HLSL_FINAL
+    {
+        if (is_inc_dec_operator(expr->get_operator())) {
+            if (Optimizer::Local_var_info *info = m_opt.get_local_var_info(expr->get_argument()))
+                ++info->m_n_writes;
+        }
+        return true;
+    }
+
+    bool pre_visit(Expr_binary *expr) HLSL_FINAL
+    {
+        if (expr->get_operator() == Expr_binary::OK_SELECT) {
+            // the right hand side is a member or swizzle name
+            visit(expr->get_left_argument());
+            return false;
+        }
+        if (!is_assign_operator(expr->get_operator()))
+            return true;
+
+        Expr *lhs = expr->get_left_argument();
+        Optimizer::Local_var_info *info = m_opt.get_local_var_info(lhs);
+        if (info == NULL)
+            return true;
+
+        ++info->m_n_refs;
+        ++info->m_n_writes;
+        if (expr != m_top_expr) {
+            // the value of the assignment is used
+            ++info->m_n_reads;
+        }
+
+        // the lvalue itself is not a read, but all array indices are
+        while (Expr_binary *b = as<Expr_binary>(lhs)) {
+            if (b->get_operator() == Expr_binary::OK_ARRAY_SUBSCRIPT)
+                visit(b->get_right_argument());
+            lhs = b->get_left_argument();
+        }
+        visit(expr->get_right_argument());
+        return false;
+    }
+
+    bool pre_visit(Expr_call *expr) HLSL_FINAL
+    {
+        Expr_ref *callee = as<Expr_ref>(expr->get_callee());
+        if (callee == NULL)
+            return true;
+
+        Definition *def = callee->get_definition();
+        if (def == NULL || !is<Def_function>(def)) {
+            // type constructor or typecast
+            return true;
+        }
+
+        Def_function  *fdef = cast<Def_function>(def);
+        Type_function *ftype = fdef->get_type();
+        size_t n_params = ftype->get_parameter_count();
+
+        for (size_t i = 0, n = expr->get_argument_count(); i < n; ++i) {
+            if (i < n_params &&
+                (ftype->get_parameter(i)->get_modifier() & Type_function::Parameter::PM_OUT) == 0)
+            {
+                continue;
+            }
+            if (Optimizer::Local_var_info *info = m_opt.get_local_var_info(expr->get_argument(i)))
+                ++info->m_n_writes;
+        }
+        return true;
+    }
+
+private:
+    /// Prevent any optimization of a variable.
+    static void pin(Optimizer::Local_var_info &info)
+    {
+        ++info.m_n_refs;
+        ++info.m_n_reads;
+        ++info.m_n_writes;
+    }
+
+private:
+    /// The optimizer.
+    Optimizer &m_opt;
+
+    /// The current declaration statement if any.
+    Stmt_decl *m_decl_stmt;
+
+    /// The expression of the current expression statement if any.
+    Expr *m_top_expr;
+
+    /// True, while an array specifier is visited.
+    bool m_in_array_spec;
+};
+
 // Constructor.
 Optimizer::Optimizer(
     IAllocator       *alloc,
@@ -49,6 +311,9 @@ Optimizer::Optimizer(
 , m_df(unit.get_declaration_factory())
 , m_value_factory(unit.get_value_factory())
 , m_opt_level(opt_level)
+, m_local_vars(0, Local_var_map::hasher(), Local_var_map::key_equal(), alloc)
+, m_local_syms(0, Local_sym_map::hasher(), Local_sym_map::key_equal(), alloc)
+, m_copy_map(0, Copy_map::hasher(), Copy_map::key_equal(), alloc)
 {
 }
 
@@ -67,9 +332,28 @@ void Optimizer::run(
         return;
     }
 
+    size_t n_before = count_nodes(unit);
+
     Optimizer opt(alloc, compiler, unit, opt_level);
 
     opt.local_opt();
+
+    if (opt_level > 1) {
+        opt.global_opt();
+
+        // clean up the statements emptied by the global optimizations
+        opt.local_opt();
+    }
+
+    unit.set_optimizer_statistics(n_before, count_nodes(unit));
+}
+
+// Count the AST nodes (declarations, statements and expressions) of a compilation unit.
+size_t Optimizer::count_nodes(Compilation_unit &unit)
+{
+    Node_counter counter;
+    counter.visit(&unit);
+    return counter.get_count();
 }
 
 // Checks if two given expressions are semantically the same.
@@ -129,16 +413,155 @@ bool Optimizer::same_expr(Expr *a, Expr *b) const
             return same_expr(ca->get_false(), cb->get_false());
         }
     case Expr::EK_CALL:
-        // NYI
-        return false;
+        {
+            Expr_call *ca = cast<Expr_call>(a);
+            Expr_call *cb = cast<Expr_call>(b);
+
+            if (ca->is_typecast() != cb->is_typecast())
+                return false;
+            if (!same_expr(ca->get_callee(), cb->get_callee()))
+                return false;
+
+            size_t n = ca->get_argument_count();
+            if (n != cb->get_argument_count())
+                return false;
+            for (size_t i = 0; i < n; ++i) {
+                if (!same_expr(ca->get_argument(i), cb->get_argument(i)))
+                    return false;
+            }
+            return true;
+        }
     case Expr::EK_COMPOUND:
-        // NYI
-        return false;
+        {
+            Expr_compound *ca = cast<Expr_compound>(a);
+            Expr_compound *cb = cast<Expr_compound>(b);
+
+            size_t n = ca->get_element_count();
+            if (n != cb->get_element_count())
+                return false;
+            for (size_t i = 0; i < n; ++i) {
+                if (!same_expr(ca->get_element(i), cb->get_element(i)))
+                    return false;
+            }
+            return true;
+        }
     }
     HLSL_ASSERT(!"unsupported expression kind");
     return false;
 }
 
+// Checks if the evaluation of an expression might have side effects.
+bool Optimizer::has_side_effects(Expr *expr) const
+{
+    switch (expr->get_kind()) {
+    case Expr::EK_INVALID:
+        return true;
+    case Expr::EK_LITERAL:
+    case Expr::EK_REFERENCE:
+        return false;
+    case Expr::EK_UNARY:
+        {
+            Expr_unary *unary = cast<Expr_unary>(expr);
+
+            if (is_inc_dec_operator(unary->get_operator()))
+                return true;
+            return has_side_effects(unary->get_argument());
+        }
+    case Expr::EK_BINARY:
+        {
+            Expr_binary *binary = cast<Expr_binary>(expr);
+
+            if (is_assign_operator(binary->get_operator()))
+                return true;
+            return
+                has_side_effects(binary->get_left_argument()) ||
+                has_side_effects(binary->get_right_argument());
+        }
+    case Expr::EK_CONDITIONAL:
+        {
+            Expr_conditional *c_expr = cast<Expr_conditional>(expr);
+
+            return
+                has_side_effects(c_expr->get_condition()) ||
+                has_side_effects(c_expr->get_true()) ||
+                has_side_effects(c_expr->get_false());
+        }
+    case Expr::EK_CALL:
+        {
+            Expr_call *call = cast<Expr_call>(expr);
+
+            if (!call->is_typecast()) {
+                // only elemental constructors are known to be free of side effects
+                if (!is_elem_constructor_call(call))
+                    return true;
+            }
+            for (size_t i = 0, n = call->get_argument_count(); i < n; ++i) {
+                if (has_side_effects(call->get_argument(i)))
+                    return true;
+            }
+            return false;
+        }
+    case Expr::EK_COMPOUND:
+        {
+            Expr_compound *c_expr = cast<Expr_compound>(expr);
+
+            for (size_t i = 0, n = c_expr->get_element_count(); i < n; ++i) {
+                if (has_side_effects(c_expr->get_element(i)))
+                    return true;
+            }
+            return false;
+        }
+    }
+    HLSL_ASSERT(!"unsupported expression kind");
+    return true;
+}
+
+// Checks if an expression is built only from literals and elemental constructors.
+bool Optimizer::is_constant_expr(Expr *expr) const
+{
+    switch (expr->get_kind()) {
+    case Expr::EK_LITERAL:
+        return true;
+    case Expr::EK_CALL:
+        {
+            Expr_call *call = cast<Expr_call>(expr);
+
+            if (!is_elem_constructor_call(call))
+                return false;
+
+            for (size_t i = 0, n = call->get_argument_count(); i < n; ++i) {
+                if (!is_constant_expr(call->get_argument(i)))
+                    return false;
+            }
+            return true;
+        }
+    case Expr::EK_COMPOUND:
+        {
+            Expr_compound *c_expr = cast<Expr_compound>(expr);
+
+            for (size_t i = 0, n = c_expr->get_element_count(); i < n; ++i) {
+                if (!is_constant_expr(c_expr->get_element(i)))
+                    return false;
+            }
+            return true;
+        }
+    default:
+        return false;
+    }
+}
+
+// Creates a reference to a definition.
+Expr *Optimizer::create_reference(Definition *def, Location const &loc)
+{
+    Type_name *tn = m_df.create_type_name(loc);
+    tn->set_name(m_df.create_name(loc, def->get_symbol()));
+
+    Expr_ref *ref = cast<Expr_ref>(m_ef.create_reference(tn));
+    ref->set_type(def->get_type());
+    ref->set_definition(def);
+    return ref;
+}
+
 // Optimize vector constructors.
 Expr *Optimizer::optimize_vector_constructor(Expr_call *constr)
 {
@@ -215,6 +638,32 @@ Expr *Optimizer::optimize_vector_constructor(Expr_call *constr)
     }
 }
 
+// Fold a vector constructor with literal arguments into a literal.
+Expr *Optimizer::fold_vector_constructor(Expr_call *constr)
+{
+    Type_vector *v_type = cast<Type_vector>(constr->get_type()->skip_type_alias());
+
+    size_t n_args = constr->get_argument_count();
+    if (n_args != v_type->get_size())
+        return NULL;
+
+    Small_VLA<Value_scalar *, 4> values(m_alloc, n_args);
+
+    for (size_t i = 0; i < n_args; ++i) {
+        Expr_literal *lit = as<Expr_literal>(constr->get_argument(i));
+        if (lit == NULL)
+            return NULL;
+
+        Value_scalar *v = as<Value_scalar>(lit->get_value());
+        if (v == NULL || v->get_type() != v_type->get_element_type())
+            return NULL;
+        values[i] = v;
+    }
+
+    Value *res = m_value_factory.get_vector(v_type, values);
+    return m_ef.create_literal(constr->get_location(), res);
+}
+
 // Optimize calls.
 Expr *Optimizer::optimize_call(Expr_call *call)
 {
@@ -239,6 +688,10 @@ Expr *Optimizer::optimize_call(Expr_call *call)
             // vector(a.x, a.y, ...) ==> a.xy...
             if (Expr *res = optimize_vector_constructor(call))
                 return res;
+
+            // vector(c_1, c_2, ...) ==> literal
+            if (Expr *res = fold_vector_constructor(call))
+                return res;
         }
     }
     return NULL;
@@ -289,7 +742,18 @@ Expr *Optimizer::create_unary(
 // Run local optimizations.
 Declaration *Optimizer::local_opt(Declaration *decl)
 {
-    return NULL;
+    if (Declaration_variable *vdecl = as<Declaration_variable>(decl)) {
+        for (Declaration_variable::iterator it(vdecl->begin()), end(vdecl->end());
+             it != end;
+             ++it)
+        {
+            Init_declarator *init = it;
+
+            if (Expr *expr = init->get_initializer())
+                init->set_initializer(local_opt(expr));
+        }
+    }
+    return decl;
 }
 
 // Run local optimizations.
@@ -316,13 +780,36 @@ Stmt *Optimizer::local_opt(Stmt *stmt)
                 Stmt *s = it;
                 Stmt *n = local_opt(s);
 
-                if (n != s) {
-                    // FIXME: replace
-                    ++it;
-                } else {
-                    ++it;
+                // advance before the list is modified
+                ++it;
+
+                if (n == NULL) {
+                    c_smtm->remove_stmt(s);
+                    continue;
+                }
+                if (n != s)
+                    c_smtm->replace_stmt(s, n);
+
+                switch (n->get_kind()) {
+                case Stmt::SK_BREAK:
+                case Stmt::SK_CONTINUE:
+                case Stmt::SK_RETURN:
+                case Stmt::SK_DISCARD:
+                    // everything after a jump is unreachable
+                    while (it != end) {
+                        Stmt *dead = it;
+                        ++it;
+                        c_smtm->remove_stmt(dead);
+                    }
+                    break;
+                default:
+                    break;
                 }
             }
+            if (c_smtm->size() == 0) {
+                // the block was emptied
+                return NULL;
+            }
             return c_smtm;
         }
 
@@ -364,7 +851,7 @@ Stmt *Optimizer::local_opt(Stmt *stmt)
 
             Expr *n_cond = local_opt(cond);
             if (n_cond != cond)
-                if_stmt->set_condition(cond);
+                if_stmt->set_condition(n_cond);
 
             if (Expr_literal *lit = as<Expr_literal>(n_cond)) {
                 Value_bool *val = cast<Value_bool>(lit->get_value());
@@ -417,12 +904,13 @@ Stmt *Optimizer::local_opt(Stmt *stmt)
                 Stmt *s = it;
                 Stmt *n = local_opt(s);
 
-                if (n != s) {
-                    // FIXME: replace
-                    ++it;
-                } else {
-                    ++it;
-                }
+                // advance before the list is modified
+                ++it;
+
+                if (n == NULL)
+                    s_smtm->remove_stmt(s);
+                else if (n != s)
+                    s_smtm->replace_stmt(s, n);
             }
             return s_smtm;
         }
@@ -469,7 +957,7 @@ Stmt *Optimizer::local_opt(Stmt *stmt)
 
                 if (v->get_value()) {
                     // endless loop
-                } else {
+                } else if (!has_loop_jump(loop_stmt->get_body(), /*in_switch=*/false)) {
                     // body executed once, replace the loop by the body
                     return local_opt(loop_stmt->get_body());
                 }
@@ -526,7 +1014,7 @@ Stmt *Optimizer::local_opt(Stmt *stmt)
                 Location const &loc = body->get_location();
                 n_body = m_sf.create_expression(loc, NULL);
             }
-            for_stmt->set_body(body);
+            for_stmt->set_body(n_body);
 
             Expr *next = for_stmt->get_update();
             if (next != NULL) {
@@ -642,8 +1130,15 @@ Expr *Optimizer::local_opt(Expr *expr)
         }
         break;
     case Expr::EK_CALL:
-        if (Expr *res = optimize_call(cast<Expr_call>(expr)))
-            return res;
+        {
+            Expr_call *call = cast<Expr_call>(expr);
+
+            for (size_t i = 0, n = call->get_argument_count(); i < n; ++i) {
+                call->set_argument(i, local_opt(call->get_argument(i)));
+            }
+            if (Expr *res = optimize_call(call))
+                return res;
+        }
         break;
     case Expr::EK_COMPOUND:
         // NYI
@@ -658,6 +1153,521 @@ void Optimizer::local_opt()
     run_on_function(&Optimizer::local_opt, &Optimizer::local_opt);
 }
 
+// Get the definition of a reference, resolving references without definition
+// to local variables by their symbol.
+Definition *Optimizer::get_ref_definition(Expr_ref *ref)
+{
+    if (Definition *def = ref->get_definition())
+        return def;
+
+    Name *name = ref->get_name()->get_name();
+    if (name == NULL)
+        return NULL;
+
+    Local_sym_map::iterator it(m_local_syms.find(name->get_symbol()));
+    if (it == m_local_syms.end())
+        return NULL;
+    return it->second;
+}
+
+// Get the local variable info for the (base) variable accessed by an lvalue expression.
+Optimizer::Local_var_info *Optimizer::get_local_var_info(Expr *expr)
+{
+    for (;;) {
+        Expr_binary *binary = as<Expr_binary>(expr);
+        if (binary == NULL)
+            break;
+
+        Expr_binary::Operator op = binary->get_operator();
+        if (op != Expr_binary::OK_SELECT && op != Expr_binary::OK_ARRAY_SUBSCRIPT)
+            return NULL;
+        expr = binary->get_left_argument();
+    }
+
+    Expr_ref *ref = as<Expr_ref>(expr);
+    if (ref == NULL)
+        return NULL;
+
+    Definition *def = get_ref_definition(ref);
+    if (def == NULL)
+        return NULL;
+
+    Local_var_map::iterator it(m_local_vars.find(def));
+    if (it == m_local_vars.end())
+        return NULL;
+    return &it->second;
+}
+
+// Replace references to copied variables.
+Expr *Optimizer::propagate_copies(Expr *expr)
+{
+    switch (expr->get_kind()) {
+    case Expr::EK_INVALID:
+    case Expr::EK_LITERAL:
+        break;
+    case Expr::EK_REFERENCE:
+        {
+            Expr_ref *ref = cast<Expr_ref>(expr);
+            Definition *def = get_ref_definition(ref);
+            if (def == NULL)
+                break;
+
+            Copy_map::iterator it(m_copy_map.find(def));
+            if (it == m_copy_map.end())
+                break;
+
+            Expr *repl = it->second;
+            Location const &loc = ref->get_location();
+
+            // follow chains of copies
+            while (Expr_ref *src = as<Expr_ref>(repl)) {
+                Copy_map::iterator s_it(m_copy_map.find(get_ref_definition(src)));
+                if (s_it == m_copy_map.end())
+                    break;
+                repl = s_it->second;
+            }
+
+            if (Expr_literal *lit = as<Expr_literal>(repl))
+                return m_ef.create_literal(loc, lit->get_value());
+            if (Expr_ref *src = as<Expr_ref>(repl))
+                return create_reference(get_ref_definition(src), loc);
+
+            // a single use, move the expression
+            return repl;
+        }
+    case Expr::EK_UNARY:
+        {
+            Expr_unary *unary = cast<Expr_unary>(expr);
+            unary->set_argument(propagate_copies(unary->get_argument()));
+        }
+        break;
+    case Expr::EK_BINARY:
+        {
+            Expr_binary *binary = cast<Expr_binary>(expr);
+            binary->set_left_argument(propagate_copies(binary->get_left_argument()));
+
+            // the right hand side of a select is a member or swizzle name
+            if (binary->get_operator() != Expr_binary::OK_SELECT)
+                binary->set_right_argument(propagate_copies(binary->get_right_argument()));
+        }
+        break;
+    case Expr::EK_CONDITIONAL:
+        {
+            Expr_conditional *c_expr = cast<Expr_conditional>(expr);
+            c_expr->set_condition(propagate_copies(c_expr->get_condition()));
+            c_expr->set_true(propagate_copies(c_expr->get_true()));
+            c_expr->set_false(propagate_copies(c_expr->get_false()));
+        }
+        break;
+    case Expr::EK_CALL:
+        {
+            Expr_call *call = cast<Expr_call>(expr);
+            for (size_t i = 0, n = call->get_argument_count(); i < n; ++i) {
+                call->set_argument(i, propagate_copies(call->get_argument(i)));
+            }
+        }
+        break;
+    case Expr::EK_COMPOUND:
+        {
+            Expr_compound *c_expr = cast<Expr_compound>(expr);
+            for (size_t i = 0, n = c_expr->get_element_count(); i < n; ++i) {
+                c_expr->set_element(i, propagate_copies(c_expr->get_element(i)));
+            }
+        }
+        break;
+    }
+    return expr;
+}
+
+// Replace references to copied variables.
+void Optimizer::propagate_copies(Stmt *stmt)
+{
+    switch (stmt->get_kind()) {
+    case Stmt::SK_INVALID:
+    case Stmt::SK_CASE:
+    case Stmt::SK_BREAK:
+    case Stmt::SK_CONTINUE:
+    case Stmt::SK_DISCARD:
+        break;
+    case Stmt::SK_COMPOUND:
+    case Stmt::SK_SWITCH:
+        {
+            if (Stmt_switch *s_stmt = as<Stmt_switch>(stmt))
+                s_stmt->set_condition(propagate_copies(s_stmt->get_condition()));
+
+            Stmt_list *list = static_cast<Stmt_list *>(stmt);
+            for (Stmt_list::iterator it(list->begin()), end(list->end()); it != end; ++it) {
+                propagate_copies(it);
+            }
+        }
+        break;
+    case Stmt::SK_DECLARATION:
+        {
+            Stmt_decl *decl_stmt = cast<Stmt_decl>(stmt);
+
+            if (Declaration_variable *vdecl =
+                    as<Declaration_variable>(decl_stmt->get_declaration()))
+            {
+                for (Declaration_variable::iterator it(vdecl->begin()), end(vdecl->end());
+                     it != end;
+                     ++it)
+                {
+                    Init_declarator *init = it;
+
+                    if (Expr *expr = init->get_initializer())
+                        init->set_initializer(propagate_copies(expr));
+                }
+            }
+        }
+        break;
+    case Stmt::SK_EXPRESSION:
+        {
+            Stmt_expr *e_stmt = cast<Stmt_expr>(stmt);
+            if (Expr *expr = e_stmt->get_expression())
+                e_stmt->set_expression(propagate_copies(expr));
+        }
+        break;
+    case Stmt::SK_IF:
+        {
+            Stmt_if *if_stmt = cast<Stmt_if>(stmt);
+            if_stmt->set_condition(propagate_copies(if_stmt->get_condition()));
+            propagate_copies(if_stmt->get_then_statement());
+            if (Stmt *else_stmt = if_stmt->get_else_statement())
+                propagate_copies(else_stmt);
+        }
+        break;
+    case Stmt::SK_WHILE:
+        {
+            Stmt_while *loop_stmt = cast<Stmt_while>(stmt);
+            propagate_copies(loop_stmt->get_condition());
+            propagate_copies(loop_stmt->get_body());
+        }
+        break;
+    case Stmt::SK_DO_WHILE:
+        {
+            Stmt_do_while *loop_stmt = cast<Stmt_do_while>(stmt);
+            propagate_copies(loop_stmt->get_body());
+            loop_stmt->set_condition(propagate_copies(loop_stmt->get_condition()));
+        }
+        break;
+    case Stmt::SK_FOR:
+        {
+            Stmt_for *for_stmt = cast<Stmt_for>(stmt);
+            if (Stmt *init = for_stmt->get_init())
+                propagate_copies(init);
+            if (Stmt *cond = for_stmt->get_condition())
+                propagate_copies(cond);
+            if (Expr *update = for_stmt->get_update())
+                for_stmt->set_update(propagate_copies(update));
+            propagate_copies(for_stmt->get_body());
+        }
+        break;
+    case Stmt::SK_RETURN:
+        {
+            Stmt_return *r_stmt = cast<Stmt_return>(stmt);
+            if (Expr *expr = r_stmt->get_expression())
+                r_stmt->set_expression(propagate_copies(expr));
+        }
+        break;
+    }
+}
+
+// Checks if an expression is a store to a variable that is never read.
+bool Optimizer::is_dead_store(Expr *expr, Expr *&remainder)
+{
+    if (Expr_unary *unary = as<Expr_unary>(expr)) {
+        if (!is_inc_dec_operator(unary->get_operator()))
+            return false;
+
+        Expr *arg = unary->get_argument();
+        Local_var_info *info = get_local_var_info(arg);
+        if (info == NULL || info->m_n_reads > 0 || has_side_effects(arg))
+            return false;
+
+        remainder = NULL;
+        return true;
+    }
+
+    if (Expr_binary *binary = as<Expr_binary>(expr)) {
+        if (!is_assign_operator(binary->get_operator()))
+            return false;
+
+        Expr *lhs = binary->get_left_argument();
+        Local_var_info *info = get_local_var_info(lhs);
+        if (info == NULL || info->m_n_reads > 0 || has_side_effects(lhs))
+            return false;
+
+        Expr *rhs = binary->get_right_argument();
+        remainder = has_side_effects(rhs) ? rhs : NULL;
+        return true;
+    }
+    return false;
+}
+
+// Checks if a statement declares only an unused variable.
+bool Optimizer::is_dead_declaration(Stmt *stmt)
+{
+    Stmt_decl *decl_stmt = as<Stmt_decl>(stmt);
+    if (decl_stmt == NULL)
+        return false;
+
+    Declaration_variable *vdecl = as<Declaration_variable>(decl_stmt->get_declaration());
+    if (vdecl == NULL)
+        return false;
+
+    Declaration_variable::iterator it(vdecl->begin());
+    if (it == vdecl->end())
+        return false;
+
+    Definition *def = it->get_name()->get_definition();
+    if (def == NULL)
+        return false;
+
+    Local_var_map::iterator v_it(m_local_vars.find(def));
+    if (v_it == m_local_vars.end())
+        return false;
+
+    Local_var_info const &info = v_it->second;
+    if (info.m_decl_stmt != decl_stmt || info.m_n_refs > 0)
+        return false;
+
+    Expr *init = info.m_init->get_initializer();
+    return init == NULL || !has_side_effects(init);
+}
+
+// Remove dead stores and declarations of unused variables.
+bool Optimizer::remove_dead_code(Stmt *stmt)
+{
+    bool changed = false;
+
+    switch (stmt->get_kind()) {
+    case Stmt::SK_COMPOUND:
+    case Stmt::SK_SWITCH:
+        {
+            Stmt_list *list = static_cast<Stmt_list *>(stmt);
+            for (Stmt_list::iterator it(list->begin()), end(list->end()); it != end;) {
+                Stmt *s = it;
+
+                // advance before the list is modified
+                ++it;
+
+                if (is_dead_declaration(s)) {
+                    list->remove_stmt(s);
+                    changed = true;
+                } else {
+                    changed |= remove_dead_code(s);
+                }
+            }
+        }
+        break;
+    case Stmt::SK_EXPRESSION:
+        {
+            Stmt_expr *e_stmt = cast<Stmt_expr>(stmt);
+            Expr      *remainder = NULL;
+
+            if (Expr *expr = e_stmt->get_expression()) {
+                if (is_dead_store(expr, remainder)) {
+                    // an expression statement without expression is removed by local_opt()
+                    e_stmt->set_expression(remainder);
+                    changed = true;
+                }
+            }
+        }
+        break;
+    case Stmt::SK_IF:
+        {
+            Stmt_if *if_stmt = cast<Stmt_if>(stmt);
+            changed |= remove_dead_code(if_stmt->get_then_statement());
+            if (Stmt *else_stmt = if_stmt->get_else_statement())
+                changed |= remove_dead_code(else_stmt);
+        }
+        break;
+    case Stmt::SK_WHILE:
+        changed |= remove_dead_code(cast<Stmt_while>(stmt)->get_body());
+        break;
+    case Stmt::SK_DO_WHILE:
+        changed |= remove_dead_code(cast<Stmt_do_while>(stmt)->get_body());
+        break;
+    case Stmt::SK_FOR:
+        {
+            Stmt_for *for_stmt = cast<Stmt_for>(stmt);
+            if (Stmt *init = for_stmt->get_init())
+                changed |= remove_dead_code(init);
+            changed |= remove_dead_code(for_stmt->get_body());
+        }
+        break;
+    default:
+        break;
+    }
+    return changed;
+}
+
+// Run global optimizations on one function body.
+bool Optimizer::global_opt(Stmt_compound *body)
+{
+    m_local_vars.clear();
+    m_local_syms.clear();
+    m_copy_map.clear();
+
+    Local_var_collector collector(*this);
+    collector.visit(body);
+
+    for (Stmt_compound::iterator it(body->begin()), end(body->end()); it != end; ++it) {
+        if (Stmt_decl *decl_stmt = as<Stmt_decl>(it)) {
+            if (Declaration_variable *vdecl =
+                    as<Declaration_variable>(decl_stmt->get_declaration()))
+            {
+                Declaration_variable::iterator d_it(vdecl->begin());
+                if (d_it == vdecl->end())
+                    continue;
+                Local_var_map::iterator v_it(m_local_vars.find(d_it->get_name()->get_definition()));
+                if (v_it != m_local_vars.end() && v_it->second.m_decl_stmt == decl_stmt)
+                    v_it->second.m_is_top_level = true;
+            }
+        }
+    }
+
+    // Copy propagation: variables that are never written after their initialization
+    // are replaced by their literal initializer, or by their constant initializer if
+    // they are used only once.
+    for (Local_var_map::iterator it(m_local_vars.begin()), end(m_local_vars.end());
+         it != end;
+         ++it)
+    {
+        Local_var_info const &info = it->second;
+        if (info.m_decl_stmt == NULL || info.m_n_writes > 0 || info.m_n_reads == 0)
+            continue;
+
+        Expr *init = info.m_init->get_initializer();
+        if (init == NULL)
+            continue;
+
+        if (Expr_literal *lit = as<Expr_literal>(init)) {
+            Value *v = lit->get_value();
+
+            // array and struct literals are only allowed inside initializers
+            if (as<Value_array>(v) != NULL || as<Value_struct>(v) != NULL)
+                continue;
+
+            // do not duplicate vector and matrix literals
+            if (as<Value_scalar>(v) != NULL || info.m_n_reads == 1)
+                m_copy_map[it->first] = lit;
+        } else if (info.m_n_reads == 1 && !is<Expr_compound>(init) && is_constant_expr(init)) {
+            m_copy_map[it->first] = init;
+        }
+    }
+
+    // Variables which are copies of other unmodified variables are replaced by those.
+    for (Local_var_map::iterator it(m_local_vars.begin()), end(m_local_vars.end());
+         it != end;
+         ++it)
+    {
+        Local_var_info const &info = it->second;
+        if (info.m_decl_stmt == NULL || info.m_n_writes > 0 || info.m_n_reads == 0)
+            continue;
+
+        Expr_ref *ref = as<Expr_ref>(info.m_init->get_initializer());
+        if (ref == NULL || m_copy_map.find(it->first) != m_copy_map.end())
+            continue;
+
+        Local_var_map::iterator src_it(m_local_vars.find(get_ref_definition(ref)));
+        if (src_it == m_local_vars.end())
+            continue;
+
+        Local_var_info const &src_info = src_it->second;
+        if (src_info.m_n_writes > 0 || src_info.m_init->get_initializer() == NULL)
+            continue;
+
+        Copy_map::iterator c_it(m_copy_map.find(src_it->first));
+        if (c_it != m_copy_map.end() && !is<Expr_literal>(c_it->second)) {
+            // the initializer of the source is moved away
+            continue;
+        }
+        m_copy_map[it->first] = ref;
+    }
+
+    // Redundant constants: a top-level constant variable with the same initializer as a
+    // previous one is replaced by the previous one.
+    vector<Definition *>::Type constants(m_alloc);
+    for (Stmt_compound::iterator it(body->begin()), end(body->end()); it != end; ++it) {
+        Stmt_decl *decl_stmt = as<Stmt_decl>(it);
+        if (decl_stmt == NULL)
+            continue;
+        Declaration_variable *vdecl = as<Declaration_variable>(decl_stmt->get_declaration());
+        if (vdecl == NULL || vdecl->begin() == vdecl->end())
+            continue;
+
+        Definition *def = vdecl->begin()->get_name()->get_definition();
+        Local_var_map::iterator v_it(m_local_vars.find(def));
+        if (v_it == m_local_vars.end())
+            continue;
+
+        Local_var_info const &info = v_it->second;
+        if (!info.m_is_top_level || info.m_n_writes > 0 || info.m_n_reads == 0)
+            continue;
+        if (m_copy_map.find(def) != m_copy_map.end())
+            continue;
+
+        Expr *init = info.m_init->get_initializer();
+        if (init == NULL || !is_constant_expr(init))
+            continue;
+
+        bool found = false;
+        for (size_t i = 0, n = constants.size(); i < n; ++i) {
+            Definition *prev = constants[i];
+            if (prev->get_type() != def->get_type())
+                continue;
+
+            Expr *prev_init = m_local_vars[prev].m_init->get_initializer();
+            if (same_expr(prev_init, init)) {
+                m_copy_map[def] = create_reference(prev, info.m_init->get_location());
+                found = true;
+                break;
+            }
+        }
+        if (!found)
+            constants.push_back(def);
+    }
+
+    bool changed = false;
+    if (!m_copy_map.empty()) {
+        propagate_copies(body);
+
+        // all references to the replaced variables are gone now
+        for (Copy_map::iterator it(m_copy_map.begin()), end(m_copy_map.end()); it != end; ++it) {
+            Local_var_info &info = m_local_vars[it->first];
+            info.m_n_refs  = 0;
+            info.m_n_reads = 0;
+        }
+        changed = true;
+    }
+
+    changed |= remove_dead_code(body);
+    return changed;
+}
+
+// Run global optimizations.
+void Optimizer::global_opt()
+{
+    for (Compilation_unit::iterator it(m_unit.decl_begin()), end(m_unit.decl_end());
+         it != end;
+         ++it)
+    {
+        Declaration *decl = it;
+
+        if (Declaration_function *fdecl = as<Declaration_function>(decl)) {
+            if (Stmt_compound *body = as<Stmt_compound>(fdecl->get_body())) {
+                // every iteration removes at least one variable or store, so this terminates
+                while (global_opt(body)) {
+                }
+            }
+        }
+    }
+    m_local_vars.clear();
+    m_local_syms.clear();
+    m_copy_map.clear();
+}
+
 }  // hlsl
 }  // mdl
 }  // mi
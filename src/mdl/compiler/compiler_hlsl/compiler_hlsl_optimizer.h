@@ -29,6 +29,8 @@
 #ifndef MDL_COMPILER_HLSL_OPTIMIZER_H
 #define MDL_COMPILER_HLSL_OPTIMIZER_H 1
 
+#include "mdl/compiler/compilercore/compilercore_allocator.h"
+
 #include "compiler_hlsl_cc_conf.h"
 
 namespace mi {
@@ -37,12 +39,17 @@ namespace hlsl {
 
 class Compiler;
 class Compilation_unit;
+class Definition;
 class Expr_factory;
+class Init_declarator;
+class Local_var_collector;
 class Stmt_factory;
+class Symbol;
 class Value_factory;
 
 /// This class implements the AST optimizer for the HLSL compiler.
 class Optimizer {
+    friend class Local_var_collector;
 public:
     /// Run the optimizer on this compilation unit.
     ///
@@ -57,9 +64,58 @@ public:
         int              opt_level);
 
 private:
+    /// Usage information of a local variable.
+    struct Local_var_info {
+        /// Constructor.
+        Local_var_info(Init_declarator *init = NULL, Stmt_decl *decl_stmt = NULL)
+        : m_init(init)
+        , m_decl_stmt(decl_stmt)
+        , m_is_top_level(false)
+        , m_n_refs(0)
+        , m_n_reads(0)
+        , m_n_writes(0)
+        {
+        }
+
+        /// The declarator of the variable.
+        Init_declarator *m_init;
+
+        /// The declaration statement if it declares only this variable, else NULL.
+        Stmt_decl *m_decl_stmt;
+
+        /// True, if the variable is declared in the outermost block of its function.
+        bool m_is_top_level;
+
+        /// Number of references to this variable.
+        size_t m_n_refs;
+
+        /// Number of references reading the variable.
+        size_t m_n_reads;
+
+        /// Number of writes to this variable, not counting the initializer.
+        size_t m_n_writes;
+    };
+
+    typedef ptr_hash_map<Definition, Local_var_info>::Type Local_var_map;
+    typedef ptr_hash_map<Definition, Expr *>::Type         Copy_map;
+    typedef ptr_hash_map<Symbol, Definition *>::Type       Local_sym_map;
+
+private:
+    /// Count the AST nodes (declarations, statements and expressions) of a compilation unit.
+    static size_t count_nodes(Compilation_unit &unit);
+
     /// Checks if two given expressions are semantically the same.
     bool same_expr(Expr *a, Expr *b) const;
 
+    /// Checks if the evaluation of an expression might have side effects.
+    bool has_side_effects(Expr *expr) const;
+
+    /// Checks if an expression is built only from literals and elemental constructors.
+    bool is_constant_expr(Expr *expr) const;
+
+    /// Creates a reference to a definition.
+    Expr *create_reference(Definition *def, Location const &loc);
+
     /// Creates an unary expression.
     Expr *create_unary(
         Expr_unary::Operator op,
@@ -69,6 +125,9 @@ private:
     /// Optimize vector constructors.
     Expr *optimize_vector_constructor(Expr_call *constr);
 
+    /// Fold a vector constructor with literal arguments into a literal.
+    Expr *fold_vector_constructor(Expr_call *constr);
+
     /// Optimize calls.
     Expr *optimize_call(Expr_call *call);
 
@@ -92,6 +151,45 @@ private:
     /// Run local optimizations.
     void local_opt();
 
+    /// Get the definition of a reference, resolving references without definition
+    /// to local variables by their symbol.
+    Definition *get_ref_definition(Expr_ref *ref);
+
+    /// Get the local variable info for the (base) variable accessed by an lvalue expression.
+    ///
+    /// \return NULL if expr does not access a local variable
+    Local_var_info *get_local_var_info(Expr *expr);
+
+    /// Replace references to copied variables.
+    Expr *propagate_copies(Expr *expr);
+
+    /// Replace references to copied variables.
+    void propagate_copies(Stmt *stmt);
+
+    /// Checks if an expression is a store to a variable that is never read.
+    ///
+    /// \param expr       the expression to check
+    /// \param remainder  if true is returned, the part of expr that must be kept
+    ///                   for its side effects or NULL
+    bool is_dead_store(Expr *expr, Expr *&remainder);
+
+    /// Checks if a statement declares only an unused variable.
+    bool is_dead_declaration(Stmt *stmt);
+
+    /// Remove dead stores and declarations of unused variables.
+    ///
+    /// \return true if the statement was changed
+    bool remove_dead_code(Stmt *stmt);
+
+    /// Run global optimizations on one function body.
+    ///
+    /// \return true if the body was changed
+    bool global_opt(Stmt_compound *body);
+
+    /// Run global optimizations, i.e. copy propagation, elimination of
+    /// redundant constants and dead variable elimination.
+    void global_opt();
+
 private:
     /// Constructor.
     ///
@@ -135,6 +233,15 @@ private:
 
     /// Current optimizer level.
     int m_opt_level;
+
+    /// Usage information of the local variables of the currently optimized function.
+    Local_var_map m_local_vars;
+
+    /// The local variables of the currently optimized function by their symbol.
+    Local_sym_map m_local_syms;
+
+    /// Replacements for references to variables of the currently optimized function.
+    Copy_map m_copy_map;
 };
 
 }  // hlsl
@@ -241,6 +241,12 @@ public:
     /// Delete last element.
     void pop_back() { m_stmts.pop_back(); }
 
+    /// Remove a statement from this list.
+    void remove_stmt(Stmt *stmt) { m_stmts.remove(stmt); }
+
+    /// Replace a statement of this list by another one.
+    void replace_stmt(Stmt *old_stmt, Stmt *new_stmt) { m_stmts.replace(old_stmt, new_stmt); }
+
     /// Get the number of elements in the list.
     size_t size() const { return m_stmts.size(); }
 
@@ -0,0 +1,376 @@
+/***************************************************************************************************
+ * Copyright (c) 2007-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************************************/
+
+/// \file
+/// \brief Regression tests for the HLSL AST optimizer.
+
+#include <base/system/test/i_test_auto_driver.h>
+
+#include <string>
+
+#include <mi/base/handle.h>
+
+#include <mdl/compiler/compilercore/compilercore_malloc_allocator.h>
+#include <mdl/compiler/compilercore/compilercore_streams.h>
+#include <mdl/compiler/compiler_hlsl/compiler_hlsl_compilation_unit.h>
+#include <mdl/compiler/compiler_hlsl/compiler_hlsl_compiler.h>
+#include <mdl/compiler/compiler_hlsl/compiler_hlsl_declarations.h>
+#include <mdl/compiler/compiler_hlsl/compiler_hlsl_definitions.h>
+#include <mdl/compiler/compiler_hlsl/compiler_hlsl_exprs.h>
+#include <mdl/compiler/compiler_hlsl/compiler_hlsl_printers.h>
+#include <mdl/compiler/compiler_hlsl/compiler_hlsl_stmts.h>
+#include <mdl/compiler/compiler_hlsl/compiler_hlsl_symbols.h>
+#include <mdl/compiler/compiler_hlsl/compiler_hlsl_tools.h>
+#include <mdl/compiler/compiler_hlsl/compiler_hlsl_types.h>
+#include <mdl/compiler/compiler_hlsl/compiler_hlsl_values.h>
+
+using namespace mi::mdl::hlsl;
+
+namespace {
+
+Location const zero_loc(0, 0, 0);
+
+/// Builds the function "int f(int p, bool c)" and returns its optimized HLSL code.
+class Function_builder
+{
+public:
+    Function_builder()
+    : m_alloc(mi::mdl::MallocAllocator::create_instance())
+    , m_compiler(mi::mdl::impl_cast<Compiler>(initialize(m_alloc.get())))
+    , m_unit(m_compiler->create_unit("test"))
+    , m_df(m_unit->get_declaration_factory())
+    , m_ef(m_unit->get_expression_factory())
+    , m_sf(m_unit->get_statement_factory())
+    , m_tf(m_unit->get_type_factory())
+    , m_vf(m_unit->get_value_factory())
+    , m_st(m_unit->get_symbol_table())
+    , m_def_tab(m_unit->get_definition_table())
+    , m_body(m_sf.create_compound(zero_loc))
+    {
+        m_def_tab.transition_to_scope(m_def_tab.get_global_scope());
+
+        Type_function::Parameter params[] = {
+            Type_function::Parameter(m_tf.get_int(), Type_function::Parameter::PM_IN),
+            Type_function::Parameter(m_tf.get_bool(), Type_function::Parameter::PM_IN),
+        };
+        Type_function *func_type = m_tf.get_function(m_tf.get_int(), params);
+
+        Name *func_name = m_df.create_name(zero_loc, m_st.get_symbol("f"));
+        m_func_def = m_def_tab.enter_function_definition(
+            func_name->get_symbol(), func_type, Def_function::DS_UNKNOWN, &zero_loc);
+        m_decl_func = m_df.create_function(type_name(m_tf.get_int()), func_name);
+        m_func_def->set_declaration(m_decl_func);
+        func_name->set_definition(m_func_def);
+
+        Scope *scope = m_def_tab.enter_scope(m_func_def);
+        m_func_def->set_own_scope(scope);
+
+        m_p = add_param("p", m_tf.get_int());
+        m_c = add_param("c", m_tf.get_bool());
+    }
+
+    /// Returns the parameter "p".
+    Def_param *p() const { return m_p; }
+
+    /// Returns the parameter "c".
+    Def_param *c() const { return m_c; }
+
+    /// Returns the function body.
+    Stmt_compound *body() const { return m_body; }
+
+    /// Declares a local variable at the start of the function body.
+    Def_variable *add_var(char const *name, Type *type, Expr *init)
+    {
+        Declaration_variable *decl_var  = m_df.create_variable(type_name(type));
+        Init_declarator      *init_decl = m_df.create_init_declarator(zero_loc);
+        Name                 *var_name  = m_df.create_name(zero_loc, m_st.get_symbol(name));
+        init_decl->set_name(var_name);
+        init_decl->set_initializer(init);
+        decl_var->add_init(init_decl);
+
+        Def_variable *var_def = m_def_tab.enter_variable_definition(
+            var_name->get_symbol(), type, &zero_loc);
+        var_def->set_declaration(decl_var);
+        var_name->set_definition(var_def);
+
+        m_body->add_stmt(m_sf.create_declaration(decl_var));
+        return var_def;
+    }
+
+    /// Creates a reference to a variable or parameter.
+    Expr *ref(Definition *def)
+    {
+        Type_name *name = m_df.create_type_name(zero_loc);
+        name->set_name(m_df.create_name(zero_loc, def->get_symbol()));
+        Expr *expr = m_ef.create_reference(name);
+        expr->set_type(def->get_type());
+        cast<Expr_ref>(expr)->set_definition(def);
+        return expr;
+    }
+
+    /// Creates an int literal.
+    Expr *lit(int v) { return m_ef.create_literal(zero_loc, m_vf.get_int32(v)); }
+
+    /// Creates a bool literal.
+    Expr *lit(bool v) { return m_ef.create_literal(zero_loc, m_vf.get_bool(v)); }
+
+    /// Creates the statement "def = value;".
+    Stmt *assign(Definition *def, Expr *value)
+    {
+        Expr *expr = m_ef.create_binary(Expr_binary::OK_ASSIGN, ref(def), value);
+        expr->set_type(def->get_type());
+        return m_sf.create_expression(zero_loc, expr);
+    }
+
+    /// Creates "left + right".
+    Expr *plus(Expr *left, Expr *right)
+    {
+        Expr *sum = m_ef.create_binary(Expr_binary::OK_PLUS, left, right);
+        sum->set_type(left->get_type());
+        return sum;
+    }
+
+    /// Creates the statement "def = def + 1;".
+    Stmt *increment(Definition *def) { return assign(def, plus(ref(def), lit(1))); }
+
+    /// Creates the statement "return expr;".
+    Stmt *ret(Expr *expr) { return m_sf.create_return(zero_loc, expr); }
+
+    /// Creates a block from the given statements.
+    Stmt_compound *block(Stmt *a, Stmt *b = NULL, Stmt *c = NULL)
+    {
+        Stmt_compound *res = m_sf.create_compound(zero_loc);
+        res->add_stmt(a);
+        if (b != NULL)
+            res->add_stmt(b);
+        if (c != NULL)
+            res->add_stmt(c);
+        return res;
+    }
+
+    /// Creates the statement "if (c) jump".
+    Stmt *if_c(Stmt *jump) { return m_sf.create_if(zero_loc, ref(m_c), jump, NULL); }
+
+    /// Creates a break statement.
+    Stmt *brk() { return m_sf.create_break(zero_loc); }
+
+    /// Creates a continue statement.
+    Stmt *cont() { return m_sf.create_continue(zero_loc); }
+
+    /// Creates "do body while (cond);".
+    Stmt *do_while(Stmt *body, Expr *cond) { return m_sf.create_do_while(zero_loc, cond, body); }
+
+    /// Creates "switch (p) { case 0: body }".
+    Stmt *switch_p(Stmt *body)
+    {
+        Stmt_switch *s = m_sf.create_switch(zero_loc, ref(m_p));
+        s->add_stmt(m_sf.create_case_label(zero_loc, lit(0), s));
+        s->add_stmt(body);
+        return s;
+    }
+
+    /// Finishes the function, runs the optimizer and returns the HLSL code.
+    std::string finish()
+    {
+        m_def_tab.leave_scope();
+
+        m_decl_func->set_body(m_body);
+        m_unit->add_decl(m_decl_func);
+        m_unit->analyze(*m_compiler.get());
+
+        mi::base::Handle<mi::mdl::Buffer_output_stream> out(
+            mi::mdl::Allocator_builder(m_alloc.get()).create<mi::mdl::Buffer_output_stream>(m_alloc.get()));
+        mi::base::Handle<IPrinter> printer(m_compiler->create_printer(out.get()));
+        printer->print(m_unit.get());
+
+        return std::string(out->get_data(), out->get_data_size());
+    }
+
+private:
+    /// Creates a type name for a type.
+    Type_name *type_name(Type *type)
+    {
+        Type_name *res = m_df.create_type_name(zero_loc);
+        res->set_name(m_df.create_name(zero_loc, type->get_sym()));
+        res->set_type(type);
+        return res;
+    }
+
+    /// Adds a parameter to the function.
+    Def_param *add_param(char const *name, Type *type)
+    {
+        Declaration_param *decl_param = m_df.create_param(type_name(type));
+        Name              *param_name = m_df.create_name(zero_loc, m_st.get_symbol(name));
+        decl_param->set_name(param_name);
+
+        Def_param *param_def = m_def_tab.enter_parameter_definition(
+            param_name->get_symbol(), type, &zero_loc);
+        param_def->set_declaration(decl_param);
+        param_name->set_definition(param_def);
+
+        m_decl_func->add_param(decl_param);
+        return param_def;
+    }
+
+private:
+    mi::base::Handle<mi::mdl::IAllocator>       m_alloc;
+    mi::base::Handle<Compiler>         m_compiler;
+    mi::base::Handle<Compilation_unit> m_unit;
+    Decl_factory                       &m_df;
+    Expr_factory                       &m_ef;
+    Stmt_factory                       &m_sf;
+    Type_factory                       &m_tf;
+    Value_factory                      &m_vf;
+    Symbol_table                       &m_st;
+    Definition_table                   &m_def_tab;
+    Stmt_compound                      *m_body;
+    Def_function                       *m_func_def;
+    Declaration_function               *m_decl_func;
+    Def_param                          *m_p;
+    Def_param                          *m_c;
+};
+
+/// Checks if \p code contains \p str.
+bool contains(std::string const &code, char const *str)
+{
+    return code.find(str) != std::string::npos;
+}
+
+} // namespace
+
+MI_TEST_AUTO_FUNCTION( test_copy_propagation)
+{
+    // int a = 3; return p + a;  ==>  return p + 3;
+    Function_builder f;
+    Def_variable *a = f.add_var("a", f.p()->get_type(), f.lit(3));
+    f.body()->add_stmt(f.ret(f.plus(f.ref(f.p()), f.ref(a))));
+
+    std::string code = f.finish();
+    MI_CHECK( !contains( code, "int a"));
+    MI_CHECK( contains( code, "return p + 3;"));
+}
+
+MI_TEST_AUTO_FUNCTION( test_copy_of_unmodified_variable)
+{
+    // int s = p + 1; int a = s; return a + s;  ==>  int s = p + 1; return s + s;
+    Function_builder f;
+    Def_variable *s = f.add_var("s", f.p()->get_type(), f.plus(f.ref(f.p()), f.lit(1)));
+    Def_variable *a = f.add_var("a", f.p()->get_type(), f.ref(s));
+    f.body()->add_stmt(f.ret(f.plus(f.ref(a), f.ref(s))));
+
+    std::string code = f.finish();
+    MI_CHECK( !contains( code, "int a"));
+    MI_CHECK( contains( code, "int s = p + 1;"));
+    MI_CHECK( contains( code, "return s + s;"));
+}
+
+MI_TEST_AUTO_FUNCTION( test_dead_store_removal)
+{
+    // int b = p; b = 5; return p;  ==>  return p;
+    Function_builder f;
+    Def_variable *b = f.add_var("b", f.p()->get_type(), f.ref(f.p()));
+    f.body()->add_stmt(f.assign(b, f.lit(5)));
+    f.body()->add_stmt(f.ret(f.ref(f.p())));
+
+    std::string code = f.finish();
+    MI_CHECK( !contains( code, "int b"));
+    MI_CHECK( contains( code, "return p;"));
+}
+
+MI_TEST_AUTO_FUNCTION( test_modified_variable_is_kept)
+{
+    // int a = 3; a = a + 1; return a;  -- a is written, so it must not be propagated
+    Function_builder f;
+    Def_variable *a = f.add_var("a", f.p()->get_type(), f.lit(3));
+    f.body()->add_stmt(f.increment(a));
+    f.body()->add_stmt(f.ret(f.ref(a)));
+
+    std::string code = f.finish();
+    MI_CHECK( contains( code, "int a = 3;"));
+    MI_CHECK( contains( code, "return a;"));
+}
+
+MI_TEST_AUTO_FUNCTION( test_do_while_false_is_unwrapped)
+{
+    // bool done = false; do { p = p + 1; } while (done); return p;
+    //   ==>  p = p + 1; return p;
+    Function_builder f;
+    Def_variable *done = f.add_var("done", f.c()->get_type(), f.lit(false));
+    f.body()->add_stmt(f.do_while(f.block(f.increment(f.p())), f.ref(done)));
+    f.body()->add_stmt(f.ret(f.ref(f.p())));
+
+    std::string code = f.finish();
+    MI_CHECK( !contains( code, "do"));
+    MI_CHECK( !contains( code, "while"));
+    MI_CHECK( contains( code, "p = p + 1;"));
+}
+
+MI_TEST_AUTO_FUNCTION( test_do_while_false_with_break_is_kept)
+{
+    // bool done = false; do { if (c) break; p = p + 1; } while (done); return p;
+    // the break must still leave the loop, so the loop is kept
+    Function_builder f;
+    Def_variable *done = f.add_var("done", f.c()->get_type(), f.lit(false));
+    f.body()->add_stmt(
+        f.do_while(f.block(f.if_c(f.brk()), f.increment(f.p())), f.ref(done)));
+    f.body()->add_stmt(f.ret(f.ref(f.p())));
+
+    std::string code = f.finish();
+    MI_CHECK( contains( code, "do"));
+    MI_CHECK( contains( code, "break;"));
+    MI_CHECK( contains( code, "while (false)"));
+}
+
+MI_TEST_AUTO_FUNCTION( test_do_while_false_with_continue_is_kept)
+{
+    // do { if (c) continue; p = p + 1; } while (false); return p;
+    Function_builder f;
+    f.body()->add_stmt(
+        f.do_while(f.block(f.if_c(f.cont()), f.increment(f.p())), f.lit(false)));
+    f.body()->add_stmt(f.ret(f.ref(f.p())));
+
+    std::string code = f.finish();
+    MI_CHECK( contains( code, "do"));
+    MI_CHECK( contains( code, "continue;"));
+}
+
+MI_TEST_AUTO_FUNCTION( test_do_while_false_with_nested_jumps_is_unwrapped)
+{
+    // do { switch (p) { case 0: break; } do { if (c) break; } while (c); } while (false);
+    // both breaks are bound to the inner statements, so the outer loop is unwrapped
+    Function_builder f;
+    Stmt *inner_loop = f.do_while(f.block(f.if_c(f.brk())), f.ref(f.c()));
+    f.body()->add_stmt(
+        f.do_while(f.block(f.switch_p(f.brk()), inner_loop), f.lit(false)));
+    f.body()->add_stmt(f.ret(f.ref(f.p())));
+
+    std::string code = f.finish();
+    MI_CHECK( contains( code, "switch"));
+    MI_CHECK( contains( code, "while (c)"));
+    MI_CHECK( !contains( code, "while (false)"));
+}
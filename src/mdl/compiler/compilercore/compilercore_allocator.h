@@ -112,6 +112,19 @@ public:
     virtual void dec_ref_count(void const *obj) = 0;
 };
 
+///
+/// An optional interface of allocators that prefer memory arenas to allocate
+/// their memory in chunks of a specific size.
+///
+class IArena_chunk_size_hint : public
+    mi::base::Interface_declare<0x235162b8,0xa354,0x4a35,0x8a,0x1a,0x04,0xd0,0x82,0xe4,0x4a,0x39,
+        mi::base::IInterface>
+{
+public:
+    /// Get the chunk size for memory arenas allocating from this allocator.
+    virtual size_t get_arena_chunk_size() const = 0;
+};
+
 typedef mi::base::IAllocator IAllocator;
 
 ///
@@ -37,7 +37,9 @@
 #include <algorithm>
 #include <list>
 #include <utility>
+#include <vector>
 #include <base/system/main/types.h>
+#include <base/system/stlext/i_stlext_thread_budget.h>
 
 #include "compilercore_allocator.h"
 #include "compilercore_malloc_allocator.h"
@@ -3469,6 +3471,139 @@ Module const *NT_analysis::load_module_to_import(
     return imp_mod;
 }
 
+// Load all modules imported by the current module that are not yet available
+// concurrently on worker threads.
+void NT_analysis::prefetch_imports()
+{
+    typedef vector<IQualified_name const *>::Type Name_vec;
+    typedef vector<string>::Type                  String_vec;
+
+    // Namespace aliases are not entered yet, so names using them cannot be resolved
+    // here; collect them first, so they are left to the sequential processing.
+    ptr_hash_set<ISymbol const>::Type alias_syms(
+        0, ptr_hash_set<ISymbol const>::Type::hasher(),
+        ptr_hash_set<ISymbol const>::Type::key_equal(), get_allocator());
+    Name_vec  import_names(get_allocator());
+    vector<bool>::Type ignore_last(get_allocator());
+
+    for (int i = 0, n = m_module.get_declaration_count(); i < n; ++i) {
+        IDeclaration const *decl = m_module.get_declaration(i);
+
+        if (IDeclaration_namespace_alias const *alias_decl =
+                as<IDeclaration_namespace_alias>(decl))
+        {
+            alias_syms.insert(alias_decl->get_alias()->get_symbol());
+            continue;
+        }
+
+        IDeclaration_import const *import_decl = as<IDeclaration_import>(decl);
+        if (import_decl == NULL)
+            continue;
+
+        if (IQualified_name const *mod_name = import_decl->get_module_name()) {
+            // using <mod_name> import ..
+            if (!is_error(mod_name)) {
+                import_names.push_back(mod_name);
+                ignore_last.push_back(false);
+            }
+        } else {
+            // import ...
+            for (int j = 0, m = import_decl->get_name_count(); j < m; ++j) {
+                IQualified_name const *name = import_decl->get_name(j);
+                if (!is_error(name) && name->get_component_count() > 1) {
+                    import_names.push_back(name);
+                    ignore_last.push_back(true);
+                }
+            }
+        }
+    }
+
+    // errors are reported by the sequential processing, so drop all messages here
+    Messages_impl messages(get_allocator(), m_module.get_filename());
+    File_resolver resolver(
+        *m_compiler,
+        m_module_cache,
+        m_compiler->get_external_resolver(),
+        m_compiler->get_search_path(),
+        m_compiler->get_search_path_lock(),
+        messages,
+        m_ctx.get_front_path());
+
+    String_vec abs_names(get_allocator());
+    for (size_t i = 0, n = import_names.size(); i < n; ++i) {
+        IQualified_name const *rel_name = import_names[i];
+        bool                  is_absolute = rel_name->is_absolute();
+
+        string import_name(is_absolute ? "::" : "", get_allocator());
+
+        bool uses_alias = false;
+        size_t k = rel_name->get_component_count() - (ignore_last[i] ? 1 : 0);
+        for (size_t c = 0; c < k; ++c) {
+            ISymbol const *sym = rel_name->get_component(c)->get_symbol();
+            if (alias_syms.find(sym) != alias_syms.end()) {
+                uses_alias = true;
+                break;
+            }
+            if (c > 0)
+                import_name += "::";
+            import_name += sym->get_name();
+        }
+        if (uses_alias)
+            continue;
+
+        if (m_module.get_mdl_version() >= IMDL::MDL_VERSION_1_6) {
+            // from MDL 1.6 weak imports are relative
+            if (!is_absolute && import_name[0] != '.')
+                import_name = ".::" + import_name;
+        }
+
+        mi::base::Handle<IMDL_import_result> result(m_compiler->resolve_import(
+            resolver,
+            import_name.c_str(),
+            &m_module,
+            /*pos=*/NULL));
+        if (!result.is_valid_interface())
+            continue;
+
+        string abs_name(result->get_absolute_name(), get_allocator());
+        if (m_compiler->find_builtin_module(abs_name) != NULL)
+            continue;
+        if (abs_name == m_module.get_name())
+            continue;
+
+        // already loaded?
+        mi::base::Handle<IModule const> cached(m_module_cache->lookup(abs_name.c_str(), NULL));
+        if (cached.is_valid_interface())
+            continue;
+
+        if (std::find(abs_names.begin(), abs_names.end(), abs_name) == abs_names.end())
+            abs_names.push_back(abs_name);
+    }
+
+    // nothing to gain for less than two modules
+    if (abs_names.size() < 2)
+        return;
+
+    Imported_module_cache   cache(m_module, m_module_cache);
+    char const              *front_path = m_ctx.get_front_path();
+    bool                    experimental = m_enable_experimental_features;
+    MDL                     *compiler = m_compiler;
+
+    // Every worker loads whole modules. Modules that are imported by several of them
+    // are loaded only once, the module cache lets the other workers wait for the result.
+    // The imports of these modules are loaded in parallel again, hence the workers are
+    // borrowed from the process-wide thread budget.
+    MI::STLEXT::parallel_for(abs_names.size(), [&](size_t idx) {
+        mi::base::Handle<Thread_context> ctx(compiler->create_thread_context());
+        ctx->set_front_path(front_path);
+        ctx->access_options().set_option(
+            MDL::option_experimental_features, experimental ? "true" : "false");
+
+        mi::base::Handle<Module const> imp_mod(
+            compiler->compile_module(*ctx.get(), abs_names[idx].c_str(), &cache));
+    });
+}
+
 // Check if the given imported definition is a re-export, if true, add its module
 // to the current import table and return the import index of the owner module.
 size_t NT_analysis::handle_reexported_entity(
@@ -15328,6 +15463,13 @@ void NT_analysis::run()
             string("::<builtins>", get_allocator())));
 
         visit_material_default(*this);
+
+        if (m_module_cache != NULL &&
+            m_compiler->get_compiler_bool_option(
+                &m_ctx, MDL::option_parallel_imports, /*def_value=*/false))
+        {
+            prefetch_imports();
+        }
     }
 
     visit(&m_module);
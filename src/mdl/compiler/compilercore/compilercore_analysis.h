@@ -835,6 +835,15 @@ private:
         IQualified_name const *rel_name,
         bool                  ignore_last);
 
+    /// Load all modules imported by the current module that are not yet available
+    /// concurrently on worker threads.
+    ///
+    /// The loaded modules are registered at the module cache, hence the following
+    /// sequential import processing finds them there. Imports that cannot be resolved
+    /// silently are skipped and handled (including error reporting) by the sequential
+    /// processing.
+    void prefetch_imports();
+
     /// Check if the given imported definition is a re-export, if true, add its module
     /// to the current import table and return the import index of the owner module.
     ///
@@ -28,6 +28,17 @@
 
 #include "pch.h"
 
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <base/lib/zlib/zlib.h>
+#include <base/system/stlext/i_stlext_thread_budget.h>
+
 #include "compilercore_file_utils.h"
 #include "compilercore_mdl.h"
 #include "compilercore_errors.h"
@@ -157,6 +168,416 @@ protected:
 
 typedef hash_set<string, string_hash<string> >::Type String_set;
 
+/// Deflates archive members ahead of time on worker threads.
+///
+/// libzip compresses the members of an archive one after another inside zip_close(). Members
+/// registered here are instead read and deflated concurrently into memory buffers, which are
+/// handed to libzip as already compressed sources and copied verbatim. libzip consumes the
+/// members in the order they were added, so the workers run only a bounded window ahead of the
+/// writer, and every buffer is released as soon as libzip has written it.
+class Parallel_deflater {
+public:
+    /// Constructor.
+    ///
+    /// \param max_pending_bytes  the maximum number of compressed bytes held in memory,
+    ///                           the member libzip waits for is always processed
+    explicit Parallel_deflater(size_t max_pending_bytes);
+
+    /// Destructor. Stops and joins the worker threads.
+    ~Parallel_deflater();
+
+    /// Register a file to be deflated.
+    ///
+    /// \param fname  the name of the file
+    /// \param ze     if this function fails, ze contains the libzip error
+    ///
+    /// \return a libzip source delivering the deflated file or NULL on error
+    zip_source_t *add(string const &fname, zip_error_t &ze);
+
+    /// Start deflating. Must be called after all members were added.
+    void start();
+
+private:
+    /// An archive member.
+    struct Member {
+        Parallel_deflater          *owner;
+        std::string                fname;
+        std::vector<unsigned char> data;
+        size_t                     read_pos;
+        zip_uint64_t               size;
+        zip_uint64_t               comp_size;
+        zip_uint32_t               crc;
+        time_t                     mtime;
+        bool                       has_mtime;
+        bool                       done;
+        bool                       failed;
+        bool                       released;
+        zip_error_t                ze;
+    };
+
+    /// The source callback function invoked by libzip.
+    static zip_int64_t callback(
+        void             *env,
+        void             *data,
+        zip_uint64_t     len,
+        zip_source_cmd_t cmd);
+
+    /// The worker thread function.
+    void worker();
+
+    /// Check if a worker may start the next member. Requires the lock.
+    bool may_start() const;
+
+    /// Read and deflate the given member. Runs without the lock.
+    static bool deflate_member(Member &m);
+
+    /// Wait until the given member is deflated.
+    void wait_for(Member &m);
+
+    /// Release the compressed data of the given member.
+    void release(Member &m);
+
+private:
+    /// The members, a deque keeps the addresses stable.
+    std::deque<Member> m_members;
+
+    /// The worker threads.
+    std::vector<std::thread> m_threads;
+
+    /// The number of worker threads borrowed from the thread budget.
+    size_t m_borrowed_threads;
+
+    /// Protects the following members and the state of every member.
+    std::mutex m_mutex;
+
+    /// Signaled whenever a member is deflated or released.
+    std::condition_variable m_cond;
+
+    /// The index of the next member to deflate.
+    size_t m_next;
+
+    /// The index of the first member not yet written by libzip.
+    size_t m_first_unreleased;
+
+    /// The number of compressed bytes currently held.
+    size_t m_pending_bytes;
+
+    /// The maximum number of compressed bytes held.
+    size_t const m_max_pending_bytes;
+
+    /// The maximum number of members deflated ahead of the writer.
+    size_t m_window;
+
+    /// Set if the workers must stop.
+    bool m_abort;
+};
+
+// Constructor.
+Parallel_deflater::Parallel_deflater(size_t max_pending_bytes)
+: m_members()
+, m_threads()
+, m_borrowed_threads(0)
+, m_mutex()
+, m_cond()
+, m_next(0)
+, m_first_unreleased(0)
+, m_pending_bytes(0)
+, m_max_pending_bytes(max_pending_bytes)
+, m_window(0)
+, m_abort(false)
+{
+}
+
+// Destructor.
+Parallel_deflater::~Parallel_deflater()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_abort = true;
+    }
+    m_cond.notify_all();
+    for (size_t i = 0, n = m_threads.size(); i < n; ++i)
+        m_threads[i].join();
+    MI::STLEXT::Thread_budget::release(m_borrowed_threads);
+    for (size_t i = 0, n = m_members.size(); i < n; ++i)
+        zip_error_fini(&m_members[i].ze);
+}
+
+// Register a file to be deflated.
+zip_source_t *Parallel_deflater::add(string const &fname, zip_error_t &ze)
+{
+    MDL_ASSERT(m_threads.empty() && "members must be added before start()");
+
+    m_members.push_back(Member());
+    Member &m = m_members.back();
+
+    m.owner     = this;
+    m.fname     = fname.c_str();
+    m.read_pos  = 0;
+    m.size      = 0;
+    m.comp_size = 0;
+    m.crc       = 0;
+    m.mtime     = 0;
+    m.has_mtime = false;
+    m.done      = false;
+    m.failed    = false;
+    m.released  = false;
+    zip_error_init(&m.ze);
+
+    zip_source_t *src = zip_source_function_create(callback, &m, &ze);
+    if (src == NULL) {
+        zip_error_fini(&m.ze);
+        m_members.pop_back();
+    }
+    return src;
+}
+
+// Start deflating.
+void Parallel_deflater::start()
+{
+    if (m_members.empty())
+        return;
+
+    // The writer only waits inside zip_close(), so the first worker takes its place. Further
+    // workers are borrowed from the process-wide thread budget.
+    m_borrowed_threads = MI::STLEXT::Thread_budget::acquire(m_members.size() - 1);
+    size_t n_threads = 1 + m_borrowed_threads;
+
+    m_window = 2 * n_threads;
+
+    for (size_t i = 0; i < n_threads; ++i)
+        m_threads.push_back(std::thread(&Parallel_deflater::worker, this));
+}
+
+// Check if a worker may start the next member.
+bool Parallel_deflater::may_start() const
+{
+    if (m_next == m_first_unreleased) {
+        // libzip is (or will be) waiting for this one
+        return true;
+    }
+    return m_next < m_first_unreleased + m_window && m_pending_bytes < m_max_pending_bytes;
+}
+
+// The worker thread function.
+void Parallel_deflater::worker()
+{
+    for (;;) {
+        Member *m = NULL;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            while (!m_abort && m_next < m_members.size() && !may_start())
+                m_cond.wait(lock);
+            if (m_abort || m_next >= m_members.size())
+                return;
+            m = &m_members[m_next++];
+        }
+
+        bool ok = deflate_member(*m);
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m->done   = true;
+            m->failed = !ok;
+            m_pending_bytes += m->data.size();
+        }
+        m_cond.notify_all();
+    }
+}
+
+// Read and deflate the given member.
+bool Parallel_deflater::deflate_member(Member &m)
+{
+    zip_source_t *src = zip_source_file_create(m.fname.c_str(), 0, -1, &m.ze);
+    if (src == NULL)
+        return false;
+
+    zip_stat_t st;
+    if (zip_source_stat(src, &st) == 0 && (st.valid & ZIP_STAT_MTIME) != 0) {
+        m.mtime     = st.mtime;
+        m.has_mtime = true;
+    }
+
+    if (zip_source_open(src) < 0) {
+        zip_error_t const *err = zip_source_error(src);
+        zip_error_set(&m.ze, zip_error_code_zip(err), zip_error_code_system(err));
+        zip_source_free(src);
+        return false;
+    }
+
+    // use the same parameters as libzip's own deflate implementation, a negative window size
+    // suppresses the zlib header
+    z_stream zs;
+    memset(&zs, 0, sizeof(zs));
+    if (deflateInit2(
+        &zs, Z_BEST_COMPRESSION, Z_DEFLATED, -MAX_WBITS, MAX_MEM_LEVEL, Z_DEFAULT_STRATEGY) != Z_OK)
+    {
+        zip_error_set(&m.ze, ZIP_ER_ZLIB, 0);
+        zip_source_close(src);
+        zip_source_free(src);
+        return false;
+    }
+
+    size_t const chunk_size = 64 * 1024;
+
+    std::vector<unsigned char> in(chunk_size);
+    size_t out_pos = 0;
+    uLong  crc     = crc32(0L, Z_NULL, 0);
+    bool   ok      = true;
+    int    flush   = Z_NO_FLUSH;
+
+    do {
+        zip_int64_t n = zip_source_read(src, in.data(), in.size());
+        if (n < 0) {
+            zip_error_t const *err = zip_source_error(src);
+            zip_error_set(&m.ze, zip_error_code_zip(err), zip_error_code_system(err));
+            ok = false;
+            break;
+        }
+        crc = crc32(crc, in.data(), uInt(n));
+        m.size += zip_uint64_t(n);
+
+        flush       = n == 0 ? Z_FINISH : Z_NO_FLUSH;
+        zs.next_in  = in.data();
+        zs.avail_in = uInt(n);
+
+        do {
+            if (m.data.size() - out_pos < chunk_size)
+                m.data.resize(m.data.size() < chunk_size ? 2 * chunk_size : 2 * m.data.size());
+
+            size_t avail = m.data.size() - out_pos;
+            if (avail > (1u << 30))
+                avail = 1u << 30;
+
+            zs.next_out  = &m.data[out_pos];
+            zs.avail_out = uInt(avail);
+
+            if (deflate(&zs, flush) == Z_STREAM_ERROR) {
+                zip_error_set(&m.ze, ZIP_ER_ZLIB, Z_STREAM_ERROR);
+                ok = false;
+                break;
+            }
+            out_pos += avail - zs.avail_out;
+        } while (zs.avail_out == 0);
+    } while (ok && flush != Z_FINISH);
+
+    deflateEnd(&zs);
+    zip_source_close(src);
+    zip_source_free(src);
+
+    m.crc       = zip_uint32_t(crc);
+    m.comp_size = ok ? out_pos : 0;
+    m.data.resize(size_t(m.comp_size));
+    m.data.shrink_to_fit();
+    return ok;
+}
+
+// Wait until the given member is deflated.
+void Parallel_deflater::wait_for(Member &m)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (!m.done)
+        m_cond.wait(lock);
+}
+
+// Release the compressed data of the given member.
+void Parallel_deflater::release(Member &m)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m.released || !m.done)
+            return;
+
+        m.released = true;
+        m_pending_bytes -= m.data.size();
+        std::vector<unsigned char>().swap(m.data);
+
+        while (m_first_unreleased < m_members.size() && m_members[m_first_unreleased].released)
+            ++m_first_unreleased;
+    }
+    m_cond.notify_all();
+}
+
+// The source callback function invoked by libzip.
+zip_int64_t Parallel_deflater::callback(
+    void             *env,
+    void             *data,
+    zip_uint64_t     len,
+    zip_source_cmd_t cmd)
+{
+    Member            &m    = *reinterpret_cast<Member *>(env);
+    Parallel_deflater *self = m.owner;
+
+    switch (cmd) {
+    case ZIP_SOURCE_SUPPORTS:
+        return zip_source_make_command_bitmap(
+            ZIP_SOURCE_OPEN, ZIP_SOURCE_READ, ZIP_SOURCE_CLOSE, ZIP_SOURCE_STAT,
+            ZIP_SOURCE_ERROR, ZIP_SOURCE_FREE, ZIP_SOURCE_SUPPORTS,
+            ZIP_SOURCE_GET_COMPRESSION_FLAGS, -1);
+
+    case ZIP_SOURCE_GET_COMPRESSION_FLAGS:
+        // "maximum compression", as libzip would set it for Z_BEST_COMPRESSION
+        return 1;
+
+    case ZIP_SOURCE_STAT:
+        {
+            self->wait_for(m);
+            if (m.failed)
+                return -1;
+
+            // the size is known even after the data was released
+            zip_stat_t *st = (zip_stat_t *) data;
+            zip_stat_init(st);
+            st->valid       = ZIP_STAT_SIZE | ZIP_STAT_COMP_SIZE | ZIP_STAT_COMP_METHOD |
+                              ZIP_STAT_CRC;
+            st->size        = m.size;
+            st->comp_size   = m.comp_size;
+            st->comp_method = ZIP_CM_DEFLATE;
+            st->crc         = m.crc;
+            if (m.has_mtime) {
+                st->valid |= ZIP_STAT_MTIME;
+                st->mtime  = m.mtime;
+            }
+            return sizeof(zip_stat_t);
+        }
+
+    case ZIP_SOURCE_OPEN:
+        self->wait_for(m);
+        if (m.failed || m.released) {
+            if (!m.failed)
+                zip_error_set(&m.ze, ZIP_ER_INTERNAL, 0);
+            return -1;
+        }
+        m.read_pos = 0;
+        return 0;
+
+    case ZIP_SOURCE_READ:
+        {
+            size_t n = m.data.size() - m.read_pos;
+            if (n > len)
+                n = size_t(len);
+            memcpy(data, m.data.data() + m.read_pos, n);
+            m.read_pos += n;
+            return zip_int64_t(n);
+        }
+
+    case ZIP_SOURCE_CLOSE:
+        // libzip has written the member, its data is not needed anymore
+        self->release(m);
+        return 0;
+
+    case ZIP_SOURCE_ERROR:
+        return zip_error_to_data(&m.ze, data, len);
+
+    case ZIP_SOURCE_FREE:
+        return 0;
+
+    default:
+        zip_error_set(&m.ze, ZIP_ER_OPNOTSUPP, 0);
+        return -1;
+    }
+}
+
 /// Helper class for the archive builder.
 class Archive_builder : public Archive_helper {
     typedef Archive_helper Base;
@@ -1280,6 +1701,10 @@ bool Archive_builder::create_zip_archive()
         return false;
     }
 
+    // modules and compressible resources are deflated in parallel while zip_close() writes
+    // the archive, holding at most 256 MiB of compressed data at a time
+    Parallel_deflater deflater(size_t(256) * 1024 * 1024);
+
     // ensure the life time of the output buffer lasts until zip_close() where the data is written
     Allocator_builder builder(m_alloc);
     mi::base::Handle<Buffer_output_stream> os(builder.create<Buffer_output_stream>(m_alloc));
@@ -1338,7 +1763,7 @@ bool Archive_builder::create_zip_archive()
             string fname = join_path(m_root_path, entry);
 
             zip_error_t err;
-            zip_source_t *source = zip_source_file_create(fname.c_str(), 0, -1, &err);
+            zip_source_t *source = deflater.add(fname, err);
             if (source == NULL) {
                 translate_zip_error(err);
                 break;
@@ -1368,19 +1793,21 @@ bool Archive_builder::create_zip_archive()
 
             string fname = join_path(m_root_path, entry);
 
+            // do not compress resources by default
+            zip_int32_t comp_method = ZIP_CM_STORE;
+
+            if (should_be_compressed(fname))
+                comp_method = ZIP_CM_DEFLATE;
+
             zip_error_t err;
-            zip_source_t *source = zip_source_file_create(fname.c_str(), 0, -1, &err);
+            zip_source_t *source = comp_method == ZIP_CM_STORE ?
+                zip_source_file_create(fname.c_str(), 0, -1, &err) :
+                deflater.add(fname, err);
             if (source == NULL) {
                 translate_zip_error(err.zip_err);
                 break;
             }
 
-            // do not compress resources by default
-            zip_int32_t comp_method = ZIP_CM_STORE;
-
-            if (should_be_compressed(fname))
-                comp_method = ZIP_CM_DEFAULT;
-
             fire_event(
                 comp_method == ZIP_CM_STORE ?
                     IArchive_tool_event::EV_STORING :
@@ -1401,6 +1828,8 @@ bool Archive_builder::create_zip_archive()
     }
 
     if (za != NULL) {
+        // zip_close() waits for every added member, so start even after an error
+        deflater.start();
         if (zip_close(za) != 0)
             translate_zip_error(za);
     }
@@ -95,10 +95,36 @@ public:
     void push_front(T *id) {
         id->m_prev = NULL;
         id->m_next = m_first;
+        if (m_first != NULL) { m_first->m_prev = id; }
         m_first    = id;
         if (m_last == NULL) { m_last = id; }
     }
 
+    /// Remove an element from the list.
+    ///
+    /// \param id  the element to be removed, must be an element of this list
+    void remove(T *id) {
+        if (id->m_prev != NULL) { id->m_prev->m_next = id->m_next; }
+        else                    { m_first = id->m_next; }
+        if (id->m_next != NULL) { id->m_next->m_prev = id->m_prev; }
+        else                    { m_last = id->m_prev; }
+        id->m_next = id->m_prev = NULL;
+    }
+
+    /// Replace an element of the list by another one.
+    ///
+    /// \param old_id  the element to be replaced, must be an element of this list
+    /// \param new_id  the new element, must not be an element of any list
+    void replace(T *old_id, T *new_id) {
+        new_id->m_prev = old_id->m_prev;
+        new_id->m_next = old_id->m_next;
+        if (new_id->m_prev != NULL) { new_id->m_prev->m_next = new_id; }
+        else                        { m_first = new_id; }
+        if (new_id->m_next != NULL) { new_id->m_next->m_prev = new_id; }
+        else                        { m_last = new_id; }
+        old_id->m_next = old_id->m_prev = NULL;
+    }
+
     /// Get the first layout qualifier id.
     iterator begin() { return iterator(m_first); }
 
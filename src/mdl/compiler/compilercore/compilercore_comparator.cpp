@@ -40,6 +40,19 @@
 #include "compilercore_archiver.h"
 #include "compilercore_file_utils.h"
 #include "compilercore_mangle.h"
+#include "compilercore_hash.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <base/system/stlext/i_stlext_thread_budget.h>
 
 namespace mi {
 namespace mdl {
@@ -173,6 +186,45 @@ private:
     char const * const m_cache_name;
 };
 
+/// Serializes events fired by comparators running on different threads.
+class Locked_comparator_event : public IMDL_comparator_event
+{
+public:
+    /// Constructor.
+    ///
+    /// \param cb  the event callback to forward to
+    explicit Locked_comparator_event(IMDL_comparator_event *cb)
+    : m_cb(cb)
+    , m_lock()
+    {
+    }
+
+    /// Called when an event is fired.
+    void fire_event(
+        Event      ev,
+        char const *name) MDL_FINAL
+    {
+        std::lock_guard<std::mutex> guard(m_lock);
+        m_cb->fire_event(ev, name);
+    }
+
+    /// Called to report a percentage.
+    void percentage(
+        size_t curr,
+        size_t count) MDL_FINAL
+    {
+        std::lock_guard<std::mutex> guard(m_lock);
+        m_cb->percentage(curr, count);
+    }
+
+private:
+    /// The forwarded callback.
+    IMDL_comparator_event *m_cb;
+
+    /// Protects the callback.
+    std::mutex m_lock;
+};
+
 /// Base class for all comparators.
 class Comparator_base
 {
@@ -522,6 +574,17 @@ private:
         string const &archive_fnameA,
         string const &archive_fnameB);
 
+    /// Find the modules that are unchanged in both archives.
+    ///
+    /// A module is unchanged if its source is byte-identical and all modules it imports from the
+    /// archive are unchanged as well.
+    ///
+    /// \param module_names  the absolute names of the modules of archive A
+    /// \param identical     will be set to non-zero for every unchanged module
+    void find_identical_modules(
+        vector<string>::Type const  &module_names,
+        vector<unsigned char>::Type &identical);
+
 public:
     /// Constructor.
     ///
@@ -2241,6 +2304,227 @@ string Archive_comparator::replace_archive_prefix(
     return res;
 }
 
+namespace {
+
+/// Compute the MD5 hash of a file inside an archive.
+///
+/// \param tool     the archive tool to use
+/// \param archive  the archive file name
+/// \param member   the file name inside the archive
+/// \param hash     the computed hash
+///
+/// \return false if the file could not be read
+static bool hash_archive_member(
+    Archive_tool  *tool,
+    char const    *archive,
+    char const    *member,
+    unsigned char hash[16])
+{
+    mi::base::Handle<IInput_stream> is(tool->get_file_content(archive, member));
+    if (!is.is_valid_interface())
+        return false;
+
+    MD5_hasher    hasher;
+    unsigned char buffer[4096];
+    size_t        count = 0;
+    for (int c = is->read_char(); c != -1; c = is->read_char()) {
+        buffer[count++] = (unsigned char)c;
+        if (count == sizeof(buffer)) {
+            hasher.update(buffer, count);
+            count = 0;
+        }
+    }
+    hasher.update(buffer, count);
+    hasher.final(hash);
+    return true;
+}
+
+/// Add the absolute names of all modules a qualified import name might refer to.
+///
+/// The names are over-approximated: every prefix of the resolved path counts, and a path that
+/// is neither absolute nor explicitly relative is resolved both ways.
+///
+/// \param alloc    the allocator
+/// \param qname    the qualified name of an import declaration
+/// \param package  the package components of the importing module
+/// \param names    the candidate names are appended here
+static void add_import_candidates(
+    IAllocator                  *alloc,
+    IQualified_name const       *qname,
+    vector<string>::Type const  &package,
+    vector<string>::Type        &names)
+{
+    vector<string>::Type comps(alloc);
+    for (int i = 0, n = qname->get_component_count(); i < n; ++i) {
+        string comp(qname->get_component(i)->get_symbol()->get_name(), alloc);
+        if (comp != "*")
+            comps.push_back(comp);
+    }
+
+    vector<vector<string>::Type>::Type paths(alloc);
+    if (qname->is_absolute()) {
+        paths.push_back(comps);
+    } else if (!comps.empty() && (comps[0] == "." || comps[0] == "..")) {
+        vector<string>::Type path(package);
+        size_t i = 0;
+        for (size_t n = comps.size(); i < n && (comps[i] == "." || comps[i] == ".."); ++i) {
+            if (comps[i] == ".." && !path.empty())
+                path.pop_back();
+        }
+        path.insert(path.end(), comps.begin() + i, comps.end());
+        paths.push_back(path);
+    } else {
+        vector<string>::Type path(package);
+        path.insert(path.end(), comps.begin(), comps.end());
+        paths.push_back(comps);
+        paths.push_back(path);
+    }
+
+    for (size_t i = 0, n = paths.size(); i < n; ++i) {
+        string name(alloc);
+        for (size_t j = 0, m = paths[i].size(); j < m; ++j) {
+            name += "::";
+            name += paths[i][j];
+            names.push_back(name);
+        }
+    }
+}
+
+/// Collect the absolute names of all modules an unanalyzed module might import.
+///
+/// \param alloc  the allocator
+/// \param mod    the parsed module
+/// \param names  the candidate names are appended here
+static void collect_import_candidates(
+    IAllocator           *alloc,
+    Module const         *mod,
+    vector<string>::Type &names)
+{
+    // "::a::b::m" lives in package "a::b"
+    vector<string>::Type package(alloc);
+    string mod_name(mod->get_name(), alloc);
+    for (size_t pos = 2, l = mod_name.size(); pos < l;) {
+        size_t end = mod_name.find("::", pos);
+        if (end == string::npos)
+            break;
+        package.push_back(mod_name.substr(pos, end - pos));
+        pos = end + 2;
+    }
+
+    for (int i = 0, n = mod->get_declaration_count(); i < n; ++i) {
+        IDeclaration_import const *import_decl = as<IDeclaration_import>(mod->get_declaration(i));
+        if (import_decl == NULL)
+            continue;
+
+        if (IQualified_name const *using_name = import_decl->get_module_name()) {
+            // using a::b import c;
+            add_import_candidates(alloc, using_name, package, names);
+        } else {
+            for (int j = 0, m = import_decl->get_name_count(); j < m; ++j)
+                add_import_candidates(alloc, import_decl->get_name(j), package, names);
+        }
+    }
+}
+
+/// The comparison of one module pair of an archive.
+struct Module_comparison {
+    /// Constructor.
+    Module_comparison()
+    : modA()
+    , modB()
+    , ctx()
+    , time(0.0)
+    {
+    }
+
+    mi::base::Handle<Module const>   modA;  ///< the original module
+    mi::base::Handle<Module const>   modB;  ///< the replacement module
+    mi::base::Handle<Thread_context> ctx;   ///< receives the comparison messages
+    double                           time;  ///< the comparison time in seconds
+};
+
+}  // anonymous
+
+// Find the modules that are unchanged in both archives.
+void Archive_comparator::find_identical_modules(
+    vector<string>::Type const  &module_names,
+    vector<unsigned char>::Type &identical)
+{
+    size_t n = module_names.size();
+    identical.assign(n, 0);
+
+    // the archive modules every module with identical source might import
+    vector<vector<size_t>::Type>::Type imports(
+        n, vector<size_t>::Type(get_allocator()), get_allocator());
+
+    MI::STLEXT::parallel_for(n, [this, &module_names, &identical, &imports](size_t i) {
+        // the archive tool is not thread-safe, every call uses its own
+        Allocator_builder builder(get_allocator());
+        mi::base::Handle<Archive_tool> tool(
+            builder.create<Archive_tool>(get_allocator(), m_compiler.get()));
+
+        // "::a::b" is stored as "a/b.mdl"
+        string const &name = module_names[i];
+        string member(get_allocator());
+        for (size_t k = 2, l = name.size(); k < l; ++k) {
+            if (name[k] == ':' && k + 1 < l && name[k + 1] == ':') {
+                member += '/';
+                ++k;
+            } else {
+                member += name[k];
+            }
+        }
+        member += ".mdl";
+
+        unsigned char hashA[16], hashB[16];
+        if (!hash_archive_member(tool.get(), m_fnameA.c_str(), member.c_str(), hashA) ||
+            !hash_archive_member(tool.get(), m_fnameB.c_str(), member.c_str(), hashB) ||
+            memcmp(hashA, hashB, sizeof(hashA)) != 0)
+        {
+            return;
+        }
+
+        // identical source is not enough, the imported modules must be unchanged, too
+        mi::base::Handle<IInput_stream> is(
+            tool->get_file_content(m_fnameA.c_str(), member.c_str()));
+        if (!is.is_valid_interface())
+            return;
+
+        // only the imports are of interest, so accept all features
+        mi::base::Handle<Module const> mod(
+            m_compiler->parse_module(name.c_str(), is.get(), /*experimental=*/true));
+        if (mod->access_messages().get_error_message_count() > 0)
+            return;
+
+        vector<string>::Type candidates(get_allocator());
+        collect_import_candidates(get_allocator(), mod.get(), candidates);
+        for (size_t k = 0, l = candidates.size(); k < l; ++k) {
+            vector<string>::Type::const_iterator it(
+                std::find(module_names.begin(), module_names.end(), candidates[k]));
+            if (it != module_names.end() && it != module_names.begin() + i)
+                imports[i].push_back(size_t(it - module_names.begin()));
+        }
+        identical[i] = 1;
+    });
+
+    // a module is only unchanged if all modules it imports from the archive are, modules outside
+    // the archive are resolved identically for both archives
+    for (bool changed = true; changed;) {
+        changed = false;
+        for (size_t i = 0; i < n; ++i) {
+            if (!identical[i])
+                continue;
+            for (size_t k = 0, l = imports[i].size(); k < l; ++k) {
+                if (!identical[imports[i][k]]) {
+                    identical[i] = 0;
+                    changed = true;
+                    break;
+                }
+            }
+        }
+    }
+}
+
 // Compare the two archives.
 void Archive_comparator::compare_archives()
 {
@@ -2278,19 +2562,87 @@ void Archive_comparator::compare_archives()
 
     mi::base::Handle<IMDL_search_path> sp(m_compiler->get_search_path());
 
-    for (size_t i = 0, n = manifestA->get_module_count(); i < n; ++i) {
+    size_t n = manifestA->get_module_count();
+
+    vector<string>::Type module_names(get_allocator());
+    module_names.reserve(n);
+    for (size_t i = 0; i < n; ++i) {
         // Manifest contains the names WITHOUT leading '::'
         string module_name("::", get_allocator());
         module_name.append(manifestA->get_module_name(i));
 
         MDL_ASSERT(':' != manifestA->get_module_name(i)[0] && "unexpected '::' at manifest");
 
-        if (m_cb != NULL) {
-            m_cb->fire_event(IMDL_comparator_event::EV_COMPARING_MODULE, module_name.c_str());
+        module_names.push_back(module_name);
+    }
+
+    // unchanged modules need neither to be loaded nor compared
+    vector<unsigned char>::Type identical(get_allocator());
+    find_identical_modules(module_names, identical);
+
+    // Loading must stay on this thread, because it temporarily replaces the search path of the
+    // compiler. The loaded pairs are compared by worker threads meanwhile.
+    Locked_comparator_event locked_cb(m_cb);
+    IMDL_comparator_event   *cb = m_cb != NULL ? &locked_cb : NULL;
+
+    std::vector<Module_comparison> comparisons(n);
+
+    std::mutex              queue_lock;
+    std::condition_variable queue_cv;
+    std::deque<size_t>      queue;
+    bool                    loading_done = false;
+
+    auto compare_loaded = [&]() {
+        for (;;) {
+            size_t i;
+            {
+                std::unique_lock<std::mutex> guard(queue_lock);
+                queue_cv.wait(guard, [&]() { return !queue.empty() || loading_done; });
+                if (queue.empty())
+                    break;
+                i = queue.front();
+                queue.pop_front();
+            }
+
+            Module_comparison &cmp = comparisons[i];
+
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+            Comparator comparator(
+                get_allocator(),
+                m_compiler.get(),
+                cmp.modA.get(),
+                cmp.modB.get(),
+                *cmp.ctx.get(),
+                cb);
+
+            comparator.compare_modules();
+
+            cmp.time = std::chrono::duration_cast<std::chrono::duration<double> >(
+                std::chrono::steady_clock::now() - start).count();
+        }
+    };
+
+    // the workers are borrowed from the process-wide thread budget, this thread loads the
+    // modules and compares the remaining ones after loading is done
+    size_t n_threads = MI::STLEXT::Thread_budget::acquire(n);
+
+    std::vector<std::thread> workers;
+    for (size_t t = 0; t < n_threads; ++t)
+        workers.push_back(std::thread(compare_loaded));
+
+    for (size_t i = 0; i < n; ++i) {
+        string const &module_name = module_names[i];
 
-            m_cb->percentage(i, n);
+        if (cb != NULL) {
+            cb->fire_event(IMDL_comparator_event::EV_COMPARING_MODULE, module_name.c_str());
+
+            cb->percentage(i, n);
         }
 
+        if (identical[i])
+            continue;
+
         mi::base::Handle<Module const> moduleA(
             m_compiler->load_module(&m_ctx, module_name.c_str(), &m_cache_A));
         append_ctx_messages();
@@ -2330,17 +2682,48 @@ void Archive_comparator::compare_archives()
         cache_module(m_cache_B, moduleB.get());
 
         // compare the modules
-        Comparator comparator(
-            get_allocator(),
-            m_compiler.get(),
-            moduleA.get(),
-            moduleB.get(),
-            m_ctx,
-            m_cb);
+        Module_comparison &cmp = comparisons[i];
+        cmp.modA = moduleA;
+        cmp.modB = moduleB;
+        cmp.ctx  = mi::base::make_handle(m_compiler->create_thread_context());
 
-        comparator.compare_modules();
+        {
+            std::lock_guard<std::mutex> guard(queue_lock);
+            queue.push_back(i);
+        }
+        queue_cv.notify_one();
+    }
 
-        append_ctx_messages();
+    {
+        std::lock_guard<std::mutex> guard(queue_lock);
+        loading_done = true;
+    }
+    queue_cv.notify_all();
+
+    compare_loaded();
+
+    for (size_t t = 0, m = workers.size(); t < m; ++t)
+        workers[t].join();
+    MI::STLEXT::Thread_budget::release(n_threads);
+
+    // report in manifest order
+    for (size_t i = 0; i < n; ++i) {
+        Module_comparison const &cmp = comparisons[i];
+
+        if (cmp.ctx.is_valid_interface())
+            m_msgs.copy_messages(cmp.ctx->access_messages_impl());
+
+        if (m_cb != NULL && (identical[i] || cmp.ctx.is_valid_interface())) {
+            char buf[64];
+            if (identical[i])
+                snprintf(buf, sizeof(buf), ": identical source");
+            else
+                snprintf(buf, sizeof(buf), ": %.3f ms", cmp.time * 1000.0);
+
+            string report(module_names[i]);
+            report.append(buf);
+            m_cb->fire_event(IMDL_comparator_event::EV_MODULE_COMPARED, report.c_str());
+        }
     }
 
     // finally copy the accumulated messages back to the context
@@ -41,6 +41,10 @@
 
 #include <mi/mdl/mdl_entity_resolver.h>
 
+#include <vector>
+
+#include <base/system/stlext/i_stlext_thread_budget.h>
+
 namespace mi {
 namespace mdl {
 
@@ -104,6 +108,59 @@ bool MDL_zip_container_mdle::get_hash(unsigned char hash[16]) const
 
 //-------------------------------------------------------------------------------------------------
 
+// Constructor.
+Encapsulate_resource_store::Encapsulate_resource_store(IAllocator *alloc)
+: Base(alloc)
+, m_lock()
+, m_hashes(alloc)
+{
+}
+
+// Look up the content hash of a resource.
+bool Encapsulate_resource_store::get_content_hash(
+    char const    *file_name,
+    Uint64        file_size,
+    Uint64        file_time,
+    unsigned char hash[16]) const
+{
+    if (file_name == NULL)
+        return false;
+
+    mi::base::Lock::Block block(&m_lock);
+
+    Hash_map::const_iterator it(m_hashes.find(string(file_name, get_allocator())));
+    if (it == m_hashes.end())
+        return false;
+
+    // the file was changed since it was hashed
+    if (it->second.file_size != file_size || it->second.file_time != file_time)
+        return false;
+
+    memcpy(hash, it->second.data, 16);
+    return true;
+}
+
+// Record the content hash of a resource.
+void Encapsulate_resource_store::set_content_hash(
+    char const          *file_name,
+    Uint64              file_size,
+    Uint64              file_time,
+    unsigned char const hash[16])
+{
+    if (file_name == NULL)
+        return;
+
+    Hash h;
+    h.file_size = file_size;
+    h.file_time = file_time;
+    memcpy(h.data, hash, 16);
+
+    mi::base::Lock::Block block(&m_lock);
+    m_hashes[string(file_name, get_allocator())] = h;
+}
+
+//-------------------------------------------------------------------------------------------------
+
 // Constructor.
 Encapsulate_tool::Encapsulate_tool(
     IAllocator *alloc,
@@ -394,19 +451,8 @@ bool Encapsulate_tool::add_file_uncompressed(
     char const                         *target_name,
     char const                         *mdle_name,
     vector<Resource_zip_source*>::Type &add_sources,
-    unsigned char                      hash[16])
+    unsigned char const                hash[16])
 {
-    // compute MD5 hash
-    // it would be nice to do this on the fly when the zip is reading the file
-    // but this happens later
-    MD5_hasher hasher;
-    unsigned char buffer[1024];
-    while (size_t count = reader->read(buffer, 1024))
-        hasher.update(buffer, count);
-
-    hasher.final(hash);
-    reader->seek(0, mi::mdl::IMDL_resource_reader::MDL_SEEK_SET);
-
     // wrap reader into zip source
     Allocator_builder builder(get_allocator());
     add_sources.push_back(builder.create<Resource_zip_source>(reader));
@@ -435,6 +481,90 @@ bool Encapsulate_tool::add_file_uncompressed(
     return true;
 }
 
+// Computes the MD5 content hashes of the given resources.
+void Encapsulate_tool::compute_content_hashes(
+    vector<mi::base::Handle<IMDL_resource_reader> >::Type const &readers,
+    vector<unsigned char>::Type                               &hashes,
+    IEncapsulate_tool_resource_store                          *store)
+{
+    size_t n = readers.size();
+    hashes.resize(16 * n);
+
+    // for every reader, the index of the reader whose hash it shares, ~0 if already known
+    vector<size_t>::Type shared(n, ~size_t(0), get_allocator());
+
+    // the readers that must be hashed
+    vector<size_t>::Type pending(get_allocator());
+
+    typedef map<string, size_t>::Type Name_map;
+    Name_map first_reader(get_allocator());
+
+    // the size and modification time of the files of the readers, if they are plain files;
+    // the store only knows the content of files in that state
+    vector<Uint64>::Type file_sizes(n, 0, get_allocator());
+    vector<Uint64>::Type file_times(n, 0, get_allocator());
+    vector<bool>::Type   is_file(n, false, get_allocator());
+
+    for (size_t i = 0; i < n; ++i) {
+        IMDL_resource_reader *reader = readers[i].get();
+        unsigned char        *hash   = &hashes[16 * i];
+
+        // resources from MDLEs carry their hash already
+        if (reader->get_resource_hash(hash))
+            continue;
+
+        char const *file_name = reader->get_filename();
+        if (file_name != NULL && file_name[0] != '\0') {
+            if (store != NULL) {
+                is_file[i] = get_file_size_and_time_utf8(
+                    get_allocator(), file_name, file_sizes[i], file_times[i]);
+                if (is_file[i] &&
+                        store->get_content_hash(file_name, file_sizes[i], file_times[i], hash))
+                    continue;
+            }
+
+            // the same file used several times is hashed once
+            string key(file_name, get_allocator());
+            Name_map::const_iterator it(first_reader.find(key));
+            if (it != first_reader.end()) {
+                shared[i] = it->second;
+                continue;
+            }
+            first_reader.insert(Name_map::value_type(key, i));
+        }
+        shared[i] = i;
+        pending.push_back(i);
+    }
+
+    // hash the remaining resources concurrently, every reader is used by one thread only
+    MI::STLEXT::parallel_for(pending.size(), [&readers, &hashes, &pending](size_t k) {
+        size_t               i      = pending[k];
+        IMDL_resource_reader *reader = readers[i].get();
+
+        std::vector<unsigned char> buffer(64 * 1024);
+        MD5_hasher hasher;
+        while (size_t count = reader->read(buffer.data(), buffer.size()))
+            hasher.update(buffer.data(), count);
+        hasher.final(&hashes[16 * i]);
+
+        reader->seek(0, IMDL_resource_reader::MDL_SEEK_SET);
+    });
+
+    for (size_t i = 0; i < n; ++i) {
+        if (shared[i] != ~size_t(0) && shared[i] != i)
+            memcpy(&hashes[16 * i], &hashes[16 * shared[i]], 16);
+    }
+
+    if (store != NULL) {
+        for (size_t k = 0, n_pending = pending.size(); k < n_pending; ++k) {
+            size_t i = pending[k];
+            if (is_file[i])
+                store->set_content_hash(
+                    readers[i]->get_filename(), file_sizes[i], file_times[i], &hashes[16 * i]);
+        }
+    }
+}
+
 // Create a new encapsulated mdl file from a given module.
 bool Encapsulate_tool::create_encapsulated_module(
     IModule const                 *module,
@@ -534,7 +664,12 @@ bool Encapsulate_tool::create_encapsulated_module(
     // keep track of zip sources
     vector<Resource_zip_source*>::Type added_zip_sources(get_allocator());
 
-    // write resources
+    // collect the resources and user files first, so their content hashes can be computed
+    // concurrently before they are written
+    vector<mi::base::Handle<IMDL_resource_reader> >::Type readers(get_allocator());
+    vector<char const *>::Type                             target_names(get_allocator());
+
+    // collect resources
     for (size_t f = 0, f_n = desc.resource_collector->get_resource_count(); f < f_n; ++f) {
         // source
         mi::base::Handle<mi::mdl::IMDL_resource_reader> reader(
@@ -552,19 +687,12 @@ bool Encapsulate_tool::create_encapsulated_module(
         if (target_name[0] == '.' && target_name[1] == '/')
             target_name += 2;
 
-        if (!add_file_uncompressed(
-                za, reader.get(), target_name, mdle_name, added_zip_sources, hash.data))
-        {
-            has_error = true;
-            break;
-        }
-
-        // store hash to eventually compute the MDLE top level hash
-        sorted_md5_map[target_name] = hash;
+        readers.push_back(reader);
+        target_names.push_back(target_name);
     }
 
-    // write user files specified by file name
-    for (size_t i = 0, n = desc.additional_file_count; i < n; ++i) {
+    // collect user files specified by file name
+    for (size_t i = 0, n = has_error ? 0 : desc.additional_file_count; i < n; ++i) {
         // source
         mi::base::Handle<mi::mdl::IMDL_resource_reader> reader(
             desc.resource_collector->get_additional_data_reader(
@@ -579,15 +707,28 @@ bool Encapsulate_tool::create_encapsulated_module(
         // target
         char const *target_name = desc.additional_file_target_paths[i];
 
-        if (!add_file_uncompressed(
-            za, reader.get(), target_name, mdle_name, added_zip_sources, hash.data)) 
-        {
-            has_error = true;
-            break;
-        }
+        readers.push_back(reader);
+        target_names.push_back(target_name);
+    }
+
+    // write resources and user files
+    if (!has_error) {
+        vector<unsigned char>::Type hashes(get_allocator());
+        compute_content_hashes(readers, hashes, desc.resource_store);
+
+        for (size_t i = 0, n = readers.size(); i < n; ++i) {
+            memcpy(hash.data, &hashes[16 * i], 16);
 
-        // store hash to eventually compute the MDLE top level hash
-        sorted_md5_map[target_name] = hash;
+            if (!add_file_uncompressed(
+                    za, readers[i].get(), target_names[i], mdle_name, added_zip_sources, hash.data))
+            {
+                has_error = true;
+                break;
+            }
+
+            // store hash to eventually compute the MDLE top level hash
+            sorted_md5_map[target_names[i]] = hash;
+        }
     }
 
     // add zip file comments
@@ -644,6 +785,36 @@ bool Encapsulate_tool::create_encapsulated_module(
     return true;
 }
 
+// Create several encapsulated mdl files in one call.
+size_t Encapsulate_tool::create_encapsulated_modules(
+    size_t                        count,
+    IModule const * const         *modules,
+    char const * const            *mdle_names,
+    char const                    *dest_path,
+    Mdle_export_description const *descs)
+{
+    // the store shared by all descriptions without one
+    mi::base::Handle<Encapsulate_resource_store> store(create_resource_store());
+
+    size_t n_created = 0;
+    for (size_t i = 0; i < count; ++i) {
+        Mdle_export_description desc(descs[i]);
+        if (desc.resource_store == NULL)
+            desc.resource_store = store.get();
+
+        if (create_encapsulated_module(modules[i], mdle_names[i], dest_path, desc))
+            ++n_created;
+    }
+    return n_created;
+}
+
+// Create a new resource store that can be shared between MDLE creations.
+Encapsulate_resource_store *Encapsulate_tool::create_resource_store()
+{
+    Allocator_builder builder(get_allocator());
+    return builder.create<Encapsulate_resource_store>(get_allocator());
+}
+
 // Get the content of a file into a memory buffer.
 IMDL_resource_reader *Encapsulate_tool::get_content_buffer(
     char const *archive_name,
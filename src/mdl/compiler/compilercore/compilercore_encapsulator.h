@@ -30,6 +30,7 @@
 #define MDL_COMPILERCORE_ENCAPSULATOR_H 1
 
 #include <mi/base/handle.h>
+#include <mi/base/lock.h>
 #include <mi/mdl/mdl_encapsulator.h>
 
 #include "compilercore_allocator.h"
@@ -79,6 +80,48 @@ private:
         zip_t       *za);
 };
 
+/// Implementation of the IEncapsulate_tool_resource_store interface.
+class Encapsulate_resource_store
+    : public Allocator_interface_implement<IEncapsulate_tool_resource_store>
+{
+    typedef Allocator_interface_implement<IEncapsulate_tool_resource_store> Base;
+    friend class Allocator_builder;
+
+public:
+    /// Look up the content hash of a resource.
+    bool get_content_hash(
+        char const    *file_name,
+        Uint64        file_size,
+        Uint64        file_time,
+        unsigned char hash[16]) const MDL_FINAL;
+
+    /// Record the content hash of a resource.
+    void set_content_hash(
+        char const          *file_name,
+        Uint64              file_size,
+        Uint64              file_time,
+        unsigned char const hash[16]) MDL_FINAL;
+
+private:
+    /// Constructor.
+    explicit Encapsulate_resource_store(IAllocator *alloc);
+
+private:
+    struct Hash {
+        Uint64        file_size;  ///< The size of the file when it was hashed.
+        Uint64        file_time;  ///< The modification time of the file when it was hashed.
+        unsigned char data[16];   ///< The MD5 hash.
+    };
+
+    typedef map<string, Hash>::Type Hash_map;
+
+    /// Protects the hash map.
+    mutable mi::base::Lock m_lock;
+
+    /// The content hashes by file name.
+    Hash_map m_hashes;
+};
+
 /// Implementation of the IEncapsulate_tool interface.
 class Encapsulate_tool : public Allocator_interface_implement<IEncapsulate_tool>
 {
@@ -104,6 +147,25 @@ public:
         char const                      *dest_path,
         Mdle_export_description const   &desc) MDL_FINAL;
 
+    /// Create several encapsulated mdl files in one call.
+    ///
+    /// \param count            Number of MDLEs to create.
+    /// \param modules          Modules that should be written to MDLE files.
+    /// \param mdle_names       MDLE file names without path and without extension.
+    /// \param dest_path        The path where the created MDLE files should be stored.
+    /// \param descs            The export descriptions, one per MDLE.
+    ///
+    /// \returns the number of successfully created MDLEs
+    size_t create_encapsulated_modules(
+        size_t                          count,
+        IModule const * const           *modules,
+        char const * const              *mdle_names,
+        char const                      *dest_path,
+        Mdle_export_description const   *descs) MDL_FINAL;
+
+    /// Create a new resource store that can be shared between MDLE creations.
+    Encapsulate_resource_store *create_resource_store() MDL_FINAL;
+
     /// Get the content from any file out of an MDLe on the file system.
     ///
     /// \param mdle_path    The MDLe file that contains the requested file.
@@ -211,7 +273,20 @@ private:
         char const *target_name,
         char const *mdle_name,
         vector<Resource_zip_source*>::Type &add_sources,
-        unsigned char hash[16]);
+        unsigned char const hash[16]);
+
+    /// Computes the MD5 content hashes of the given resources.
+    ///
+    /// Hashes provided by the readers or found in the store are reused, the remaining
+    /// resources are hashed concurrently, each distinct file only once.
+    ///
+    /// \param readers  the resource readers
+    /// \param hashes   receives 16 bytes per reader
+    /// \param store    the resource store if any
+    void compute_content_hashes(
+        vector<mi::base::Handle<IMDL_resource_reader> >::Type const &readers,
+        vector<unsigned char>::Type                               &hashes,
+        IEncapsulate_tool_resource_store                          *store);
 
     IMDL_resource_reader *get_content_buffer(
         char const *archive_name,
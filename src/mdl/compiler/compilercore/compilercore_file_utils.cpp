@@ -183,6 +183,37 @@ bool is_file_utf8(
     return false;
 }
 
+// Get the size and the modification time of a file (UTF8 encoded name).
+bool get_file_size_and_time_utf8(
+    IAllocator *alloc,
+    char const *fname,
+    Uint64     &size,
+    Uint64     &mtime)
+{
+#ifdef MI_PLATFORM_WINDOWS
+    struct _stat64 st;
+
+    wstring path(alloc);
+    utf8_to_utf16(path, fname);
+
+    if (!::_wstat64(path.c_str(), &st)) {
+        size  = Uint64(st.st_size);
+        mtime = Uint64(st.st_mtime);
+        return true;
+    }
+#else
+    struct stat st;
+
+    // assume native UTF8-support
+    if (!::stat(fname, &st)) {
+        size  = Uint64(st.st_size);
+        mtime = Uint64(st.st_mtime);
+        return true;
+    }
+#endif
+    return false;
+}
+
 // Check if in the given directory a file matching the given mask exists.
 bool has_file_utf8(
     IAllocator *alloc,
@@ -86,6 +86,20 @@ bool is_file_utf8(
     IAllocator *alloc,
     char const *fname);
 
+/// Get the size and the modification time of a file (UTF8 encoded name).
+///
+/// \param alloc       an allocator
+/// \param fname       an UTF8 encoded file name
+/// \param[out] size   the size of the file in bytes
+/// \param[out] mtime  the modification time of the file
+///
+/// \return false if the file does not exist
+bool get_file_size_and_time_utf8(
+    IAllocator *alloc,
+    char const *fname,
+    Uint64     &size,
+    Uint64     &mtime);
+
 /// Check if in the given directory a file matching the given mask exists.
 ///
 /// \param alloc      an allocator
@@ -40,6 +40,7 @@
 #include "compilercore_encapsulator.h"
 #include "compilercore_factories.h"
 #include "compilercore_malloc_allocator.h"
+#include "compilercore_thread_cache_allocator.h"
 #include "compilercore_modules.h"
 #include "compilercore_options.h"
 #include "compilercore_file_resolution.h"
@@ -77,6 +78,7 @@ char const *MDL::option_opt_level                     = MDL_OPTION_OPT_LEVEL;
 char const *MDL::option_strict                        = MDL_OPTION_STRICT;
 char const *MDL::option_experimental_features         = MDL_OPTION_EXPERIMENTAL_FEATURES;
 char const *MDL::option_resolve_resources             = MDL_OPTION_RESOLVE_RESOURCES;
+char const *MDL::option_parallel_imports              = MDL_OPTION_PARALLEL_IMPORTS;
 char const *MDL::option_limits_float_min              = MDL_OPTION_LIMITS_FLOAT_MIN;
 char const *MDL::option_limits_float_max              = MDL_OPTION_LIMITS_FLOAT_MAX;
 char const *MDL::option_limits_double_min             = MDL_OPTION_LIMITS_DOUBLE_MIN;
@@ -555,7 +557,6 @@ Module *MDL::create_module(
 {
     // FIXME: check for name already in use
 
-    // TODO: this must be thread safe if create_module should be thread safe
     // Don't use number 0, this is reserved for "owner module".
     size_t id = ++m_next_module_id;
 
@@ -1009,6 +1010,8 @@ void MDL::create_options()
         "Enables undocumented experimental MDL features");
     m_options.add_option(option_resolve_resources, "true",
         "Controls resource resolution.");
+    m_options.add_option(option_parallel_imports, "false",
+        "Load independent imports of a module on worker threads");
 
     m_options.add_option(option_limits_float_min, STR(FLT_MIN),
         "The smallest positive normalized float value supported by the current platform");
@@ -1424,6 +1427,27 @@ IExpression const *MDL::parse_expression(
     return parser.parse_expression();
 }
 
+// Parse a module without analyzing it.
+Module *MDL::parse_module(
+    char const    *module_name,
+    IInput_stream *s,
+    bool          enable_experimental_features)
+{
+    Module *module = create_module(
+        module_name, s->get_filename(), IMDL::MDL_DEFAULT_VERSION, Module::MF_STANDARD);
+
+    Messages_impl &msgs = module->access_messages_impl();
+    Syntax_error  err(get_allocator(), msgs);
+    Scanner       scanner(get_allocator(), &err, s);
+    Parser        parser(&scanner, &err);
+
+    parser.set_imdl(get_allocator(), this);
+
+    parser.set_module(module, enable_experimental_features);
+    parser.Parse();
+    return module;
+}
+
 // Create a printer.
 Printer *MDL::create_printer(IOutput_stream *stream) const
 {
@@ -2475,6 +2499,27 @@ IAllocator *get_debug_log_allocator() { return g_debug_log_allocator; }
 // Initialize MDL
 //
 
+/// Create the allocator used if MDL uses its own allocation.
+///
+/// Setting MI_MDL_ALLOCATOR to "thread_cache" selects the thread caching allocator,
+/// which scales better if many threads compile in parallel. In DEBUG builds, it also
+/// collects allocation statistics per class name.
+static IAllocator *create_default_allocator()
+{
+    char const *name = getenv("MI_MDL_ALLOCATOR");
+    if (name != NULL && strcmp(name, "thread_cache") == 0) {
+        if (Thread_cache_allocator *alloc = Thread_cache_allocator::create_instance())
+            return alloc;
+    }
+#ifdef DEBUG
+    // does not work with neuray's own allocator, so we use the debug allocator
+    // only if MDL uses its own allocation
+    return &dbgMallocAlloc;
+#else
+    return MallocAllocator::create_instance();
+#endif
+}
+
 // Initializes the mdl library and obtains the primary mdl interface.
 mi::mdl::IMDL *initialize(IAllocator *allocator)
 {
@@ -2485,15 +2530,7 @@ mi::mdl::IMDL *initialize(IAllocator *allocator)
         return create_mdl(allocator);
     }
 
-    mi::base::Handle<mi::base::IAllocator> alloc(
-#ifdef DEBUG
-        // does not work with neuray's own allocator, so we use the debug allocator
-        // only if MDL uses its own allocation
-        &dbgMallocAlloc
-#else
-        MallocAllocator::create_instance()
-#endif
-    );
+    mi::base::Handle<mi::base::IAllocator> alloc(create_default_allocator());
 
     // FIXME: This creates a non-ref-counted reference!
     g_debug_log_allocator = alloc.get();
@@ -29,6 +29,7 @@
 #ifndef MDL_COMPILERCORE_MDL_H
 #define MDL_COMPILERCORE_MDL_H 1
 
+#include <mi/base/atom.h>
 #include <mi/base/handle.h>
 #include <mi/base/lock.h>
 #include <mi/mdl/mdl_mdl.h>
@@ -85,6 +86,9 @@ public:
     /// The name of the option that controls, if resources are resolved by the compiler.
     static char const *option_resolve_resources;
 
+    /// The name of the option that enables loading of independent imports on worker threads.
+    static char const *option_parallel_imports;
+
     /// The value of limits::FLOAT_MIN.
     static char const *option_limits_float_min;
 
@@ -587,6 +591,19 @@ public:
         bool          enable_experimental_features,
         Messages_impl &msgs);
 
+    /// Parse a module without analyzing it.
+    ///
+    /// \param module_name                   the absolute name of the module
+    /// \param s                             the input stream of the module
+    /// \param enable_experimental_features  if true, allow experimental MDL features
+    ///
+    /// \return the syntax tree of the module, its imports are not resolved.
+    ///         Syntax errors are reported at the module.
+    Module *parse_module(
+        char const    *module_name,
+        IInput_stream *s,
+        bool          enable_experimental_features);
+
 public:
     /// Constructor.
     explicit MDL(IAllocator *alloc);
@@ -657,7 +674,7 @@ private:
     mutable Allocator_builder m_builder;
 
     /// Next unique module id.
-    size_t m_next_module_id;
+    mi::base::Atom32 m_next_module_id;
 
     /// Arena for the compiler.
     Memory_arena m_arena;
@@ -89,12 +89,24 @@ static inline size_t start_offset(unsigned char *p, size_t a)
 
 Memory_arena::Memory_arena(IAllocator *alloc, size_t chunk_size)
 : m_alloc(alloc, mi::base::DUP_INTERFACE)
-, m_chunk_size(chunk_size)
+, m_chunk_size(chunk_size != 0 ? chunk_size : get_preferred_chunk_size(alloc))
 , m_chunks(NULL)
 , m_next(NULL)
 , m_curr_size(0)
 {
-    MDL_ASSERT(alloc && chunk_size > 16);
+    MDL_ASSERT(alloc && m_chunk_size > 16);
+}
+
+// Get the chunk size preferred by an allocator.
+size_t Memory_arena::get_preferred_chunk_size(IAllocator *alloc)
+{
+    if (alloc != NULL) {
+        mi::base::Handle<IArena_chunk_size_hint> hint(
+            alloc->get_interface<IArena_chunk_size_hint>());
+        if (hint.is_valid_interface())
+            return hint->get_arena_chunk_size();
+    }
+    return CHUNK_SIZE;
 }
 /// Destructs the memory arena and frees ALL memory.
 Memory_arena::~Memory_arena()
@@ -74,8 +74,9 @@ public:
     /// Constructs a new memory arena.
     ///
     /// \param alloc       the allocator
-    /// \param chunk_size  the size of the memory chunks allocated from alloc
-    explicit Memory_arena(IAllocator *alloc, size_t chunk_size = CHUNK_SIZE);
+    /// \param chunk_size  the size of the memory chunks allocated from alloc,
+    ///                    0 for the chunk size preferred by alloc
+    explicit Memory_arena(IAllocator *alloc, size_t chunk_size = 0);
 
     /// Destructs the memory arena and frees ALL memory.
     ~Memory_arena();
@@ -118,6 +119,13 @@ public:
     void swap(Memory_arena &other);
 
 private:
+    /// Get the chunk size preferred by an allocator.
+    ///
+    /// \param alloc  the allocator
+    ///
+    /// \return the size from IArena_chunk_size_hint if alloc implements it, else CHUNK_SIZE
+    static size_t get_preferred_chunk_size(IAllocator *alloc);
+
 
     /// The allocator.
     mi::base::Handle<IAllocator> m_alloc;
@@ -0,0 +1,561 @@
+/******************************************************************************
+ * Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *****************************************************************************/
+
+#include "pch.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+#include "compilercore_thread_cache_allocator.h"
+#include "compilercore_assert.h"
+
+namespace mi {
+namespace mdl {
+
+/// The thread caches of the current thread, one slot per allocator.
+struct Thread_cache_slots {
+    /// The IDs of the allocators owning the caches.
+    Uint32 id[Thread_cache_allocator::MAX_THREAD_SLOTS];
+
+    /// The caches.
+    Thread_cache_allocator::Thread_cache *cache[Thread_cache_allocator::MAX_THREAD_SLOTS];
+
+    /// Clear all slots of allocators that were destroyed, these have already freed the caches.
+    ///
+    /// \return true if at least one slot was cleared
+    bool reclaim()
+    {
+        bool cleared = false;
+
+        mi::base::Lock::Block block(&Thread_cache_allocator::get_registry_lock());
+
+        for (size_t i = 0; i < Thread_cache_allocator::MAX_THREAD_SLOTS; ++i) {
+            if (cache[i] != NULL && Thread_cache_allocator::find_allocator(id[i]) == NULL) {
+                cache[i] = NULL;
+                cleared  = true;
+            }
+        }
+        return cleared;
+    }
+
+    /// Destructor, called when the thread exits.
+    ~Thread_cache_slots()
+    {
+        for (size_t i = 0; i < Thread_cache_allocator::MAX_THREAD_SLOTS; ++i) {
+            if (cache[i] != NULL) {
+                Thread_cache_allocator::release_thread_cache(id[i], cache[i]);
+                cache[i] = NULL;
+            }
+        }
+    }
+};
+
+/// The thread caches of the current thread.
+static thread_local Thread_cache_slots g_thread_slots;
+
+// All living allocators.
+Thread_cache_allocator *Thread_cache_allocator::s_allocators = NULL;
+
+// The ID for the next allocator.
+mi::base::Atom32 Thread_cache_allocator::s_next_id;
+
+void *Thread_cache_allocator::malloc(mi::Size size)
+{
+    if (size > MAX_SMALL_SIZE) {
+        Block_header *h = (Block_header *)::malloc(sizeof(Block_header) + size);
+        if (h == NULL) {
+            fprintf(stderr, "*** Memory exhausted.\n");
+            abort();
+        }
+        h->size_class = LARGE_BLOCK;
+        h->size       = size;
+        ++m_n_large_allocs;
+        return h + 1;
+    }
+
+    size_t size_class = get_size_class(size);
+    void   *res       = NULL;
+
+    if (Thread_cache *cache = get_thread_cache()) {
+        if (cache->free_list[size_class] == NULL)
+            refill(cache, size_class);
+
+        if (Free_block *b = cache->free_list[size_class]) {
+            cache->free_list[size_class] = b->next;
+            --cache->count[size_class];
+            ++cache->n_allocs[size_class];
+            res = b;
+        }
+    } else {
+        res = central_alloc(size_class);
+    }
+
+    if (res == NULL) {
+        fprintf(stderr, "*** Memory exhausted.\n");
+        abort();
+    }
+    ((Block_header *)res - 1)->size = size;
+    return res;
+}
+
+void Thread_cache_allocator::free(void *memory)
+{
+    if (memory == NULL)
+        return;
+
+    Block_header *h = (Block_header *)memory - 1;
+    size_t size_class = size_t(h->size_class);
+
+    if (size_class == LARGE_BLOCK) {
+        ::free(h);
+        return;
+    }
+
+    Free_block *b = (Free_block *)memory;
+    if (Thread_cache *cache = get_thread_cache()) {
+        b->next = cache->free_list[size_class];
+        cache->free_list[size_class] = b;
+        if (++cache->count[size_class] > CACHE_LIMIT)
+            flush(cache, size_class);
+    } else {
+        central_free(b, size_class);
+    }
+}
+
+// Allocates a memory block for a class instance.
+void *Thread_cache_allocator::objalloc(char const *cls_name, Size size)
+{
+    if (cls_name != NULL) {
+        size_t bucket = (size_t(cls_name) >> 4) % CLASS_STATS_BUCKETS;
+
+        mi::base::Lock::Block block(&m_lock);
+
+        Class_stats *s = m_class_stats[bucket];
+        for (; s != NULL; s = s->next) {
+            if (s->cls_name == cls_name)
+                break;
+        }
+        if (s == NULL) {
+            s = (Class_stats *)::malloc(sizeof(Class_stats));
+            if (s != NULL) {
+                s->cls_name = cls_name;
+                s->count    = 0;
+                s->size     = 0;
+                s->next     = m_class_stats[bucket];
+                m_class_stats[bucket] = s;
+            }
+        }
+        if (s != NULL) {
+            ++s->count;
+            s->size += size;
+        }
+    }
+    return malloc(size);
+}
+
+// Marks the given object as reference counted and set the initial count.
+void Thread_cache_allocator::mark_ref_counted(void const *obj, Uint32 initial)
+{
+    // reference counts are not tracked
+}
+
+// Increments the reference count of an reference counted object.
+void Thread_cache_allocator::inc_ref_count(void const *obj)
+{
+    // reference counts are not tracked
+}
+
+// Decrements the reference count of an reference counted object.
+void Thread_cache_allocator::dec_ref_count(void const *obj)
+{
+    // reference counts are not tracked
+}
+
+// Decrements the reference count.
+Uint32 Thread_cache_allocator::release() const
+{
+    Uint32 cnt = Base::release();
+    if (cnt == 1) {
+        // we have reached our self-reference, kick this object.
+        this->~Thread_cache_allocator();
+        // don't do this normally
+        ::free((void *)this);
+    }
+    return cnt;
+}
+
+// Dump the allocation statistics to stderr.
+void Thread_cache_allocator::dump_statistics()
+{
+    mi::base::Lock::Block block(&m_lock);
+
+    size_t n_spans = 0;
+    for (Free_block *s = m_spans; s != NULL; s = s->next)
+        ++n_spans;
+
+    fprintf(stderr, "*** MDL allocator statistics\n");
+    fprintf(stderr, "Spans: %lu (%lu Kb)\n",
+        (unsigned long)n_spans, (unsigned long)(n_spans * SPAN_SIZE / 1024));
+    fprintf(stderr, "Large blocks allocated: %u\n", Uint32(m_n_large_allocs));
+
+    for (size_t c = 0; c < SIZE_CLASS_COUNT; ++c) {
+        size_t n_allocs = m_central[c].n_allocs;
+        size_t n_cached = m_central[c].count;
+
+        for (Thread_cache *cache = m_caches; cache != NULL; cache = cache->next) {
+            n_allocs += cache->n_allocs[c];
+            n_cached += cache->count[c];
+        }
+        if (n_allocs == 0)
+            continue;
+        fprintf(stderr, "Size class %4lu: %10lu allocations, %8lu free blocks\n",
+            (unsigned long)get_class_size(c), (unsigned long)n_allocs, (unsigned long)n_cached);
+    }
+
+    bool has_class_stats = false;
+    for (size_t i = 0; i < CLASS_STATS_BUCKETS; ++i) {
+        for (Class_stats *s = m_class_stats[i]; s != NULL; s = s->next) {
+            if (!has_class_stats) {
+                fprintf(stderr, "Objects by class:\n");
+                has_class_stats = true;
+            }
+            fprintf(stderr, "%10lu objects, %10lu bytes: %s\n",
+                (unsigned long)s->count, (unsigned long)s->size, s->cls_name);
+        }
+    }
+}
+
+// Create a new Thread_cache_allocator.
+Thread_cache_allocator *Thread_cache_allocator::create_instance()
+{
+    Thread_cache_allocator *p =
+        (Thread_cache_allocator *)::malloc(sizeof(Thread_cache_allocator));
+
+    if (p != NULL)
+        new (p) Thread_cache_allocator;
+    return p;
+}
+
+// Constructor.
+Thread_cache_allocator::Thread_cache_allocator()
+: Base(/*initial=*/2)
+, m_id(++s_next_id)
+, m_next_alloc(NULL)
+, m_lock()
+, m_spans(NULL)
+, m_caches(NULL)
+, m_n_large_allocs()
+, m_dump_statistics(getenv("MI_MDL_ALLOCATOR_STATISTICS") != NULL)
+{
+    for (size_t c = 0; c < SIZE_CLASS_COUNT; ++c) {
+        m_central[c].free_list = NULL;
+        m_central[c].count     = 0;
+        m_central[c].n_allocs  = 0;
+    }
+    for (size_t i = 0; i < CLASS_STATS_BUCKETS; ++i)
+        m_class_stats[i] = NULL;
+
+    mi::base::Lock::Block block(&get_registry_lock());
+    m_next_alloc = s_allocators;
+    s_allocators = this;
+}
+
+// Destructor.
+Thread_cache_allocator::~Thread_cache_allocator()
+{
+    if (m_dump_statistics)
+        dump_statistics();
+
+    // the cache of this thread is freed below, release its slot right away; other threads
+    // reclaim theirs when they run out of slots
+    Thread_cache_slots &slots = g_thread_slots;
+    for (size_t i = 0; i < MAX_THREAD_SLOTS; ++i) {
+        if (slots.cache[i] != NULL && slots.id[i] == m_id)
+            slots.cache[i] = NULL;
+    }
+
+    mi::base::Lock::Block block(&get_registry_lock());
+
+    for (Thread_cache_allocator **p = &s_allocators; *p != NULL; p = &(*p)->m_next_alloc) {
+        if (*p == this) {
+            *p = m_next_alloc;
+            break;
+        }
+    }
+
+    // the caches of still running threads are freed here, those threads will not find
+    // this allocator anymore when they exit
+    for (Thread_cache *cache = m_caches, *n; cache != NULL; cache = n) {
+        n = cache->next;
+        ::free(cache);
+    }
+    for (Free_block *span = m_spans, *n; span != NULL; span = n) {
+        n = span->next;
+        ::free(span);
+    }
+    for (size_t i = 0; i < CLASS_STATS_BUCKETS; ++i) {
+        for (Class_stats *s = m_class_stats[i], *n; s != NULL; s = n) {
+            n = s->next;
+            ::free(s);
+        }
+    }
+}
+
+// Get the size class of a small block size.
+size_t Thread_cache_allocator::get_size_class(size_t size)
+{
+    MDL_ASSERT(size <= MAX_SMALL_SIZE);
+    if (size <= 256) {
+        // 16 byte steps
+        return size == 0 ? 0 : (size - 1) >> 4;
+    }
+    if (size <= 512) {
+        // 64 byte steps
+        return 16 + ((size - 257) >> 6);
+    }
+    // 128 byte steps
+    return 20 + ((size - 513) >> 7);
+}
+
+// Get the block size of a size class.
+size_t Thread_cache_allocator::get_class_size(size_t size_class)
+{
+    if (size_class < 16)
+        return (size_class + 1) << 4;
+    if (size_class < 20)
+        return 256 + ((size_class - 15) << 6);
+    return 512 + ((size_class - 19) << 7);
+}
+
+// Get the cache of the current thread, creating it if necessary.
+Thread_cache_allocator::Thread_cache *Thread_cache_allocator::get_thread_cache()
+{
+    Thread_cache_slots &slots = g_thread_slots;
+
+    size_t free_slot = MAX_THREAD_SLOTS;
+    for (size_t i = 0; i < MAX_THREAD_SLOTS; ++i) {
+        if (slots.cache[i] == NULL) {
+            if (free_slot == MAX_THREAD_SLOTS)
+                free_slot = i;
+        } else if (slots.id[i] == m_id) {
+            return slots.cache[i];
+        }
+    }
+    if (free_slot == MAX_THREAD_SLOTS) {
+        // slots of allocators destroyed on other threads are still occupied
+        if (!slots.reclaim()) {
+            // too many allocators used by this thread, use the central lists
+            return NULL;
+        }
+        free_slot = 0;
+        while (slots.cache[free_slot] != NULL)
+            ++free_slot;
+    }
+
+    Thread_cache *cache = (Thread_cache *)::calloc(1, sizeof(Thread_cache));
+    if (cache == NULL)
+        return NULL;
+
+    {
+        mi::base::Lock::Block block(&m_lock);
+        cache->next = m_caches;
+        m_caches    = cache;
+    }
+
+    slots.id[free_slot]    = m_id;
+    slots.cache[free_slot] = cache;
+    return cache;
+}
+
+// Move up to BATCH_SIZE blocks from the central list into a thread cache.
+void Thread_cache_allocator::refill(Thread_cache *cache, size_t size_class)
+{
+    Central_list &central = m_central[size_class];
+
+    mi::base::Lock::Block block(&central.lock);
+
+    if (central.free_list == NULL)
+        add_span(size_class);
+
+    for (size_t i = 0; i < BATCH_SIZE && central.free_list != NULL; ++i) {
+        Free_block *b = central.free_list;
+        central.free_list = b->next;
+        --central.count;
+
+        b->next = cache->free_list[size_class];
+        cache->free_list[size_class] = b;
+        ++cache->count[size_class];
+    }
+}
+
+// Move BATCH_SIZE blocks from a thread cache to the central list.
+void Thread_cache_allocator::flush(Thread_cache *cache, size_t size_class)
+{
+    Central_list &central = m_central[size_class];
+
+    mi::base::Lock::Block block(&central.lock);
+
+    for (size_t i = 0; i < BATCH_SIZE && cache->free_list[size_class] != NULL; ++i) {
+        Free_block *b = cache->free_list[size_class];
+        cache->free_list[size_class] = b->next;
+        --cache->count[size_class];
+
+        b->next = central.free_list;
+        central.free_list = b;
+        ++central.count;
+    }
+}
+
+// Allocate one block from the central list.
+void *Thread_cache_allocator::central_alloc(size_t size_class)
+{
+    Central_list &central = m_central[size_class];
+
+    mi::base::Lock::Block block(&central.lock);
+
+    if (central.free_list == NULL)
+        add_span(size_class);
+
+    Free_block *b = central.free_list;
+    if (b != NULL) {
+        central.free_list = b->next;
+        --central.count;
+        ++central.n_allocs;
+    }
+    return b;
+}
+
+// Return one block to the central list.
+void Thread_cache_allocator::central_free(Free_block *block, size_t size_class)
+{
+    Central_list &central = m_central[size_class];
+
+    mi::base::Lock::Block lock_block(&central.lock);
+
+    block->next = central.free_list;
+    central.free_list = block;
+    ++central.count;
+}
+
+// Carve a new span into free blocks of the given class and add them to its central list.
+void Thread_cache_allocator::add_span(size_t size_class)
+{
+    Free_block *span = (Free_block *)::malloc(SPAN_SIZE);
+    if (span == NULL)
+        return;
+
+    {
+        mi::base::Lock::Block block(&m_lock);
+        span->next = m_spans;
+        m_spans    = span;
+    }
+
+    Central_list &central = m_central[size_class];
+
+    // the span link occupies the first 16 bytes, keep the blocks 16 byte aligned
+    size_t block_size = sizeof(Block_header) + get_class_size(size_class);
+    size_t n_blocks   = (SPAN_SIZE - 16) / block_size;
+    char   *start     = (char *)span + 16;
+
+    for (size_t i = 0; i < n_blocks; ++i) {
+        Block_header *h = (Block_header *)(start + i * block_size);
+        h->size_class = size_class;
+        h->size       = 0;
+
+        Free_block *b = (Free_block *)(h + 1);
+        b->next = central.free_list;
+        central.free_list = b;
+    }
+    central.count += n_blocks;
+}
+
+// Release the thread cache of an exiting thread.
+void Thread_cache_allocator::release_thread_cache(Uint32 id, Thread_cache *cache)
+{
+    mi::base::Lock::Block block(&get_registry_lock());
+
+    Thread_cache_allocator *alloc = find_allocator(id);
+    if (alloc == NULL) {
+        // the allocator is already destroyed and has freed the cache
+        return;
+    }
+
+    for (size_t c = 0; c < SIZE_CLASS_COUNT; ++c) {
+        Central_list &central = alloc->m_central[c];
+
+        mi::base::Lock::Block central_block(&central.lock);
+
+        while (Free_block *b = cache->free_list[c]) {
+            cache->free_list[c] = b->next;
+
+            b->next = central.free_list;
+            central.free_list = b;
+            ++central.count;
+        }
+        central.n_allocs += cache->n_allocs[c];
+    }
+
+    {
+        mi::base::Lock::Block alloc_block(&alloc->m_lock);
+
+        for (Thread_cache **p = &alloc->m_caches; *p != NULL; p = &(*p)->next) {
+            if (*p == cache) {
+                *p = cache->next;
+                break;
+            }
+        }
+    }
+    ::free(cache);
+}
+
+// Find a living allocator by its ID.
+Thread_cache_allocator *Thread_cache_allocator::find_allocator(Uint32 id)
+{
+    for (Thread_cache_allocator *alloc = s_allocators; alloc != NULL; alloc = alloc->m_next_alloc) {
+        if (alloc->m_id == id)
+            return alloc;
+    }
+    return NULL;
+}
+
+// Check if the current thread allocates small blocks from its own cache.
+bool Thread_cache_allocator::has_thread_cache()
+{
+    return get_thread_cache() != NULL;
+}
+
+// Get the lock protecting the list of all living allocators.
+mi::base::Lock &Thread_cache_allocator::get_registry_lock()
+{
+    static mi::base::Lock s_registry_lock;
+    return s_registry_lock;
+}
+
+}  // mdl
+}  // mi
@@ -0,0 +1,236 @@
+/******************************************************************************
+ * Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *****************************************************************************/
+
+#ifndef MDL_COMPILERCORE_THREAD_CACHE_ALLOCATOR_H
+#define MDL_COMPILERCORE_THREAD_CACHE_ALLOCATOR_H 1
+
+#include <mi/base/atom.h>
+#include <mi/base/lock.h>
+#include <mi/base/interface_implement.h>
+
+#include "compilercore_cc_conf.h"
+#include "compilercore_allocator.h"
+
+namespace mi {
+namespace mdl {
+
+///
+/// A malloc/free based allocator for many threads compiling in parallel.
+///
+/// Small blocks are grouped into size classes. Every thread keeps a cache of free blocks
+/// per size class, so allocating and freeing small blocks does not need any lock. Caches
+/// exchange blocks in batches with a central free list per size class, which is refilled
+/// from large spans. Spans are only returned to the system when the allocator is destroyed.
+/// Large blocks are directly allocated with malloc.
+///
+/// The allocator implements IDebugAllocator. Only DEBUG builds pass the class names of
+/// the objects created by the Allocator_builder to it, so the per class statistics are
+/// collected in DEBUG builds only; other builds count the blocks per size class.
+///
+/// Memory arenas allocating from it use chunks of SPAN_SIZE, see IArena_chunk_size_hint.
+///
+/// If the environment variable MI_MDL_ALLOCATOR_STATISTICS is set, the statistics are
+/// dumped when the allocator is destroyed.
+///
+class Thread_cache_allocator
+: public mi::base::Interface_implement_2<IDebugAllocator, IArena_chunk_size_hint>
+{
+    typedef mi::base::Interface_implement_2<IDebugAllocator, IArena_chunk_size_hint> Base;
+    friend struct Thread_cache_slots;
+public:
+    enum Constants {
+        SIZE_CLASS_COUNT = 24,            ///< Number of size classes.
+        MAX_SMALL_SIZE   = 1024,          ///< Blocks up to this size are cached.
+        CACHE_LIMIT      = 128,           ///< Maximum number of cached blocks per class.
+        BATCH_SIZE       = 32,            ///< Number of blocks moved at once.
+        SPAN_SIZE        = 64 * 1024,     ///< Size of the spans small blocks are carved from.
+        MAX_THREAD_SLOTS = 4              ///< Allocators with a cache per thread.
+    };
+
+    void *malloc(mi::Size size) MDL_FINAL;
+
+    void free(void *memory) MDL_FINAL;
+
+    /// Allocates a memory block for a class instance.
+    void *objalloc(char const *cls_name, Size size) MDL_FINAL;
+
+    /// Marks the given object as reference counted and set the initial count.
+    void mark_ref_counted(void const *obj, Uint32 initial) MDL_FINAL;
+
+    /// Increments the reference count of an reference counted object.
+    void inc_ref_count(void const *obj) MDL_FINAL;
+
+    /// Decrements the reference count of an reference counted object.
+    void dec_ref_count(void const *obj) MDL_FINAL;
+
+    /// Decrements the reference count.
+    Uint32 release() const MDL_FINAL;
+
+    /// Get the chunk size for memory arenas allocating from this allocator.
+    size_t get_arena_chunk_size() const MDL_FINAL { return SPAN_SIZE; }
+
+    /// Dump the allocation statistics to stderr.
+    void dump_statistics();
+
+    /// Check if the current thread allocates small blocks from its own cache.
+    ///
+    /// \return false if the current thread has no free cache slot
+    bool has_thread_cache();
+
+    /// Create a new Thread_cache_allocator.
+    static Thread_cache_allocator *create_instance();
+
+private:
+    /// The header in front of every block.
+    struct Block_header {
+        Uint64 size_class;  ///< The size class of this block or LARGE_BLOCK.
+        Uint64 size;        ///< The requested size of this block.
+    };
+
+    /// A free block, linked through its payload.
+    struct Free_block {
+        Free_block *next;   ///< The next free block.
+    };
+
+    /// The per thread cache.
+    struct Thread_cache {
+        Thread_cache *next;                         ///< Next cache of this allocator.
+        Free_block   *free_list[SIZE_CLASS_COUNT];  ///< The cached free blocks per class.
+        size_t       count[SIZE_CLASS_COUNT];       ///< Number of cached blocks per class.
+        size_t       n_allocs[SIZE_CLASS_COUNT];    ///< Number of allocations per class.
+    };
+
+    /// The central free list of one size class.
+    struct Central_list {
+        mi::base::Lock lock;                        ///< Protects this list.
+        Free_block     *free_list;                  ///< The free blocks.
+        size_t         count;                       ///< Number of free blocks.
+        size_t         n_allocs;                    ///< Number of uncached allocations.
+    };
+
+    /// Statistics of one class name.
+    struct Class_stats {
+        char const  *cls_name;                      ///< The class name.
+        size_t      count;                          ///< Number of allocated objects.
+        size_t      size;                           ///< Size of all allocated objects.
+        Class_stats *next;                          ///< Next entry in the same bucket.
+    };
+
+    enum Internal_constants {
+        LARGE_BLOCK        = SIZE_CLASS_COUNT,      ///< Size class of large blocks.
+        CLASS_STATS_BUCKETS = 256                   ///< Number of class statistic buckets.
+    };
+
+private:
+    /// Constructor.
+    Thread_cache_allocator();
+
+    /// Destructor.
+    ~Thread_cache_allocator() MDL_FINAL;
+
+    /// Get the size class of a small block size.
+    static size_t get_size_class(size_t size);
+
+    /// Get the block size of a size class.
+    static size_t get_class_size(size_t size_class);
+
+    /// Get the cache of the current thread, creating it if necessary.
+    ///
+    /// \return NULL if the current thread has no free cache slot
+    Thread_cache *get_thread_cache();
+
+    /// Move up to BATCH_SIZE blocks from the central list into a thread cache.
+    void refill(Thread_cache *cache, size_t size_class);
+
+    /// Move BATCH_SIZE blocks from a thread cache to the central list.
+    void flush(Thread_cache *cache, size_t size_class);
+
+    /// Allocate one block from the central list.
+    void *central_alloc(size_t size_class);
+
+    /// Return one block to the central list.
+    void central_free(Free_block *block, size_t size_class);
+
+    /// Carve a new span into free blocks of the given class and add them to its central list.
+    ///
+    /// \note the lock of the central list must be held
+    void add_span(size_t size_class);
+
+    /// Release the thread cache of an exiting thread.
+    ///
+    /// \param id     the ID of the allocator owning the cache
+    /// \param cache  the cache
+    static void release_thread_cache(Uint32 id, Thread_cache *cache);
+
+    /// Find a living allocator by its ID.
+    ///
+    /// \note the registry lock must be held
+    static Thread_cache_allocator *find_allocator(Uint32 id);
+
+    /// Get the lock protecting the list of all living allocators.
+    static mi::base::Lock &get_registry_lock();
+
+private:
+    /// The unique ID of this allocator.
+    Uint32 const m_id;
+
+    /// Next living allocator.
+    Thread_cache_allocator *m_next_alloc;
+
+    /// The central lists.
+    Central_list m_central[SIZE_CLASS_COUNT];
+
+    /// Protects the span list, the thread caches list and the statistics.
+    mi::base::Lock m_lock;
+
+    /// All allocated spans.
+    Free_block *m_spans;
+
+    /// All thread caches.
+    Thread_cache *m_caches;
+
+    /// Number of large allocations.
+    mi::base::Atom32 m_n_large_allocs;
+
+    /// The class name statistics.
+    Class_stats *m_class_stats[CLASS_STATS_BUCKETS];
+
+    /// If true, dump statistics when destroyed.
+    bool m_dump_statistics;
+
+    /// All living allocators.
+    static Thread_cache_allocator *s_allocators;
+
+    /// The ID for the next allocator.
+    static mi::base::Atom32 s_next_id;
+};
+
+}  // mdl
+}  // mi
+
+#endif // MDL_COMPILERCORE_THREAD_CACHE_ALLOCATOR_H
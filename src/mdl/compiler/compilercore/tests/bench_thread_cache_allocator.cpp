@@ -0,0 +1,121 @@
+/***************************************************************************************************
+ * Copyright (c) 2007-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************************************/
+/// \file
+/// \brief Benchmark of the Thread_cache_allocator against the MallocAllocator.
+///
+/// Usage: mdl-compiler-compilercore-allocator-benchmark [<loads per thread> [<max threads>]]
+///
+/// Every thread repeatedly builds and releases a simulated module: many small AST, type and
+/// symbol sized blocks plus a few large ones, all freed when the module is dropped. The time
+/// per allocator is reported for 1, 2, 4, ... threads.
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#include <mi/base/handle.h>
+
+#include <mdl/compiler/compilercore/compilercore_malloc_allocator.h>
+#include <mdl/compiler/compilercore/compilercore_thread_cache_allocator.h>
+
+using mi::mdl::IAllocator;
+using mi::mdl::MallocAllocator;
+using mi::mdl::Thread_cache_allocator;
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+/// Number of blocks of one simulated module.
+size_t const BLOCKS_PER_MODULE = 20000;
+
+/// Builds and releases \p loads simulated modules.
+void load_modules(IAllocator *alloc, size_t loads, unsigned seed)
+{
+    std::vector<void *> blocks;
+    blocks.reserve(BLOCKS_PER_MODULE);
+
+    for (size_t l = 0; l < loads; ++l) {
+        for (size_t i = 0; i < BLOCKS_PER_MODULE; ++i) {
+            // a cheap LCG, so the benchmark does not measure the random number generator
+            seed = seed * 1664525u + 1013904223u;
+            unsigned r = seed >> 16;
+
+            // mostly small nodes, every 64th block is a large buffer
+            size_t size = (r & 63) == 0 ? 4096 + (r & 4095) : 16 + (r % 240);
+            blocks.push_back(alloc->malloc(size));
+        }
+        for (size_t i = 0, n = blocks.size(); i < n; ++i)
+            alloc->free(blocks[i]);
+        blocks.clear();
+    }
+}
+
+/// Runs \p loads simulated module loads on each of \p n_threads threads, returns the seconds.
+double run(IAllocator *alloc, size_t loads, unsigned n_threads)
+{
+    Clock::time_point start = Clock::now();
+
+    std::vector<std::thread> threads;
+    for (unsigned t = 0; t < n_threads; ++t)
+        threads.push_back(std::thread(load_modules, alloc, loads, t + 1));
+    for (unsigned t = 0; t < n_threads; ++t)
+        threads[t].join();
+
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+    size_t   loads       = argc > 1 ? strtoul(argv[1], 0, 10) : 200;
+    unsigned max_threads = argc > 2 ? unsigned(strtoul(argv[2], 0, 10))
+                                    : std::thread::hardware_concurrency();
+    if (loads == 0) {
+        fprintf(stderr, "Usage: %s [<loads per thread> [<max threads>]]\n", argv[0]);
+        return 1;
+    }
+    if (max_threads == 0)
+        max_threads = 1;
+
+    mi::base::Handle<IAllocator> malloc_alloc(MallocAllocator::create_instance());
+    mi::base::Handle<IAllocator> cache_alloc(Thread_cache_allocator::create_instance());
+
+    printf("%lu loads of %lu blocks per thread:\n",
+        static_cast<unsigned long>(loads), static_cast<unsigned long>(BLOCKS_PER_MODULE));
+    for (unsigned n = 1; n <= max_threads; n *= 2) {
+        double malloc_time = run(malloc_alloc.get(), loads, n);
+        double cache_time  = run(cache_alloc.get(), loads, n);
+        printf("  %2u threads: malloc %8.1f ms, thread cache %8.1f ms\n",
+            n, malloc_time * 1e3, cache_time * 1e3);
+    }
+    return 0;
+}
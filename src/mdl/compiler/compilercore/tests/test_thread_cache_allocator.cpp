@@ -0,0 +1,115 @@
+/***************************************************************************************************
+ * Copyright (c) 2007-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************************************/
+/// \file
+/// \brief Tests for the thread cache slots of the Thread_cache_allocator.
+
+#include <base/system/test/i_test_auto_driver.h>
+
+#include <future>
+#include <thread>
+#include <vector>
+
+#include <mi/base/handle.h>
+
+#include <mdl/compiler/compilercore/compilercore_thread_cache_allocator.h>
+
+using mi::mdl::Thread_cache_allocator;
+
+namespace {
+
+typedef mi::base::Handle<Thread_cache_allocator> Allocator_handle;
+
+/// Allocates and frees a few small blocks.
+void use_allocator(Thread_cache_allocator *alloc)
+{
+    std::vector<void *> blocks;
+    for (size_t size = 8; size <= Thread_cache_allocator::MAX_SMALL_SIZE; size *= 2)
+        blocks.push_back(alloc->malloc(size));
+    for (size_t i = 0, n = blocks.size(); i < n; ++i)
+        alloc->free(blocks[i]);
+}
+
+}
+
+MI_TEST_AUTO_FUNCTION( test_slots_of_destroyed_allocators_are_reused)
+{
+    // many more allocators than slots, one after another
+    for (size_t i = 0; i < 4 * Thread_cache_allocator::MAX_THREAD_SLOTS; ++i) {
+        Allocator_handle alloc( Thread_cache_allocator::create_instance());
+        use_allocator( alloc.get());
+        MI_CHECK( alloc->has_thread_cache());
+    }
+}
+
+MI_TEST_AUTO_FUNCTION( test_slots_are_limited)
+{
+    std::vector<Allocator_handle> allocs;
+    for (size_t i = 0; i < Thread_cache_allocator::MAX_THREAD_SLOTS; ++i) {
+        allocs.push_back( Allocator_handle( Thread_cache_allocator::create_instance()));
+        MI_CHECK( allocs.back()->has_thread_cache());
+    }
+
+    // all slots are used by living allocators, the central lists are used instead
+    Allocator_handle extra( Thread_cache_allocator::create_instance());
+    use_allocator( extra.get());
+    MI_CHECK( !extra->has_thread_cache());
+
+    allocs.pop_back();
+    MI_CHECK( extra->has_thread_cache());
+}
+
+MI_TEST_AUTO_FUNCTION( test_slots_of_allocators_destroyed_on_other_threads)
+{
+    std::vector<Allocator_handle> allocs;
+    for (size_t i = 0; i < Thread_cache_allocator::MAX_THREAD_SLOTS; ++i)
+        allocs.push_back( Allocator_handle( Thread_cache_allocator::create_instance()));
+
+    std::promise<void> used, destroyed;
+    std::future<void>  destroyed_future = destroyed.get_future();
+    bool               has_cache = false;
+
+    std::thread worker( [&]() {
+        for (size_t i = 0, n = allocs.size(); i < n; ++i)
+            use_allocator( allocs[i].get());
+        used.set_value();
+
+        // the allocators are destroyed by the main thread meanwhile
+        destroyed_future.wait();
+
+        Allocator_handle alloc( Thread_cache_allocator::create_instance());
+        use_allocator( alloc.get());
+        has_cache = alloc->has_thread_cache();
+    });
+
+    used.get_future().wait();
+    allocs.clear();
+    destroyed.set_value();
+    worker.join();
+
+    MI_CHECK( has_cache);
+}
@@ -130,6 +130,20 @@ Code_generator_jit::Code_generator_jit(
         MDL_JIT_USE_BUILTIN_RESOURCE_HANDLER_CPU,
         "true",
         "Use built-in resource handler on CPU");
+    m_options.add_option(
+        MDL_JIT_OPTION_SHARE_FUNCTIONS,
+        "false",
+        "Share compiled functions with identical semantic hash between native modules");
+    m_options.add_option(
+        MDL_JIT_OPTION_TIERED_COMPILATION,
+        "false",
+        "Compile native code with full optimizations in the background, if a lower "
+        "optimization level was requested");
+    m_options.add_option(
+        MDL_JIT_OPTION_SHARED_RUNTIME_MODE,
+        "inline",
+        "PTX/HLSL: Emit the shared libbsdf runtime functions inline, as external declarations "
+        "or as a separate runtime part (inline, external or runtime)");
     m_options.add_option(
         MDL_JIT_OPTION_HLSL_USE_RESOURCE_DATA,
         "false",
@@ -1480,12 +1494,13 @@ IGenerated_code_executable *Code_generator_jit::compile_unit(
 {
     if (iunit == NULL)
         return NULL;
+    Link_unit_jit const &unit = *impl_cast<Link_unit_jit>(iunit);
+
+    // an empty unit is only useful to create the shared runtime part
     size_t num_funcs = iunit->get_function_count();
-    if (num_funcs == 0)
+    if (num_funcs == 0 && !unit->emits_shared_runtime())
         return NULL;
 
-    Link_unit_jit const &unit = *impl_cast<Link_unit_jit>(iunit);
-
     IAllocator        *alloc = get_allocator();
     Allocator_builder builder(alloc);
 
@@ -1505,6 +1520,22 @@ IGenerated_code_executable *Code_generator_jit::compile_unit(
             code_obj->get_interface<mi::mdl::Generated_code_lambda_function>());
 
         llvm::Module *module = unit.get_function(0)->getParent();
+
+        // for tiered compilation, keep the module as it was before machine code generation,
+        // which may modify it
+        bool tiered = num_funcs > 0 &&
+            m_options.get_bool_option(MDL_JIT_OPTION_TIERED_COMPILATION) &&
+            m_options.get_int_option(MDL_JIT_OPTION_OPT_LEVEL) < 2;
+        string bitcode(alloc);
+        vector<string>::Type entry_names(alloc);
+        if (tiered) {
+            unit->llvm_bc_compile(module, bitcode);
+            for (size_t i = 0; i < num_funcs; ++i) {
+                llvm::StringRef name(unit.get_function(i)->getName());
+                entry_names.push_back(string(name.data(), name.size(), alloc));
+            }
+        }
+
         MDL_JIT_module_key module_key = unit->jit_compile(module);
         code->set_llvm_module(module_key, module);
         unit->fill_function_info(code.get());
@@ -1515,6 +1546,9 @@ IGenerated_code_executable *Code_generator_jit::compile_unit(
             code->add_entry_point(unit->get_entry_point(module_key, func));
         }
 
+        if (tiered)
+            code->enable_tiered_compilation(bitcode, entry_names);
+
         // copy the render state usage
         code->set_render_state_usage(unit->get_render_state_usage());
 
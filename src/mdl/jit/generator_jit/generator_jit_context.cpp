@@ -2169,6 +2169,9 @@ llvm::BasicBlock *Function_context::get_unreachable_bb()
 // Register a resource value and return its index.
 size_t Function_context::get_resource_index(mi::mdl::IValue_resource const *resource)
 {
+    // resource indices are specific to the current module
+    m_code_gen.mark_function_unshareable(m_function);
+
     int tag_value = resource->get_tag_value();
     if (tag_value == 0) {
         tag_value = m_code_gen.find_resource_tag(resource);
@@ -28,12 +28,22 @@
 
 #include "pch.h"
 
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
 #include <mdl/compiler/compilercore/compilercore_errors.h>
 #include <mdl/compiler/compilercore/compilercore_mdl.h>
 #include <mdl/compiler/compilercore/compilercore_printers.h>
 #include <mdl/compiler/compilercore/compilercore_tools.h>
 
+#include <llvm/Bitcode/BitcodeReader.h>
+#include <llvm/IR/Constants.h>
+#include <llvm/IR/LLVMContext.h>
 #include <llvm/IR/Module.h>
+#include <llvm/Support/MemoryBuffer.h>
 
 #include "generator_jit.h"
 #include "generator_jit_code_printer.h"
@@ -1210,6 +1220,98 @@ void Generated_code_source::Source_res_manag::import_resource_attribute_map(
     }
 }
 
+// --------------------------- Tiered_compilation_queue ----------------------------
+
+/// Runs the tiered compilations of all lambda functions on a bounded number of threads.
+///
+/// The threads are started on demand and end when the queue is empty.
+class Tiered_compilation_queue
+{
+public:
+    /// Get the only instance.
+    static Tiered_compilation_queue &get_instance()
+    {
+        static Tiered_compilation_queue queue;
+        return queue;
+    }
+
+    /// Queue the tiered compilation of a lambda function.
+    void enqueue(Generated_code_lambda_function *code)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        m_queue.push_back(code);
+        if (m_num_threads < m_max_threads) {
+            ++m_num_threads;
+            std::thread(&Tiered_compilation_queue::work, this).detach();
+        }
+    }
+
+    /// Remove a lambda function from the queue or wait until its running tiered compilation
+    /// has stopped.
+    void remove(Generated_code_lambda_function *code)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+
+        std::deque<Generated_code_lambda_function *>::iterator it =
+            std::find(m_queue.begin(), m_queue.end(), code);
+        if (it != m_queue.end()) {
+            m_queue.erase(it);
+            return;
+        }
+        m_done.wait(lock, [this, code]() {
+            return std::find(m_running.begin(), m_running.end(), code) == m_running.end();
+        });
+    }
+
+private:
+    /// Constructor.
+    Tiered_compilation_queue()
+    : m_max_threads(std::max(1u, std::thread::hardware_concurrency() / 4))
+    , m_num_threads(0)
+    {
+    }
+
+    /// The thread function, runs queued compilations until the queue is empty.
+    void work()
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+
+        while (!m_queue.empty()) {
+            Generated_code_lambda_function *code = m_queue.front();
+            m_queue.pop_front();
+            m_running.push_back(code);
+
+            lock.unlock();
+            code->run_tiered_compilation();
+            lock.lock();
+
+            m_running.erase(std::find(m_running.begin(), m_running.end(), code));
+            m_done.notify_all();
+        }
+        --m_num_threads;
+    }
+
+private:
+    /// Protects all members.
+    std::mutex m_mutex;
+
+    /// Signaled when a compilation has finished.
+    std::condition_variable m_done;
+
+    /// The queued lambda functions.
+    std::deque<Generated_code_lambda_function *> m_queue;
+
+    /// The lambda functions currently compiled.
+    std::vector<Generated_code_lambda_function *> m_running;
+
+    /// The maximum number of compilation threads.
+    unsigned m_max_threads;
+
+    /// The number of running compilation threads.
+    unsigned m_num_threads;
+};
+
 // --------------------------- Generated_code_lambda_function ----------------------------
 
 // Constructor.
@@ -1221,6 +1323,17 @@ Generated_code_lambda_function::Generated_code_lambda_function(
 , m_module(NULL)
 , m_module_key(0)
 , m_jitted_funcs(get_allocator())
+, m_entry_points(NULL)
+, m_tiered_state(TS_NONE)
+, m_tiered_calls()
+, m_tiered_funcs(get_allocator())
+, m_tiered_bitcode(get_allocator())
+, m_tiered_entry_names(get_allocator())
+, m_tiered_context(NULL)
+, m_tiered_module_key(0)
+, m_has_tiered_module(false)
+, m_tiered_cancel(false)
+, m_tiered_error(get_allocator())
 , m_res_entries(get_allocator())
 , m_string_entries(get_allocator())
 , m_messages(get_allocator(), "<lambda expression>")
@@ -1240,6 +1353,17 @@ Generated_code_lambda_function::Generated_code_lambda_function(
 // Destructor.
 Generated_code_lambda_function::~Generated_code_lambda_function()
 {
+    if (m_tiered_state.load() != TS_NONE) {
+        m_tiered_cancel = true;
+        Tiered_compilation_queue::get_instance().remove(this);
+    }
+
+    // the optimized module may use shared functions kept alive by the original module,
+    // so remove it first
+    if (m_has_tiered_module)
+        m_jitted_code->delete_llvm_module(m_tiered_module_key);
+    delete m_tiered_context;
+
     if (m_ro_segment) {
         IAllocator *alloc = m_jitted_code->get_allocator();
 
@@ -1428,7 +1552,7 @@ bool Generated_code_lambda_function::run_environment(
         Res_data_pair pair(m_res_data, tex_data);
 
         if (setjmp(exc.env) == 0) {
-            Env_func *env_func = reinterpret_cast<Env_func *>(m_jitted_funcs[index]);
+            Env_func *env_func = reinterpret_cast<Env_func *>(get_entry_point(index));
             env_func(result, state, pair, exc, NULL);
             return true;
         }
@@ -1447,7 +1571,7 @@ bool Generated_code_lambda_function::run(bool &result)
         Res_data_pair pair(m_res_data, NULL);
 
         if (setjmp(exc.env) == 0) {
-            Lambda_func_bool *bool_func = reinterpret_cast<Lambda_func_bool *>(m_jitted_funcs[0]);
+            Lambda_func_bool *bool_func = reinterpret_cast<Lambda_func_bool *>(get_entry_point(0));
             bool_func(result, pair, exc, NULL);
             return true;
         }
@@ -1463,7 +1587,7 @@ bool Generated_code_lambda_function::run(int &result)
         Res_data_pair pair(m_res_data, NULL);
 
         if (setjmp(exc.env) == 0) {
-            Lambda_func_int *int_func = reinterpret_cast<Lambda_func_int *>(m_jitted_funcs[0]);
+            Lambda_func_int *int_func = reinterpret_cast<Lambda_func_int *>(get_entry_point(0));
             int_func(result, pair, exc, NULL);
             return true;
         }
@@ -1480,7 +1604,7 @@ bool Generated_code_lambda_function::run(unsigned &result)
 
         if (setjmp(exc.env) == 0) {
             Lambda_func_unsigned *unsigned_func =
-                reinterpret_cast<Lambda_func_unsigned *>(m_jitted_funcs[0]);
+                reinterpret_cast<Lambda_func_unsigned *>(get_entry_point(0));
             unsigned_func(result, pair, exc, NULL);
             return true;
         }
@@ -1497,7 +1621,7 @@ bool Generated_code_lambda_function::run(float &result)
 
         if (setjmp(exc.env) == 0) {
             Lambda_func_float *float_func =
-                reinterpret_cast<Lambda_func_float *>(m_jitted_funcs[0]);
+                reinterpret_cast<Lambda_func_float *>(get_entry_point(0));
             float_func(result, pair, exc, NULL);
             return true;
         }
@@ -1514,7 +1638,7 @@ bool Generated_code_lambda_function::run(Float2_struct &result)
 
         if (setjmp(exc.env) == 0) {
             Lambda_func_float2 *float2_func =
-                reinterpret_cast<Lambda_func_float2 *>(m_jitted_funcs[0]);
+                reinterpret_cast<Lambda_func_float2 *>(get_entry_point(0));
             float2_func(result, pair, exc, NULL);
             return true;
         }
@@ -1531,7 +1655,7 @@ bool Generated_code_lambda_function::run(Float3_struct &result)
 
         if (setjmp(exc.env) == 0) {
             Lambda_func_float3 *float3_func =
-                reinterpret_cast<Lambda_func_float3 *>(m_jitted_funcs[0]);
+                reinterpret_cast<Lambda_func_float3 *>(get_entry_point(0));
             float3_func(result, pair, exc, NULL);
             return true;
         }
@@ -1548,7 +1672,7 @@ bool Generated_code_lambda_function::run(Float4_struct &result)
 
         if (setjmp(exc.env) == 0) {
             Lambda_func_float4 *float4_func =
-                reinterpret_cast<Lambda_func_float4 *>(m_jitted_funcs[0]);
+                reinterpret_cast<Lambda_func_float4 *>(get_entry_point(0));
             float4_func(result, pair, exc, NULL);
             return true;
         }
@@ -1565,7 +1689,7 @@ bool Generated_code_lambda_function::run(Matrix3x3_struct &result)
 
         if (setjmp(exc.env) == 0) {
             Lambda_func_float3x3 *float3x3_func =
-                reinterpret_cast<Lambda_func_float3x3 *>(m_jitted_funcs[0]);
+                reinterpret_cast<Lambda_func_float3x3 *>(get_entry_point(0));
             float3x3_func(result, pair, exc, NULL);
             return true;
         }
@@ -1582,7 +1706,7 @@ bool Generated_code_lambda_function::run(Matrix4x4_struct &result)
 
         if (setjmp(exc.env) == 0) {
             Lambda_func_float4x4 *float4x4_func =
-                reinterpret_cast<Lambda_func_float4x4 *>(m_jitted_funcs[0]);
+                reinterpret_cast<Lambda_func_float4x4 *>(get_entry_point(0));
             float4x4_func(result, pair, exc, NULL);
             return true;
         }
@@ -1599,7 +1723,7 @@ bool Generated_code_lambda_function::run(char const *&result)
 
         if (setjmp(exc.env) == 0) {
             Lambda_func_string *string_func =
-                reinterpret_cast<Lambda_func_string *>(m_jitted_funcs[0]);
+                reinterpret_cast<Lambda_func_string *>(get_entry_point(0));
             string_func(result, pair, exc, NULL);
             return true;
         }
@@ -1620,7 +1744,7 @@ bool Generated_code_lambda_function::run_core(
         Res_data_pair pair(m_res_data, tex_data);
 
         if (setjmp(exc.env) == 0) {
-            Core_func *core_func = reinterpret_cast<Core_func *>(m_jitted_funcs[0]);
+            Core_func *core_func = reinterpret_cast<Core_func *>(get_entry_point(0));
             return core_func(state, pair, exc, cap_args, result, proj);
         }
     }
@@ -1640,7 +1764,7 @@ bool Generated_code_lambda_function::run_generic(
         Res_data_pair pair(m_res_data, tex_data);
 
         if (setjmp(exc.env) == 0) {
-            Gen_func *gen_func = reinterpret_cast<Gen_func *>(m_jitted_funcs[index]);
+            Gen_func *gen_func = reinterpret_cast<Gen_func *>(get_entry_point(index));
             gen_func(result, state, pair, exc, cap_args);
             return true;
         }
@@ -1660,7 +1784,7 @@ bool Generated_code_lambda_function::run_init(
         Res_data_pair pair(m_res_data, tex_data);
 
         if (setjmp(exc.env) == 0) {
-            Init_func *init_func = reinterpret_cast<Init_func *>(m_jitted_funcs[index]);
+            Init_func *init_func = reinterpret_cast<Init_func *>(get_entry_point(index));
             init_func(state, pair, exc, cap_args);
             return true;
         }
@@ -1719,7 +1843,161 @@ void Generated_code_lambda_function::add_mapped_string(char const *s, size_t id)
 // Set the entry point the the JIT compiled function.
 void Generated_code_lambda_function::add_entry_point(void *address)
 {
+    MDL_ASSERT(m_tiered_state.load() == TS_NONE && "entry points added after enabling tiering");
+
     m_jitted_funcs.push_back(reinterpret_cast<Jitted_func *>(address));
+    m_entry_points.store(m_jitted_funcs.data(), std::memory_order_release);
+}
+
+// Enable compiling the hot entry points again with full optimizations.
+void Generated_code_lambda_function::enable_tiered_compilation(
+    string const               &bitcode,
+    vector<string>::Type const &entry_names)
+{
+    MDL_ASSERT(
+        m_tiered_state.load() == TS_NONE && entry_names.size() == m_jitted_funcs.size());
+
+    m_tiered_bitcode = bitcode;
+    m_tiered_entry_names = entry_names;
+    m_tiered_calls.reset(new std::atomic<unsigned>[entry_names.size()]());
+    m_tiered_state.store(TS_WAITING);
+}
+
+// Get the state of the tiered compilation.
+Generated_code_lambda_function::Tiered_state Generated_code_lambda_function::get_tiered_state(
+    char const **error) const
+{
+    Tiered_state state = Tiered_state(m_tiered_state.load(std::memory_order_acquire));
+    if (error != NULL)
+        *error = state == TS_FAILED ? m_tiered_error.c_str() : NULL;
+    return state;
+}
+
+// Count a call of the entry point with the given index and queue the tiered compilation
+// once it is hot.
+void Generated_code_lambda_function::count_tiered_call(size_t index) const
+{
+    if (m_tiered_calls[index].fetch_add(1, std::memory_order_relaxed) + 1 != TIERED_HOT_CALLS)
+        return;
+
+    int expected = TS_WAITING;
+    if (m_tiered_state.compare_exchange_strong(expected, TS_QUEUED)) {
+        Tiered_compilation_queue::get_instance().enqueue(
+            const_cast<Generated_code_lambda_function *>(this));
+    }
+}
+
+// Compile the hot entry points with full optimizations, runs on a tiered compilation thread.
+void Generated_code_lambda_function::run_tiered_compilation()
+{
+    char const *error = compile_tiered_module();
+
+    // the tiered module is not needed anymore once its code is generated
+    string(get_allocator()).swap(m_tiered_bitcode);
+
+    if (error != NULL) {
+        // keep the baseline code
+        m_tiered_error = error;
+        m_tiered_state.store(TS_FAILED, std::memory_order_release);
+    } else if (!m_tiered_cancel) {
+        // switch all entry points at once, running functions finish on the old code,
+        // which stays alive as long as this object
+        m_entry_points.store(m_tiered_funcs.data(), std::memory_order_release);
+        m_tiered_state.store(TS_FINISHED, std::memory_order_release);
+    }
+}
+
+// Compile the hot entry points with full optimizations.
+char const *Generated_code_lambda_function::compile_tiered_module()
+{
+    m_tiered_context = new llvm::LLVMContext();
+
+    std::unique_ptr<llvm::Module> module;
+    {
+        std::unique_ptr<llvm::MemoryBuffer> mem(llvm::MemoryBuffer::getMemBuffer(
+            llvm::StringRef(m_tiered_bitcode.c_str(), m_tiered_bitcode.size()),
+            "tiered",
+            /*RequiresNullTerminator=*/ false));
+
+        auto mod = llvm::parseBitcodeFile(*mem.get(), *m_tiered_context);
+        if (!mod) {
+            llvm::consumeError(mod.takeError());
+            return "parsing the bitcode failed";
+        }
+        module = std::move(mod.get());
+    }
+
+    if (m_tiered_cancel)
+        return NULL;
+
+    // Only the hot entry points stay visible: the optimizer may drop whatever it inlined, and
+    // functions shared with other modules are still resolved to the original module.
+    // The entry points are renamed, so symbol lookups never find them instead of the
+    // original ones.
+    for (llvm::Function &func : module->functions()) {
+        if (!func.isDeclaration())
+            func.setLinkage(llvm::GlobalValue::InternalLinkage);
+    }
+
+    // Constants may be duplicated, but all other globals must be those of the original module,
+    // so replace them by the addresses of the original ones.
+    std::vector<llvm::GlobalVariable *> vars;
+    for (llvm::GlobalVariable &var : module->globals()) {
+        if (!var.isDeclaration() && !var.isConstant() && !var.getName().startswith("llvm."))
+            vars.push_back(&var);
+    }
+    llvm::Type *int_ptr_type = llvm::Type::getIntNTy(*m_tiered_context, 8 * sizeof(void *));
+    for (size_t i = 0, n = vars.size(); i < n; ++i) {
+        llvm::GlobalVariable *var = vars[i];
+        void *address = var->hasLocalLinkage() ?
+            NULL : m_jitted_code->get_function_address(m_module_key, var->getName());
+        if (address == NULL)
+            return "a global variable of the module cannot be shared";
+
+        var->replaceAllUsesWith(llvm::ConstantExpr::getIntToPtr(
+            llvm::ConstantInt::get(int_ptr_type, uint64_t(address)), var->getType()));
+        var->eraseFromParent();
+    }
+
+    std::vector<std::string> names(m_tiered_entry_names.size());
+    for (size_t i = 0, n = m_tiered_entry_names.size(); i < n; ++i) {
+        if (m_tiered_calls[i].load(std::memory_order_relaxed) == 0)
+            continue;
+
+        llvm::Function *func = module->getFunction(m_tiered_entry_names[i].c_str());
+        if (func == NULL || func->isDeclaration())
+            return "an entry point is missing in the bitcode";
+        func->setLinkage(llvm::GlobalValue::ExternalLinkage);
+        func->setName(func->getName() + "_tiered");
+        names[i] = func->getName().str();
+    }
+
+    if (m_tiered_cancel)
+        return NULL;
+
+    Jitted_code::optimize_llvm_module(module.get());
+
+    if (m_tiered_cancel)
+        return NULL;
+
+    m_tiered_module_key = m_jitted_code->add_llvm_module(
+        module.release(), llvm::CodeGenOpt::Aggressive);
+    m_has_tiered_module = true;
+
+    if (m_tiered_cancel)
+        return NULL;
+
+    m_tiered_funcs = m_jitted_funcs;
+    for (size_t i = 0, n = names.size(); i < n; ++i) {
+        if (names[i].empty())
+            continue;
+
+        void *address = m_jitted_code->get_function_address(m_tiered_module_key, names[i]);
+        if (address == NULL)
+            return "the code of an entry point was not generated";
+        m_tiered_funcs[i] = reinterpret_cast<Jitted_func *>(address);
+    }
+    return NULL;
 }
 
 // Set the Read-Only data segment.
@@ -29,7 +29,9 @@
 #ifndef MDL_GENERATOR_JIT_GENERATED_CODE
 #define MDL_GENERATOR_JIT_GENERATED_CODE 1
 
+#include <atomic>
 #include <csetjmp>
+#include <memory>
 
 #include <mi/base/atom.h>
 #include <mi/base/handle.h>
@@ -53,6 +55,7 @@ namespace mi {
 namespace mdl {
 
 class LLVM_code_generator;
+class Tiered_compilation_queue;
 
 using MDL_JIT_module_key = uint64_t;
 
@@ -721,6 +724,7 @@ class Generated_code_lambda_function :
 {
     typedef Generated_code_executable_base<IGenerated_code_lambda_function> Base;
     friend class Allocator_builder;
+    friend class Tiered_compilation_queue;
 
     /// Helper value class to handle resource entries.
     class Resource_entry {
@@ -1180,6 +1184,32 @@ public:
     /// \param address  the function address
     void add_entry_point(void *address);
 
+    /// The states of the tiered compilation.
+    enum Tiered_state {
+        TS_NONE,      ///< No tiered compilation was requested.
+        TS_WAITING,   ///< Waiting until an entry point is hot.
+        TS_QUEUED,    ///< Queued or running on a tiered compilation thread.
+        TS_FINISHED,  ///< The hot entry points use the fully optimized code.
+        TS_FAILED     ///< The tiered compilation failed, the baseline code stays in use.
+    };
+
+    /// Enable compiling the hot entry points again with full optimizations.
+    ///
+    /// Once an entry point has been called TIERED_HOT_CALLS times, all entry points called so
+    /// far are compiled again on a tiered compilation thread. They stay in use until the
+    /// optimized code is ready. Then all of them are replaced at once.
+    ///
+    /// \param bitcode      the LLVM bitcode of the module before machine code generation
+    /// \param entry_names  the names of the entry point functions in the order of the entry points
+    void enable_tiered_compilation(
+        string const               &bitcode,
+        vector<string>::Type const &entry_names);
+
+    /// Get the state of the tiered compilation.
+    ///
+    /// \param[out] error  if non-NULL, receives the reason of a failure or NULL
+    Tiered_state get_tiered_state(char const **error = NULL) const;
+
     /// Set the Read-Only data segment.
     void set_ro_segment(char const *data, size_t size);
 
@@ -1226,6 +1256,18 @@ private:
     size_t register_string(
         char const *s);
 
+    /// Count a call of the entry point with the given index and queue the tiered compilation
+    /// once it is hot.
+    void count_tiered_call(size_t index) const;
+
+    /// Compile the hot entry points with full optimizations, runs on a tiered compilation thread.
+    void run_tiered_compilation();
+
+    /// Compile the hot entry points with full optimizations.
+    ///
+    /// \returns NULL on success or if canceled, otherwise the reason of the failure
+    char const *compile_tiered_module();
+
 private:
     /// Constructor.
     ///
@@ -1438,6 +1480,51 @@ private:
     /// The list of JIT compiled functions.
     mi::mdl::vector<Jitted_func *>::Type m_jitted_funcs;
 
+    /// The entry points used by the run methods, either those of m_jitted_funcs or
+    /// of m_tiered_funcs.
+    std::atomic<Jitted_func * const *> m_entry_points;
+
+    /// Get the entry point with the given index.
+    Jitted_func *get_entry_point(size_t index) const {
+        if (m_tiered_state.load(std::memory_order_relaxed) == TS_WAITING)
+            count_tiered_call(index);
+        return m_entry_points.load(std::memory_order_acquire)[index];
+    }
+
+    /// The number of calls after which an entry point is hot.
+    static unsigned const TIERED_HOT_CALLS = 1024;
+
+    /// The state of the tiered compilation, a Tiered_state.
+    mutable std::atomic<int> m_tiered_state;
+
+    /// The number of calls of each entry point while waiting for a hot one.
+    std::unique_ptr<std::atomic<unsigned>[]> m_tiered_calls;
+
+    /// The entry points used after the tiered compilation, the fully optimized code for the
+    /// hot ones and the baseline code for the others.
+    mi::mdl::vector<Jitted_func *>::Type m_tiered_funcs;
+
+    /// The bitcode of the module to compile with full optimizations.
+    string m_tiered_bitcode;
+
+    /// The names of the entry point functions in the bitcode.
+    vector<string>::Type m_tiered_entry_names;
+
+    /// The LLVM context of the fully optimized module.
+    llvm::LLVMContext *m_tiered_context;
+
+    /// The JIT module key of the fully optimized module, if m_has_tiered_module is set.
+    MDL_JIT_module_key m_tiered_module_key;
+
+    /// True, if the fully optimized module was added to the JIT.
+    bool m_has_tiered_module;
+
+    /// If set, the tiered compilation stops as soon as possible.
+    std::atomic<bool> m_tiered_cancel;
+
+    /// The reason of a failed tiered compilation.
+    string m_tiered_error;
+
     /// Collected resource entries used for the IResource_handler interface
     mi::mdl::vector<Resource_entry>::Type m_res_entries;
 
@@ -125,8 +125,13 @@ bool HLSLWriterPass::runOnModule(llvm::Module &M)
     // create definitions for all user defined functions, so we can create a call graph
     // on the fly
     for (llvm::Function &func : M.functions()) {
-        if (func.isDeclaration())
+        if (func.isDeclaration()) {
+            // functions of the shared runtime part are defined elsewhere, but need a prototype
+            if (func.getName().startswith(
+                    mi::mdl::LLVM_code_generator::get_shared_runtime_prefix()))
+                create_prototype(create_definition(&func));
             continue;
+        }
 
         create_definition(&func);
     }
@@ -241,6 +246,11 @@ hlsl::Def_function *HLSLWriterPass::create_definition(llvm::Function *func)
 
     llvm::SmallVector<hlsl::Type_function::Parameter, 8> params;
 
+    // the signature of shared runtime functions must not depend on the optimization of the
+    // current module
+    bool is_shared_runtime = func->getName().startswith(
+        mi::mdl::LLVM_code_generator::get_shared_runtime_prefix());
+
     if (hlsl::is<hlsl::Type_array>(ret_type)) {
         // HLSL does not support returning arrays, turn into an out parameter
         out_type = ret_type;
@@ -266,7 +276,7 @@ hlsl::Def_function *HLSLWriterPass::create_definition(llvm::Function *func)
             if (arg_it.hasStructRetAttr()) {
                 // the sret attribute marks "return" values, so OUT is enough
                 param_mod = hlsl::Type_function::Parameter::PM_OUT;
-            } else if (arg_it.onlyReadsMemory()) {
+            } else if (arg_it.onlyReadsMemory() && !is_shared_runtime) {
                 // can be safely passed as an IN attribute IF noalias
                 param_mod = hlsl::Type_function::Parameter::PM_IN;
             } else {
@@ -290,6 +300,48 @@ hlsl::Def_function *HLSLWriterPass::create_definition(llvm::Function *func)
     return func_def;
 }
 
+// Create the prototype for a function defined in the shared runtime part.
+void HLSLWriterPass::create_prototype(hlsl::Def_function *func_def)
+{
+    hlsl::Type_function  *func_type     = func_def->get_type();
+    hlsl::Type_name      *ret_type_name = get_type_name(func_type->get_return_type());
+    hlsl::Name           *func_name     = get_name(zero_loc, func_def->get_symbol());
+    Declaration_function *decl_func     = m_decl_factory.create_function(
+        ret_type_name, func_name);
+
+    func_def->set_declaration(decl_func);
+    func_name->set_definition(func_def);
+
+    for (size_t i = 0, n = func_type->get_parameter_count(); i < n; ++i) {
+        hlsl::Type_function::Parameter *param = func_type->get_parameter(i);
+        hlsl::Type                     *param_type = param->get_type();
+
+        hlsl::Type_name         *param_type_name = get_type_name(param_type);
+        hlsl::Declaration_param *decl_param = m_decl_factory.create_param(param_type_name);
+        add_array_specifiers(decl_param, param_type);
+
+        hlsl::Parameter_qualifier param_qualifier = hlsl::PQ_NONE;
+        switch (param->get_modifier()) {
+        case hlsl::Type_function::Parameter::PM_IN:
+            param_qualifier = hlsl::PQ_IN;
+            break;
+        case hlsl::Type_function::Parameter::PM_OUT:
+            param_qualifier = hlsl::PQ_OUT;
+            break;
+        case hlsl::Type_function::Parameter::PM_INOUT:
+            param_qualifier = hlsl::PQ_INOUT;
+            break;
+        }
+        param_type_name->get_qualifier().set_parameter_qualifier(param_qualifier);
+
+        char name[16];
+        snprintf(name, sizeof(name), "p_%u", unsigned(i));
+        decl_param->set_name(get_name(zero_loc, name));
+
+        decl_func->add_param(decl_param);
+    }
+}
+
 // Get the definition for a LLVM function, if one exists.
 hlsl::Def_function *HLSLWriterPass::get_definition(llvm::Function *func)
 {
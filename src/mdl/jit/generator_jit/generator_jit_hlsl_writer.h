@@ -151,6 +151,9 @@ private:
     /// Create the HLSL definition for a user defined LLVM function.
     hlsl::Def_function *create_definition(llvm::Function * func);
 
+    /// Create the prototype for a function defined in the shared runtime part.
+    void create_prototype(hlsl::Def_function *func_def);
+
     /// Get the definition for a LLVM function, if one exists.
     hlsl::Def_function *get_definition(llvm::Function * func);
 
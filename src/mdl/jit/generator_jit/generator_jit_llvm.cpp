@@ -80,6 +80,7 @@
 #include "mdl/compiler/compilercore/compilercore_bitset.h"
 #include "mdl/compiler/compilercore/compilercore_cc_conf.h"
 #include "mdl/compiler/compilercore/compilercore_errors.h"
+#include "mdl/compiler/compilercore/compilercore_hash.h"
 #include "mdl/compiler/compilercore/compilercore_tools.h"
 #include "mdl/compiler/compilercore/compilercore_visitor.h"
 #include "mdl/codegenerators/generator_dag/generator_dag_derivatives.h"
@@ -224,11 +225,21 @@ public:
     llvm::DataLayout const &get_data_layout() const { return m_data_layout; }
 
     /// Add an LLVM module to the JIT and get its module key.
-    MDL_JIT_module_key add_module(std::unique_ptr<llvm::Module> module) {
+    ///
+    /// \param module     the LLVM module
+    /// \param opt_level  the optimization level of the machine code generation
+    MDL_JIT_module_key add_module(
+        std::unique_ptr<llvm::Module> module,
+        llvm::CodeGenOpt::Level       opt_level)
+    {
         MDL_ASSERT(!module->getDataLayout().isDefault() && "No data layout was set for module");
 
         llvm::MutexGuard locked(m_lock);
 
+        // The module is compiled immediately by the compile layer, so switching the level of
+        // the shared target machine under the lock affects only this module.
+        m_target_machine->setOptLevel(opt_level);
+
         // Add the module to the JIT with a new VModuleKey.
         auto K = m_execution_session.allocateVModule();
         llvm::cantFail(m_compile_layer.addModule(K, std::move(module)));
@@ -259,6 +270,19 @@ public:
         return addr.get();
     }
 
+    /// Get the address for a symbol name in the given module, 0 if it cannot be found.
+    llvm::JITTargetAddress get_symbol_address_in(
+        MDL_JIT_module_key K,
+        const llvm::Twine &name)
+    {
+        llvm::Expected<uint64_t> addr = find_symbol_in(K, name).getAddress();
+        if (!addr) {
+            llvm::consumeError(addr.takeError());
+            return llvm::JITTargetAddress(0);
+        }
+        return addr.get();
+    }
+
     /// Remove the given module.
     void remove_module(MDL_JIT_module_key key) {
         llvm::MutexGuard locked(m_lock);
@@ -301,6 +325,10 @@ Jitted_code::Jitted_code(mi::mdl::IAllocator *alloc)
 : Base(alloc)
 , m_llvm_context(new llvm::LLVMContext())
 , m_mdl_jit(NULL)
+, m_shared_lock()
+, m_next_shared_module_id(0)
+, m_shared_functions()
+, m_shared_modules()
 {
     llvm::TargetOptions target_options;
 
@@ -388,15 +416,127 @@ llvm::DataLayout Jitted_code::get_layout_data() const
 }
 
 // Helper: add this LLVM module to the execution engine.
-MDL_JIT_module_key Jitted_code::add_llvm_module(llvm::Module *llvm_module)
+MDL_JIT_module_key Jitted_code::add_llvm_module(
+    llvm::Module            *llvm_module,
+    llvm::CodeGenOpt::Level opt_level)
 {
-    return m_mdl_jit->add_module(std::unique_ptr<llvm::Module>(llvm_module));
+    return m_mdl_jit->add_module(std::unique_ptr<llvm::Module>(llvm_module), opt_level);
 }
 
 // Helper: remove this module from the execution engine and delete it.
 void Jitted_code::delete_llvm_module(MDL_JIT_module_key module_key)
 {
+    mi::base::Lock::Block block(&m_shared_lock);
+
+    Shared_module_map::iterator it(m_shared_modules.find(module_key));
+    if (it != m_shared_modules.end() && it->second.m_ref_count > 0) {
+        // still used by other modules: stop exporting its functions and remove it later
+        Shared_module_info &info = it->second;
+        for (size_t i = 0, n = info.m_exports.size(); i < n; ++i) {
+            m_shared_functions.erase(info.m_exports[i]);
+        }
+        info.m_exports.clear();
+        info.m_is_deleted = true;
+        return;
+    }
+    remove_shared_module(module_key);
+}
+
+// Get a new ID used to create unique symbol names for shared functions of a module.
+unsigned Jitted_code::get_next_shared_module_id()
+{
+    mi::base::Lock::Block block(&m_shared_lock);
+
+    return m_next_shared_module_id++;
+}
+
+// Look up a shared function and keep the module exporting it alive.
+bool Jitted_code::acquire_shared_function(
+    char const         *name,
+    std::string        &symbol,
+    MDL_JIT_module_key &module_key)
+{
+    mi::base::Lock::Block block(&m_shared_lock);
+
+    Shared_function_map::const_iterator it(m_shared_functions.find(name));
+    if (it == m_shared_functions.end())
+        return false;
+
+    symbol     = it->second.first;
+    module_key = it->second.second;
+    ++m_shared_modules[module_key].m_ref_count;
+    return true;
+}
+
+// Register the shared functions exported by a module and the modules it depends on.
+void Jitted_code::register_shared_module(
+    MDL_JIT_module_key         module_key,
+    Shared_function_list const &exports,
+    Module_key_list const      &deps)
+{
+    if (exports.empty() && deps.empty())
+        return;
+
+    mi::base::Lock::Block block(&m_shared_lock);
+
+    Shared_module_info &info = m_shared_modules[module_key];
+    info.m_deps.insert(info.m_deps.end(), deps.begin(), deps.end());
+
+    for (size_t i = 0, n = exports.size(); i < n; ++i) {
+        std::string const &name = exports[i].first;
+
+        // the first module exporting a function wins
+        if (m_shared_functions.insert(
+            std::make_pair(name, std::make_pair(exports[i].second, module_key))).second)
+        {
+            info.m_exports.push_back(name);
+        }
+    }
+}
+
+// Release modules acquired by acquire_shared_function().
+void Jitted_code::release_shared_modules(Module_key_list const &deps)
+{
+    if (deps.empty())
+        return;
+
+    mi::base::Lock::Block block(&m_shared_lock);
+
+    release_shared_modules_locked(deps);
+}
+
+// Remove a module from the execution engine and release its dependencies.
+void Jitted_code::remove_shared_module(MDL_JIT_module_key module_key)
+{
+    Module_key_list deps;
+
+    Shared_module_map::iterator it(m_shared_modules.find(module_key));
+    if (it != m_shared_modules.end()) {
+        Shared_module_info &info = it->second;
+        for (size_t i = 0, n = info.m_exports.size(); i < n; ++i) {
+            m_shared_functions.erase(info.m_exports[i]);
+        }
+        deps.swap(info.m_deps);
+        m_shared_modules.erase(it);
+    }
+
     m_mdl_jit->remove_module(module_key);
+
+    release_shared_modules_locked(deps);
+}
+
+// Release the given modules.
+void Jitted_code::release_shared_modules_locked(Module_key_list const &deps)
+{
+    for (size_t i = 0, n = deps.size(); i < n; ++i) {
+        Shared_module_map::iterator it(m_shared_modules.find(deps[i]));
+        MDL_ASSERT(it != m_shared_modules.end() && it->second.m_ref_count > 0);
+        if (it == m_shared_modules.end())
+            continue;
+
+        if (--it->second.m_ref_count == 0 && it->second.m_is_deleted)
+            remove_shared_module(deps[i]);
+    }
 }
 
 // JIT compile the given LLVM function.
@@ -408,6 +548,27 @@ void *Jitted_code::jit_compile(
     return (void *)(m_mdl_jit->get_symbol_address_in(module_key, func->getName(), code_gen));
 }
 
+// Optimize this LLVM module with full optimizations.
+void Jitted_code::optimize_llvm_module(llvm::Module *llvm_module)
+{
+    // same pipeline as LLVM_code_generator::optimize() for native code at level 2
+    llvm::PassManagerBuilder builder;
+    builder.OptLevel = 2;
+    builder.Inliner = llvm::createFunctionInliningPass();
+
+    llvm::legacy::PassManager mpm;
+    builder.populateModulePassManager(mpm);
+    mpm.run(*llvm_module);
+}
+
+// Get the address of a function or global variable in a module added to the execution engine.
+void *Jitted_code::get_function_address(
+    MDL_JIT_module_key    module_key,
+    llvm::StringRef const &name)
+{
+    return (void *)(m_mdl_jit->get_symbol_address_in(module_key, name));
+}
+
 // ----------------------------- Internal_function class -----------------------------
 
 // Constructor for an internal function.
@@ -1062,6 +1223,7 @@ LLVM_code_generator::LLVM_code_generator(
 , m_optix_cp_from_id(NULL)
 , m_captured_args_mdl_types(get_allocator())
 , m_captured_args_type(NULL)
+, m_lambda_cache(0, Lambda_cache::hasher(), Lambda_cache::key_equal(), get_allocator())
 , m_hlsl_func_argblock_as_int(NULL)
 , m_hlsl_func_argblock_as_uint(NULL)
 , m_hlsl_func_argblock_as_float(NULL)
@@ -1122,6 +1284,10 @@ LLVM_code_generator::LLVM_code_generator(
     Instantiated_dfs(get_allocator()),
     get_allocator())
 , m_libbsdf_template_funcs(get_allocator())
+, m_libbsdf_runtime_funcs(get_allocator())
+, m_shared_runtime_mode(target_lang == TL_NATIVE || m_texruntime_with_derivs
+    ? SRM_INLINE
+    : parse_shared_runtime_mode(options.get_string_option(MDL_JIT_OPTION_SHARED_RUNTIME_MODE)))
 , m_enable_auxiliary(options.get_bool_option(MDL_JIT_OPTION_ENABLE_AUXILIARY))
 , m_module_lambda_funcs(get_allocator())
 , m_module_lambda_index_map(get_allocator())
@@ -1171,6 +1337,14 @@ LLVM_code_generator::LLVM_code_generator(
 , m_int_func_df_light_profile_sample(NULL)
 , m_int_func_df_light_profile_pdf(NULL)
 , m_next_func_name_id(0)
+, m_share_functions(
+    target_lang == TL_NATIVE && options.get_bool_option(MDL_JIT_OPTION_SHARE_FUNCTIONS))
+, m_share_options_digest(get_allocator())
+, m_shared_func_candidates(get_allocator())
+, m_unshareable_funcs(
+    0, Function_set::hasher(), Function_set::key_equal(), get_allocator())
+, m_exported_shared_funcs()
+, m_shared_func_deps()
 {
     // clear the lookup tables
     memset(m_lut_info,              0, sizeof(m_lut_info));
@@ -1218,6 +1392,43 @@ LLVM_code_generator::LLVM_code_generator(
         m_hlsl_use_resource_data = false;
     }
 
+    if (m_share_functions) {
+        if (m_type_mapper.strings_mapped_to_ids() ||
+            m_user_state_module.data != NULL ||
+            m_enable_full_debug)
+        {
+            // the generated code depends on data of the current module
+            m_share_functions = false;
+        } else {
+            // only functions generated with identical options can be shared, so add a digest
+            // of all options to the names of shared functions
+            MD5_hasher hasher;
+            for (int i = 0, n = options.get_option_count(); i < n; ++i) {
+                hasher.update(options.get_option_name(i));
+                hasher.update(options.get_option_value(i));
+            }
+            hasher.update(mi::Uint32(tm_mode));
+            hasher.update(mi::Uint32(has_tex_handler));
+            hasher.update(mi::Uint32(state_mode));
+            hasher.update(mi::Uint32(num_texture_spaces));
+            hasher.update(mi::Uint32(num_texture_results));
+            hasher.update(mi::Uint32(state_mapping));
+            hasher.update(mi::Uint32(m_opt_level));
+            hasher.update(mi::Uint32(m_fast_math));
+            hasher.update(mi::Uint32(m_finite_math));
+            hasher.update(mi::Uint32(m_reciprocal_math));
+
+            unsigned char digest[16];
+            hasher.final(digest);
+
+            char buf[3];
+            for (size_t i = 0; i < dimension_of(digest); ++i) {
+                snprintf(buf, sizeof(buf), "%02x", unsigned(digest[i]));
+                m_share_options_digest += buf;
+            }
+        }
+    }
+
     // parse scene data names option if available
     char const *names = options.get_string_option(MDL_JIT_OPTION_SCENE_DATA_NAMES);
     if (names != NULL && *names) {
@@ -1509,6 +1720,9 @@ void LLVM_code_generator::prepare_internal_functions()
 // Destructor.
 LLVM_code_generator::~LLVM_code_generator()
 {
+    // release shared functions of modules that were never JIT compiled
+    m_jitted_code->release_shared_modules(m_shared_func_deps);
+
     terminate_mdl_runtime(m_runtime);
 
     if (m_ro_segment != NULL) {
@@ -1538,6 +1752,16 @@ static void AddDeleteUnusedLibDeviceExtension(
     PM.add(llvm::createDeleteUnusedLibDevicePass());
 }
 
+// Get the optimization level for the machine code generation.
+llvm::CodeGenOpt::Level LLVM_code_generator::get_codegen_opt_level() const
+{
+    if (m_opt_level == 0)
+        return llvm::CodeGenOpt::None;
+    if (m_opt_level == 1)
+        return llvm::CodeGenOpt::Default;
+    return llvm::CodeGenOpt::Aggressive;
+}
+
 // Optimize an LLVM function.
 bool LLVM_code_generator::optimize(llvm::Function *func)
 {
@@ -2269,6 +2493,22 @@ llvm::Function *LLVM_code_generator::compile_switch_lambda(
 
     create_resource_tables(lambda);
 
+    // in incremental mode, reuse the code of an identical lambda if possible
+    DAG_hash cache_key;
+    if (incremental) {
+        cache_key = get_lambda_cache_key(lambda, IGenerated_code_executable::FK_SWITCH_LAMBDA);
+        if (llvm::Function *func = reuse_cached_lambda(lambda, cache_key)) {
+            m_exported_func_list.push_back(
+                Exported_function(
+                    get_allocator(),
+                    func,
+                    IGenerated_code_executable::DK_NONE,
+                    IGenerated_code_executable::FK_SWITCH_LAMBDA,
+                    m_captured_args_type != NULL ? next_arg_block_index : ~0));
+            return func;
+        }
+    }
+
     LLVM_context_data *ctx_data = get_or_create_context_data(&lambda);
     llvm::Function    *func     = ctx_data->get_function();
     unsigned          flags     = ctx_data->get_function_flags();
@@ -2402,6 +2642,9 @@ llvm::Function *LLVM_code_generator::compile_switch_lambda(
     // also we want to avoid reuse of the same pointers, when DAG nodes are deleted.
     clear_dag_node_map();
 
+    if (incremental)
+        m_lambda_cache[cache_key] = func;
+
     if (!incremental) {
         // finalize the module and store it
         if (finalize_module() != NULL) {
@@ -2463,6 +2706,24 @@ llvm::Function *LLVM_code_generator::compile_generic_lambda(
 
     create_resource_tables(lambda);
 
+    // in incremental mode, reuse the code of an identical lambda if possible, but only without
+    // a call transformer, which might produce different code for the same DAG
+    bool use_cache = incremental && transformer == NULL;
+    DAG_hash cache_key;
+    if (use_cache) {
+        cache_key = get_lambda_cache_key(lambda, IGenerated_code_executable::FK_LAMBDA);
+        if (llvm::Function *func = reuse_cached_lambda(lambda, cache_key)) {
+            m_exported_func_list.push_back(
+                Exported_function(
+                    get_allocator(),
+                    func,
+                    IGenerated_code_executable::DK_NONE,
+                    IGenerated_code_executable::FK_LAMBDA,
+                    m_captured_args_type != NULL ? next_arg_block_index : ~0));
+            return func;
+        }
+    }
+
     LLVM_context_data *ctx_data = get_or_create_context_data(&lambda);
     llvm::Function    *func     = ctx_data->get_function();
     unsigned          flags     = ctx_data->get_function_flags();
@@ -2510,6 +2771,9 @@ llvm::Function *LLVM_code_generator::compile_generic_lambda(
     // also we want to avoid reuse of the same pointers, when DAG nodes are deleted.
     clear_dag_node_map();
 
+    if (use_cache)
+        m_lambda_cache[cache_key] = func;
+
     if (!incremental) {
         // finalize the module and store it
         if (finalize_module() != NULL) {
@@ -4717,6 +4981,9 @@ llvm::Value *LLVM_code_generator::create_global_const(
             size_t curr_ofs = add_to_ro_data_segment(v, size);
             is_ro_segment_ofs = true;
 
+            // the offset is specific to the RO data segment of the current module
+            mark_function_unshareable(ctx.get_function());
+
             return ctx.get_constant(curr_ofs);
         }
     }
@@ -8502,7 +8769,7 @@ void LLVM_code_generator::compile_waiting_functions()
             mi::mdl::IDeclaration_function const *func_decl =
                 cast<mi::mdl::IDeclaration_function>(func_def->get_declaration());
 
-            if (func_decl != NULL) {
+            if (func_decl != NULL && !import_shared_function(owner, func_inst, func)) {
                 MDL_module_scope scope(*this, owner);
                 if (m_deriv_infos != NULL)
                     m_cur_func_deriv_info = m_deriv_infos->get_function_derivative_infos(func_inst);
@@ -8516,6 +8783,143 @@ void LLVM_code_generator::compile_waiting_functions()
     }
 }
 
+// Returns true, if functions of the current module can be shared with other modules.
+bool LLVM_code_generator::can_share_functions() const
+{
+    return m_share_functions
+        && !m_use_ro_data_segment
+        && m_deriv_infos == NULL
+        && m_di_builder == NULL;
+}
+
+// Get the name under which a function instance can be shared with other modules.
+string LLVM_code_generator::get_shared_function_name(
+    mi::mdl::IModule const  *owner,
+    Function_instance const &inst) const
+{
+    string name(m_arena.get_allocator());
+
+    IDefinition const *def = inst.get_def();
+    if (!can_share_functions() || owner == NULL || def == NULL ||
+        inst.is_instantiated() || inst.get_return_derivs())
+    {
+        return name;
+    }
+
+    IModule::Function_hash const *hash = owner->get_function_hash(def);
+    if (hash == NULL)
+        return name;
+
+    char buf[3];
+    name = "mdl_shared_";
+    for (size_t i = 0; i < dimension_of(hash->hash); ++i) {
+        snprintf(buf, sizeof(buf), "%02x", unsigned(hash->hash[i]));
+        name += buf;
+    }
+    name += '_';
+    name += m_share_options_digest;
+    return name;
+}
+
+// Mark a function as not shareable with other modules.
+void LLVM_code_generator::mark_function_unshareable(llvm::Function *func)
+{
+    if (m_share_functions || m_shared_runtime_mode != SRM_INLINE)
+        m_unshareable_funcs.insert(func);
+}
+
+// Try to use a function exported by another module instead of compiling it.
+bool LLVM_code_generator::import_shared_function(
+    mi::mdl::IModule const  *owner,
+    Function_instance const &inst,
+    llvm::Function          *func)
+{
+    string name(get_shared_function_name(owner, inst));
+    if (name.empty())
+        return false;
+
+    std::string        symbol;
+    MDL_JIT_module_key module_key;
+    if (!m_jitted_code->acquire_shared_function(name.c_str(), symbol, module_key)) {
+        // not available yet, compile it and offer it to other modules
+        m_shared_func_candidates.push_back(Shared_func_candidate(func, name));
+        return false;
+    }
+
+    if (m_module->getFunction(symbol) != NULL) {
+        // already used under this name by another instance, compile it again
+        Jitted_code::Module_key_list deps(1, module_key);
+        m_jitted_code->release_shared_modules(deps);
+        return false;
+    }
+
+    // keep it as a declaration that is resolved to the shared function by the JIT
+    func->setName(symbol);
+    func->setLinkage(llvm::GlobalValue::ExternalLinkage);
+    m_shared_func_deps.push_back(module_key);
+    return true;
+}
+
+// Check if a function or any function called by it depends on data of the current module.
+bool LLVM_code_generator::depends_on_module_data(
+    llvm::Function *func,
+    Function_set   &visited) const
+{
+    if (!visited.insert(func).second)
+        return false;
+
+    if (m_unshareable_funcs.find(func) != m_unshareable_funcs.end())
+        return true;
+
+    for (llvm::BasicBlock &bb : *func) {
+        for (llvm::Instruction &inst : bb) {
+            if (llvm::CallInst *call = llvm::dyn_cast<llvm::CallInst>(&inst)) {
+                llvm::Function *callee = call->getCalledFunction();
+                if (callee != NULL && depends_on_module_data(callee, visited))
+                    return true;
+            }
+        }
+    }
+    return false;
+}
+
+// Export all shareable functions of the current module to other modules.
+void LLVM_code_generator::export_shared_functions()
+{
+    if (m_shared_func_candidates.empty())
+        return;
+
+    if (can_share_functions()) {
+        // make the symbol names unique across modules, so importers always bind to the module
+        // they hold a reference to
+        char buf[16];
+        snprintf(buf, sizeof(buf), "_%u", m_jitted_code->get_next_shared_module_id());
+
+        for (size_t i = 0, n = m_shared_func_candidates.size(); i < n; ++i) {
+            llvm::Function *func = m_shared_func_candidates[i].first;
+            string const   &name = m_shared_func_candidates[i].second;
+
+            if (func->isDeclaration())
+                continue;
+
+            Function_set visited(
+                0, Function_set::hasher(), Function_set::key_equal(), get_allocator());
+            if (depends_on_module_data(func, visited))
+                continue;
+
+            std::string symbol(name.c_str());
+            symbol += buf;
+            if (m_module->getFunction(symbol) != NULL)
+                continue;
+
+            func->setName(symbol);
+            func->setLinkage(llvm::GlobalValue::ExternalLinkage);
+            m_exported_shared_funcs.push_back(std::make_pair(std::string(name.c_str()), symbol));
+        }
+    }
+    m_shared_func_candidates.clear();
+}
+
 namespace {
 
 class RO_segment_builder {
@@ -8705,6 +9109,9 @@ void LLVM_code_generator::create_module(char const *mod_name, char const *mod_fn
     // clear the render state usage
     m_render_state_usage = 0;
 
+    // functions of previous modules cannot be reused
+    m_lambda_cache.clear();
+
     // creates a new llvm module
     m_module = new llvm::Module(mod_name, m_llvm_context);
     m_module->setDataLayout(*get_target_layout_data());
@@ -8757,6 +9164,9 @@ void LLVM_code_generator::create_module(char const *mod_name, char const *mod_fn
 // Finalize compilation of the current module.
 llvm::Module *LLVM_code_generator::finalize_module()
 {
+    if (!prepare_shared_runtime())
+        return NULL;
+
     // note: these functions could introduce new resource table accesses
     compile_waiting_functions();
 
@@ -8764,6 +9174,12 @@ llvm::Module *LLVM_code_generator::finalize_module()
     if (m_use_ro_data_segment)
         create_ro_segment();
 
+    // offer the shareable functions to other modules before they get optimized
+    export_shared_functions();
+
+    // must be done before the resource tables are created, which would hide resource accesses
+    split_shared_runtime();
+
     // create the resource tables if they were accessed
     create_texture_attribute_table();
     create_light_profile_attribute_table();
@@ -8844,7 +9260,14 @@ MDL_JIT_module_key LLVM_code_generator::jit_compile(llvm::Module *module)
     }
 
     // the jitted code must take ownership of this module
-    MDL_JIT_module_key module_key = m_jitted_code->add_llvm_module(module);
+    MDL_JIT_module_key module_key = m_jitted_code->add_llvm_module(
+        module, get_codegen_opt_level());
+
+    // the module now owns the references to the modules of the shared functions it uses
+    m_jitted_code->register_shared_module(
+        module_key, m_exported_shared_funcs, m_shared_func_deps);
+    m_exported_shared_funcs.clear();
+    m_shared_func_deps.clear();
 
     // now JIT compile all functions that are not jitted yet:
     // we want to do this ahead of time
@@ -8905,16 +9328,10 @@ void LLVM_code_generator::ptx_compile(
     llvm::Target const *target = llvm::TargetRegistry::lookupTarget(march, error);
     MDL_ASSERT(target != NULL);  // backend not found, should not happen
 
-    llvm::CodeGenOpt::Level OLvl = llvm::CodeGenOpt::None;
-    if (m_opt_level == 1)
-        OLvl = llvm::CodeGenOpt::Default;
-    else if (m_opt_level >= 2)
-        OLvl = llvm::CodeGenOpt::Aggressive;
-
     llvm::TargetOptions options;
     std::unique_ptr<llvm::TargetMachine> target_machine(target->createTargetMachine(
         triple, mcpu, features, options,
-        llvm::None, llvm::None, OLvl));
+        llvm::None, llvm::None, get_codegen_opt_level()));
     llvm::legacy::PassManager pm;
 
     // set the data layout
@@ -9708,6 +10125,74 @@ void LLVM_code_generator::reset_lambda_state()
     m_lambda_force_no_lambda_results = false;
 }
 
+// Compute the key of a lambda function for the lambda cache.
+DAG_hash LLVM_code_generator::get_lambda_cache_key(
+    Lambda_function const                     &lambda,
+    IGenerated_code_executable::Function_kind kind) const
+{
+    MD5_hasher hasher;
+
+    DAG_hash const *hash = lambda.get_hash();
+    hasher.update(hash->data(), hash->size());
+
+    // these properties change the interface of the generated function
+    hasher.update(mi::Uint32(kind));
+    hasher.update(mi::Uint32(lambda.get_execution_context()));
+    hasher.update(lambda.is_entry_point() ? 't' : 'f');
+    hasher.update(m_lambda_force_sret ? 't' : 'f');
+    hasher.update(m_lambda_first_param_by_ref ? 't' : 'f');
+    hasher.update(m_lambda_force_render_state ? 't' : 'f');
+    hasher.update(m_lambda_force_no_lambda_results ? 't' : 'f');
+
+    unsigned char key[16];
+    hasher.final(key);
+    return DAG_hash(key);
+}
+
+// Reuse the code of an identical lambda function compiled earlier into the current module.
+llvm::Function *LLVM_code_generator::reuse_cached_lambda(
+    Lambda_function const &lambda,
+    DAG_hash const        &key)
+{
+    Lambda_cache::const_iterator it(m_lambda_cache.find(key));
+    if (it == m_lambda_cache.end())
+        return NULL;
+
+    llvm::Function *target = it->second;
+    if (target->getParent() != m_module)
+        return NULL;
+
+    // create a new function with the name of the lambda that just calls the existing one,
+    // the optimizer will inline it
+    llvm::Function *func = llvm::Function::Create(
+        target->getFunctionType(),
+        target->getLinkage(),
+        lambda.get_name(),
+        m_module);
+    func->setCallingConv(target->getCallingConv());
+    func->setAttributes(target->getAttributes());
+
+    llvm::BasicBlock *start_bb = llvm::BasicBlock::Create(m_llvm_context, "start", func);
+    llvm::IRBuilder<> builder(start_bb);
+
+    llvm::SmallVector<llvm::Value *, 8> args;
+    for (llvm::Function::arg_iterator arg_it = func->arg_begin(), end = func->arg_end();
+        arg_it != end;
+        ++arg_it)
+    {
+        args.push_back(&*arg_it);
+    }
+
+    llvm::CallInst *call = builder.CreateCall(target, args);
+    call->setCallingConv(target->getCallingConv());
+    if (func->getReturnType()->isVoidTy())
+        builder.CreateRetVoid();
+    else
+        builder.CreateRet(call);
+
+    return func;
+}
+
 // Parse a call mode option.
 Function_context::Tex_lookup_call_mode LLVM_code_generator::parse_call_mode(char const *name)
 {
@@ -9739,6 +10224,17 @@ mi::mdl::Df_handle_slot_mode LLVM_code_generator::parse_df_handle_slot_mode(char
     return mi::mdl::DF_HSM_NONE;
 }
 
+/// Parse the Shared_runtime_mode
+LLVM_code_generator::Shared_runtime_mode LLVM_code_generator::parse_shared_runtime_mode(
+    char const *name)
+{
+    if (strcmp(name, "external") == 0)
+        return SRM_EXTERNAL;
+    if (strcmp(name, "runtime") == 0)
+        return SRM_RUNTIME;
+    return SRM_INLINE;
+}
+
 // Get a unique string value object used to represent the string of the value.
 mi::mdl::IValue_string const *LLVM_code_generator::get_internalized_string(
     mi::mdl::IValue_string const *s)
@@ -29,12 +29,18 @@
 #ifndef MDL_GENERATOR_JIT_LLVM_H
 #define MDL_GENERATOR_JIT_LLVM_H 1
 
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
 #include <mi/base/iinterface.h>
 #include <mi/base/lock.h>
 
 #include <mi/mdl/mdl_declarations.h>
 #include <mi/mdl/mdl_generated_dag.h>
 #include <mi/mdl/mdl_types.h>
+#include <llvm/Support/CodeGen.h>
 #include <mdl/compiler/compilercore/compilercore_bitset.h>
 #include <mdl/compiler/compilercore/compilercore_function_instance.h>
 #include <mdl/compiler/compilercore/compilercore_memory_arena.h>
@@ -104,7 +110,10 @@ public:
     /// Add this LLVM module to the execution engine.
     ///
     /// \param llvm_module  the LLVM module, takes ownership
-    MDL_JIT_module_key add_llvm_module(llvm::Module *llvm_module);
+    /// \param opt_level    the optimization level of the machine code generation
+    MDL_JIT_module_key add_llvm_module(
+        llvm::Module            *llvm_module,
+        llvm::CodeGenOpt::Level opt_level);
 
     /// Remove this module from the execution engine and delete it.
     ///
@@ -126,6 +135,24 @@ public:
         llvm::Function *func,
         LLVM_code_generator &code_gen);
 
+    /// Optimize this LLVM module with full optimizations.
+    ///
+    /// Used for tiered compilation, where no code generator is available anymore.
+    ///
+    /// \param llvm_module  the LLVM module
+    static void optimize_llvm_module(llvm::Module *llvm_module);
+
+    /// Get the address of a function or global variable in a module added to the execution
+    /// engine.
+    ///
+    /// \param module_key  the module key returned by add_llvm_module()
+    /// \param name        the name of the function or global variable
+    ///
+    /// \return The address of the function or variable or NULL if it was not found.
+    void *get_function_address(
+        MDL_JIT_module_key    module_key,
+        llvm::StringRef const &name);
+
     /// Get the only instance.
     ///
     /// \param alloc    the allocator
@@ -140,6 +167,72 @@ public:
     /// Get the layout data for the current JITer target.
     llvm::DataLayout get_layout_data() const;
 
+    /// A list of (shared name, symbol name) pairs of shared functions.
+    typedef std::vector<std::pair<std::string, std::string> > Shared_function_list;
+
+    /// A list of module keys.
+    typedef std::vector<MDL_JIT_module_key> Module_key_list;
+
+    /// Get a new ID used to create unique symbol names for shared functions of a module.
+    unsigned get_next_shared_module_id();
+
+    /// Look up a shared function and keep the module exporting it alive until
+    /// release_shared_modules() is called for it.
+    ///
+    /// \param name        the shared name of the function
+    /// \param symbol      receives the symbol name of the function in the exporting module
+    /// \param module_key  receives the key of the exporting module
+    ///
+    /// \return true, if a module exports a function with the given shared name
+    bool acquire_shared_function(
+        char const         *name,
+        std::string        &symbol,
+        MDL_JIT_module_key &module_key);
+
+    /// Register the shared functions exported by a module and the modules it depends on.
+    ///
+    /// \param module_key  the key of a module added by add_llvm_module()
+    /// \param exports     the shared functions exported by the module
+    /// \param deps        the modules acquired for the shared functions used by the module,
+    ///                    ownership of the references is transferred to the module
+    void register_shared_module(
+        MDL_JIT_module_key         module_key,
+        Shared_function_list const &exports,
+        Module_key_list const      &deps);
+
+    /// Release modules acquired by acquire_shared_function().
+    ///
+    /// \param deps  the acquired modules
+    void release_shared_modules(Module_key_list const &deps);
+
+private:
+    /// Sharing information of a module.
+    struct Shared_module_info {
+        Shared_module_info() : m_ref_count(0), m_is_deleted(false) {}
+
+        /// The number of references by modules using its shared functions.
+        unsigned m_ref_count;
+
+        /// True, if the module was deleted but is still referenced.
+        bool m_is_deleted;
+
+        /// The shared names of the functions exported by this module.
+        std::vector<std::string> m_exports;
+
+        /// The modules whose shared functions are used by this module.
+        Module_key_list m_deps;
+    };
+
+    typedef std::map<std::string, std::pair<std::string, MDL_JIT_module_key> > Shared_function_map;
+    typedef std::map<MDL_JIT_module_key, Shared_module_info>                   Shared_module_map;
+
+    /// Remove a module from the execution engine and release its dependencies.
+    /// The shared lock must be held.
+    void remove_shared_module(MDL_JIT_module_key module_key);
+
+    /// Release the given modules. The shared lock must be held.
+    void release_shared_modules_locked(Module_key_list const &deps);
+
 private:
     /// Constructor.
     ///
@@ -174,6 +267,18 @@ private:
 
     /// The LLVM JIT for MDL.
     MDL_JIT *m_mdl_jit;
+
+    /// The lock protecting the shared function data.
+    mi::base::Lock m_shared_lock;
+
+    /// The next ID for unique symbol names of shared functions.
+    unsigned m_next_shared_module_id;
+
+    /// Maps shared names to the symbol name and module of the exported function.
+    Shared_function_map m_shared_functions;
+
+    /// The sharing information of all modules exporting or using shared functions.
+    Shared_module_map m_shared_modules;
 };
 
 ///
@@ -930,6 +1035,13 @@ public:
                                   pause on function enter (to connect the debugger). */
     }; // can be or'ed
 
+    /// Modes for emitting the libbsdf runtime functions shared by all materials.
+    enum Shared_runtime_mode {
+        SRM_INLINE   = 0,  ///< Compile the runtime functions into the code of every module.
+        SRM_EXTERNAL = 1,  ///< Only reference the runtime functions by external declarations.
+        SRM_RUNTIME  = 2,  ///< Emit the runtime functions as externally visible definitions.
+    };
+
     /// The coordinate space encoding, must match the definitions in state.mdl.
     enum coordinate_space {
         coordinate_internal,
@@ -1121,6 +1233,19 @@ public:
     /// \param res  the resource
     int find_resource_tag(IValue_resource const *res) const;
 
+    /// Mark a function as not shareable with other modules, because its code depends on data
+    /// of the current module.
+    ///
+    /// \param func  the LLVM function
+    void mark_function_unshareable(llvm::Function *func);
+
+    /// Returns true, if this code generator emits the shared libbsdf runtime functions, so
+    /// a module without any functions can be finalized.
+    bool emits_shared_runtime() const { return m_shared_runtime_mode == SRM_RUNTIME; }
+
+    /// Get the name prefix of the shared libbsdf runtime functions.
+    static char const *get_shared_runtime_prefix() { return "mdl_rt_"; }
+
     /// Compile all functions of a module.
     ///
     /// \param module   the module to compile
@@ -1776,6 +1901,11 @@ private:
     /// \return true if module was modified, false otherwise
     bool optimize(llvm::Module *module);
 
+    /// Get the optimization level for the machine code generation.
+    ///
+    /// Follows the JIT optimization level, so unoptimized code is also emitted quickly.
+    llvm::CodeGenOpt::Level get_codegen_opt_level() const;
+
     /// Check if a given type needs reference return calling convention.
     ///
     /// \param type  the type to check
@@ -2733,6 +2863,52 @@ private:
     /// Compile all functions waiting in the wait queue into the current module.
     void compile_waiting_functions();
 
+    typedef ptr_hash_set<llvm::Function>::Type Function_set;
+
+    /// Returns true, if functions of the current module can be shared with other modules.
+    bool can_share_functions() const;
+
+    /// Get the name under which a function instance can be shared with other modules.
+    ///
+    /// \param owner  the owner module of the function definition
+    /// \param inst   the function instance
+    ///
+    /// \return the name built from the semantic hash of the function and the code generation
+    ///         options or the empty string, if the function instance cannot be shared
+    string get_shared_function_name(
+        mi::mdl::IModule const  *owner,
+        Function_instance const &inst) const;
+
+    /// Try to use a function exported by another module instead of compiling it.
+    ///
+    /// \param owner  the owner module of the function definition
+    /// \param inst   the function instance
+    /// \param func   the declared LLVM function of the instance
+    ///
+    /// \return true, if the function was turned into a declaration of the shared function
+    bool import_shared_function(
+        mi::mdl::IModule const  *owner,
+        Function_instance const &inst,
+        llvm::Function          *func);
+
+    /// Check if a function or any function called by it depends on data of the current module.
+    ///
+    /// \param func     the LLVM function
+    /// \param visited  the already visited functions
+    bool depends_on_module_data(llvm::Function *func, Function_set &visited) const;
+
+    /// Export all shareable functions of the current module to other modules.
+    void export_shared_functions();
+
+    /// Make sure, the current module contains libbsdf, when the shared runtime part is emitted.
+    ///
+    /// \returns false if there was any error.
+    bool prepare_shared_runtime();
+
+    /// Give the libbsdf runtime functions not depending on data of the current module stable
+    /// external names and drop their bodies, if they are provided by the shared runtime part.
+    void split_shared_runtime();
+
     /// Create the RO data segment.
     void create_ro_segment();
 
@@ -3022,6 +3198,28 @@ private:
     /// Reset the lambda function compilation state.
     void reset_lambda_state();
 
+    /// Compute the key of a lambda function for the lambda cache.
+    ///
+    /// The key combines the DAG hash of the lambda with all properties that influence the
+    /// generated code and the interface of the LLVM function.
+    ///
+    /// \param lambda  the lambda function
+    /// \param kind    the kind of the function to generate
+    DAG_hash get_lambda_cache_key(
+        Lambda_function const                     &lambda,
+        IGenerated_code_executable::Function_kind kind) const;
+
+    /// Reuse the code of an identical lambda function compiled earlier into the current module.
+    ///
+    /// \param lambda  the lambda function
+    /// \param key     the lambda cache key of the lambda function
+    ///
+    /// \return a new function named after \p lambda forwarding to the already compiled function
+    ///         or NULL if no identical lambda function was compiled into the current module
+    llvm::Function *reuse_cached_lambda(
+        Lambda_function const &lambda,
+        DAG_hash const        &key);
+
     /// Get the next basic block chain.
     size_t get_next_bb() { return ++m_last_bb; }
 
@@ -3035,6 +3233,11 @@ private:
     /// \param name  a valid Df_handle_slot_mode name
     static mi::mdl::Df_handle_slot_mode parse_df_handle_slot_mode(char const *name);
 
+    /// Parse the Shared_runtime_mode
+    ///
+    /// \param name  a valid Shared_runtime_mode name
+    static Shared_runtime_mode parse_shared_runtime_mode(char const *name);
+
     /// Get a unique string value object used to represent the string of the value.
     ///
     /// \param s  the string value object
@@ -3302,6 +3505,25 @@ private:
     /// The type of all captured arguments if any.
     llvm::StructType *m_captured_args_type;
 
+    /// Hash functor for lambda cache keys.
+    struct Lambda_cache_key_hash {
+        size_t operator()(DAG_hash const &h) const {
+            size_t res;
+            memcpy(&res, h.data(), sizeof(res));
+            return res;
+        }
+    };
+
+    typedef mi::mdl::hash_map<
+        DAG_hash,
+        llvm::Function *,
+        Lambda_cache_key_hash>::Type Lambda_cache;
+
+    /// Maps the keys of lambda functions compiled into the current module to their LLVM
+    /// functions. Used to avoid compiling identical lambda functions (for instance, from several
+    /// instances of the same material class) more than once into a link unit.
+    Lambda_cache m_lambda_cache;
+
     /// The HLSL function asint().
     llvm::Function *m_hlsl_func_argblock_as_int;
 
@@ -3464,6 +3686,12 @@ private:
     /// List of all libbsdf template functions which should be removed before optimizing.
     mi::mdl::vector<llvm::Function *>::Type m_libbsdf_template_funcs;
 
+    /// List of all other libbsdf functions, which may be part of the shared runtime.
+    mi::mdl::vector<llvm::Function *>::Type m_libbsdf_runtime_funcs;
+
+    /// The mode for emitting the shared libbsdf runtime functions.
+    Shared_runtime_mode m_shared_runtime_mode;
+
 
     /// If true, auxiliary functions are generated for DFs.
     bool m_enable_auxiliary;
@@ -3625,6 +3853,26 @@ private:
 
     /// The next ID used to create unique function names for cloned LLVM functions.
     unsigned m_next_func_name_id;
+
+    /// If true, functions may be shared with other native modules.
+    bool m_share_functions;
+
+    /// The digest of the code generation options, part of the names of shared functions.
+    string m_share_options_digest;
+
+    typedef std::pair<llvm::Function *, string> Shared_func_candidate;
+
+    /// The functions compiled into the current module that may be offered to other modules.
+    vector<Shared_func_candidate>::Type m_shared_func_candidates;
+
+    /// The functions of the current module depending on data of this module.
+    Function_set m_unshareable_funcs;
+
+    /// The shared functions exported by the current module.
+    Jitted_code::Shared_function_list m_exported_shared_funcs;
+
+    /// The modules of the shared functions used by the current module.
+    Jitted_code::Module_key_list m_shared_func_deps;
 };
 
 /// copysignf implementation for windows runtime.
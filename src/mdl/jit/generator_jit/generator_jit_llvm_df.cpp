@@ -2002,6 +2002,16 @@ bool LLVM_code_generator::load_and_link_libbsdf(mdl::Df_handle_slot_mode hsm)
     // also avoid LLVM warning on console about mixing different data layouts
     libbsdf->setDataLayout(m_module->getDataLayout());
 
+    // remember the libbsdf functions, which may become part of the shared runtime
+    vector<string>::Type runtime_func_names(get_allocator());
+    if (m_shared_runtime_mode != SRM_INLINE) {
+        for (llvm::Function &f : libbsdf->functions()) {
+            if (!f.isDeclaration())
+                runtime_func_names.push_back(
+                    string(f.getName().begin(), f.getName().end(), get_allocator()));
+        }
+    }
+
     // collect all functions available before linking
     // note: we cannot use the function pointers, as linking removes some function declarations and
     //       may reuse the old pointers
@@ -2369,9 +2379,104 @@ bool LLVM_code_generator::load_and_link_libbsdf(mdl::Df_handle_slot_mode hsm)
         }
     }
 
+    // the template functions were replaced, all remaining ones are identical for all materials
+    for (string const &name : runtime_func_names) {
+        llvm::Function *func = m_module->getFunction(llvm::StringRef(name.c_str(), name.size()));
+        if (func != NULL && !func->isDeclaration())
+            m_libbsdf_runtime_funcs.push_back(func);
+    }
+
+    return true;
+}
+
+// Make sure, the current module contains libbsdf, when the shared runtime part is emitted.
+bool LLVM_code_generator::prepare_shared_runtime()
+{
+    if (m_shared_runtime_mode != SRM_RUNTIME)
+        return true;
+
+    if (m_module == NULL) {
+        // the link unit is empty, create a module for the runtime only
+        create_module("lambda_mod", NULL);
+
+        // initialize the module with user code
+        if (!init_user_modules()) {
+            // drop the module and give up
+            drop_llvm_module(m_module);
+            m_module = NULL;
+            return false;
+        }
+
+        if (m_target_lang == TL_HLSL) {
+            init_hlsl_code_gen();
+        }
+    }
+
+    // load libbsdf into the current module, if it was not initialized, yet
+    if (m_type_bsdf_sample_data == NULL && !load_and_link_libbsdf(
+            m_link_libbsdf_df_handle_slot_mode)) {
+        // drop the module and give up
+        drop_llvm_module(m_module);
+        m_module = NULL;
+        return false;
+    }
     return true;
 }
 
+// Give the libbsdf runtime functions not depending on data of the current module stable
+// external names and drop their bodies, if they are provided by the shared runtime part.
+void LLVM_code_generator::split_shared_runtime()
+{
+    if (m_libbsdf_runtime_funcs.empty())
+        return;
+
+    // the resource tables and the BSDF data texture IDs are specific to the current module
+    for (size_t i = 0; i <= RTK_LAST; ++i) {
+        if (m_lut_info[i].m_get_lut != NULL)
+            m_unshareable_funcs.insert(m_lut_info[i].m_get_lut);
+        if (m_lut_info[i].m_get_lut_size != NULL)
+            m_unshareable_funcs.insert(m_lut_info[i].m_get_lut_size);
+    }
+    if (llvm::Function *func = m_module->getFunction(
+            "_ZNK5State24get_bsdf_data_texture_idE14Bsdf_data_kind"))
+        m_unshareable_funcs.insert(func);
+
+    // decide for all functions first, dropping bodies would hide dependencies
+    vector<llvm::Function *>::Type shared_funcs(get_allocator());
+    for (llvm::Function *func : m_libbsdf_runtime_funcs) {
+        Function_set visited(
+            0, Function_set::hasher(), Function_set::key_equal(), get_allocator());
+        if (!depends_on_module_data(func, visited))
+            shared_funcs.push_back(func);
+    }
+    m_libbsdf_runtime_funcs.clear();
+
+    for (llvm::Function *func : shared_funcs) {
+        // the name must be identical in all modules and also be a valid HLSL identifier.
+        // Every other character is escaped as "_XX" with its hex code, so different
+        // functions never get the same name, which LLVM would resolve by adding a suffix
+        // depending on the current module
+        static char const hex_digits[] = "0123456789ABCDEF";
+        std::string name(get_shared_runtime_prefix());
+        for (char c : func->getName()) {
+            unsigned char u = (unsigned char)c;
+            if (isalnum(u)) {
+                name += c;
+            } else {
+                name += '_';
+                name += hex_digits[u >> 4];
+                name += hex_digits[u & 15];
+            }
+        }
+        func->setName(name);
+        MDL_ASSERT(func->getName() == name && "shared runtime function name is not unique");
+        func->setLinkage(llvm::GlobalValue::ExternalLinkage);
+
+        if (m_shared_runtime_mode == SRM_EXTERNAL)
+            func->deleteBody();
+    }
+}
+
 // Generate a call to an expression lambda function.
 Expression_result LLVM_code_generator::generate_expr_lambda_call(
     Function_context                &ctx,
@@ -44,19 +44,28 @@
 #include <sys/types.h>
 #include <sys/stat.h>   // For stat().
 
+#include <cctype>
 #include <cstring>
 #include <cstdio>
 #include <cstdlib>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <thread>
 #include <vector>
 
 #include <mi/base/handle.h>
 #include <mi/mdl/mdl_generated_dag.h>
+#include <mi/mdl/mdl_modules.h>
 #include <mi/mdl/mdl_code_generators.h>
 #include <mi/mdl/mdl_module_transformer.h>
 
 
 #include <string>
 #include <algorithm>
+#include <base/system/stlext/i_stlext_thread_budget.h>
 #include <base/system/version/i_version.h>
 
 #include <mdl/compiler/compilercore/compilercore_mdl.h>
@@ -90,6 +99,9 @@ using mi::mdl::IOutput_stream;
 using mi::mdl::IInput_stream;
 using mi::mdl::IThread_context;
 using mi::mdl::IMDL_module_transformer;
+using mi::mdl::IModule_cache;
+using mi::mdl::IModule_cache_lookup_handle;
+using mi::mdl::IModule_loaded_callback;
 
 
 using namespace std;
@@ -106,6 +118,328 @@ static void print_messages(Messages const &msgs, IPrinter *printer)
     }
 }
 
+namespace {
+
+class Batch_job;
+
+/// The lookup handle of the batch module cache.
+class Batch_lookup_handle : public IModule_cache_lookup_handle
+{
+public:
+    /// Constructor.
+    ///
+    /// \param job  the batch compilation this handle belongs to
+    explicit Batch_lookup_handle(Batch_job const *job)
+    : m_job(job)
+    , m_lookup_name()
+    , m_is_processing(false)
+    , m_owns_entry(false)
+    {
+    }
+
+    /// Destructor.
+    virtual ~Batch_lookup_handle() {}
+
+    /// Get an identifier to be used throughout the loading of a module.
+    char const *get_lookup_name() const MDL_FINAL { return m_lookup_name.c_str(); }
+
+    /// Returns true if this handle belongs to the context that loads the module.
+    bool is_processing() const MDL_FINAL { return m_is_processing; }
+
+    /// The batch compilation this handle belongs to.
+    Batch_job const *m_job;
+
+    /// The name of the looked up module.
+    std::string m_lookup_name;
+
+    /// True if the module is loaded by the owner of this handle.
+    bool m_is_processing;
+
+    /// True if the module is registered as being loaded by the owner of this handle.
+    bool m_owns_entry;
+};
+
+/// A module cache shared by all compilations of a batch run.
+///
+/// Modules are entered as soon as they were compiled, so later compilations on any thread reuse
+/// them. A module that is currently loaded by one compilation is not loaded again by another one,
+/// instead the other compilation waits for the result. Waiting is only refused if it would close
+/// a cycle of compilations waiting for each other, which happens for cyclic imports only. In that
+/// case, and if the loading failed, the module is loaded by the waiting compilation as well, so
+/// it reports the errors itself.
+class Batch_module_cache : public IModule_loaded_callback
+{
+    friend class Batch_job;
+public:
+    /// Constructor.
+    Batch_module_cache()
+    : m_lock()
+    , m_loaded()
+    , m_modules()
+    , m_loading()
+    {
+    }
+
+    /// Function that is called when the module was loaded successfully so that it can be cached.
+    bool register_module(IModule const *module) MDL_FINAL
+    {
+        if (module->is_stdlib() || module->is_builtins()) {
+            // these are owned by the compiler
+            return true;
+        }
+        {
+            std::lock_guard<std::mutex> guard(m_lock);
+
+            std::string name(module->get_name());
+            if (m_modules.find(name) == m_modules.end())
+                m_modules[name] = mi::base::make_handle_dup(module);
+
+            // the module is available now, no matter who registered it
+            m_loading.erase(name);
+        }
+        m_loaded.notify_all();
+        return true;
+    }
+
+    /// Function that is called when a module was not found or when loading failed.
+    void module_loading_failed(IModule_cache_lookup_handle const &handle) MDL_FINAL
+    {
+        Batch_lookup_handle const &h = static_cast<Batch_lookup_handle const &>(handle);
+        if (!h.m_owns_entry)
+            return;
+        {
+            std::lock_guard<std::mutex> guard(m_lock);
+
+            m_loading.erase(h.m_lookup_name);
+        }
+        m_loaded.notify_all();
+    }
+
+    /// Called while loading a module to check if the built-in modules are already registered.
+    bool is_builtin_module_registered(char const *absname) const MDL_FINAL {
+        // the built-in modules are owned by the compiler and never entered
+        return true;
+    }
+
+    /// Enters a module and all its imports into the cache.
+    void enter(IModule const *module)
+    {
+        if (module->is_stdlib() || module->is_builtins()) {
+            // these are owned by the compiler
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> guard(m_lock);
+
+            std::string name(module->get_name());
+            if (m_modules.find(name) != m_modules.end())
+                return;
+            m_modules[name] = mi::base::make_handle_dup(module);
+        }
+        for (int i = 0, n = module->get_import_count(); i < n; ++i) {
+            mi::base::Handle<IModule const> imp(module->get_import(i));
+            if (imp.is_valid_interface())
+                enter(imp.get());
+        }
+    }
+
+private:
+    /// Lookup a module for a compilation.
+    ///
+    /// \param absname  the absolute name of the module
+    /// \param handle   the lookup handle or NULL to just check if the module is loaded
+    /// \param job      the compilation looking up the module
+    IModule const *lookup(
+        char const          *absname,
+        Batch_lookup_handle *handle,
+        Batch_job const     *job);
+
+    /// Check if the given compilation waits, directly or indirectly, for another one.
+    bool waits_for(Batch_job const *job, Batch_job const *other) const;
+
+private:
+    typedef std::map<std::string, mi::base::Handle<IModule const> > Module_map;
+    typedef std::map<std::string, Batch_job const *>                 Loading_map;
+
+    /// Protects all members and the wait lists of the compilations.
+    mutable std::mutex m_lock;
+
+    /// Signaled whenever a module loading has finished.
+    std::condition_variable m_loaded;
+
+    /// The cached modules by absolute name.
+    Module_map m_modules;
+
+    /// The compilations currently loading a module by absolute name.
+    Loading_map m_loading;
+};
+
+/// The view of one batch compilation onto the shared module cache.
+///
+/// All threads working on the compilation, including the ones loading imports in parallel, use
+/// the same view. Modules being loaded by the own compilation are never waited for.
+class Batch_job : public IModule_cache
+{
+    friend class Batch_module_cache;
+public:
+    /// Constructor.
+    ///
+    /// \param cache  the shared module cache
+    explicit Batch_job(Batch_module_cache &cache)
+    : m_cache(cache)
+    , m_waits_for()
+    {
+    }
+
+    /// Create a IModule_cache_lookup_handle for this IModule_cache implementation.
+    IModule_cache_lookup_handle *create_lookup_handle() const MDL_FINAL {
+        return new Batch_lookup_handle(this);
+    }
+
+    /// Free a handle created by create_lookup_handle().
+    void free_lookup_handle(IModule_cache_lookup_handle *handle) const MDL_FINAL {
+        delete static_cast<Batch_lookup_handle *>(handle);
+    }
+
+    /// Lookup a module.
+    IModule const *lookup(
+        char const                  *absname,
+        IModule_cache_lookup_handle *handle) const MDL_FINAL
+    {
+        return m_cache.lookup(absname, static_cast<Batch_lookup_handle *>(handle), this);
+    }
+
+    /// Get the module loading callback.
+    IModule_loaded_callback *get_module_loading_callback() const MDL_FINAL {
+        return &m_cache;
+    }
+
+private:
+    /// The shared module cache.
+    Batch_module_cache &m_cache;
+
+    /// The compilations this one is currently waiting for, once per waiting thread.
+    /// Protected by the lock of the shared cache.
+    mutable std::vector<Batch_job const *> m_waits_for;
+};
+
+// Lookup a module for a compilation.
+IModule const *Batch_module_cache::lookup(
+    char const          *absname,
+    Batch_lookup_handle *handle,
+    Batch_job const     *job)
+{
+    std::unique_lock<std::mutex> guard(m_lock);
+
+    std::string name(absname);
+    if (handle != NULL)
+        handle->m_lookup_name = name;
+
+    for (;;) {
+        Module_map::const_iterator it(m_modules.find(name));
+        if (it != m_modules.end()) {
+            IModule const *module = it->second.get();
+            module->retain();
+            return module;
+        }
+        if (handle == NULL)
+            return NULL;
+
+        Loading_map::const_iterator lit(m_loading.find(name));
+        if (lit == m_loading.end()) {
+            // nobody loads it (anymore), do it here
+            m_loading[name] = job;
+            handle->m_is_processing = true;
+            handle->m_owns_entry    = true;
+            return NULL;
+        }
+
+        Batch_job const *owner = lit->second;
+        if (owner == job || waits_for(owner, job)) {
+            // waiting would never return, load it here as well
+            handle->m_is_processing = true;
+            return NULL;
+        }
+
+        std::vector<Batch_job const *> &waits = job->m_waits_for;
+        waits.push_back(owner);
+        m_loaded.wait(guard);
+        waits.erase(std::find(waits.begin(), waits.end(), owner));
+    }
+}
+
+// Check if the given compilation waits, directly or indirectly, for another one.
+bool Batch_module_cache::waits_for(Batch_job const *job, Batch_job const *other) const
+{
+    std::vector<Batch_job const *> queue(1, job);
+    std::vector<Batch_job const *> visited(1, job);
+    while (!queue.empty()) {
+        Batch_job const *curr = queue.back();
+        queue.pop_back();
+
+        for (size_t i = 0, n = curr->m_waits_for.size(); i < n; ++i) {
+            Batch_job const *next = curr->m_waits_for[i];
+            if (next == other)
+                return true;
+            if (std::find(visited.begin(), visited.end(), next) == visited.end()) {
+                visited.push_back(next);
+                queue.push_back(next);
+            }
+        }
+    }
+    return false;
+}
+
+/// The per module result of a batch run.
+struct Batch_result
+{
+    /// Constructor.
+    Batch_result()
+    : errors(0)
+    , failed(false)
+    , frontend_time(0.0)
+    , backend_time(0.0)
+    {
+    }
+
+    unsigned errors;         ///< number of compiler errors
+    bool     failed;         ///< true if the module or its target code could not be created
+    double   frontend_time;  ///< time in seconds spent loading and compiling the module
+    double   backend_time;   ///< time in seconds spent generating and writing target code
+};
+
+/// Convert a module name into a file name without extension.
+///
+/// \param module_name  the (possibly absolute) MDL module name
+static std::string module_file_name(std::string const &module_name)
+{
+    std::string res;
+    size_t i = 0, n = module_name.size();
+    if (module_name.compare(0, 2, "::") == 0)
+        i = 2;
+    for (; i < n; ++i) {
+        char c = module_name[i];
+        if (c == ':' && i + 1 < n && module_name[i + 1] == ':') {
+            res += '_';
+            ++i;
+        } else if (c == '/' || c == '\\') {
+            res += '_';
+        } else {
+            res += c;
+        }
+    }
+    return res;
+}
+
+/// Convert a steady clock duration into seconds.
+template<typename D>
+static double to_seconds(D const &d)
+{
+    return std::chrono::duration_cast<std::chrono::duration<double> >(d).count();
+}
+
+} // anonymous
+
 
 Mdlc::Mdlc(char const *program_name)
 : m_program(program_name)
@@ -120,6 +454,10 @@ Mdlc::Mdlc(char const *program_name)
 , m_target_lang(TL_NONE)
 , m_input_modules()
 , m_inline(false)
+, m_batch(false)
+, m_threads(0)
+, m_output_dir()
+, m_output_lock()
 {
 }
 
@@ -192,6 +530,20 @@ void Mdlc::usage()
         "  --inline\n"
         "  -i\n"
         "\tInlines the given module (if target is set to MDL).\n"
+        "  --batch\n"
+        "\tCompile all given modules in parallel, sharing one module cache, and\n"
+        "\treport per-phase timings and throughput. Modules are also taken from\n"
+        "\t--check-lib and --module-list. Target code is generated in batch mode\n"
+        "\teven for --check-lib.\n"
+        "  --module-list <file>\n"
+        "\tRead additional module names from <file>, one per line.\n"
+        "  --threads <n>\n"
+        "  -j <n>\n"
+        "\tUse at most <n> threads in batch mode (default: number of cores). More\n"
+        "\tthreads than cores are not used.\n"
+        "  --output-dir <dir>\n"
+        "\tIn batch mode, write the target code of each module into a file in <dir>\n"
+        "\tinstead of stdout. BIN output defaults to the current directory.\n"
         "  --help\n"
         "  -?"
         "\tThis help.\n",
@@ -215,16 +567,21 @@ int Mdlc::run(int argc, char *argv[])
         /*11*/ { "backend",                mi::getopt::REQUIRED_ARGUMENT, NULL, 'B' },
         /*12*/ { "internal-space",         mi::getopt::REQUIRED_ARGUMENT, NULL, 0 },
         /*13*/ { "show-positions",         mi::getopt::NO_ARGUMENT,       NULL, 0 },
-        /*15*/{ "inline",                  mi::getopt::NO_ARGUMENT,       NULL, 'i' },
-        /*16*/ { "help",                   mi::getopt::NO_ARGUMENT,       NULL, '?' },
-       
-        /*17*/ { NULL,                     0,                             NULL, 0 }
+        /*14*/ { "inline",                 mi::getopt::NO_ARGUMENT,       NULL, 'i' },
+        /*15*/ { "help",                   mi::getopt::NO_ARGUMENT,       NULL, '?' },
+        /*16*/ { "batch",                  mi::getopt::NO_ARGUMENT,       NULL, 0 },
+        /*17*/ { "module-list",            mi::getopt::REQUIRED_ARGUMENT, NULL, 0 },
+        /*18*/ { "threads",                mi::getopt::REQUIRED_ARGUMENT, NULL, 'j' },
+        /*19*/ { "output-dir",             mi::getopt::REQUIRED_ARGUMENT, NULL, 0 },
+
+        /*20*/ { NULL,                     0,                             NULL, 0 }
     };
 
     bool opt_error = false;
     bool show_version = false;
     int  c, longidx;
     std::string warn_options;
+    String_list module_lists;
 
     MDL_search_path *search_path(new MDL_search_path);
 
@@ -234,7 +591,7 @@ int Mdlc::run(int argc, char *argv[])
 
 
     while (
-        (c = mi::getopt::getopt_long(argc, argv, "O:W:Vvip:Ct:d:B:?", long_options, &longidx)) != -1
+        (c = mi::getopt::getopt_long(argc, argv, "O:W:Vvip:Ct:d:B:j:?", long_options, &longidx)) != -1
     ) {
         switch (c) {
         case 'O':
@@ -339,6 +696,22 @@ int Mdlc::run(int argc, char *argv[])
         case 'i':
             m_inline = true;
             break;
+        case 'j':
+            {
+                char const *s = mi::getopt::optarg;
+                char *end = NULL;
+                unsigned long n = strtoul(s, &end, 10);
+                if (end == s || *end != '\0' || n == 0) {
+                    fprintf(
+                        stderr,
+                        "%s error: invalid number of threads (%s)\n",
+                        argv[0],
+                        s);
+                    opt_error = true;
+                }
+                m_threads = unsigned(n);
+            }
+            break;
         case '\0':
             switch (longidx) {
             case 2:
@@ -370,6 +743,15 @@ int Mdlc::run(int argc, char *argv[])
             case 13:
                 m_show_positions = true;
                 break;
+            case 16:
+                m_batch = true;
+                break;
+            case 17:
+                module_lists.push_back(mi::getopt::optarg);
+                break;
+            case 19:
+                m_output_dir = mi::getopt::optarg;
+                break;
             default:
                 fprintf(
                     stderr,
@@ -410,21 +792,36 @@ int Mdlc::run(int argc, char *argv[])
 
     m_imdl->install_search_path(search_path);
 
-    if (mi::getopt::optind >= argc) {
+    if (mi::getopt::optind >= argc && m_check_root.empty() && module_lists.empty()) {
         fprintf(stderr,"%s: no source modules specified\n", argv[0]);
         return EXIT_FAILURE;
     }
 
     unsigned err_count = 0;
 
+    std::chrono::steady_clock::time_point discovery_start = std::chrono::steady_clock::now();
+
     if (!m_check_root.empty()) {
         find_all_modules(m_check_root.c_str(), NULL);
     }
 
+    for (String_list::const_iterator it(module_lists.begin()), end(module_lists.end());
+         it != end;
+         ++it)
+    {
+        if (!read_module_list(it->c_str()))
+            return EXIT_FAILURE;
+    }
+
     for (int i = mi::getopt::optind; i < argc; ++i) {
         m_input_modules.push_back(argv[i]);
     }
 
+    if (m_batch) {
+        double discovery_time = to_seconds(std::chrono::steady_clock::now() - discovery_start);
+        return run_batch(discovery_time) == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
     for (String_list::const_iterator it(m_input_modules.begin()), end(m_input_modules.end());
          it != end;
          ++it)
@@ -470,18 +867,16 @@ int Mdlc::run(int argc, char *argv[])
 }
 
 // Compile one module.
-IModule const *Mdlc::compile(char const *module_name, unsigned &errors)
+IModule const *Mdlc::compile(
+    char const    *module_name,
+    unsigned      &errors,
+    IModule_cache *cache)
 {
     mi::base::Handle<IThread_context> ctx(m_imdl->create_thread_context());
-    IModule const *module = m_imdl->load_module(ctx.get(), module_name, /*cache=*/NULL);
-
-    mi::base::Handle<IOutput_stream> os_stderr(m_imdl->create_std_stream(IMDL::OS_STDERR));
-    mi::base::Handle<IPrinter> printer(m_imdl->create_printer(os_stderr.get()));
-
-    printer->enable_color(m_syntax_coloring);
+    IModule const *module = m_imdl->load_module(ctx.get(), module_name, cache);
 
     Messages const &msgs = ctx->access_messages();
-    print_messages(msgs, printer.get());
+    report_messages(msgs);
 
     unsigned err_count = msgs.get_error_message_count();
     if (0 < err_count) {
@@ -494,6 +889,21 @@ IModule const *Mdlc::compile(char const *module_name, unsigned &errors)
     return module;
 }
 
+// Prints compiler messages to stderr.
+void Mdlc::report_messages(Messages const &msgs)
+{
+    if (msgs.get_message_count() == 0)
+        return;
+
+    mi::base::Handle<IOutput_stream> os_stderr(m_imdl->create_std_stream(IMDL::OS_STDERR));
+    mi::base::Handle<IPrinter> printer(m_imdl->create_printer(os_stderr.get()));
+
+    printer->enable_color(m_syntax_coloring);
+
+    std::lock_guard<std::mutex> guard(m_output_lock);
+    print_messages(msgs, printer.get());
+}
+
 // Apply backend options.
 void Mdlc::apply_backend_options(mi::mdl::Options &opts)
 {
@@ -520,13 +930,8 @@ void Mdlc::apply_backend_options(mi::mdl::Options &opts)
 
 
 // Compile a module to a target language.
-bool Mdlc::backend(IModule const *module)
+bool Mdlc::backend(IModule const *module, IOutput_stream *os)
 {
-    mi::base::Handle<IOutput_stream> os_stderr(m_imdl->create_std_stream(IMDL::OS_STDERR));
-    mi::base::Handle<IPrinter> printer(m_imdl->create_printer(os_stderr.get()));
-
-    printer->enable_color(m_syntax_coloring);
-
     switch (m_target_lang) {
     case TL_NONE:
         break;
@@ -537,7 +942,7 @@ bool Mdlc::backend(IModule const *module)
             mi::base::Handle<IModule const> inlined_module(
                 transformer->inline_imports(module));
             if (inlined_module.is_valid_interface()) {
-                print_generated_code(inlined_module.get());
+                print_generated_code(inlined_module.get(), os);
             } else {
                 fprintf(
                     stderr,
@@ -545,12 +950,12 @@ bool Mdlc::backend(IModule const *module)
                     m_program, module->get_name());
 
                 Messages const &msgs = transformer->access_messages();
-                print_messages(msgs, printer.get());
+                report_messages(msgs);
 
                 return false;
             }
         } else {
-            print_generated_code(module);
+            print_generated_code(module, os);
         }
         break;
     case TL_DAG:
@@ -590,7 +995,7 @@ bool Mdlc::backend(IModule const *module)
             }
 
             Messages const &msgs = dag->access_messages();
-            print_messages(msgs, printer.get());
+            report_messages(msgs);
 
             int err_count = msgs.get_error_message_count();
             if (0 < err_count) {
@@ -598,7 +1003,7 @@ bool Mdlc::backend(IModule const *module)
                                 m_program, err_count, module->get_name());
                 return false;
             } else {
-                print_generated_code(dag.get());
+                print_generated_code(dag.get(), os);
             }
         }
         break;
@@ -612,10 +1017,14 @@ bool Mdlc::backend(IModule const *module)
         break;
     case TL_BIN:
         if (module->is_valid()) {
-            mi::base::Handle<IOutput_stream> os(m_imdl->create_file_output_stream("output.bin"));
-            mi::mdl::Stream_serializer stream_serializer(os.get());
-
-            if (os.is_valid_interface()) {
+            mi::base::Handle<IOutput_stream> bin_os;
+            if (os != NULL)
+                bin_os = mi::base::make_handle_dup(os);
+            else
+                bin_os = mi::base::make_handle(m_imdl->create_file_output_stream("output.bin"));
+            mi::mdl::Stream_serializer stream_serializer(bin_os.get());
+
+            if (bin_os.is_valid_interface()) {
                 m_imdl->serialize_module(module, &stream_serializer, true);
             }
         }
@@ -662,10 +1071,17 @@ IModule const *Mdlc::load_binary(char const *filename, unsigned &errors)
 }
 
 
-// Prints colorized code to stdout.
-void Mdlc::print_generated_code(IModule const *mod)
+// Prints colorized code to the given stream or stdout if NULL.
+void Mdlc::print_generated_code(IModule const *mod, IOutput_stream *os)
 {
-    mi::base::Handle<IOutput_stream> os_stdout(m_imdl->create_std_stream(IMDL::OS_STDOUT));
+    std::unique_lock<std::mutex> guard(m_output_lock, std::defer_lock);
+    mi::base::Handle<IOutput_stream> os_stdout;
+    if (os != NULL) {
+        os_stdout = mi::base::make_handle_dup(os);
+    } else {
+        os_stdout = mi::base::make_handle(m_imdl->create_std_stream(IMDL::OS_STDOUT));
+        guard.lock();
+    }
     if (mod->is_valid()) {
         // use the exporter
         mi::base::Handle<IMDL_exporter> exporter(m_imdl->create_exporter());
@@ -680,16 +1096,206 @@ void Mdlc::print_generated_code(IModule const *mod)
     }
 }
 
-// Prints colorized code to stdout.
-void Mdlc::print_generated_code(IGenerated_code const *code)
+// Prints colorized code to the given stream or stdout if NULL.
+void Mdlc::print_generated_code(IGenerated_code const *code, IOutput_stream *os)
 {
-    mi::base::Handle<IOutput_stream> os_stdout(m_imdl->create_std_stream(IMDL::OS_STDOUT));
+    std::unique_lock<std::mutex> guard(m_output_lock, std::defer_lock);
+    mi::base::Handle<IOutput_stream> os_stdout;
+    if (os != NULL) {
+        os_stdout = mi::base::make_handle_dup(os);
+    } else {
+        os_stdout = mi::base::make_handle(m_imdl->create_std_stream(IMDL::OS_STDOUT));
+        guard.lock();
+    }
     mi::base::Handle<IPrinter> printer(m_imdl->create_printer(os_stdout.get()));
     printer->enable_color(m_syntax_coloring);
     printer->show_positions(m_show_positions);
     printer->print(code);
 }
 
+// Compile all input modules in parallel, sharing one module cache.
+unsigned Mdlc::run_batch(double discovery_time)
+{
+    typedef std::chrono::steady_clock Clock;
+
+    std::vector<std::string> modules(m_input_modules.begin(), m_input_modules.end());
+    size_t n_modules = modules.size();
+
+    if (n_modules == 0) {
+        fprintf(stderr, "%s: no modules found for batch compilation\n", m_program);
+        return 0;
+    }
+
+    unsigned n_threads = m_threads;
+    if (n_threads == 0)
+        n_threads = std::thread::hardware_concurrency();
+    if (n_threads == 0)
+        n_threads = 1;
+    if (n_threads > n_modules)
+        n_threads = unsigned(n_modules);
+
+    std::string output_dir(m_output_dir);
+    if (output_dir.empty() && m_target_lang == TL_BIN) {
+        // all workers would write output.bin otherwise
+        output_dir = ".";
+    }
+
+    char const *ext = "";
+    switch (m_target_lang) {
+    case TL_MDL: ext = ".mdl"; break;
+    case TL_DAG: ext = ".dag"; break;
+    case TL_BIN: ext = ".bin"; break;
+    default:     break;
+    }
+
+    Batch_module_cache      cache;
+    std::vector<Batch_result> results(n_modules);
+    std::atomic<size_t>     next_module(0);
+
+    auto worker = [&]() {
+        for (;;) {
+            size_t i = next_module.fetch_add(1);
+            if (i >= n_modules)
+                break;
+
+            std::string const &name = modules[i];
+            Batch_result       &res = results[i];
+
+            Clock::time_point t0 = Clock::now();
+
+            mi::base::Handle<IModule const> module;
+            if (is_binary(name.c_str())) {
+                module = mi::base::make_handle(load_binary(name.c_str(), res.errors));
+            } else {
+                Batch_job job(cache);
+                module = mi::base::make_handle(compile(name.c_str(), res.errors, &job));
+            }
+
+            Clock::time_point t1 = Clock::now();
+            res.frontend_time = to_seconds(t1 - t0);
+
+            if (!module.is_valid_interface()) {
+                res.failed = true;
+                continue;
+            }
+            cache.enter(module.get());
+
+            mi::base::Handle<IOutput_stream> os;
+            if (!output_dir.empty() && m_target_lang != TL_NONE && module->is_valid()) {
+                std::string fname(output_dir + "/" + module_file_name(name) + ext);
+                os = mi::base::make_handle(m_imdl->create_file_output_stream(fname.c_str()));
+                if (!os.is_valid_interface()) {
+                    fprintf(
+                        stderr, "%s: failed to open '%s' for writing\n",
+                        m_program, fname.c_str());
+                    res.failed = true;
+                    continue;
+                }
+            }
+
+            if (!backend(module.get(), os.get()))
+                res.failed = true;
+            if (res.errors > 0)
+                res.failed = true;
+
+            res.backend_time = to_seconds(Clock::now() - t1);
+        }
+    };
+
+    Clock::time_point start = Clock::now();
+
+    // the workers are borrowed from the process-wide thread budget, which the parallel loops
+    // inside the compiler share
+    unsigned n_workers = unsigned(MI::STLEXT::Thread_budget::acquire(n_threads - 1));
+    n_threads = n_workers + 1;
+
+    std::vector<std::thread> threads;
+    threads.reserve(n_workers);
+    for (unsigned i = 0; i < n_workers; ++i)
+        threads.push_back(std::thread(worker));
+    worker();
+    for (size_t i = 0, n = threads.size(); i < n; ++i)
+        threads[i].join();
+
+    MI::STLEXT::Thread_budget::release(n_workers);
+
+    double wall_time = to_seconds(Clock::now() - start);
+
+    unsigned n_failed = 0, n_errors = 0;
+    double frontend_time = 0.0, backend_time = 0.0;
+    for (size_t i = 0; i < n_modules; ++i) {
+        Batch_result const &res = results[i];
+
+        if (res.failed)
+            ++n_failed;
+        n_errors      += res.errors;
+        frontend_time += res.frontend_time;
+        backend_time  += res.backend_time;
+
+        if (m_verbose) {
+            fprintf(
+                stderr,
+                "%s: %-48s frontend %8.2f ms  backend %8.2f ms%s\n",
+                m_program,
+                modules[i].c_str(),
+                res.frontend_time * 1000.0,
+                res.backend_time * 1000.0,
+                res.failed ? "  FAILED" : "");
+        }
+    }
+
+    fprintf(
+        stderr,
+        "%s: batch compiled %u modules on %u threads, %u failed, %u errors\n"
+        "\tdiscovery  %10.3f s\n"
+        "\tfrontend   %10.3f s (summed over threads)\n"
+        "\tbackend    %10.3f s (summed over threads)\n"
+        "\twall       %10.3f s\n"
+        "\tthroughput %10.1f modules/s, %.2f ms/module\n",
+        m_program,
+        unsigned(n_modules),
+        n_threads,
+        n_failed,
+        n_errors,
+        discovery_time,
+        frontend_time,
+        backend_time,
+        wall_time,
+        wall_time > 0.0 ? double(n_modules) / wall_time : 0.0,
+        wall_time * 1000.0 / double(n_modules));
+
+    return n_failed;
+}
+
+// Read module names from a file, one name per line.
+bool Mdlc::read_module_list(char const *filename)
+{
+    FILE *f = fopen(filename, "r");
+    if (f == NULL) {
+        fprintf(stderr, "%s: failed to open module list '%s'\n", m_program, filename);
+        return false;
+    }
+
+    char line[1024];
+    while (fgets(line, sizeof(line), f) != NULL) {
+        // strip trailing whitespace and ignore empty lines and comments
+        size_t len = strlen(line);
+        while (len > 0 && isspace((unsigned char)line[len - 1]))
+            --len;
+        line[len] = '\0';
+
+        char const *name = line;
+        while (isspace((unsigned char)*name))
+            ++name;
+
+        if (name[0] == '\0' || name[0] == '#')
+            continue;
+        m_input_modules.push_back(name);
+    }
+    fclose(f);
+    return true;
+}
+
 namespace {
 
 /// Represents a single directory in a OS independent way.
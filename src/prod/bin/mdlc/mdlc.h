@@ -33,14 +33,18 @@
 
 #include <string>
 #include <list>
+#include <mutex>
 
 namespace mi {
     namespace mdl {
         class IMDL;
         class IModule;
         class IGenerated_code;
+        class IModule_cache;
+        class IOutput_stream;
         class ISyntax_coloring;
         class Options;
+        class Messages;
     }
 }
 
@@ -86,18 +90,34 @@ private:
     /// Compile one module.
     /// \param      module_name     The name of the module to compile.
     /// \param      errors          The number of errors detected during compilation.
+    /// \param      cache           If non-NULL, a module cache shared between compilations.
     /// \returns                    NULL: Some serious error occurred and no modules was created.
     ///                             The created module.
-    mi::mdl::IModule const *compile(char const *module_name, unsigned &errors);
+    mi::mdl::IModule const *compile(
+        char const              *module_name,
+        unsigned                &errors,
+        mi::mdl::IModule_cache  *cache = NULL);
 
     // Apply backend options.
     void apply_backend_options(mi::mdl::Options &opts);
 
     /// Compile a module to a target language.
     /// \param      module          The module to compile.
+    /// \param      os              If non-NULL, the stream receiving the target code,
+    ///                             otherwise stdout (or output.bin for the BIN target).
     /// \returns                    false: Some serious error occurred.
     ///                             true: compiled to target
-    bool backend(mi::mdl::IModule const *module);
+    bool backend(mi::mdl::IModule const *module, mi::mdl::IOutput_stream *os = NULL);
+
+    /// Compile all input modules in parallel, sharing one module cache.
+    /// \param      discovery_time  The time in seconds spent collecting the input modules.
+    /// \returns                    The number of modules that failed.
+    unsigned run_batch(double discovery_time);
+
+    /// Read module names from a file, one name per line.
+    /// \param      filename        The name of the list file.
+    /// \returns                    false if the file could not be opened.
+    bool read_module_list(char const *filename);
 
     /// Check if the given filename exists and if it represents a binary,
     ///
@@ -111,11 +131,18 @@ private:
     ///                             The created module.
     mi::mdl::IModule const *load_binary(char const *filename, unsigned &errors);
 
-    /// Prints colorized code to stdout.
-    void print_generated_code(mi::mdl::IModule const *mod);
+    /// Prints colorized code to the given stream or stdout if NULL.
+    void print_generated_code(
+        mi::mdl::IModule const  *mod,
+        mi::mdl::IOutput_stream *os = NULL);
 
-    /// Prints colorized code to stdout.
-    void print_generated_code(mi::mdl::IGenerated_code const *code);
+    /// Prints colorized code to the given stream or stdout if NULL.
+    void print_generated_code(
+        mi::mdl::IGenerated_code const *code,
+        mi::mdl::IOutput_stream        *os = NULL);
+
+    /// Prints compiler messages to stderr.
+    void report_messages(mi::mdl::Messages const &msgs);
 
     /// Find all modules in a library.
     void find_all_modules(char const *root, char const *package);
@@ -160,6 +187,18 @@ private:
 
     /// If set and target equals MDL, inline all imports except for stdlib/builtins
     bool m_inline;
+
+    /// If set, compile all input modules in parallel.
+    bool m_batch;
+
+    /// The number of worker threads in batch mode, 0 for the number of cores.
+    unsigned m_threads;
+
+    /// If non empty, batch mode writes one target file per module into this directory.
+    std::string m_output_dir;
+
+    /// Serializes output to stdout and stderr between batch workers.
+    std::mutex m_output_lock;
 };
 
 #endif
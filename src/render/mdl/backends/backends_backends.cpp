@@ -28,12 +28,14 @@
 
 #include "pch.h"
 
+#include <algorithm>
 #include <cstring>
 #include <map>
 #include <string>
 
 #include <mi/base/handle.h>
 #include <mi/base/types.h>
+#include <mi/neuraylib/icompiled_material.h>
 #include "mi/mdl/mdl_generated_dag.h"
 #include <mi/mdl/mdl_mdl.h>
 #include <mi/mdl/mdl_symbols.h>
@@ -1551,6 +1553,9 @@ Target_argument_block::Target_argument_block(mi::Size arg_block_size)
 , m_data(new char[arg_block_size])
 {
     memset(m_data, 0, m_size);
+
+    // a new block must be uploaded completely
+    mark_dirty(0, m_size);
 }
 
 Target_argument_block::~Target_argument_block()
@@ -1581,6 +1586,138 @@ mi::neuraylib::ITarget_argument_block *Target_argument_block::clone() const
     return cloned_block;
 }
 
+mi::Size Target_argument_block::get_dirty_range_count() const
+{
+    return m_dirty_ranges.size();
+}
+
+bool Target_argument_block::get_dirty_range(
+    mi::Size index,
+    mi::Size &offset,
+    mi::Size &size) const
+{
+    if (index >= m_dirty_ranges.size())
+        return false;
+
+    offset = m_dirty_ranges[index].first;
+    size   = m_dirty_ranges[index].second - m_dirty_ranges[index].first;
+    return true;
+}
+
+void Target_argument_block::mark_dirty(mi::Size offset, mi::Size size)
+{
+    if (offset >= m_size || size == 0)
+        return;
+
+    mi::Size begin = offset;
+    mi::Size end   = size > m_size - offset ? m_size : offset + size;
+
+    // find the first range ending at or after begin, all ranges from there on starting at or
+    // before end overlap or touch the new one and are merged into it
+    std::vector<std::pair<mi::Size, mi::Size> >::iterator first = std::lower_bound(
+        m_dirty_ranges.begin(), m_dirty_ranges.end(), begin,
+        [](std::pair<mi::Size, mi::Size> const &r, mi::Size b) { return r.second < b; });
+
+    std::vector<std::pair<mi::Size, mi::Size> >::iterator last = first;
+    while (last != m_dirty_ranges.end() && last->first <= end) {
+        begin = std::min(begin, last->first);
+        end   = std::max(end, last->second);
+        ++last;
+    }
+
+    if (first == last) {
+        m_dirty_ranges.insert(first, std::make_pair(begin, end));
+    } else {
+        *first = std::make_pair(begin, end);
+        m_dirty_ranges.erase(first + 1, last);
+    }
+}
+
+void Target_argument_block::clear_dirty_ranges()
+{
+    m_dirty_ranges.clear();
+}
+
+mi::Sint32 Target_argument_block::set_value(
+    const mi::neuraylib::ITarget_value_layout *layout,
+    mi::Size index,
+    const mi::neuraylib::IValue *value,
+    mi::neuraylib::ITarget_resource_callback *resource_callback)
+{
+    if (index >= layout->get_num_elements())
+        return -2;
+
+    mi::neuraylib::Target_value_layout_state state = layout->get_nested_state(index);
+
+    mi::neuraylib::IValue::Kind kind;
+    mi::Size arg_size;
+    mi::Size offs = layout->get_layout(kind, arg_size, state);
+    if (offs == ~mi::Size(0))
+        return -2;
+
+    mi::Sint32 res = layout->set_value(m_data, value, resource_callback, state);
+    if (res == 0)
+        mark_dirty(offs, arg_size);
+    return res;
+}
+
+mi::Sint32 Target_argument_block::set_values(
+    const mi::neuraylib::ITarget_value_layout *layout,
+    mi::Size count,
+    const mi::Size *indices,
+    const mi::neuraylib::IValue* const *values,
+    mi::neuraylib::ITarget_resource_callback *resource_callback)
+{
+    if (layout == NULL || (count > 0 && (indices == NULL || values == NULL)))
+        return -1;
+    if (layout->get_size() != m_size)
+        return -1;
+
+    for (mi::Size i = 0; i < count; ++i) {
+        if (values[i] == NULL)
+            return -1;
+        mi::Sint32 res = set_value(layout, indices[i], values[i], resource_callback);
+        if (res != 0)
+            return res;
+    }
+    return 0;
+}
+
+mi::Sint32 Target_argument_block::set_values_by_name(
+    const mi::neuraylib::ICompiled_material *material,
+    const mi::neuraylib::ITarget_value_layout *layout,
+    mi::Size count,
+    const char* const *names,
+    const mi::neuraylib::IValue* const *values,
+    mi::neuraylib::ITarget_resource_callback *resource_callback)
+{
+    if (material == NULL || layout == NULL || (count > 0 && (names == NULL || values == NULL)))
+        return -1;
+    if (layout->get_size() != m_size)
+        return -1;
+
+    // map the parameter names to the layout indices once for the whole batch
+    std::map<std::string, mi::Size> index_map;
+    for (mi::Size i = 0, n = material->get_parameter_count(); i < n; ++i) {
+        if (char const *name = material->get_parameter_name(i))
+            index_map[name] = i;
+    }
+
+    for (mi::Size i = 0; i < count; ++i) {
+        if (names[i] == NULL || values[i] == NULL)
+            return -1;
+
+        std::map<std::string, mi::Size>::const_iterator it = index_map.find(names[i]);
+        if (it == index_map.end())
+            return -2;
+
+        mi::Sint32 res = set_value(layout, it->second, values[i], resource_callback);
+        if (res != 0)
+            return res;
+    }
+    return 0;
+}
+
 // ---------------------- Target value layout class ---------------------
 
 // Constructor.
@@ -1965,6 +2102,8 @@ mi::Sint32 Link_unit::add_environment(
     char const                   *fname,
     MDL::Execution_context       *context)
 {
+    MDL::Profiling_scope profiling_scope(context, "link_unit_add_environment");
+
     if (function_call == NULL || m_transaction == NULL)
     {
         MDL::add_context_error(context, "Invalid parameters (NULL pointer).", -1);
@@ -2031,6 +2170,7 @@ mi::Sint32 Link_unit::add_environment(
         lambda->set_has_resource_attributes(false);
 
     // ... and add it to the compilation unit
+    MDL::Profiling_scope codegen_scope(context, "generate_code");
     mi::base::Handle<mi::mdl::IGenerated_code_executable> code;
 
     size_t arg_block_index = ~0;
@@ -2101,6 +2241,8 @@ mi::Sint32 Link_unit::add_material(
     mi::Size                                      description_count,
     MDL::Execution_context                       *context)
 {
+    MDL::Profiling_scope profiling_scope(context, "link_unit_add_material");
+
     if (compiled_material == NULL) {
         MDL::add_context_error(context, "Invalid parameters (NULL pointer).", -1);
         return -1;
@@ -2511,7 +2653,11 @@ Mdl_llvm_backend::Mdl_llvm_backend(
     m_output_target_lang(true),
     m_strings_mapped_to_ids(string_ids),
     m_calc_derivatives(false),
-    m_use_builtin_resource_handler(true)
+    m_use_builtin_resource_handler(true),
+    m_linearize_textures(false),
+    m_use_texture_footprints(false),
+    m_use_ptex_lookups(false),
+    m_ptex_cache_size(64 * 1024 * 1024)
 {
     mi::mdl::Options &options = m_jit->access_options();
 
@@ -2704,6 +2850,18 @@ mi::Sint32 Mdl_llvm_backend::set_option(
         return 0;
     }
 
+    if (strcmp(name, "shared_runtime") == 0) {
+        if (m_kind != mi::neuraylib::IMdl_compiler::MB_CUDA_PTX &&
+            m_kind != mi::neuraylib::IMdl_compiler::MB_HLSL)
+            return -1;
+        if (strcmp(value, "inline") != 0 &&
+            strcmp(value, "external") != 0 &&
+            strcmp(value, "runtime") != 0)
+            return -2;
+        jit_options.set_option(MDL_JIT_OPTION_SHARED_RUNTIME_MODE, value);
+        return 0;
+    }
+
 
     switch (m_kind) {
     case mi::neuraylib::IMdl_compiler::MB_CUDA_PTX:
@@ -2799,6 +2957,66 @@ mi::Sint32 Mdl_llvm_backend::set_option(
             jit_options.set_option(MDL_JIT_USE_BUILTIN_RESOURCE_HANDLER_CPU, value);
             return 0;
         }
+        if (strcmp(name, "linearize_textures") == 0) {
+            if (strcmp(value, "on") == 0) {
+                m_linearize_textures = true;
+            } else if (strcmp(value, "off") == 0) {
+                m_linearize_textures = false;
+            } else {
+                return -2;
+            }
+            return 0;
+        }
+        if (strcmp(name, "share_functions") == 0) {
+            if (strcmp(value, "off") == 0) {
+                value = "false";
+            } else if (strcmp(value, "on") == 0) {
+                value = "true";
+            } else {
+                return -2;
+            }
+            jit_options.set_option(MDL_JIT_OPTION_SHARE_FUNCTIONS, value);
+            return 0;
+        }
+        if (strcmp(name, "tiered_compilation") == 0) {
+            if (strcmp(value, "off") == 0) {
+                value = "false";
+            } else if (strcmp(value, "on") == 0) {
+                value = "true";
+            } else {
+                return -2;
+            }
+            jit_options.set_option(MDL_JIT_OPTION_TIERED_COMPILATION, value);
+            return 0;
+        }
+        if (strcmp(name, "texture_lookup_footprints") == 0) {
+            if (strcmp(value, "on") == 0) {
+                m_use_texture_footprints = true;
+            } else if (strcmp(value, "off") == 0) {
+                m_use_texture_footprints = false;
+            } else {
+                return -2;
+            }
+            return 0;
+        }
+        if (strcmp(name, "texture_lookup_ptex") == 0) {
+            if (strcmp(value, "on") == 0) {
+                m_use_ptex_lookups = true;
+            } else if (strcmp(value, "off") == 0) {
+                m_use_ptex_lookups = false;
+            } else {
+                return -2;
+            }
+            return 0;
+        }
+        if (strcmp(name, "ptex_cache_size") == 0) {
+            unsigned long long v = 0;
+            if (sscanf(value, "%llu", &v) != 1) {
+                return -2;
+            }
+            m_ptex_cache_size = mi::Size(v);
+            return 0;
+        }
         break;
 
     case mi::neuraylib::IMdl_compiler::MB_HLSL:
@@ -2842,6 +3060,8 @@ mi::neuraylib::ITarget_code const *Mdl_llvm_backend::translate_environment(
     char const                   *fname,
     MDL::Execution_context       *context)
 {
+    MDL::Profiling_scope profiling_scope(context, "translate_environment");
+
     if (transaction == NULL || function_call == NULL) {
         MDL::add_context_error(context, "Invalid parameters (NULL pointer).", -1);
         return NULL;
@@ -2892,6 +3112,7 @@ mi::neuraylib::ITarget_code const *Mdl_llvm_backend::translate_environment(
         lambda->set_has_resource_attributes(false);
 
     // now compile
+    MDL::Profiling_scope codegen_scope(context, "generate_code");
     mi::base::Handle<mi::mdl::IGenerated_code_executable> code;
 
     // currently supported only for LLVM-IR
@@ -2948,7 +3169,11 @@ mi::neuraylib::ITarget_code const *Mdl_llvm_backend::translate_environment(
         transaction,
         m_strings_mapped_to_ids,
         m_calc_derivatives,
-        m_use_builtin_resource_handler);
+        m_use_builtin_resource_handler,
+        m_linearize_textures,
+        m_use_texture_footprints,
+        m_use_ptex_lookups,
+        m_ptex_cache_size);
 
     // Enter the resource-table here
     fill_resource_tables(tc_reg, tc);
@@ -2975,6 +3200,8 @@ mi::neuraylib::ITarget_code const *Mdl_llvm_backend::translate_material_expressi
     char const                       *fname,
     MDL::Execution_context           *context)
 {
+    MDL::Profiling_scope profiling_scope(context, "translate_material_expression");
+
     if (!transaction || !compiled_material || !path) {
         MDL::add_context_error(context, "Invalid parameters (NULL pointer).", -1);
         return NULL;
@@ -3022,6 +3249,7 @@ mi::neuraylib::ITarget_code const *Mdl_llvm_backend::translate_material_expressi
         builder.enumerate_resource_arguments(lambda.get(), compiled_material, enumerator);
 
     // ... and compile
+    MDL::Profiling_scope codegen_scope(context, "generate_code");
     mi::base::Handle<mi::mdl::IGenerated_code_executable> code;
     switch (m_kind) {
     case mi::neuraylib::IMdl_compiler::MB_LLVM_IR:
@@ -3079,7 +3307,11 @@ mi::neuraylib::ITarget_code const *Mdl_llvm_backend::translate_material_expressi
         transaction,
         m_strings_mapped_to_ids,
         m_calc_derivatives,
-        m_use_builtin_resource_handler);
+        m_use_builtin_resource_handler,
+        m_linearize_textures,
+        m_use_texture_footprints,
+        m_use_ptex_lookups,
+        m_ptex_cache_size);
 
     // Enter the resource-table here
     fill_resource_tables(tc_reg, tc);
@@ -3235,7 +3467,12 @@ mi::neuraylib::ITarget_code const *Mdl_llvm_backend::translate_material_expressi
         code.get(),
         transaction,
         m_strings_mapped_to_ids,
-        m_calc_derivatives, m_use_builtin_resource_handler);
+        m_calc_derivatives,
+        m_use_builtin_resource_handler,
+        m_linearize_textures,
+        m_use_texture_footprints,
+        m_use_ptex_lookups,
+        m_ptex_cache_size);
 
     // Enter the resource-table here
     fill_resource_tables(tc_reg, tc);
@@ -3409,7 +3646,12 @@ mi::neuraylib::ITarget_code const *Mdl_llvm_backend::translate_material_expressi
         code.get(),
         transaction,
         m_strings_mapped_to_ids,
-        m_calc_derivatives, m_use_builtin_resource_handler);
+        m_calc_derivatives,
+        m_use_builtin_resource_handler,
+        m_linearize_textures,
+        m_use_texture_footprints,
+        m_use_ptex_lookups,
+        m_ptex_cache_size);
 
     // Enter the resource-table here
     fill_resource_tables(tc_reg, tc);
@@ -3441,6 +3683,8 @@ const mi::neuraylib::ITarget_code* Mdl_llvm_backend::translate_material_df(
     const char* base_fname,
     MDL::Execution_context* context)
 {
+    MDL::Profiling_scope profiling_scope(context, "translate_material_df");
+
     if (!compiled_material->is_valid(transaction, context)) {
         MDL::add_context_error(context, "Compiled material is invalid.", -1);
         return NULL;
@@ -3507,6 +3751,7 @@ const mi::neuraylib::ITarget_code* Mdl_llvm_backend::translate_material_df(
     }
 
     // ... and compile
+    MDL::Profiling_scope codegen_scope(context, "generate_code");
     mi::base::Handle<mi::mdl::IGenerated_code_executable> code;
 
     switch (m_kind) {
@@ -3554,7 +3799,11 @@ const mi::neuraylib::ITarget_code* Mdl_llvm_backend::translate_material_df(
         transaction,
         m_strings_mapped_to_ids,
         m_calc_derivatives,
-        m_use_builtin_resource_handler);
+        m_use_builtin_resource_handler,
+        m_linearize_textures,
+        m_use_texture_footprints,
+        m_use_ptex_lookups,
+        m_ptex_cache_size);
 
     // Enter the resource-table here
     fill_resource_tables(tc_reg, tc);
@@ -3596,9 +3845,12 @@ mi::neuraylib::ITarget_code const *Mdl_llvm_backend::translate_link_unit(
     Link_unit const *lu,
     MDL::Execution_context* context)
 {
+    MDL::Profiling_scope profiling_scope(context, "translate_link_unit");
+
     m_jit->access_options().set_option(MDL_CG_OPTION_INTERNAL_SPACE,
         lu->get_internal_space());
 
+    MDL::Profiling_scope codegen_scope(context, "generate_code");
     mi::base::Handle<mi::mdl::IGenerated_code_executable> code(
         m_jit->compile_unit(mi::base::make_handle(lu->get_compilation_unit()).get()));
 
@@ -3617,7 +3869,14 @@ mi::neuraylib::ITarget_code const *Mdl_llvm_backend::translate_link_unit(
     }
 
     mi::base::Handle<Target_code> tc(lu->get_target_code());
-    tc->finalize(code.get(), lu->get_transaction(), m_calc_derivatives);
+    tc->finalize(
+        code.get(),
+        lu->get_transaction(),
+        m_calc_derivatives,
+        m_linearize_textures,
+        m_use_texture_footprints,
+        m_use_ptex_lookups,
+        m_ptex_cache_size);
 
     // Enter the resource-table here
     fill_resource_tables(*lu->get_tc_reg(), tc.get());
@@ -219,6 +219,19 @@ private:
 
     /// If true, use the builtin resource handler when running native code
     bool m_use_builtin_resource_handler;
+
+    /// If true, the builtin resource handler converts gamma-encoded textures to linear canvases
+    /// at initialization instead of linearizing them on lookup.
+    bool m_linearize_textures;
+
+    /// If true, the builtin resource handler uses footprints for non-derivative 2D lookups.
+    bool m_use_texture_footprints;
+
+    /// If true, the builtin resource handler takes faces for ptex lookups from the thread data.
+    bool m_use_ptex_lookups;
+
+    /// The maximum number of bytes of decoded ptex faces kept by the builtin resource handler.
+    mi::Size m_ptex_cache_size;
 };
 
 
@@ -246,16 +259,55 @@ public:
     /// Clones the target argument block (to make it writeable).
     ITarget_argument_block *clone() const override;
 
+    /// Returns the number of byte ranges modified since the last acknowledgment.
+    mi::Size get_dirty_range_count() const override;
+
+    /// Returns a modified byte range.
+    bool get_dirty_range(mi::Size index, mi::Size &offset, mi::Size &size) const override;
+
+    /// Marks a byte range as modified.
+    void mark_dirty(mi::Size offset, mi::Size size) override;
+
+    /// Acknowledges all modifications.
+    void clear_dirty_ranges() override;
+
+    /// Sets several arguments given by their layout indices.
+    mi::Sint32 set_values(
+        const mi::neuraylib::ITarget_value_layout *layout,
+        mi::Size count,
+        const mi::Size *indices,
+        const mi::neuraylib::IValue* const *values,
+        mi::neuraylib::ITarget_resource_callback *resource_callback) override;
+
+    /// Sets several arguments given by their compiled material parameter names.
+    mi::Sint32 set_values_by_name(
+        const mi::neuraylib::ICompiled_material *material,
+        const mi::neuraylib::ITarget_value_layout *layout,
+        mi::Size count,
+        const char* const *names,
+        const mi::neuraylib::IValue* const *values,
+        mi::neuraylib::ITarget_resource_callback *resource_callback) override;
+
 private:
     /// Destructor.
     ~Target_argument_block();
 
+    /// Sets one top-level argument and marks its byte range as modified.
+    mi::Sint32 set_value(
+        const mi::neuraylib::ITarget_value_layout *layout,
+        mi::Size index,
+        const mi::neuraylib::IValue *value,
+        mi::neuraylib::ITarget_resource_callback *resource_callback);
+
 private:
     /// The size of the argument block data.
     mi::Size m_size;
 
     /// The target argument block data.
     char *m_data;
+
+    /// The modified byte ranges as sorted, disjoint and non-adjacent [begin, end) pairs.
+    std::vector<std::pair<mi::Size, mi::Size> > m_dirty_ranges;
 };
 
 /// Internal version of the #mi::neuraylib::ITarget_resource_callback callback interface
@@ -108,7 +108,11 @@ Target_code::Target_code(
     MI::DB::Transaction* transaction,
     bool string_ids,
     bool use_derivatives,
-    bool use_builtin_resource_handler)
+    bool use_builtin_resource_handler,
+    bool linearize_textures,
+    bool use_texture_footprints,
+    bool use_ptex_lookups,
+    mi::Size ptex_cache_size)
   : m_native_code(),
     m_code(),
     m_code_segments(),
@@ -127,7 +131,14 @@ Target_code::Target_code(
     m_string_args_mapped_to_ids(string_ids),
     m_use_builtin_resource_handler(use_builtin_resource_handler)
 {
-    finalize(code, transaction, use_derivatives);
+    finalize(
+        code,
+        transaction,
+        use_derivatives,
+        linearize_textures,
+        use_texture_footprints,
+        use_ptex_lookups,
+        ptex_cache_size);
 
     size_t num_layouts = code->get_captured_argument_layouts_count();
     m_cap_arg_blocks.resize(num_layouts);   // already prepare the empty argument block slots
@@ -183,7 +194,11 @@ Target_code::~Target_code()
 void Target_code::finalize(
     mi::mdl::IGenerated_code_executable* code,
     MI::DB::Transaction* transaction,
-    bool use_derivatives)
+    bool use_derivatives,
+    bool linearize_textures,
+    bool use_texture_footprints,
+    bool use_ptex_lookups,
+    mi::Size ptex_cache_size)
 {
     m_native_code = mi::base::make_handle(
         code->get_interface<mi::mdl::IGenerated_code_lambda_function>());
@@ -191,7 +206,12 @@ void Target_code::finalize(
 
     if (m_native_code.is_valid_interface()) {
         if(m_use_builtin_resource_handler)
-            m_rh = new MDLRT::Resource_handler(use_derivatives);
+            m_rh = new MDLRT::Resource_handler(
+                use_derivatives,
+                linearize_textures,
+                use_texture_footprints,
+                use_ptex_lookups,
+                ptex_cache_size);
 
         m_native_code->init(transaction, NULL, m_rh);
     } else {
@@ -103,12 +103,24 @@ public:
     /// \param use_derivatives  True if derivative support is enabled for the generated code
     /// \param use_builtin_resource_handler True, if the builtin texture runtime is supposed to be
     ///                         used when running x86 code.
+    /// \param linearize_textures True, if the builtin texture runtime should convert
+    ///                         gamma-encoded textures to linear canvases at initialization.
+    /// \param use_texture_footprints True, if the builtin texture runtime should use the
+    ///                         footprints passed via the texture handler for 2D lookups.
+    /// \param use_ptex_lookups True, if the builtin texture runtime should use the faces passed
+    ///                         via the texture handler for ptex lookups.
+    /// \param ptex_cache_size  The maximum number of bytes of decoded ptex faces kept by the
+    ///                         builtin texture runtime.
     Target_code(
         mi::mdl::IGenerated_code_executable* code,
         MI::DB::Transaction* transaction,
         bool string_ids,
         bool use_derivatives,
-        bool use_builtin_resource_handler);
+        bool use_builtin_resource_handler,
+        bool linearize_textures,
+        bool use_texture_footprints,
+        bool use_ptex_lookups,
+        mi::Size ptex_cache_size);
 
 
     /// Constructor for link mode.
@@ -121,7 +133,11 @@ public:
     /// Finalization method for link mode for executable code.
     void finalize( mi::mdl::IGenerated_code_executable* code,
         MI::DB::Transaction* transaction,
-        bool use_derivatives);
+        bool use_derivatives,
+        bool linearize_textures,
+        bool use_texture_footprints,
+        bool use_ptex_lookups,
+        mi::Size ptex_cache_size);
 
 
     // API methods
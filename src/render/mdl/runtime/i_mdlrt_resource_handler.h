@@ -35,6 +35,9 @@
 
 #include <mi/mdl/mdl_generated_executable.h>
 #include <mi/base/handle.h>
+#include <mi/neuraylib/target_code_types.h>
+
+#include <render/mdl/runtime/i_mdlrt_texture.h>
 
 namespace MI {
 namespace MDLRT {
@@ -47,12 +50,33 @@ class Resource_handler : public mi::mdl::IResource_handler {
 public:
     /// Constructor.
     ///
-    /// \param use_derivatives  true if derivative texturing functions will be used
-    Resource_handler(bool use_derivatives=false)
+    /// \param use_derivatives     true if derivative texturing functions will be used
+    /// \param linearize_textures  true if gamma-encoded 2D textures should be converted to
+    ///                            linear float canvases at initialization instead of being
+    ///                            linearized on lookup
+    /// \param use_footprints      true if the thread data of non-derivative 2D texture lookups
+    ///                            points to a \c mi::neuraylib::Texture_handler_footprint
+    /// \param use_ptex            true if the thread data of ptex lookups points to a
+    ///                            \c mi::neuraylib::Texture_handler_ptex
+    /// \param ptex_cache_size     the maximum number of bytes of decoded ptex faces kept by
+    ///                            the handler
+    Resource_handler(
+        bool use_derivatives=false,
+        bool linearize_textures=false,
+        bool use_footprints=false,
+        bool use_ptex=false,
+        size_t ptex_cache_size=64*1024*1024)
         : m_use_derivatives(use_derivatives)
+        , m_linearize_textures(linearize_textures)
+        , m_use_footprints(use_footprints)
+        , m_use_ptex(use_ptex)
+        , m_ptex_cache(ptex_cache_size)
     {
     }
 
+    /// Get the cache of decoded ptex faces shared by all ptex textures of this handler.
+    MI::MDLRT::Ptex_face_cache const &get_ptex_cache() const { return m_ptex_cache; }
+
     /// Get the number of bytes that must be allocated for a resource object.
     size_t get_data_size() const override;
 
@@ -585,6 +609,29 @@ public:
 private:
     /// Specifies, whether derivative texture functions will be used.
     bool m_use_derivatives;
+
+    /// Get the footprint for non-derivative 2D texture lookups from the thread data.
+    ///
+    /// \return the footprint or 0, if footprints are disabled or no thread data is given
+    float get_footprint(void const *thread_data) const;
+
+    /// Specifies, whether gamma-encoded 2D textures are linearized at initialization.
+    bool m_linearize_textures;
+
+    /// Specifies, whether the thread data provides footprints for non-derivative 2D lookups.
+    bool m_use_footprints;
+
+    /// Get the face and face coordinates for ptex lookups from the thread data.
+    ///
+    /// \return the texture handler, or a handler with an invalid face, if ptex lookups are
+    ///         disabled or no thread data is given
+    mi::neuraylib::Texture_handler_ptex const *get_ptex_handler(void const *thread_data) const;
+
+    /// Specifies, whether the thread data provides faces for ptex lookups.
+    bool m_use_ptex;
+
+    /// The cache of decoded ptex faces.
+    MI::MDLRT::Ptex_face_cache m_ptex_cache;
 };
 
 }  // MDLRT
@@ -32,9 +32,18 @@
 #ifndef RENDER_MDL_RUNTIME_I_MDLRT_TEXTURE_H
 #define RENDER_MDL_RUNTIME_I_MDLRT_TEXTURE_H
 
+#include <mi/base/handle.h>
+#include <mi/base/interface_implement.h>
+#include <mi/base/lock.h>
 #include <mi/neuraylib/typedefs.h>
 #include <mi/mdl/mdl_stdlib_types.h>
 
+#include <list>
+#include <map>
+#include <vector>
+
+#include <base/data/db/i_db_access.h>
+#include <io/scene/dbimage/i_dbimage.h>
 #include <io/scene/texture/i_texture.h>
 #include <io/image/image/i_image_access_canvas.h>
 
@@ -76,7 +85,8 @@ public:
     ~Texture_2d();
 
 
-    Texture_2d(const DB::Typed_tag<TEXTURE::Texture>&, Gamma_mode, bool, DB::Transaction*);
+    Texture_2d(
+        const DB::Typed_tag<TEXTURE::Texture>&, Gamma_mode, bool, bool, bool, DB::Transaction*);
 
     mi::Sint32_2 get_resolution(const mi::Sint32_2& uv_tile) const;
 
@@ -85,7 +95,8 @@ public:
             Wrap_mode wrap_u,
             Wrap_mode wrap_v,
             const mi::Float32_2& crop_u,
-            const mi::Float32_2& crop_v
+            const mi::Float32_2& crop_v,
+            float footprint = 0.0f
             ) const;
 
 
@@ -94,7 +105,8 @@ public:
             Wrap_mode wrap_u,
             Wrap_mode wrap_v,
             const mi::Float32_2& crop_u,
-            const mi::Float32_2& crop_v
+            const mi::Float32_2& crop_v,
+            float footprint = 0.0f
             ) const;
 
 
@@ -103,7 +115,8 @@ public:
             Wrap_mode wrap_u,
             Wrap_mode wrap_v,
             const mi::Float32_2& crop_u,
-            const mi::Float32_2& crop_v
+            const mi::Float32_2& crop_v,
+            float footprint = 0.0f
             ) const;
 
 
@@ -112,7 +125,8 @@ public:
             Wrap_mode wrap_u,
             Wrap_mode wrap_v,
             const mi::Float32_2& crop_u,
-            const mi::Float32_2& crop_v
+            const mi::Float32_2& crop_v,
+            float footprint = 0.0f
             ) const;
 
 
@@ -132,7 +146,8 @@ public:
             Wrap_mode wrap_u,
             Wrap_mode wrap_v,
             const mi::Float32_2& crop_u,
-            const mi::Float32_2& crop_v
+            const mi::Float32_2& crop_v,
+            float footprint = 0.0f
             ) const;
 
 
@@ -166,6 +181,7 @@ private:
     std::vector< std::vector<mi::Uint32_3> >          m_tile_resolutions;
     std::vector< std::vector<IMAGE::Access_canvas> >  m_canvases;
     std::vector<float>                                  m_gamma;
+    std::vector<const float*>                           m_gamma_tables;
     std::vector<unsigned int>                           m_udim_mapping;
     bool m_is_udim;
     unsigned int  m_udim_num_u;
@@ -291,28 +307,172 @@ private:
 
 
 
+class Texture_ptex;
+
+/// Decoded texel data of a single ptex face.
+///
+/// Stores the linearized texels of the face and its box-filtered reductions down to 1x1 as one
+/// compact block of floats with the channel count of the source image. Unlike texture atlases,
+/// faces need no padding.
+class Ptex_face : public mi::base::Interface_implement<mi::base::IInterface>
+{
+public:
+    /// Constructor.
+    ///
+    /// \param res           the resolution of the face
+    /// \param num_channels  the number of channels per texel (1 to 4)
+    Ptex_face(const mi::Uint32_2& res, mi::Uint32 num_channels);
+
+    /// Returns the number of reduction levels including the face itself.
+    mi::Uint32 get_num_levels() const { return mi::Uint32(m_level_res.size()); }
+
+    /// Returns the resolution of a level.
+    const mi::Uint32_2& get_resolution(mi::Uint32 level) const { return m_level_res[level]; }
+
+    /// Returns the number of channels per texel.
+    mi::Uint32 get_num_channels() const { return m_num_channels; }
+
+    /// Returns the texels of a level.
+    float* get_texels(mi::Uint32 level) { return &m_texels[m_level_offset[level]]; }
+
+    /// Returns the texels of a level.
+    const float* get_texels(mi::Uint32 level) const { return &m_texels[m_level_offset[level]]; }
+
+    /// Computes all reduction levels from level 0.
+    void build_reductions();
+
+    /// Returns the number of bytes used by the texel data.
+    size_t get_size() const { return m_texels.size() * sizeof(float); }
+
+private:
+    std::vector<mi::Uint32_2> m_level_res;
+    std::vector<size_t>       m_level_offset;
+    std::vector<float>        m_texels;
+    mi::Uint32                m_num_channels;
+};
+
+
+/// A cache of decoded ptex faces with a bounded size.
+///
+/// One cache is shared by all ptex textures of a resource handler. If the size of all cached
+/// faces exceeds the limit, the least recently used faces are evicted. Evicted faces stay valid
+/// as long as a lookup holds a reference to them. All methods are thread-safe.
+class Ptex_face_cache
+{
+public:
+    /// Constructor.
+    ///
+    /// \param max_size  the maximum number of bytes of face data kept in the cache
+    explicit Ptex_face_cache(size_t max_size);
+
+    /// Returns a cached face, or an invalid handle if the face is not cached.
+    mi::base::Handle<const Ptex_face> get(const Texture_ptex* texture, mi::Uint32 face_id);
+
+    /// Adds a face to the cache and evicts faces if necessary. If the face was added by another
+    /// thread in the meantime, the cached face is returned instead of \p face.
+    mi::base::Handle<const Ptex_face> put(
+        const Texture_ptex* texture, mi::Uint32 face_id, const Ptex_face* face);
+
+    /// Removes all faces of a texture from the cache.
+    void purge(const Texture_ptex* texture);
+
+    /// Returns the number of bytes of face data currently kept in the cache.
+    size_t get_size() const;
+
+    /// Returns the number of cache hits, cache misses, and evicted faces.
+    void get_statistics(size_t& hits, size_t& misses, size_t& evictions) const;
+
+private:
+    typedef std::pair<const Texture_ptex*, mi::Uint32> Key;
+
+    struct Entry {
+        Key                             m_key;
+        mi::base::Handle<const Ptex_face> m_face;
+    };
+
+    typedef std::list<Entry> Entry_list;
+
+    /// Evicts least recently used faces until the limit is reached, but keeps the most recent one.
+    void evict();
+
+    mutable mi::base::Lock              m_lock;
+    Entry_list                          m_lru;
+    std::map<Key, Entry_list::iterator> m_index;
+    size_t                              m_max_size;
+    size_t                              m_size;
+    size_t                              m_hits;
+    size_t                              m_misses;
+    size_t                              m_evictions;
+};
+
+
 class Texture_ptex : public Texture
 {
 public:
     Texture_ptex();
+    ~Texture_ptex();
 
 
-    Texture_ptex(const DB::Typed_tag<TEXTURE::Texture>&, Gamma_mode, DB::Transaction*);
+    Texture_ptex(
+        const DB::Typed_tag<TEXTURE::Texture>&, Gamma_mode, Ptex_face_cache*, DB::Transaction*);
 
+    /// Returns the number of faces.
+    mi::Uint32 get_num_faces() const { return mi::Uint32(m_face_resolutions.size()); }
 
-    float lookup_float(int channel) const;
 
+    float lookup_float(
+            int face_id,
+            const mi::Float32_2& face_uv,
+            float footprint,
+            int channel
+            ) const;
+
+
+    mi::Float32_2 lookup_float2(
+            int face_id,
+            const mi::Float32_2& face_uv,
+            float footprint,
+            int channel
+            ) const;
 
-    mi::Float32_2 lookup_float2(int channel) const;
 
+    mi::Float32_3 lookup_float3(
+            int face_id,
+            const mi::Float32_2& face_uv,
+            float footprint,
+            int channel
+            ) const;
 
-    mi::Float32_3 lookup_float3(int channel) const;
 
+    mi::Float32_4 lookup_float4(
+            int face_id,
+            const mi::Float32_2& face_uv,
+            float footprint,
+            int channel
+            ) const;
 
-    mi::Float32_4 lookup_float4(int channel) const;
 
+    mi::Spectrum lookup_color(
+            int face_id,
+            const mi::Float32_2& face_uv,
+            float footprint,
+            int channel
+            ) const;
 
-    mi::Spectrum lookup_color(int channel) const;
+private:
+    /// Returns the decoded data of a face from the cache, decoding it on a cache miss.
+    mi::base::Handle<const Ptex_face> get_face(mi::Uint32 face_id) const;
+
+    /// Decodes a face from its canvas, which is only fetched for this.
+    Ptex_face* load_face(mi::Uint32 face_id) const;
+
+    Ptex_face_cache*                    m_cache;
+    DB::Access<DBIMAGE::Image_impl>     m_image_impl;
+    std::vector<mi::Uint32>             m_face_uvtiles;
+    std::vector<mi::Uint32>             m_face_layers;
+    std::vector<mi::Uint32_2>           m_face_resolutions;
+    std::vector<float>                  m_face_gamma;
+    mi::Uint32                          m_num_channels;
 };
 
 
@@ -33,6 +33,7 @@
 #include "pch.h"
 #include "i_mdlrt_resource_handler.h"
 
+#include <mi/neuraylib/target_code_types.h>
 #include <render/mdl/runtime/i_mdlrt_texture.h>
 #include <render/mdl/runtime/i_mdlrt_light_profile.h>
 #include <render/mdl/runtime/i_mdlrt_bsdf_measurement.h>
@@ -74,6 +75,8 @@ void Resource_handler::tex_init(
             typed_tag,
             MI::MDLRT::Texture::Gamma_mode(gamma),
             m_use_derivatives,
+            m_linearize_textures,
+            m_use_footprints,
             (MI::DB::Transaction *)ctx);
         break;
     case mi::mdl::IType_texture::TS_3D:
@@ -86,7 +89,10 @@ void Resource_handler::tex_init(
         break;
     case mi::mdl::IType_texture::TS_PTEX:
         new (data) MI::MDLRT::Texture_ptex(
-            typed_tag, MI::MDLRT::Texture::Gamma_mode(gamma), (MI::DB::Transaction *)ctx);
+            typed_tag,
+            MI::MDLRT::Texture::Gamma_mode(gamma),
+            m_use_ptex ? &m_ptex_cache : NULL,
+            (MI::DB::Transaction *)ctx);
         break;
     case mi::mdl::IType_texture::TS_BSDF_DATA:
         // handle like 3D texture
@@ -172,10 +178,41 @@ int Resource_handler::tex_depth(
     return o->get_depth();
 }
 
+// Get the footprint for non-derivative 2D texture lookups from the thread data, if enabled.
+float Resource_handler::get_footprint(void const *thread_data) const
+{
+    if (!m_use_footprints || thread_data == NULL)
+        return 0.0f;
+    return static_cast<mi::neuraylib::Texture_handler_footprint const *>(thread_data)->footprint;
+}
+
+// Returns a ptex texture handler with an invalid face, which makes all ptex lookups return zero.
+static mi::neuraylib::Texture_handler_ptex make_no_face_handler()
+{
+    mi::neuraylib::Texture_handler_ptex handler;
+    handler.vtable     = NULL;
+    handler.footprint  = 0.0f;
+    handler.face_id    = -1;
+    handler.face_uv[0] = 0.0f;
+    handler.face_uv[1] = 0.0f;
+    return handler;
+}
+
+// Get the face and face coordinates for ptex lookups from the thread data, if enabled.
+mi::neuraylib::Texture_handler_ptex const *Resource_handler::get_ptex_handler(
+    void const *thread_data) const
+{
+    static mi::neuraylib::Texture_handler_ptex const no_face = make_no_face_handler();
+
+    if (!m_use_ptex || thread_data == NULL)
+        return &no_face;
+    return static_cast<mi::neuraylib::Texture_handler_ptex const *>(thread_data);
+}
+
 // Handle tex::lookup_float(texture_2d, ...)
 float Resource_handler::tex_lookup_float_2d(
     void const    *tex_data,
-    void          * /*thread_data*/,
+    void          *thread_data,
     float const   coord[2],
     Tex_wrap_mode wrap_u,
     Tex_wrap_mode wrap_v,
@@ -189,7 +226,8 @@ float Resource_handler::tex_lookup_float_2d(
         MI::MDLRT::Texture::Wrap_mode(wrap_u),
         MI::MDLRT::Texture::Wrap_mode(wrap_v),
         *reinterpret_cast<mi::Float32_2 const *>(crop_u),
-        *reinterpret_cast<mi::Float32_2 const *>(crop_v));
+        *reinterpret_cast<mi::Float32_2 const *>(crop_v),
+        get_footprint(thread_data));
 }
 
 // Handle tex::lookup_float(texture_2d, ...) with derivatives
@@ -252,19 +290,24 @@ float Resource_handler::tex_lookup_float_cube(
 // Handle tex::lookup_float(texture_ptex, ...)
 float Resource_handler::tex_lookup_float_ptex(
     void const    *tex_data,
-    void          * /*thread_data*/,
+    void          *thread_data,
     int           channel) const
 {
     MI::MDLRT::Texture_ptex const *o = reinterpret_cast<MI::MDLRT::Texture_ptex const *>(tex_data);
+    mi::neuraylib::Texture_handler_ptex const *h = get_ptex_handler(thread_data);
 
-    return o->lookup_float(channel);
+    return o->lookup_float(
+        h->face_id,
+        *reinterpret_cast<mi::Float32_2 const *>(h->face_uv),
+        h->footprint,
+        channel);
 }
 
 // Handle tex::lookup_float2(texture_2d, ...)
 void Resource_handler::tex_lookup_float2_2d(
     float         result[2],
     void const    *tex_data,
-    void          * /*thread_data*/,
+    void          *thread_data,
     float const   coord[2],
     Tex_wrap_mode wrap_u,
     Tex_wrap_mode wrap_v,
@@ -279,7 +322,8 @@ void Resource_handler::tex_lookup_float2_2d(
             MI::MDLRT::Texture::Wrap_mode(wrap_u),
             MI::MDLRT::Texture::Wrap_mode(wrap_v),
             *reinterpret_cast<mi::Float32_2 const *>(crop_u),
-            *reinterpret_cast<mi::Float32_2 const *>(crop_v));
+            *reinterpret_cast<mi::Float32_2 const *>(crop_v),
+            get_footprint(thread_data));
 }
 
 // Handle tex::lookup_float2(texture_2d, ...) with derivatives
@@ -351,19 +395,24 @@ void Resource_handler::tex_lookup_float2_cube(
 void Resource_handler::tex_lookup_float2_ptex(
     float         result[2],
     void const    *tex_data,
-    void          * /*thread_data*/,
+    void          *thread_data,
     int           channel) const
 {
     MI::MDLRT::Texture_ptex const *o = reinterpret_cast<MI::MDLRT::Texture_ptex const *>(tex_data);
+    mi::neuraylib::Texture_handler_ptex const *h = get_ptex_handler(thread_data);
 
-    *reinterpret_cast<mi::Float32_2*>(result) = o->lookup_float2(channel);
+    *reinterpret_cast<mi::Float32_2*>(result) = o->lookup_float2(
+        h->face_id,
+        *reinterpret_cast<mi::Float32_2 const *>(h->face_uv),
+        h->footprint,
+        channel);
 }
 
 // Handle tex::lookup_float3(texture_2d, ...)
 void Resource_handler::tex_lookup_float3_2d(
     float         result[3],
     void const    *tex_data,
-    void          * /*thread_data*/,
+    void          *thread_data,
     float const   coord[2],
     Tex_wrap_mode wrap_u,
     Tex_wrap_mode wrap_v,
@@ -378,7 +427,8 @@ void Resource_handler::tex_lookup_float3_2d(
             MI::MDLRT::Texture::Wrap_mode(wrap_u),
             MI::MDLRT::Texture::Wrap_mode(wrap_v),
             *reinterpret_cast<mi::Float32_2 const *>(crop_u),
-            *reinterpret_cast<mi::Float32_2 const *>(crop_v));
+            *reinterpret_cast<mi::Float32_2 const *>(crop_v),
+            get_footprint(thread_data));
 }
 
 // Handle tex::lookup_float3(texture_2d, ...) with derivatives
@@ -450,12 +500,17 @@ void Resource_handler::tex_lookup_float3_cube(
 void Resource_handler::tex_lookup_float3_ptex(
     float         result[3],
     void const    *tex_data,
-    void          * /*thread_data*/,
+    void          *thread_data,
     int           channel) const
 {
     MI::MDLRT::Texture_ptex const *o = reinterpret_cast<MI::MDLRT::Texture_ptex const *>(tex_data);
+    mi::neuraylib::Texture_handler_ptex const *h = get_ptex_handler(thread_data);
 
-    *reinterpret_cast<mi::Float32_3*>(result) = o->lookup_float3(channel);
+    *reinterpret_cast<mi::Float32_3*>(result) = o->lookup_float3(
+        h->face_id,
+        *reinterpret_cast<mi::Float32_2 const *>(h->face_uv),
+        h->footprint,
+        channel);
 }
 
 
@@ -463,7 +518,7 @@ void Resource_handler::tex_lookup_float3_ptex(
 void Resource_handler::tex_lookup_float4_2d(
     float         result[4],
     void const    *tex_data,
-    void          * /*thread_data*/,
+    void          *thread_data,
     float const   coord[2],
     Tex_wrap_mode wrap_u,
     Tex_wrap_mode wrap_v,
@@ -478,7 +533,8 @@ void Resource_handler::tex_lookup_float4_2d(
             wrap_u,
             wrap_v,
             *reinterpret_cast<mi::Float32_2 const *>(crop_u),
-            *reinterpret_cast<mi::Float32_2 const *>(crop_v));
+            *reinterpret_cast<mi::Float32_2 const *>(crop_v),
+            get_footprint(thread_data));
 }
 
 // Handle tex::lookup_float4(texture_2d, ...) with derivatives
@@ -548,19 +604,24 @@ void Resource_handler::tex_lookup_float4_cube(
 void Resource_handler::tex_lookup_float4_ptex(
     float         result[4],
     void const    *tex_data,
-    void          * /*thread_data*/,
+    void          *thread_data,
     int           channel) const
 {
     MI::MDLRT::Texture_ptex const *o = reinterpret_cast<MI::MDLRT::Texture_ptex const *>(tex_data);
+    mi::neuraylib::Texture_handler_ptex const *h = get_ptex_handler(thread_data);
 
-    *reinterpret_cast<mi::Float32_4*>(result) = o->lookup_float4(channel);
+    *reinterpret_cast<mi::Float32_4*>(result) = o->lookup_float4(
+        h->face_id,
+        *reinterpret_cast<mi::Float32_2 const *>(h->face_uv),
+        h->footprint,
+        channel);
 }
 
 // Handle tex::lookup_color(texture_2d, ...)
 void Resource_handler::tex_lookup_color_2d(
     float         rgb[3],
     void const    *tex_data,
-    void          * /*thread_data*/,
+    void          *thread_data,
     float const   coord[2],
     Tex_wrap_mode wrap_u,
     Tex_wrap_mode wrap_v,
@@ -575,7 +636,8 @@ void Resource_handler::tex_lookup_color_2d(
             wrap_u,
             wrap_v,
             *reinterpret_cast<mi::Float32_2 const *>(crop_u),
-            *reinterpret_cast<mi::Float32_2 const *>(crop_v)).to_vector3();
+            *reinterpret_cast<mi::Float32_2 const *>(crop_v),
+            get_footprint(thread_data)).to_vector3();
 }
 
 // Handle tex::lookup_color(texture_2d, ...) with derivatives
@@ -647,12 +709,17 @@ void Resource_handler::tex_lookup_color_cube(
 void Resource_handler::tex_lookup_color_ptex(
     float         rgb[3],
     void const    *tex_data,
-    void          * /*thread_data*/,
+    void          *thread_data,
     int           channel) const
 {
     MI::MDLRT::Texture_ptex const*o = reinterpret_cast<MI::MDLRT::Texture_ptex const*>(tex_data);
+    mi::neuraylib::Texture_handler_ptex const *h = get_ptex_handler(thread_data);
 
-    *reinterpret_cast<mi::Float32_3*>(rgb) = o->lookup_color(channel).to_vector3();
+    *reinterpret_cast<mi::Float32_3*>(rgb) = o->lookup_color(
+        h->face_id,
+        *reinterpret_cast<mi::Float32_2 const *>(h->face_uv),
+        h->footprint,
+        channel).to_vector3();
 }
 
 // Handle tex::texel_float(texture_2d, ...)
@@ -33,7 +33,10 @@
 
 #include "i_mdlrt_texture.h"
 
+#include <map>
 #include <math.h>
+#include <vector>
+#include <mi/base/lock.h>
 #include <mi/neuraylib/iimage.h>
 #include <mi/math/color.h>
 #include <io/image/image/i_image.h>
@@ -85,6 +88,32 @@ static void apply_gamma4(mi::math::Color &c, const float gamma_val)
 static float saturate(const float f) {
     return std::max(0.0f, std::min(1.0f, f));
 }
+
+// Returns a table with the linearized values of all 256 codes of an 8-bit channel for the given
+// gamma. The tables are created on demand and shared by all textures using the same gamma.
+static const float *get_gamma_table(const float gamma_val)
+{
+    static mi::base::Lock s_lock;
+    static std::map<float, std::vector<float> > s_tables;
+
+    mi::base::Lock::Block block(&s_lock);
+    std::vector<float> &table = s_tables[gamma_val];
+    if (table.empty()) {
+        table.resize(256);
+        for (unsigned int i = 0; i < 256; ++i)
+            table[i] = gamma_func(float(i) * (1.0f / 255.0f), gamma_val);
+    }
+    return table.data();
+}
+
+// Linearizes a color read from an 8-bit canvas using a table from get_gamma_table().
+static void apply_gamma_table(mi::math::Color &c, const float *gamma_table)
+{
+    c.r = gamma_table[(unsigned int)(saturate(c.r) * 255.0f + 0.5f)];
+    c.g = gamma_table[(unsigned int)(saturate(c.g) * 255.0f + 0.5f)];
+    c.b = gamma_table[(unsigned int)(saturate(c.b) * 255.0f + 0.5f)];
+    c.a = gamma_table[(unsigned int)(saturate(c.a) * 255.0f + 0.5f)];
+}
 static unsigned int float_as_uint(const float f) {
     union {
         float f;
@@ -220,7 +249,8 @@ static mi::Float32_4 interpolate_biquintic(
     const mi::Float32_3 &texo,
     const bool linear,
     const float gamma_val,
-    const unsigned int layer_offset = 0)
+    const unsigned int layer_offset = 0,
+    const float *gamma_table = NULL)
 {
     if (texture_res.x == 0 || texture_res.y == 0)
         return mi::Float32_4(0.0f, 0.0f ,0.0f, 0.0f);
@@ -314,7 +344,15 @@ static mi::Float32_4 interpolate_biquintic(
         canvas.lookup(c1, texi.z, texi.y, z_layer);
         canvas.lookup(c2, texi.x, texi.w, z_layer);
         canvas.lookup(c3, texi.z, texi.w, z_layer);
-        
+
+        // 8-bit canvases are linearized per texel before filtering
+        if (gamma_table) {
+            apply_gamma_table(c0, gamma_table);
+            apply_gamma_table(c1, gamma_table);
+            apply_gamma_table(c2, gamma_table);
+            apply_gamma_table(c3, gamma_table);
+        }
+
         col = c0 * st.x + c1 * st.y + c2 * st.z + c3 * st.w;
         rgba = mi::Float32_4(col.r, col.g, col.b, col.a);
     
@@ -332,7 +370,7 @@ static mi::Float32_4 interpolate_biquintic(
     if(lerp_z != 0.f)
 	rgba += (rgba2-rgba)*lerp_z;
 
-    if(gamma_val != 1.0f) {
+    if(gamma_table == NULL && gamma_val != 1.0f) {
         rgba.x = gamma_func(rgba.x, gamma_val);
         rgba.y = gamma_func(rgba.y, gamma_val);
         rgba.z = gamma_func(rgba.z, gamma_val);
@@ -369,6 +407,8 @@ Texture_2d::Texture_2d(
     const DB::Typed_tag<TEXTURE::Texture>& tex_t,
     Gamma_mode gamma_mode,
     bool use_derivatives,
+    bool linearize,
+    bool use_footprints,
     DB::Transaction* trans)
     : Texture(gamma_mode)
     , m_is_udim(false)
@@ -411,13 +451,17 @@ Texture_2d::Texture_2d(
         m_udim_mapping.push_back(0);
     }
 
+    // footprint lookups use the same mipmap levels as derivative lookups
+    const bool use_mipmaps = use_derivatives || use_footprints;
+
     m_canvases.resize(num_tiles);
     m_gamma.resize(num_tiles);
+    m_gamma_tables.resize(num_tiles, NULL);
     m_tile_resolutions.resize(num_tiles);
 
     for (unsigned int i = 0; i < num_tiles; ++i) {
         mi::base::Handle<const IMAGE::IMipmap> mipmap(image_impl->get_mipmap(i));
-        mi::Uint32 num_levels = use_derivatives ? mipmap->get_nlevels() : 1;
+        mi::Uint32 num_levels = use_mipmaps ? mipmap->get_nlevels() : 1;
 
         m_canvases[i].resize(num_levels);
         m_tile_resolutions[i].resize(num_levels);
@@ -433,13 +477,15 @@ Texture_2d::Texture_2d(
         if (m_gamma[i] <= 0.f)
             m_gamma[i] = 1.f;
 
-        // for derivative mode, convert to linear first, if necessary.
-        // Note: for non-derivative mode, the gamma is still (incorrectly) applied after filtering
-        if (use_derivatives && m_gamma[i] != 1.0f) {
+        MI::IMAGE::Pixel_type pixel_type =
+            MI::IMAGE::convert_pixel_type_string_to_enum(base_canvas->get_type());
+
+        // for derivative and footprint mode or if requested, convert to linear first, if needed.
+        // Otherwise, 8-bit canvases are linearized per texel via a lookup table, for all other
+        // pixel types the gamma is still (incorrectly) applied after filtering
+        if ((use_mipmaps || linearize) && m_gamma[i] != 1.0f) {
             // Choose pixel format. For non-float formats, convert to float format
             // with same number of channels
-            MI::IMAGE::Pixel_type pixel_type =
-                MI::IMAGE::convert_pixel_type_string_to_enum(base_canvas->get_type());
             switch (pixel_type) {
             case MI::IMAGE::PT_RGB:
             case MI::IMAGE::PT_RGBE:
@@ -468,10 +514,13 @@ Texture_2d::Texture_2d(
             image_module->adjust_gamma(gamma_canvas.get(), 1.0f);
             base_canvas = gamma_canvas;
             m_gamma[i] = 1.0f;
+        } else if (m_gamma[i] != 1.0f
+                && (pixel_type == MI::IMAGE::PT_RGB || pixel_type == MI::IMAGE::PT_RGBA)) {
+            m_gamma_tables[i] = get_gamma_table(m_gamma[i]);
         }
 
         std::vector< mi::base::Handle<mi::neuraylib::ICanvas> > mipmaps;
-        if (use_derivatives)
+        if (use_mipmaps)
             image_module->create_mipmaps(mipmaps, base_canvas.get(), 1.0f);
 
         for (mi::Uint32 level = 0; level < num_levels; ++level) {
@@ -508,7 +557,10 @@ float Texture_2d::texel_float(const mi::Sint32_2& coord, const mi::Sint32_2& uv_
     
     mi::math::Color res(0.0f);
     m_canvases[tile_id][0].lookup(res,coord.x,coord.y,0);
-    apply_gamma1(res, m_gamma[tile_id]);
+    if (m_gamma_tables[tile_id])
+        apply_gamma_table(res, m_gamma_tables[tile_id]);
+    else
+        apply_gamma1(res, m_gamma[tile_id]);
     return res.r;
 }
 
@@ -523,7 +575,10 @@ mi::Float32_2 Texture_2d::texel_float2(
 
     mi::math::Color res(0.0f);
     m_canvases[tile_id][0].lookup(res,coord.x,coord.y,0);
-    apply_gamma2(res, m_gamma[tile_id]);
+    if (m_gamma_tables[tile_id])
+        apply_gamma_table(res, m_gamma_tables[tile_id]);
+    else
+        apply_gamma2(res, m_gamma[tile_id]);
     return mi::Float32_2(res.r,res.g);
 }
 
@@ -538,7 +593,10 @@ mi::Float32_3 Texture_2d::texel_float3(
 
     mi::math::Color res(0.0f);
     m_canvases[tile_id][0].lookup(res,coord.x,coord.y,0);
-    apply_gamma3(res, m_gamma[tile_id]);
+    if (m_gamma_tables[tile_id])
+        apply_gamma_table(res, m_gamma_tables[tile_id]);
+    else
+        apply_gamma3(res, m_gamma[tile_id]);
     return mi::Float32_3(res.r,res.g,res.b);
 }
 
@@ -553,7 +611,10 @@ mi::Float32_4 Texture_2d::texel_float4(
 
     mi::math::Color res(0.0f);
     m_canvases[tile_id][0].lookup(res,coord.x,coord.y,0);
-    apply_gamma4(res, m_gamma[tile_id]);
+    if (m_gamma_tables[tile_id])
+        apply_gamma_table(res, m_gamma_tables[tile_id]);
+    else
+        apply_gamma4(res, m_gamma[tile_id]);
     return mi::Float32_4(res.r,res.g,res.b,res.a);
 }
 
@@ -566,7 +627,10 @@ mi::Spectrum Texture_2d::texel_color(const mi::Sint32_2& coord, const mi::Sint32
 
     mi::math::Color res(0.0f);
     m_canvases[tile_id][0].lookup(res,coord.x,coord.y,0);
-    apply_gamma3(res, m_gamma[tile_id]);
+    if (m_gamma_tables[tile_id])
+        apply_gamma_table(res, m_gamma_tables[tile_id]);
+    else
+        apply_gamma3(res, m_gamma[tile_id]);
     return mi::Spectrum(res.r,res.g,res.b);
 }
 
@@ -576,10 +640,11 @@ float Texture_2d::lookup_float(
         Wrap_mode wrap_u,
         Wrap_mode wrap_v,
         const mi::Float32_2& crop_u,
-        const mi::Float32_2& crop_v
+        const mi::Float32_2& crop_v,
+        float footprint
         ) const
 {
-    return lookup_float4(coord,wrap_u,wrap_v,crop_u,crop_v).x;
+    return lookup_float4(coord,wrap_u,wrap_v,crop_u,crop_v,footprint).x;
 }
 
 
@@ -588,10 +653,11 @@ mi::Float32_2 Texture_2d::lookup_float2(
         Wrap_mode wrap_u,
         Wrap_mode wrap_v,
         const mi::Float32_2& crop_u,
-        const mi::Float32_2& crop_v
+        const mi::Float32_2& crop_v,
+        float footprint
         ) const
 {
-    const mi::Float32_4& res = lookup_float4(coord,wrap_u,wrap_v,crop_u,crop_v);
+    const mi::Float32_4& res = lookup_float4(coord,wrap_u,wrap_v,crop_u,crop_v,footprint);
     return mi::Float32_2(res.x,res.y);
 }
 
@@ -601,10 +667,11 @@ mi::Float32_3 Texture_2d::lookup_float3(
         Wrap_mode wrap_u,
         Wrap_mode wrap_v,
         const mi::Float32_2& crop_u,
-        const mi::Float32_2& crop_v
+        const mi::Float32_2& crop_v,
+        float footprint
         ) const
 {
-    const mi::Float32_4& res = lookup_float4(coord,wrap_u,wrap_v,crop_u,crop_v);
+    const mi::Float32_4& res = lookup_float4(coord,wrap_u,wrap_v,crop_u,crop_v,footprint);
     return mi::Float32_3(res.x,res.y,res.z);
 }
 
@@ -614,12 +681,21 @@ mi::Float32_4 Texture_2d::lookup_float4(
         Wrap_mode wrap_u,
         Wrap_mode wrap_v,
         const mi::Float32_2& crop_u,
-        const mi::Float32_2& crop_v
+        const mi::Float32_2& crop_v,
+        float footprint
         ) const
 {
     if (!m_is_valid)
         return mi::Float32_4(0.0f);
 
+    // with a footprint, select the mipmap levels like an isotropic derivative lookup
+    if (footprint > 0.0f)
+        return lookup_deriv_float4(
+            coord,
+            mi::Float32_2(footprint, 0.0f),
+            mi::Float32_2(0.0f, footprint),
+            wrap_u, wrap_v, crop_u, crop_v);
+
     const mi::Float32_4 uv_crop(
         saturate(crop_u.x), saturate(crop_u.y - crop_u.x),
         saturate(crop_v.x), saturate(crop_v.y - crop_v.x));
@@ -653,7 +729,7 @@ mi::Float32_4 Texture_2d::lookup_float4(
         m_tile_resolutions[tile_id][0],
         wrap_u, wrap_v, mi::mdl::stdlib::wrap_repeat,
         uv_crop, w_crop,
-        coords, false, m_gamma[tile_id]);
+        coords, false, m_gamma[tile_id], 0, m_gamma_tables[tile_id]);
 }
 
 mi::Float32_4 Texture_2d::lookup_deriv_float4(
@@ -746,10 +822,11 @@ mi::Spectrum Texture_2d::lookup_color(
         Wrap_mode wrap_u,
         Wrap_mode wrap_v,
         const mi::Float32_2& crop_u,
-        const mi::Float32_2& crop_v
+        const mi::Float32_2& crop_v,
+        float footprint
         ) const
 {
-    const mi::Float32_4& res = lookup_float4(coord,wrap_u,wrap_v,crop_u,crop_v);
+    const mi::Float32_4& res = lookup_float4(coord,wrap_u,wrap_v,crop_u,crop_v,footprint);
     return mi::Spectrum(res.x,res.y,res.z);
 }
 
@@ -1051,7 +1128,197 @@ mi::Spectrum Texture_cube::lookup_color(const mi::Float32_3& direction) const
 
 
 
-Texture_ptex::Texture_ptex() : Texture(mi::mdl::stdlib::gamma_default)
+Ptex_face::Ptex_face(const mi::Uint32_2& res, mi::Uint32 num_channels)
+    : m_num_channels(num_channels)
+{
+    mi::Uint32_2 level_res(std::max(res.x, 1u), std::max(res.y, 1u));
+    size_t size = 0;
+    for (;;) {
+        m_level_res.push_back(level_res);
+        m_level_offset.push_back(size);
+        size += size_t(level_res.x) * level_res.y * num_channels;
+        if (level_res.x == 1 && level_res.y == 1)
+            break;
+        level_res.x = std::max(level_res.x / 2, 1u);
+        level_res.y = std::max(level_res.y / 2, 1u);
+    }
+    m_texels.resize(size, 0.0f);
+}
+
+
+void Ptex_face::build_reductions()
+{
+    const mi::Uint32 n = m_num_channels;
+    for (mi::Uint32 level = 1, num_levels = get_num_levels(); level < num_levels; ++level) {
+        const mi::Uint32_2& src_res = m_level_res[level - 1];
+        const mi::Uint32_2& dst_res = m_level_res[level];
+        const float *src = get_texels(level - 1);
+        float *dst = get_texels(level);
+
+        // box filter, odd texels at the border are clamped
+        for (mi::Uint32 y = 0; y < dst_res.y; ++y) {
+            const mi::Uint32 y0 = std::min(2 * y,     src_res.y - 1);
+            const mi::Uint32 y1 = std::min(2 * y + 1, src_res.y - 1);
+            for (mi::Uint32 x = 0; x < dst_res.x; ++x) {
+                const mi::Uint32 x0 = std::min(2 * x,     src_res.x - 1);
+                const mi::Uint32 x1 = std::min(2 * x + 1, src_res.x - 1);
+                for (mi::Uint32 c = 0; c < n; ++c) {
+                    dst[(y * dst_res.x + x) * n + c] = 0.25f * (
+                        src[(y0 * src_res.x + x0) * n + c] +
+                        src[(y0 * src_res.x + x1) * n + c] +
+                        src[(y1 * src_res.x + x0) * n + c] +
+                        src[(y1 * src_res.x + x1) * n + c]);
+                }
+            }
+        }
+    }
+}
+
+
+//-------------------------------------------------------------------------------------------------
+
+
+Ptex_face_cache::Ptex_face_cache(size_t max_size)
+    : m_max_size(max_size)
+    , m_size(0)
+    , m_hits(0)
+    , m_misses(0)
+    , m_evictions(0)
+{
+}
+
+
+mi::base::Handle<const Ptex_face> Ptex_face_cache::get(
+    const Texture_ptex* texture, mi::Uint32 face_id)
+{
+    mi::base::Lock::Block block(&m_lock);
+
+    std::map<Key, Entry_list::iterator>::iterator it = m_index.find(Key(texture, face_id));
+    if (it == m_index.end()) {
+        ++m_misses;
+        return mi::base::Handle<const Ptex_face>();
+    }
+    ++m_hits;
+    m_lru.splice(m_lru.begin(), m_lru, it->second);
+    return it->second->m_face;
+}
+
+
+mi::base::Handle<const Ptex_face> Ptex_face_cache::put(
+    const Texture_ptex* texture, mi::Uint32 face_id, const Ptex_face* face)
+{
+    mi::base::Lock::Block block(&m_lock);
+
+    const Key key(texture, face_id);
+    std::map<Key, Entry_list::iterator>::iterator it = m_index.find(key);
+    if (it != m_index.end()) {
+        // decoded concurrently by another thread
+        m_lru.splice(m_lru.begin(), m_lru, it->second);
+        return it->second->m_face;
+    }
+
+    Entry entry;
+    entry.m_key  = key;
+    entry.m_face = mi::base::make_handle_dup(face);
+    m_lru.push_front(entry);
+    m_index[key] = m_lru.begin();
+    m_size += face->get_size();
+
+    evict();
+    return entry.m_face;
+}
+
+
+void Ptex_face_cache::purge(const Texture_ptex* texture)
+{
+    mi::base::Lock::Block block(&m_lock);
+
+    for (Entry_list::iterator it = m_lru.begin(); it != m_lru.end();) {
+        if (it->m_key.first == texture) {
+            m_size -= it->m_face->get_size();
+            m_index.erase(it->m_key);
+            it = m_lru.erase(it);
+        } else
+            ++it;
+    }
+}
+
+
+size_t Ptex_face_cache::get_size() const
+{
+    mi::base::Lock::Block block(&m_lock);
+    return m_size;
+}
+
+
+void Ptex_face_cache::get_statistics(size_t& hits, size_t& misses, size_t& evictions) const
+{
+    mi::base::Lock::Block block(&m_lock);
+    hits      = m_hits;
+    misses    = m_misses;
+    evictions = m_evictions;
+}
+
+
+void Ptex_face_cache::evict()
+{
+    while (m_size > m_max_size && m_lru.size() > 1) {
+        const Entry& entry = m_lru.back();
+        m_size -= entry.m_face->get_size();
+        m_index.erase(entry.m_key);
+        m_lru.pop_back();
+        ++m_evictions;
+    }
+}
+
+
+//-------------------------------------------------------------------------------------------------
+
+
+// Bilinear lookup of four channels starting at the given channel inside a level of a face.
+// Ptex faces are filtered in isolation, i.e. coordinates are clamped at the face borders.
+static mi::Float32_4 ptex_bilerp(
+    const Ptex_face *face,
+    mi::Uint32 level,
+    const mi::Float32_2 &face_uv,
+    mi::Uint32 channel)
+{
+    const mi::Uint32_2& res = face->get_resolution(level);
+    const mi::Uint32 n = face->get_num_channels();
+    const float *texels = face->get_texels(level);
+
+    const float x = saturate(face_uv.x) * float(res.x) - 0.5f;
+    const float y = saturate(face_uv.y) * float(res.y) - 0.5f;
+    const float fx = floorf(x);
+    const float fy = floorf(y);
+    const float lx = x - fx;
+    const float ly = y - fy;
+
+    const mi::Uint32 x0 = mi::Uint32(std::max(int(fx), 0));
+    const mi::Uint32 y0 = mi::Uint32(std::max(int(fy), 0));
+    const mi::Uint32 x1 = std::min(mi::Uint32(int(fx) + 1), res.x - 1);
+    const mi::Uint32 y1 = std::min(mi::Uint32(int(fy) + 1), res.y - 1);
+
+    const float *t00 = texels + (y0 * res.x + x0) * n;
+    const float *t10 = texels + (y0 * res.x + x1) * n;
+    const float *t01 = texels + (y1 * res.x + x0) * n;
+    const float *t11 = texels + (y1 * res.x + x1) * n;
+
+    float result[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+    for (mi::Uint32 i = 0; i < 4 && channel + i < n; ++i) {
+        const mi::Uint32 c = channel + i;
+        result[i] =
+            (t00[c] * (1.0f - lx) + t10[c] * lx) * (1.0f - ly) +
+            (t01[c] * (1.0f - lx) + t11[c] * lx) * ly;
+    }
+    return mi::Float32_4(result[0], result[1], result[2], result[3]);
+}
+
+
+Texture_ptex::Texture_ptex()
+    : Texture(mi::mdl::stdlib::gamma_default)
+    , m_cache(NULL)
+    , m_num_channels(0)
 {
 }
 
@@ -1059,44 +1326,185 @@ Texture_ptex::Texture_ptex() : Texture(mi::mdl::stdlib::gamma_default)
 Texture_ptex::Texture_ptex(
     const DB::Typed_tag<TEXTURE::Texture>& tex_t,
     Gamma_mode gamma_mode,
+    Ptex_face_cache* cache,
     DB::Transaction* trans)
-    : Texture(mi::mdl::stdlib::gamma_default)
+    : Texture(gamma_mode)
+    , m_cache(cache)
+    , m_num_channels(0)
 {
+    DB::Access<TEXTURE::Texture> texture(tex_t, trans);
+    if (!texture)
+        return;
+
+    DB::Access<DBIMAGE::Image> image(texture->get_image(), trans);
+    if (!image->is_valid())
+        return;
+
+    m_image_impl.set(image->get_impl_tag(), trans);
+
+    // The faces are the uv-tiles of the image, or the layers of the canvas if the image has no
+    // uv-tiles. Texel data is only decoded when a face is looked up, no canvas is kept.
+    const mi::Uint32 num_uvtiles = mi::Uint32(image->get_uvtile_length());
+    for (mi::Uint32 i = 0; i < num_uvtiles; ++i) {
+        mi::base::Handle<const IMAGE::IMipmap> mipmap(m_image_impl->get_mipmap(i));
+        mi::base::Handle<const mi::neuraylib::ICanvas> canvas(mipmap->get_level(0));
+
+        float gamma = texture->get_effective_gamma(trans, i);
+        if (gamma <= 0.f)
+            gamma = 1.f;
+
+        const IMAGE::Pixel_type pixel_type =
+            IMAGE::convert_pixel_type_string_to_enum(canvas->get_type());
+        m_num_channels = std::max(
+            m_num_channels, mi::Uint32(IMAGE::get_components_per_pixel(pixel_type)));
+
+        const mi::Uint32 num_layers = image->is_uvtile() ? 1 : canvas->get_layers_size();
+        for (mi::Uint32 layer = 0; layer < num_layers; ++layer) {
+            m_face_uvtiles.push_back(i);
+            m_face_layers.push_back(layer);
+            m_face_resolutions.push_back(
+                mi::Uint32_2(canvas->get_resolution_x(), canvas->get_resolution_y()));
+            m_face_gamma.push_back(gamma);
+        }
+    }
+
+    if (m_face_resolutions.empty() || m_cache == NULL)
+        return;
+
+    m_resolution = mi::Uint32_3(m_face_resolutions[0].x, m_face_resolutions[0].y, 0);
+    m_num_channels = std::min(m_num_channels, 4u);
+    m_is_valid = true;
+}
+
+
+Texture_ptex::~Texture_ptex()
+{
+    if (m_cache)
+        m_cache->purge(this);
+}
+
+
+mi::base::Handle<const Ptex_face> Texture_ptex::get_face(mi::Uint32 face_id) const
+{
+    mi::base::Handle<const Ptex_face> face(m_cache->get(this, face_id));
+    if (face)
+        return face;
+
+    // decode outside of the cache lock, concurrent misses on the same face are resolved by put()
+    mi::base::Handle<const Ptex_face> loaded(load_face(face_id));
+    return m_cache->put(this, face_id, loaded.get());
 }
 
 
-float Texture_ptex::lookup_float(int channel) const
+Ptex_face* Texture_ptex::load_face(mi::Uint32 face_id) const
 {
-    // TODO
-    return 0.f;
+    const mi::Uint32_2& res = m_face_resolutions[face_id];
+    mi::base::Handle<const IMAGE::IMipmap> mipmap(
+        m_image_impl->get_mipmap(m_face_uvtiles[face_id]));
+    mi::base::Handle<const mi::neuraylib::ICanvas> base_canvas(mipmap->get_level(0));
+    const IMAGE::Access_canvas canvas(base_canvas.get());
+    const mi::Uint32 layer = m_face_layers[face_id];
+    const float gamma = m_face_gamma[face_id];
+    const mi::Uint32 n = m_num_channels;
+
+    Ptex_face *face = new Ptex_face(res, n);
+    float *texels = face->get_texels(0);
+    for (mi::Uint32 y = 0; y < res.y; ++y) {
+        for (mi::Uint32 x = 0; x < res.x; ++x) {
+            mi::math::Color c(0.0f, 0.0f, 0.0f, 1.0f);
+            canvas.lookup(c, x, y, layer);
+            apply_gamma4(c, gamma);
+
+            const float values[4] = { c.r, c.g, c.b, c.a };
+            for (mi::Uint32 i = 0; i < n; ++i)
+                texels[i] = values[i];
+            texels += n;
+        }
+    }
+    face->build_reductions();
+    return face;
 }
 
 
-mi::Float32_2 Texture_ptex::lookup_float2(int channel) const
+float Texture_ptex::lookup_float(
+    int face_id,
+    const mi::Float32_2& face_uv,
+    float footprint,
+    int channel) const
 {
-    // TODO
-    return mi::Float32_2(0.f);
+    return lookup_float4(face_id, face_uv, footprint, channel).x;
 }
 
 
-mi::Float32_3 Texture_ptex::lookup_float3(int channel) const
+mi::Float32_2 Texture_ptex::lookup_float2(
+    int face_id,
+    const mi::Float32_2& face_uv,
+    float footprint,
+    int channel) const
 {
-    // TODO
-    return mi::Float32_3(0.f);
+    const mi::Float32_4& res = lookup_float4(face_id, face_uv, footprint, channel);
+    return mi::Float32_2(res.x, res.y);
 }
 
 
-mi::Float32_4 Texture_ptex::lookup_float4(int channel) const
+mi::Float32_3 Texture_ptex::lookup_float3(
+    int face_id,
+    const mi::Float32_2& face_uv,
+    float footprint,
+    int channel) const
 {
-    // TODO
-    return mi::Float32_4(0.f);
+    const mi::Float32_4& res = lookup_float4(face_id, face_uv, footprint, channel);
+    return mi::Float32_3(res.x, res.y, res.z);
 }
 
 
-mi::Spectrum Texture_ptex::lookup_color(int channel) const
+mi::Float32_4 Texture_ptex::lookup_float4(
+    int face_id,
+    const mi::Float32_2& face_uv,
+    float footprint,
+    int channel) const
 {
-    // TODO
-    return mi::Spectrum(0.f);
+    if (!m_is_valid || face_id < 0 || mi::Uint32(face_id) >= get_num_faces()
+            || channel < 0 || mi::Uint32(channel) >= m_num_channels)
+        return mi::Float32_4(0.0f);
+
+    mi::base::Handle<const Ptex_face> face(get_face(mi::Uint32(face_id)));
+
+    // select the reduction level by the footprint in face space and blend between two levels
+    const mi::Uint32 num_levels = face->get_num_levels();
+    const mi::Uint32_2& res = face->get_resolution(0);
+    float level = 0.0f;
+    if (footprint > 0.0f)
+        level = std::min(
+            std::max(log2f(footprint * float(std::max(res.x, res.y))), 0.0f),
+            float(num_levels - 1));
+
+    const mi::Uint32 level0 = mi::Uint32(level);
+    const float t = level - float(level0);
+
+    if (t <= 0.0f || level0 + 1 >= num_levels)
+        return ptex_bilerp(face.get(), level0, face_uv, mi::Uint32(channel));
+
+    const mi::Float32_4 result0 =
+        ptex_bilerp(face.get(), level0, face_uv, mi::Uint32(channel));
+    const mi::Float32_4 result1 =
+        ptex_bilerp(face.get(), level0 + 1, face_uv, mi::Uint32(channel));
+    return mi::Float32_4(
+        result0.x + (result1.x - result0.x) * t,
+        result0.y + (result1.y - result0.y) * t,
+        result0.z + (result1.z - result0.z) * t,
+        result0.w + (result1.w - result0.w) * t);
+}
+
+
+mi::Spectrum Texture_ptex::lookup_color(
+    int face_id,
+    const mi::Float32_2& face_uv,
+    float footprint,
+    int channel) const
+{
+    const mi::Float32_4& res = lookup_float4(face_id, face_uv, footprint, channel);
+    return mi::Spectrum(res.x, res.y, res.z);
 }
 
 
@@ -0,0 +1,223 @@
+/***************************************************************************************************
+ * Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************************************/
+
+#include "pch.h"
+
+#include "mitx_image_file_reader_impl.h"
+
+#include <mi/neuraylib/ireader.h>
+#include <mi/neuraylib/itile.h>
+#include <base/lib/zlib/i_zlib.h>
+
+#include <algorithm>
+#include <cstring>
+
+namespace MI {
+
+namespace MITX {
+
+Image_file_reader_impl::Image_file_reader_impl( mi::neuraylib::IReader* reader)
+  : m_is_valid( false),
+    m_pixel_type( IMAGE::PT_UNDEF)
+{
+    m_reader = reader;
+    m_reader->retain();
+
+    memset( &m_header, 0, sizeof( m_header));
+    if( m_reader->read( reinterpret_cast<char*>( &m_header), sizeof( m_header))
+            != sizeof( m_header))
+        return;
+
+    if( !is_valid_header( m_header)) {
+        log( mi::base::MESSAGE_SEVERITY_ERROR, "Invalid or unsupported MITX header.");
+        return;
+    }
+
+    m_pixel_type = static_cast<IMAGE::Pixel_type>( m_header.m_pixel_type);
+    m_is_valid = true;
+}
+
+Image_file_reader_impl::~Image_file_reader_impl()
+{
+    m_reader->release();
+}
+
+const char* Image_file_reader_impl::get_type() const
+{
+    return IMAGE::convert_pixel_type_enum_to_string( m_pixel_type);
+}
+
+mi::Uint32 Image_file_reader_impl::get_resolution_x( mi::Uint32 level) const
+{
+    if( level >= get_miplevels())
+        return 0;
+    return get_level_width( m_header, level);
+}
+
+mi::Uint32 Image_file_reader_impl::get_resolution_y( mi::Uint32 level) const
+{
+    if( level >= get_miplevels())
+        return 0;
+    return get_level_height( m_header, level);
+}
+
+mi::Uint32 Image_file_reader_impl::get_layers_size( mi::Uint32 level) const
+{
+    if( level >= get_miplevels())
+        return 0;
+    return m_header.m_layers;
+}
+
+mi::Uint32 Image_file_reader_impl::get_tile_resolution_x( mi::Uint32 level) const
+{
+    if( level >= get_miplevels())
+        return 0;
+    return m_header.m_tile_width;
+}
+
+mi::Uint32 Image_file_reader_impl::get_tile_resolution_y( mi::Uint32 level) const
+{
+    if( level >= get_miplevels())
+        return 0;
+    return m_header.m_tile_height;
+}
+
+mi::Uint32 Image_file_reader_impl::get_miplevels() const
+{
+    return m_is_valid ? m_header.m_miplevels : 0;
+}
+
+bool Image_file_reader_impl::get_is_cubemap() const
+{
+    return (m_header.m_flags & MITX_FLAG_CUBEMAP) && m_header.m_layers == 6;
+}
+
+mi::Float32 Image_file_reader_impl::get_gamma() const
+{
+    return m_header.m_gamma;
+}
+
+bool Image_file_reader_impl::read(
+    mi::neuraylib::ITile* tile, mi::Uint32 x, mi::Uint32 y, mi::Uint32 z, mi::Uint32 level) const
+{
+    if( level >= get_miplevels() || z >= get_layers_size( level))
+        return false;
+
+    if( IMAGE::convert_pixel_type_string_to_enum( tile->get_type()) != m_pixel_type)
+        return false;
+
+    const mi::Uint32 level_width  = get_level_width( m_header, level);
+    const mi::Uint32 level_height = get_level_height( m_header, level);
+    if( x >= level_width || y >= level_height)
+        return false;
+
+    // Compute the rectangular region that is to be copied
+    const mi::Uint32 tile_width  = tile->get_resolution_x();
+    const mi::Uint32 x_end = std::min( x + tile_width, level_width);
+    const mi::Uint32 y_end = std::min( y + tile->get_resolution_y(), level_height);
+
+    const mi::Uint32 file_tile_width  = m_header.m_tile_width;
+    const mi::Uint32 file_tile_height = m_header.m_tile_height;
+    const mi::Uint32 bytes_per_pixel  = IMAGE::get_bytes_per_pixel( m_pixel_type);
+
+    // Usually, the requested region is exactly one tile of the file. Other tile sizes are
+    // handled by copying from all overlapping tiles of the file.
+    char* dest = static_cast<char*>( tile->get_data());
+    for( mi::Uint32 tile_y = y / file_tile_height; tile_y * file_tile_height < y_end; ++tile_y)
+        for( mi::Uint32 tile_x = x / file_tile_width; tile_x * file_tile_width < x_end; ++tile_x) {
+
+            if( !read_tile( tile_x, tile_y, z, level))
+                return false;
+
+            const mi::Uint32 x0 = std::max( x, tile_x * file_tile_width);
+            const mi::Uint32 x1 = std::min( x_end, (tile_x + 1) * file_tile_width);
+            const mi::Uint32 y0 = std::max( y, tile_y * file_tile_height);
+            const mi::Uint32 y1 = std::min( y_end, (tile_y + 1) * file_tile_height);
+
+            const mi::Uint32 bytes_per_scanline = (x1 - x0) * bytes_per_pixel;
+            for( mi::Uint32 row = y0; row < y1; ++row) {
+                const mi::Uint8* src = &m_tile_buffer[
+                    ((row - tile_y * file_tile_height) * file_tile_width
+                        + (x0 - tile_x * file_tile_width)) * bytes_per_pixel];
+                memcpy( dest + ((row - y) * tile_width + (x0 - x)) * bytes_per_pixel,
+                    src, bytes_per_scanline);
+            }
+        }
+
+    return true;
+}
+
+bool Image_file_reader_impl::write(
+    const mi::neuraylib::ITile* tile, mi::Uint32 x, mi::Uint32 y, mi::Uint32 z, mi::Uint32 level)
+{
+    return false;
+}
+
+bool Image_file_reader_impl::read_tile(
+    mi::Uint32 tile_x, mi::Uint32 tile_y, mi::Uint32 z, mi::Uint32 level) const
+{
+    // read the tile entry
+    const mi::Uint64 index = get_tile_entry_index( m_header, level, z, tile_x, tile_y);
+    Tile_entry entry;
+    if( !m_reader->seek_absolute( sizeof( Header) + index * sizeof( Tile_entry)))
+        return false;
+    if( m_reader->read( reinterpret_cast<char*>( &entry), sizeof( entry)) != sizeof( entry))
+        return false;
+
+    const size_t tile_size = size_t( m_header.m_tile_width) * m_header.m_tile_height
+        * IMAGE::get_bytes_per_pixel( m_pixel_type);
+    m_tile_buffer.resize( tile_size);
+
+    // read the tile data
+    if( !m_reader->seek_absolute( mi::Sint64( entry.m_offset)))
+        return false;
+
+    if( (entry.m_flags & MITX_TILE_ZLIB) == 0) {
+        if( entry.m_size != tile_size)
+            return false;
+        return m_reader->read( reinterpret_cast<char*>( m_tile_buffer.data()), entry.m_size)
+            == mi::Sint64( entry.m_size);
+    }
+
+    m_compressed_buffer.resize( entry.m_size);
+    if( m_reader->read( reinterpret_cast<char*>( m_compressed_buffer.data()), entry.m_size)
+            != mi::Sint64( entry.m_size))
+        return false;
+
+    uLongf size = uLongf( tile_size);
+    if( ::uncompress( m_tile_buffer.data(), &size, m_compressed_buffer.data(), entry.m_size)
+            != Z_OK || size != tile_size) {
+        log( mi::base::MESSAGE_SEVERITY_ERROR, "Failed to decompress an MITX tile.");
+        return false;
+    }
+    return true;
+}
+
+} // namespace MITX
+
+} // namespace MI
@@ -0,0 +1,259 @@
+/***************************************************************************************************
+ * Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************************************/
+
+#include "pch.h"
+
+#include "mitx_image_file_writer_impl.h"
+
+#include <mi/neuraylib/iwriter.h>
+#include <mi/neuraylib/itile.h>
+#include <base/lib/zlib/i_zlib.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+namespace MI {
+
+namespace MITX {
+
+Image_file_writer_impl::Image_file_writer_impl(
+    mi::neuraylib::IWriter* writer,
+    const char* pixel_type,
+    mi::Uint32 resolution_x,
+    mi::Uint32 resolution_y,
+    mi::Uint32 nr_of_layers,
+    mi::Uint32 miplevels,
+    bool is_cubemap,
+    mi::Float32 gamma,
+    mi::Uint32 compression_level)
+  : m_compression_level( std::min( compression_level, 9u))
+{
+    assert( !is_cubemap || nr_of_layers == 6);
+
+    m_writer = writer;
+    m_writer->retain();
+
+    m_pixel_type = IMAGE::convert_pixel_type_string_to_enum( pixel_type);
+
+    memset( &m_header, 0, sizeof( m_header));
+    memcpy( m_header.m_magic, "MITX", 4);
+    m_header.m_version     = MITX_VERSION;
+    m_header.m_pixel_type  = m_pixel_type;
+    m_header.m_width       = resolution_x;
+    m_header.m_height      = resolution_y;
+    m_header.m_layers      = nr_of_layers;
+    m_header.m_tile_width  = IMAGE::default_tile_width;
+    m_header.m_tile_height = IMAGE::default_tile_height;
+    m_header.m_miplevels   = miplevels;
+    m_header.m_flags       = is_cubemap ? MITX_FLAG_CUBEMAP : 0;
+    m_header.m_gamma       = gamma;
+
+    const mi::Uint32 bytes_per_pixel = IMAGE::get_bytes_per_pixel( m_pixel_type);
+    m_level.resize( m_header.m_miplevels);
+    for( mi::Uint32 i = 0; i < m_header.m_miplevels; ++i)
+        m_level[i].resize( size_t( get_level_width( m_header, i))
+            * get_level_height( m_header, i) * nr_of_layers * bytes_per_pixel);
+}
+
+Image_file_writer_impl::~Image_file_writer_impl()
+{
+    if( !save()) {
+        log( mi::base::MESSAGE_SEVERITY_ERROR,
+            "The image plugin \"mitx\" failed to export an image.");
+    }
+
+    m_writer->release();
+}
+
+const char* Image_file_writer_impl::get_type() const
+{
+    return IMAGE::convert_pixel_type_enum_to_string( m_pixel_type);
+}
+
+mi::Uint32 Image_file_writer_impl::get_resolution_x( mi::Uint32 level) const
+{
+    if( level >= get_miplevels())
+        return 0;
+    return get_level_width( m_header, level);
+}
+
+mi::Uint32 Image_file_writer_impl::get_resolution_y( mi::Uint32 level) const
+{
+    if( level >= get_miplevels())
+        return 0;
+    return get_level_height( m_header, level);
+}
+
+mi::Uint32 Image_file_writer_impl::get_layers_size( mi::Uint32 level) const
+{
+    if( level >= get_miplevels())
+        return 0;
+    return m_header.m_layers;
+}
+
+mi::Uint32 Image_file_writer_impl::get_tile_resolution_x( mi::Uint32 level) const
+{
+    if( level >= get_miplevels())
+        return 0;
+    return m_header.m_tile_width;
+}
+
+mi::Uint32 Image_file_writer_impl::get_tile_resolution_y( mi::Uint32 level) const
+{
+    if( level >= get_miplevels())
+        return 0;
+    return m_header.m_tile_height;
+}
+
+mi::Uint32 Image_file_writer_impl::get_miplevels() const
+{
+    return m_header.m_miplevels;
+}
+
+bool Image_file_writer_impl::get_is_cubemap() const
+{
+    return (m_header.m_flags & MITX_FLAG_CUBEMAP) != 0;
+}
+
+mi::Float32 Image_file_writer_impl::get_gamma() const
+{
+    return m_header.m_gamma;
+}
+
+bool Image_file_writer_impl::read(
+    mi::neuraylib::ITile* tile, mi::Uint32 x, mi::Uint32 y, mi::Uint32 z, mi::Uint32 level) const
+{
+    return false;
+}
+
+bool Image_file_writer_impl::write(
+    const mi::neuraylib::ITile* tile, mi::Uint32 x, mi::Uint32 y, mi::Uint32 z, mi::Uint32 level)
+{
+    if( level >= get_miplevels() || z >= get_layers_size( level))
+        return false;
+
+    if( IMAGE::convert_pixel_type_string_to_enum( tile->get_type()) != m_pixel_type)
+        return false;
+
+    const mi::Uint32 level_width  = get_level_width( m_header, level);
+    const mi::Uint32 level_height = get_level_height( m_header, level);
+    if( x >= level_width || y >= level_height)
+        return false;
+
+    // Compute the rectangular region that is to be copied
+    const mi::Uint32 tile_width = tile->get_resolution_x();
+    const mi::Uint32 x_end = std::min( x + tile_width, level_width);
+    const mi::Uint32 y_end = std::min( y + tile->get_resolution_y(), level_height);
+
+    // Copy pixel data using memcpy() for each scanline.
+    const mi::Uint32 bytes_per_pixel = IMAGE::get_bytes_per_pixel( m_pixel_type);
+    const mi::Uint32 bytes_per_scanline = (x_end - x) * bytes_per_pixel;
+    const size_t bytes_per_layer = size_t( level_width) * level_height * bytes_per_pixel;
+    const char* src = static_cast<const char*>( tile->get_data());
+    mi::Uint8* dest = m_level[level].data() + z * bytes_per_layer
+        + (size_t( y) * level_width + x) * bytes_per_pixel;
+    for( mi::Uint32 row = y; row < y_end; ++row) {
+        memcpy( dest, src, bytes_per_scanline);
+        src  += tile_width * bytes_per_pixel;
+        dest += level_width * bytes_per_pixel;
+    }
+    return true;
+}
+
+bool Image_file_writer_impl::save()
+{
+    const mi::Uint32 tile_width      = m_header.m_tile_width;
+    const mi::Uint32 tile_height     = m_header.m_tile_height;
+    const mi::Uint32 bytes_per_pixel = IMAGE::get_bytes_per_pixel( m_pixel_type);
+    const size_t     tile_size       = size_t( tile_width) * tile_height * bytes_per_pixel;
+
+    std::vector<Tile_entry> entries( size_t( get_tile_entry_count( m_header)));
+    std::vector<mi::Uint8> data;
+    std::vector<mi::Uint8> tile( tile_size);
+    std::vector<mi::Uint8> compressed( ::compressBound( uLong( tile_size)));
+
+    const mi::Uint64 data_offset = sizeof( Header) + entries.size() * sizeof( Tile_entry);
+
+    for( mi::Uint32 level = 0; level < m_header.m_miplevels; ++level) {
+        const mi::Uint32 level_width  = get_level_width( m_header, level);
+        const mi::Uint32 level_height = get_level_height( m_header, level);
+        const size_t bytes_per_layer  = size_t( level_width) * level_height * bytes_per_pixel;
+
+        for( mi::Uint32 z = 0; z < m_header.m_layers; ++z)
+            for( mi::Uint32 tile_y = 0; tile_y < get_tiles_y( m_header, level); ++tile_y)
+                for( mi::Uint32 tile_x = 0; tile_x < get_tiles_x( m_header, level); ++tile_x) {
+
+                    // extract the tile, pixels outside of the level are zero
+                    std::fill( tile.begin(), tile.end(), mi::Uint8( 0));
+                    const mi::Uint32 x0 = tile_x * tile_width;
+                    const mi::Uint32 y0 = tile_y * tile_height;
+                    const mi::Uint32 x1 = std::min( x0 + tile_width,  level_width);
+                    const mi::Uint32 y1 = std::min( y0 + tile_height, level_height);
+                    for( mi::Uint32 row = y0; row < y1; ++row)
+                        memcpy( &tile[size_t( row - y0) * tile_width * bytes_per_pixel],
+                            &m_level[level][z * bytes_per_layer
+                                + (size_t( row) * level_width + x0) * bytes_per_pixel],
+                            (x1 - x0) * bytes_per_pixel);
+
+                    Tile_entry& entry = entries[size_t(
+                        get_tile_entry_index( m_header, level, z, tile_x, tile_y))];
+                    entry.m_offset = data_offset + data.size();
+
+                    uLongf compressed_size = uLongf( compressed.size());
+                    if( m_compression_level > 0
+                        && ::compress2( compressed.data(), &compressed_size, tile.data(),
+                               uLong( tile_size), int( m_compression_level)) == Z_OK
+                        && compressed_size < tile_size) {
+                        entry.m_size  = mi::Uint32( compressed_size);
+                        entry.m_flags = MITX_TILE_ZLIB;
+                        data.insert( data.end(), compressed.begin(),
+                            compressed.begin() + compressed_size);
+                    } else {
+                        entry.m_size  = mi::Uint32( tile_size);
+                        entry.m_flags = 0;
+                        data.insert( data.end(), tile.begin(), tile.end());
+                    }
+                }
+
+        // the pixel data of the level is no longer needed
+        std::vector<mi::Uint8>().swap( m_level[level]);
+    }
+
+    const mi::Sint64 entries_size = mi::Sint64( entries.size() * sizeof( Tile_entry));
+    return m_writer->write( reinterpret_cast<const char*>( &m_header), sizeof( Header))
+            == mi::Sint64( sizeof( Header))
+        && m_writer->write( reinterpret_cast<const char*>( entries.data()), entries_size)
+            == entries_size
+        && m_writer->write( reinterpret_cast<const char*>( data.data()), mi::Sint64( data.size()))
+            == mi::Sint64( data.size());
+}
+
+} // namespace MITX
+
+} // namespace MI
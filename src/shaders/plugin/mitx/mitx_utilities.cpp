@@ -0,0 +1,97 @@
+/***************************************************************************************************
+ * Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************************************/
+
+#include "pch.h"
+
+#include "mitx_utilities.h"
+
+#include <io/image/image/i_image_utilities.h>
+
+#include <cstring>
+
+namespace MI {
+
+namespace MITX {
+
+mi::base::Handle<mi::base::ILogger> g_logger;
+
+void log( mi::base::Message_severity severity, const char* message)
+{
+    if( !g_logger.is_valid_interface())
+        return;
+
+    g_logger->message( severity, "MITX:IMAGE", message);
+}
+
+mi::Uint64 get_tile_entry_index(
+    const Header& header, mi::Uint32 level, mi::Uint32 layer, mi::Uint32 tile_x, mi::Uint32 tile_y)
+{
+    mi::Uint64 index = 0;
+    for( mi::Uint32 l = 0; l < level; ++l)
+        index += mi::Uint64( get_tiles_x( header, l)) * get_tiles_y( header, l) * header.m_layers;
+
+    const mi::Uint32 tiles_x = get_tiles_x( header, level);
+    const mi::Uint32 tiles_y = get_tiles_y( header, level);
+    return index + (mi::Uint64( layer) * tiles_y + tile_y) * tiles_x + tile_x;
+}
+
+mi::Uint64 get_tile_entry_count( const Header& header)
+{
+    return get_tile_entry_index( header, header.m_miplevels, 0, 0, 0);
+}
+
+bool is_valid_header( const Header& header)
+{
+    if( strncmp( header.m_magic, "MITX", 4) != 0 || header.m_version != MITX_VERSION)
+        return false;
+
+    const IMAGE::Pixel_type pixel_type = static_cast<IMAGE::Pixel_type>( header.m_pixel_type);
+    if( !IMAGE::convert_pixel_type_enum_to_string( pixel_type))
+        return false;
+
+    if( header.m_width == 0 || header.m_height == 0 || header.m_layers == 0
+        || header.m_tile_width == 0 || header.m_tile_height == 0 || header.m_miplevels == 0
+        || header.m_gamma <= 0.0f)
+        return false;
+
+    if(    header.m_tile_width  > MITX_MAX_TILE_SIZE
+        || header.m_tile_height > MITX_MAX_TILE_SIZE
+        || header.m_tile_width  > std::max( header.m_width,  IMAGE::default_tile_width)
+        || header.m_tile_height > std::max( header.m_height, IMAGE::default_tile_height))
+        return false;
+
+    // miplevels are halved down to 1x1 at most
+    mi::Uint32 max_levels = 1;
+    for( mi::Uint32 size = std::max( header.m_width, header.m_height); size > 1; size /= 2)
+        ++max_levels;
+    return header.m_miplevels <= max_levels;
+}
+
+} // namespace MITX
+
+} // namespace MI
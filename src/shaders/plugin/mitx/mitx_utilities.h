@@ -0,0 +1,134 @@
+/***************************************************************************************************
+ * Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************************************/
+
+#ifndef SHADERS_PLUGIN_MITX_MITX_UTILITIES_H
+#define SHADERS_PLUGIN_MITX_MITX_UTILITIES_H
+
+#include <mi/base.h>
+
+#include <algorithm>
+
+namespace MI {
+
+namespace MITX {
+
+/// The logger used by #log() below. Do not use it directly, because it might be invalid if the
+/// plugin API is not available. Use #log() instead.
+extern mi::base::Handle<mi::base::ILogger> g_logger;
+
+/// Logs a message.
+///
+/// The message is discarded if the plugin API and the logger is not available.
+void log( mi::base::Message_severity severity, const char* message);
+
+/// The file format version written by this plugin.
+const mi::Uint32 MITX_VERSION = 1;
+
+/// Flag in Header::m_flags for cubemaps.
+const mi::Uint32 MITX_FLAG_CUBEMAP = 1;
+
+/// Flag in Tile_entry::m_flags for zlib-compressed tiles.
+const mi::Uint32 MITX_TILE_ZLIB = 1;
+
+/// The maximum tile width and height accepted by the reader. A tile is the unit of allocation
+/// when reading, hence the limit bounds the memory a corrupted header can request.
+const mi::Uint32 MITX_MAX_TILE_SIZE = 4096;
+
+/// The header of an MITX file.
+///
+/// An MITX file stores all miplevels of an image as tiles of fixed size. The header is followed
+/// by one Tile_entry per tile, ordered by miplevel, layer, tile row, and tile column, and the
+/// tile data. Each tile stores tile_width x tile_height pixels of the pixel type, also at the
+/// borders and for miplevels smaller than a tile, optionally compressed. This allows reading a
+/// single tile with two seeks, independent of the image size.
+struct Header
+{
+    char        m_magic[4];     ///< "MITX"
+    mi::Uint32  m_version;      ///< MITX_VERSION
+    mi::Uint32  m_pixel_type;   ///< IMAGE::Pixel_type
+    mi::Uint32  m_width;        ///< width of miplevel 0
+    mi::Uint32  m_height;       ///< height of miplevel 0
+    mi::Uint32  m_layers;       ///< number of layers of every miplevel
+    mi::Uint32  m_tile_width;   ///< width of all tiles
+    mi::Uint32  m_tile_height;  ///< height of all tiles
+    mi::Uint32  m_miplevels;    ///< number of miplevels
+    mi::Uint32  m_flags;        ///< MITX_FLAG_* values
+    mi::Float32 m_gamma;        ///< gamma value
+    mi::Uint32  m_reserved;     ///< unused, 0
+};
+
+/// The location of a tile in an MITX file.
+struct Tile_entry
+{
+    mi::Uint64 m_offset;        ///< absolute file offset of the tile data
+    mi::Uint32 m_size;          ///< number of bytes of the (possibly compressed) tile data
+    mi::Uint32 m_flags;         ///< MITX_TILE_* values
+};
+
+/// Returns the width of a miplevel.
+inline mi::Uint32 get_level_width( const Header& header, mi::Uint32 level)
+{
+    return std::max( header.m_width >> level, 1u);
+}
+
+/// Returns the height of a miplevel.
+inline mi::Uint32 get_level_height( const Header& header, mi::Uint32 level)
+{
+    return std::max( header.m_height >> level, 1u);
+}
+
+/// Returns the number of tiles in x direction of a miplevel.
+inline mi::Uint32 get_tiles_x( const Header& header, mi::Uint32 level)
+{
+    return (get_level_width( header, level) + header.m_tile_width - 1) / header.m_tile_width;
+}
+
+/// Returns the number of tiles in y direction of a miplevel.
+inline mi::Uint32 get_tiles_y( const Header& header, mi::Uint32 level)
+{
+    return (get_level_height( header, level) + header.m_tile_height - 1) / header.m_tile_height;
+}
+
+/// Returns the index of the Tile_entry of a tile.
+mi::Uint64 get_tile_entry_index(
+    const Header& header, mi::Uint32 level, mi::Uint32 layer, mi::Uint32 tile_x, mi::Uint32 tile_y);
+
+/// Returns the total number of tiles of all miplevels.
+mi::Uint64 get_tile_entry_count( const Header& header);
+
+/// Indicates whether the header describes a valid image of a supported version.
+///
+/// Tiles larger than miplevel 0 are accepted only up to the default tile size, which the writer
+/// uses for all images, and no tile may exceed #MITX_MAX_TILE_SIZE.
+bool is_valid_header( const Header& header);
+
+} // namespace MITX
+
+} // namespace MI
+
+#endif // SHADERS_PLUGIN_MITX_MITX_UTILITIES_H
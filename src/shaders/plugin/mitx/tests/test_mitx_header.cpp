@@ -0,0 +1,99 @@
+/***************************************************************************************************
+ * Copyright (c) 2007-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************************************/
+/// \file
+/// \brief Tests for the validation of MITX headers.
+
+#include <base/system/test/i_test_auto_driver.h>
+
+#include <cstring>
+
+#include <io/image/image/i_image_utilities.h>
+
+#include "../mitx_utilities.h"
+
+using namespace MI;
+
+namespace {
+
+// Returns the header the writer creates for an RGBA image of the given size.
+MITX::Header create_header( mi::Uint32 width, mi::Uint32 height)
+{
+    MITX::Header header;
+    memset( &header, 0, sizeof( header));
+    memcpy( header.m_magic, "MITX", 4);
+    header.m_version     = MITX::MITX_VERSION;
+    header.m_pixel_type  = IMAGE::PT_RGBA;
+    header.m_width       = width;
+    header.m_height      = height;
+    header.m_layers      = 1;
+    header.m_tile_width  = IMAGE::default_tile_width;
+    header.m_tile_height = IMAGE::default_tile_height;
+    header.m_miplevels   = 1;
+    header.m_gamma       = 2.2f;
+    return header;
+}
+
+}
+
+MI_TEST_AUTO_FUNCTION( test_written_headers_are_valid)
+{
+    MI_CHECK( MITX::is_valid_header( create_header( 1024, 512)));
+
+    // the writer uses the default tile size also for images smaller than a tile
+    MI_CHECK( MITX::is_valid_header( create_header( 10, 3)));
+}
+
+MI_TEST_AUTO_FUNCTION( test_tiles_larger_than_the_image)
+{
+    MITX::Header header = create_header( 100, 100);
+    header.m_tile_width = 100;
+    MI_CHECK( MITX::is_valid_header( header));
+
+    header.m_tile_width = 101;
+    MI_CHECK( !MITX::is_valid_header( header));
+
+    header = create_header( 10, 10);
+    header.m_tile_height = IMAGE::default_tile_height + 1;
+    MI_CHECK( !MITX::is_valid_header( header));
+}
+
+MI_TEST_AUTO_FUNCTION( test_tile_size_limit)
+{
+    MITX::Header header = create_header( 100000, 100000);
+    header.m_tile_width  = MITX::MITX_MAX_TILE_SIZE;
+    header.m_tile_height = MITX::MITX_MAX_TILE_SIZE;
+    MI_CHECK( MITX::is_valid_header( header));
+
+    header.m_tile_width = MITX::MITX_MAX_TILE_SIZE + 1;
+    MI_CHECK( !MITX::is_valid_header( header));
+
+    // sizes that overflow the computation of the tile count and the tile buffer size
+    header.m_tile_width  = 0xffffffffu;
+    header.m_tile_height = 0xffffffffu;
+    MI_CHECK( !MITX::is_valid_header( header));
+}